@@ -0,0 +1,105 @@
+#include "wikipath/common.h"
+#include "wikipath/graph-reader.h"
+#include "wikipath/hub-distances.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <string_view>
+
+namespace {
+
+bool StripPrefix(std::string_view &sv, std::string_view prefix) {
+    if (!sv.starts_with(prefix)) return false;
+    sv.remove_prefix(prefix.size());
+    return true;
+}
+
+template <class T>
+bool ParseArg(std::string_view sv, T &value) {
+  std::istringstream iss((std::string(sv)));
+  return (iss >> value) && iss.peek() == std::istringstream::traits_type::eof();
+}
+
+struct Options {
+    const char *graph_filename = nullptr;
+    const char *hubs_filename = nullptr;
+    int hubs = 16;
+    int threads = 1;
+
+    bool Parse(int argc, char *argv[]) {
+        if (argc < 3) {
+            std::cerr << "Missing required arguments.\n";
+            return false;
+        }
+        graph_filename = argv[1];
+        hubs_filename = argv[2];
+        for (int i = 3; i < argc; ++i) {
+            std::string_view arg(argv[i]);
+            if (StripPrefix(arg, "--hubs=")) {
+                if (!ParseArg(arg, hubs) || hubs < 1) {
+                    std::cerr << "Could not parse --hubs value: " << arg << '\n';
+                    return false;
+                }
+            } else if (StripPrefix(arg, "--threads=")) {
+                if (!ParseArg(arg, threads) || threads < 0) {
+                    std::cerr << "Could not parse --threads value: " << arg << '\n';
+                    return false;
+                }
+            } else {
+                std::cerr << "Unrecognized argument: " << arg << '\n';
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+void PrintUsage(const char *argv0) {
+    std::cout << "Usage: " << argv0 << " <wiki.graph> <wiki.hubs> [--hubs=<K>] [--threads=<N>]\n\n"
+        "Computes the distances between every page and the K pages with the most\n"
+        "links, which are used to bound and prune shortest path searches, and writes\n"
+        "them to <wiki.hubs>.\n"
+        "\n"
+        "Options:\n"
+        "\n"
+        "  --hubs=<K>     number of hubs (default: 16)\n"
+        "  --threads=<N>  number of threads used to compute the distances\n"
+        "                 (default: 1; 0 means one thread per core)\n"
+        << std::flush;
+}
+
+bool Main(const Options &options) {
+    using namespace wikipath;
+
+    std::unique_ptr<GraphReader> graph = GraphReader::Open(options.graph_filename, {});
+    if (graph == nullptr) {
+        std::cerr << "Could not open " << options.graph_filename << "!\n";
+        return false;
+    }
+
+    auto start_time = std::chrono::steady_clock::now();
+    HubDistanceOptions hub_options = {.hub_count = options.hubs, .threads = options.threads};
+    if (!BuildHubDistances(*graph, options.hubs_filename, hub_options)) {
+        std::cerr << "Could not write " << options.hubs_filename << "!\n";
+        return false;
+    }
+    auto elapsed_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time);
+    std::cerr << "Hub distances written to " << options.hubs_filename << " in " << elapsed_s.count() << " s\n";
+    return true;
+}
+
+}  // namespace
+
+// Tool to build the hub distances used by SearchOptions::hub_distances.
+int main(int argc, char *argv[]) {
+    Options options;
+    if (!options.Parse(argc, argv)) {
+        PrintUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    return Main(options) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
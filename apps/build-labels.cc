@@ -0,0 +1,108 @@
+#include "wikipath/common.h"
+#include "wikipath/distance-oracle.h"
+#include "wikipath/graph-reader.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <string_view>
+
+namespace {
+
+bool StripPrefix(std::string_view &sv, std::string_view prefix) {
+    if (!sv.starts_with(prefix)) return false;
+    sv.remove_prefix(prefix.size());
+    return true;
+}
+
+template <class T>
+bool ParseArg(std::string_view sv, T &value) {
+  std::istringstream iss((std::string(sv)));
+  return (iss >> value) && iss.peek() == std::istringstream::traits_type::eof();
+}
+
+struct Options {
+    const char *graph_filename = nullptr;
+    const char *labels_filename = nullptr;
+    int threads = 1;
+
+    bool Parse(int argc, char *argv[]) {
+        if (argc < 3) {
+            std::cerr << "Missing required arguments.\n";
+            return false;
+        }
+        graph_filename = argv[1];
+        labels_filename = argv[2];
+        for (int i = 3; i < argc; ++i) {
+            std::string_view arg(argv[i]);
+            if (StripPrefix(arg, "--threads=")) {
+                if (!ParseArg(arg, threads) || threads < 0) {
+                    std::cerr << "Could not parse --threads value: " << arg << '\n';
+                    return false;
+                }
+            } else {
+                std::cerr << "Unrecognized argument: " << arg << '\n';
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+void PrintUsage(const char *argv0) {
+    std::cout << "Usage: " << argv0 << " <wiki.graph> <wiki.labels> [--threads=<N>]\n\n"
+        "Computes 2-hop distance labels for the graph, which can be used to answer\n"
+        "distance queries in microseconds, and writes them to <wiki.labels>.\n"
+        "\n"
+        "Options:\n"
+        "\n"
+        "  --threads=<N>  number of threads used to build the labels\n"
+        "                 (default: 1; 0 means one thread per core)\n"
+        << std::flush;
+}
+
+void PrintStats(const wikipath::DistanceLabelStats &stats, wikipath::index_t vertex_count) {
+    std::cerr << "Hubs processed: " << stats.hubs_processed << " / " << vertex_count
+        << "; label entries: " << stats.out_entries << " out, " << stats.in_entries << " in"
+        << " (average " << static_cast<double>(stats.out_entries + stats.in_entries) / vertex_count
+        << " per vertex); file size: " << stats.file_size / 1e6 << " MB" << std::endl;
+}
+
+bool Main(const Options &options) {
+    using namespace wikipath;
+
+    std::unique_ptr<GraphReader> graph = GraphReader::Open(options.graph_filename, {});
+    if (graph == nullptr) {
+        std::cerr << "Could not open " << options.graph_filename << "!\n";
+        return false;
+    }
+
+    auto start_time = std::chrono::steady_clock::now();
+    const index_t vertex_count = graph->VertexCount();
+    DistanceLabelOptions label_options = {
+        .threads = options.threads,
+        .progress = [vertex_count](const DistanceLabelStats &stats) { PrintStats(stats, vertex_count); },
+    };
+    if (!BuildDistanceLabels(*graph, options.labels_filename, label_options)) {
+        std::cerr << "Could not write " << options.labels_filename << "!\n";
+        return false;
+    }
+    auto elapsed_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time);
+    std::cerr << "Labels written to " << options.labels_filename << " in " << elapsed_s.count() << " s\n";
+    return true;
+}
+
+}  // namespace
+
+// Tool to build the distance labels used by wikipath::DistanceOracle.
+int main(int argc, char *argv[]) {
+    Options options;
+    if (!options.Parse(argc, argv)) {
+        PrintUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    return Main(options) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,97 @@
+#include "wikipath/common.h"
+#include "wikipath/graph-reader.h"
+#include "wikipath/graph-writer.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <span>
+#include <string_view>
+#include <system_error>
+
+namespace {
+
+struct Options {
+    const char *input_filename = nullptr;
+    const char *output_filename = nullptr;
+    bool decompress = false;
+
+    bool Parse(int argc, char *argv[]) {
+        if (argc < 3) {
+            std::cerr << "Missing required arguments.\n";
+            return false;
+        }
+        input_filename = argv[1];
+        output_filename = argv[2];
+        for (int i = 3; i < argc; ++i) {
+            std::string_view arg(argv[i]);
+            if (arg == "--decompress") {
+                decompress = true;
+            } else {
+                std::cerr << "Unrecognized argument: " << arg << '\n';
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+void PrintUsage(const char *argv0) {
+    std::cout << "Usage: " << argv0 << " <input.graph> <output.graph> [--decompress]\n\n"
+        "Converts a graph file to the compressed format (version 2), where each\n"
+        "adjacency list is sorted and stored as StreamVByte-encoded gaps. The input\n"
+        "may be in either format.\n"
+        "\n"
+        "Options:\n"
+        "\n"
+        "  --decompress  convert to the uncompressed format (version 1) instead\n"
+        << std::flush;
+}
+
+bool Main(const Options &options) {
+    using namespace wikipath;
+
+    std::unique_ptr<GraphReader> graph = GraphReader::Open(options.input_filename, {});
+    if (graph == nullptr) {
+        std::cerr << "Could not open " << options.input_filename << "!\n";
+        return false;
+    }
+
+    auto start_time = std::chrono::steady_clock::now();
+    auto outlinks = [&graph](index_t v) { return graph->ForwardEdges(v); };
+    auto inlinks = [&graph](index_t v) { return graph->BackwardEdges(v); };
+    if (!(options.decompress
+            ? WriteGraphOutput(options.output_filename, graph->VertexCount(), outlinks, inlinks)
+            : WriteCompressedGraphOutput(options.output_filename, graph->VertexCount(), outlinks, inlinks))) {
+        std::cerr << "Could not write " << options.output_filename << "!\n";
+        return false;
+    }
+    auto elapsed_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time);
+
+    std::error_code input_error, output_error;
+    auto input_size = std::filesystem::file_size(options.input_filename, input_error);
+    auto output_size = std::filesystem::file_size(options.output_filename, output_error);
+    if (input_error || output_error) {
+        std::cerr << "Could not get file sizes: " << (input_error ? input_error : output_error).message() << "\n";
+        return false;
+    }
+    std::cerr << (options.decompress ? "Uncompressed" : "Compressed") << " graph written to "
+        << options.output_filename << " in " << elapsed_s.count() << " s ("
+        << input_size << " -> " << output_size << " bytes, "
+        << 100.0 * output_size / input_size << "%)\n";
+    return true;
+}
+
+}  // namespace
+
+// Tool to convert a graph file between the uncompressed and compressed formats.
+int main(int argc, char *argv[]) {
+    Options options;
+    if (!options.Parse(argc, argv)) {
+        PrintUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    return Main(options) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,449 @@
+#include "wikipath/common.h"
+#include "wikipath/graph-reader.h"
+#include "wikipath/random.h"
+#include "wikipath/searcher.h"
+#include "wikipath/thread-pool.h"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+
+bool StripPrefix(std::string_view &sv, std::string_view prefix) {
+    if (!sv.starts_with(prefix)) return false;
+    sv.remove_prefix(prefix.size());
+    return true;
+}
+
+template <class T>
+bool ParseArg(std::string_view sv, T &value) {
+  std::istringstream iss((std::string(sv)));
+  return (iss >> value) && iss.peek() == std::istringstream::traits_type::eof();
+}
+
+struct Options {
+    const char *graph_filename = nullptr;
+    int64_t samples = 1000;
+    int64_t max_diameter_searches = 10000;
+    int threads = 0;
+    bool has_seed = false;
+    unsigned seed = 0;
+
+    bool Parse(int argc, char *argv[]) {
+        if (argc < 2) {
+            std::cerr << "Missing required arguments.\n";
+            return false;
+        }
+        graph_filename = argv[1];
+        for (int i = 2; i < argc; ++i) {
+            std::string_view arg(argv[i]);
+            if (StripPrefix(arg, "--samples=")) {
+                if (!ParseArg(arg, samples) || samples < 0) {
+                    std::cerr << "Could not parse --samples value: " << arg << '\n';
+                    return false;
+                }
+            } else if (StripPrefix(arg, "--max_diameter_searches=")) {
+                if (!ParseArg(arg, max_diameter_searches) || max_diameter_searches < 0) {
+                    std::cerr << "Could not parse --max_diameter_searches value: " << arg << '\n';
+                    return false;
+                }
+            } else if (StripPrefix(arg, "--threads=")) {
+                if (!ParseArg(arg, threads) || threads < 0) {
+                    std::cerr << "Could not parse --threads value: " << arg << '\n';
+                    return false;
+                }
+            } else if (StripPrefix(arg, "--seed=")) {
+                if (!ParseArg(arg, seed)) {
+                    std::cerr << "Could not parse --seed value: " << arg << '\n';
+                    return false;
+                }
+                has_seed = true;
+            } else {
+                std::cerr << "Unrecognized argument: " << arg << '\n';
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+void PrintUsage(const char *argv0) {
+    std::cout << "Usage: " << argv0 << " <wiki.graph> [<options>]\n\n"
+        "Computes statistics of the graph and prints them as a JSON object:\n"
+        "\n"
+        "  - in-degree and out-degree distributions, in power-of-two buckets\n"
+        "  - the distribution of distances between pages, from breadth-first\n"
+        "    searches from a uniform sample of start pages\n"
+        "  - the fraction of pages reachable from (and reaching) the sampled pages\n"
+        "  - the eccentricities of the sampled pages (forward and backward)\n"
+        "  - the diameter of the strongly connected component that contains the\n"
+        "    page with the most links, computed with the iFUB algorithm\n"
+        "\n"
+        "Options:\n"
+        "\n"
+        "  --samples=<N>  number of start pages to sample (default: 1000); if N is at\n"
+        "                 least the number of pages, all pages are used, and the\n"
+        "                 distance distribution is exact\n"
+        "  --max_diameter_searches=<N>  maximum number of searches used to compute\n"
+        "                 the diameter (default: 10000); if the diameter is not\n"
+        "                 found within this limit, lower and upper bounds are printed\n"
+        "  --threads=<N>  number of threads (default: 0, which means one per core)\n"
+        "  --seed=<N>     seed for the random number generator, to make the sample\n"
+        "                 reproducible (default: random)\n"
+        << std::flush;
+}
+
+}  // namespace
+
+namespace wikipath {
+namespace {
+
+// Degrees are counted in buckets: bucket 0 contains vertices of degree 0, and
+// bucket i > 0 contains degrees between 2^(i - 1) and 2^i - 1 (inclusive).
+constexpr int DEGREE_BUCKETS = 33;
+
+struct DegreeStats {
+    int64_t buckets[DEGREE_BUCKETS] = {};
+    int64_t max = 0;
+
+    void Add(size_t degree) {
+        ++buckets[std::bit_width(degree)];
+        max = std::max(max, static_cast<int64_t>(degree));
+    }
+
+    void Merge(const DegreeStats &other) {
+        for (int i = 0; i < DEGREE_BUCKETS; ++i) buckets[i] += other.buckets[i];
+        max = std::max(max, other.max);
+    }
+};
+
+// Statistics of breadth-first searches from the sampled vertices, accumulated
+// by each thread separately and merged at the end.
+struct SampleStats {
+    // histogram[d] is the number of pairs (source, v) with v at distance d.
+    std::vector<int64_t> histogram;
+
+    // Per search, the number of vertices reached (excluding the source itself)
+    // and the eccentricity (the greatest distance to a reachable vertex).
+    std::vector<int64_t> reached[2];
+    std::vector<int> eccentricity[2];
+
+    void Merge(const SampleStats &other) {
+        if (histogram.size() < other.histogram.size()) histogram.resize(other.histogram.size(), 0);
+        for (size_t d = 0; d < other.histogram.size(); ++d) histogram[d] += other.histogram[d];
+        for (int dir = 0; dir < 2; ++dir) {
+            reached[dir].insert(reached[dir].end(), other.reached[dir].begin(), other.reached[dir].end());
+            eccentricity[dir].insert(eccentricity[dir].end(),
+                    other.eccentricity[dir].begin(), other.eccentricity[dir].end());
+        }
+    }
+};
+
+// Result of the diameter computation.
+struct DiameterStats {
+    index_t center = 0;
+    index_t component_size = 0;
+    int lower_bound = 0;
+    int upper_bound = 0;
+    int64_t searches = 0;
+};
+
+double Seconds(std::chrono::steady_clock::time_point start_time) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+}
+
+// Returns the `p`-th percentile of the histogram, which must not be empty.
+size_t Percentile(const std::vector<int64_t> &histogram, double p) {
+    int64_t total = 0;
+    for (int64_t count : histogram) total += count;
+    int64_t seen = 0;
+    for (size_t d = 0; d < histogram.size(); ++d) {
+        seen += histogram[d];
+        if (seen >= p * total) return d;
+    }
+    return histogram.size() - 1;
+}
+
+template<class T>
+void PrintSummary(std::ostream &os, const std::vector<T> &values) {
+    if (values.empty()) {
+        os << "null";
+        return;
+    }
+    double sum = 0;
+    for (T value : values) sum += value;
+    os << "{\"min\": " << *std::ranges::min_element(values)
+        << ", \"mean\": " << sum / values.size()
+        << ", \"max\": " << *std::ranges::max_element(values) << "}";
+}
+
+void PrintDegreeStats(std::ostream &os, const DegreeStats &stats, index_t vertices, index_t edges) {
+    os << "{\"mean\": " << (vertices > 0 ? static_cast<double>(edges) / vertices : 0.0)
+        << ", \"max\": " << stats.max << ", \"buckets\": [";
+    int last = DEGREE_BUCKETS - 1;
+    while (last > 0 && stats.buckets[last] == 0) --last;
+    for (int i = 0; i <= last; ++i) {
+        int64_t min = i == 0 ? 0 : int64_t{1} << (i - 1);
+        int64_t max = i == 0 ? 0 : (int64_t{1} << i) - 1;
+        if (i > 0) os << ", ";
+        os << "{\"min\": " << min << ", \"max\": " << max << ", \"count\": " << stats.buckets[i] << "}";
+    }
+    os << "]}";
+}
+
+// Returns the eccentricity of `v` within the component: the greatest distance
+// from `v` to a vertex in the component (or from a vertex to `v`, if
+// `direction` is BACKWARD).
+int ComponentEccentricity(
+        SearchWorkspace &workspace, const GraphReader &graph, index_t v, Direction direction,
+        const std::vector<bool> &in_component) {
+    Distances distances = workspace.ComputeDistances(graph, v, direction);
+    int eccentricity = 0;
+    for (index_t w = 1; w < graph.VertexCount(); ++w) {
+        if (in_component[w] && distances.distance[w] != Distances::UNREACHABLE) {
+            eccentricity = std::max(eccentricity, int{distances.distance[w]});
+        }
+    }
+    return eccentricity;
+}
+
+// Computes the diameter of the strongly connected component of `center` with
+// the directed version of the iFUB algorithm (Crescenzi et al., "On computing
+// the diameter of real-world directed (and undirected) graphs", 2012).
+//
+// Let F_i be the vertices at distance i from the center, and B_i the vertices
+// at distance i to the center. Every pair (x, y) has d(x, y) <= d(x, center) +
+// d(center, y), so once the backward eccentricities of F_j and the forward
+// eccentricities of B_j are known for all j >= i, the diameter is at most
+// max(lower_bound, 2 (i - 1)). Levels are processed from the outside in until
+// the bounds meet; the first level is a double sweep from the center in both
+// directions, which usually finds the diameter already, so that the remaining
+// levels only need to prove it.
+//
+// Distances within a strongly connected component are the same as in the
+// whole graph, so the searches run on the whole graph, and only vertices in
+// the component are taken into account.
+DiameterStats ComputeDiameter(
+        const GraphReader &graph, index_t center, int64_t max_searches,
+        ThreadPool &pool, std::vector<SearchWorkspace> &workspaces) {
+    const SearchOptions parallel_options = {.threads = pool.ThreadCount()};
+    Distances forward = workspaces[0].ComputeDistances(graph, center, Direction::FORWARD, parallel_options);
+    Distances backward = workspaces[0].ComputeDistances(graph, center, Direction::BACKWARD, parallel_options);
+
+    DiameterStats stats = {.center = center, .searches = 2};
+    std::vector<bool> in_component(graph.VertexCount(), false);
+    std::vector<std::vector<index_t>> forward_levels, backward_levels;
+    for (index_t v = 1; v < graph.VertexCount(); ++v) {
+        int f = forward.distance[v], b = backward.distance[v];
+        if (f == Distances::UNREACHABLE || b == Distances::UNREACHABLE) continue;
+        in_component[v] = true;
+        ++stats.component_size;
+        if (forward_levels.size() <= static_cast<size_t>(f)) forward_levels.resize(f + 1);
+        if (backward_levels.size() <= static_cast<size_t>(b)) backward_levels.resize(b + 1);
+        forward_levels[f].push_back(v);
+        backward_levels[b].push_back(v);
+    }
+    forward = {};
+    backward = {};
+
+    const int forward_eccentricity = static_cast<int>(forward_levels.size()) - 1;
+    const int backward_eccentricity = static_cast<int>(backward_levels.size()) - 1;
+    stats.lower_bound = std::max(forward_eccentricity, backward_eccentricity);
+    stats.upper_bound = forward_eccentricity + backward_eccentricity;
+
+    for (int i = stats.lower_bound; i > 0 && stats.lower_bound < stats.upper_bound; --i) {
+        std::vector<std::pair<index_t, Direction>> tasks;
+        if (static_cast<size_t>(i) < forward_levels.size()) {
+            for (index_t v : forward_levels[i]) tasks.push_back({v, Direction::BACKWARD});
+        }
+        if (static_cast<size_t>(i) < backward_levels.size()) {
+            for (index_t v : backward_levels[i]) tasks.push_back({v, Direction::FORWARD});
+        }
+        if (stats.searches + static_cast<int64_t>(tasks.size()) > max_searches) {
+            std::cerr << "Diameter search limit reached at level " << i << "; only bounds are known.\n";
+            break;
+        }
+        std::vector<int> lower_bounds(pool.ThreadCount(), 0);
+        pool.ParallelFor(0, tasks.size(), 1, [&](int thread_index, size_t begin, size_t end) {
+            for (size_t k = begin; k < end; ++k) {
+                auto [v, direction] = tasks[k];
+                lower_bounds[thread_index] = std::max(lower_bounds[thread_index],
+                        ComponentEccentricity(workspaces[thread_index], graph, v, direction, in_component));
+            }
+        });
+        stats.searches += tasks.size();
+        stats.lower_bound = std::max(stats.lower_bound, *std::ranges::max_element(lower_bounds));
+        stats.upper_bound = std::min(stats.upper_bound, std::max(stats.lower_bound, 2 * (i - 1)));
+        std::cerr << "Diameter level " << i << ": " << tasks.size() << " searches; bounds "
+            << stats.lower_bound << ".." << stats.upper_bound << std::endl;
+    }
+    return stats;
+}
+
+bool Main(const Options &options) {
+    std::unique_ptr<GraphReader> graph = GraphReader::Open(options.graph_filename, {});
+    if (graph == nullptr) {
+        std::cerr << "Could not open " << options.graph_filename << "!\n";
+        return false;
+    }
+    const index_t vertex_count = graph->VertexCount();
+    if (vertex_count < 2) {
+        std::cerr << "Graph is empty!\n";
+        return false;
+    }
+    // Vertex 0 is not a page, so it is excluded from all statistics.
+    const index_t pages = vertex_count - 1;
+
+    int threads = options.threads > 0 ? options.threads : std::thread::hardware_concurrency();
+    ThreadPool pool(std::max(threads, 1));
+    // One workspace per thread, which is the only memory that grows with the
+    // size of the graph, besides the distances of the current search.
+    std::vector<SearchWorkspace> workspaces(pool.ThreadCount());
+
+    // Degree distributions, and the vertex with the highest total degree.
+    auto start_time = std::chrono::steady_clock::now();
+    std::vector<DegreeStats> out_degrees(pool.ThreadCount()), in_degrees(pool.ThreadCount());
+    std::vector<std::pair<size_t, index_t>> hubs(pool.ThreadCount(), {0, 1});
+    pool.ParallelFor(1, vertex_count, 1 << 16, [&](int thread_index, size_t begin, size_t end) {
+        for (index_t v = begin; v < end; ++v) {
+            size_t out_degree = graph->ForwardDegree(v);
+            size_t in_degree = graph->BackwardDegree(v);
+            out_degrees[thread_index].Add(out_degree);
+            in_degrees[thread_index].Add(in_degree);
+            hubs[thread_index] = std::max(hubs[thread_index], std::make_pair(out_degree + in_degree, v));
+        }
+    });
+    for (int i = 1; i < pool.ThreadCount(); ++i) {
+        out_degrees[0].Merge(out_degrees[i]);
+        in_degrees[0].Merge(in_degrees[i]);
+    }
+    const index_t center = std::ranges::max(hubs).second;
+    std::cerr << "Computed degree distributions in " << Seconds(start_time) << " s" << std::endl;
+
+    // Searches in both directions from the sampled vertices.
+    start_time = std::chrono::steady_clock::now();
+    std::vector<index_t> sources;
+    if (options.samples >= pages) {
+        sources.resize(pages);
+        std::iota(sources.begin(), sources.end(), index_t{1});
+    } else {
+        std::mt19937 rng = options.has_seed ? std::mt19937(options.seed) : CreateRng();
+        // Selection sampling: each vertex is chosen with probability (samples
+        // still needed) / (vertices remaining).
+        const size_t samples = options.samples;
+        for (index_t v = 1; v < vertex_count && sources.size() < samples; ++v) {
+            if (RandInt<size_t>(0, vertex_count - v - 1, rng) < samples - sources.size()) sources.push_back(v);
+        }
+    }
+    std::vector<SampleStats> sample_stats(pool.ThreadCount());
+    pool.ParallelFor(0, sources.size(), 1, [&](int thread_index, size_t begin, size_t end) {
+        SampleStats &stats = sample_stats[thread_index];
+        for (size_t i = begin; i < end; ++i) {
+            for (Direction direction : {Direction::FORWARD, Direction::BACKWARD}) {
+                const int dir = direction == Direction::FORWARD ? 0 : 1;
+                Distances distances = workspaces[thread_index].ComputeDistances(*graph, sources[i], direction);
+                int64_t reached = -1;  // excludes the source itself
+                for (int64_t count : distances.histogram) reached += count;
+                stats.reached[dir].push_back(reached);
+                stats.eccentricity[dir].push_back(static_cast<int>(distances.histogram.size()) - 1);
+                if (direction == Direction::FORWARD) {
+                    if (stats.histogram.size() < distances.histogram.size()) {
+                        stats.histogram.resize(distances.histogram.size(), 0);
+                    }
+                    for (size_t d = 1; d < distances.histogram.size(); ++d) {
+                        stats.histogram[d] += distances.histogram[d];
+                    }
+                }
+            }
+        }
+    });
+    for (int i = 1; i < pool.ThreadCount(); ++i) sample_stats[0].Merge(sample_stats[i]);
+    const SampleStats &samples = sample_stats[0];
+    std::cerr << "Searched from " << sources.size() << " sampled pages in " << Seconds(start_time) << " s" << std::endl;
+
+    start_time = std::chrono::steady_clock::now();
+    DiameterStats diameter = ComputeDiameter(*graph, center, options.max_diameter_searches, pool, workspaces);
+    std::cerr << "Computed diameter bounds in " << Seconds(start_time) << " s" << std::endl;
+
+    std::ostream &os = std::cout;
+    os << "{\n";
+    os << "  \"pages\": " << pages << ",\n";
+    os << "  \"links\": " << graph->EdgeCount() << ",\n";
+    os << "  \"out_degree\": ";
+    PrintDegreeStats(os, out_degrees[0], pages, graph->EdgeCount());
+    os << ",\n  \"in_degree\": ";
+    PrintDegreeStats(os, in_degrees[0], pages, graph->EdgeCount());
+    os << ",\n  \"samples\": " << sources.size() << ",\n";
+
+    int64_t reachable_pairs = 0;
+    for (int64_t count : samples.histogram) reachable_pairs += count;
+    const int64_t total_pairs = static_cast<int64_t>(sources.size()) * (pages - 1);
+    os << "  \"distances\": {\"histogram\": {";
+    for (size_t d = 1; d < samples.histogram.size(); ++d) {
+        if (d > 1) os << ", ";
+        os << '"' << d << "\": " << samples.histogram[d];
+    }
+    os << "}, \"unreachable\": " << total_pairs - reachable_pairs;
+    if (reachable_pairs > 0) {
+        double sum = 0;
+        for (size_t d = 1; d < samples.histogram.size(); ++d) sum += static_cast<double>(d) * samples.histogram[d];
+        os << ", \"mean\": " << sum / reachable_pairs
+            << ", \"median\": " << Percentile(samples.histogram, 0.5)
+            << ", \"percentile_90\": " << Percentile(samples.histogram, 0.9);
+    }
+    os << "},\n";
+
+    os << "  \"reachability\": {\"pairs\": "
+        << (total_pairs > 0 ? static_cast<double>(reachable_pairs) / total_pairs : 0.0);
+    for (int dir = 0; dir < 2; ++dir) {
+        std::vector<double> fractions;
+        for (int64_t reached : samples.reached[dir]) {
+            fractions.push_back(pages > 1 ? static_cast<double>(reached) / (pages - 1) : 0.0);
+        }
+        os << (dir == 0 ? ", \"forward\": " : ", \"backward\": ");
+        PrintSummary(os, fractions);
+    }
+    os << "},\n";
+
+    os << "  \"eccentricity\": {\"forward\": ";
+    PrintSummary(os, samples.eccentricity[0]);
+    os << ", \"backward\": ";
+    PrintSummary(os, samples.eccentricity[1]);
+    os << "},\n";
+
+    os << "  \"diameter\": {\"center\": " << diameter.center
+        << ", \"component_size\": " << diameter.component_size
+        << ", \"lower_bound\": " << diameter.lower_bound
+        << ", \"upper_bound\": " << diameter.upper_bound
+        << ", \"exact\": " << (diameter.lower_bound == diameter.upper_bound ? "true" : "false")
+        << ", \"searches\": " << diameter.searches << "}\n";
+    os << "}" << std::endl;
+    return true;
+}
+
+}  // namespace
+}  // namespace wikipath
+
+// Tool to compute statistics of the graph, like the distribution of distances
+// between pages ("degrees of separation") and the diameter.
+int main(int argc, char *argv[]) {
+    Options options;
+    if (!options.Parse(argc, argv)) {
+        PrintUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    return wikipath::Main(options) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
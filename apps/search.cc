@@ -1,5 +1,6 @@
 #include "wikipath/annotated-dag.h"
 #include "wikipath/common.h"
+#include "wikipath/multi-source-search.h"
 #include "wikipath/random.h"
 #include "wikipath/reader.h"
 #include "wikipath/searcher.h"
@@ -7,12 +8,15 @@
 #include <cassert>
 #include <cstdint>
 #include <cstdlib>
+#include <fstream>
 #include <iostream>
 #include <limits>
+#include <optional>
 #include <sstream>
 #include <string_view>
 #include <utility>
 #include <unordered_map>
+#include <vector>
 
 namespace {
 
@@ -23,6 +27,7 @@ enum class DagOutputType {
     PATHS,  // Output all paths, one per line.
     EDGES,  // Output the edges in the DAG, one per line.
     DOT,    // Output the DAG in GraphViz DOT file format.
+    MATRIX, // Output distances between two lists of pages (not a DAG).
 };
 
 bool ParseDagOutputType(std::string_view sv, DagOutputType &type) {
@@ -31,6 +36,7 @@ bool ParseDagOutputType(std::string_view sv, DagOutputType &type) {
     if (sv == "paths") return type = DagOutputType::PATHS, true;
     if (sv == "edges") return type = DagOutputType::EDGES, true;
     if (sv == "dot")   return type = DagOutputType::DOT,   true;
+    if (sv == "matrix") return type = DagOutputType::MATRIX, true;
     return false;
 }
 
@@ -61,12 +67,33 @@ void DumpSearchStats(const SearchStats stats) {
     std::cerr << "Vertices reached:  " << stats.vertices_reached << '\n';
     std::cerr << "Vertices expanded: " << stats.vertices_expanded << '\n';
     std::cerr << "Edges expanded:    " << stats.edges_expanded << '\n';
-    std::cerr << "Search time:       " << stats.time_taken_ms << " ms\n";
+    std::cerr << "Search time:       " << stats.time_taken_ns / 1e6 << " ms ("
+        << stats.search_ns / 1e6 << " ms search";
+    if (stats.reconstruct_ns > 0) std::cerr << ", " << stats.reconstruct_ns / 1e6 << " ms path";
+    if (stats.propagate_ns > 0) std::cerr << ", " << stats.propagate_ns / 1e6 << " ms DAG";
+    if (stats.sort_ns > 0) std::cerr << ", " << stats.sort_ns / 1e6 << " ms sort";
+    std::cerr << ")\n";
+    std::cerr << "Page faults:       " << stats.minor_faults << " minor, " << stats.major_faults << " major\n";
+    // One letter per level: F/B for forward/backward, uppercase for top-down
+    // and lowercase for bottom-up.
+    std::cerr << "Search levels:     ";
+    for (const SearchLevel &level : stats.levels) {
+        char ch = level.direction == SearchLevel::Direction::FORWARD ? 'F' : 'B';
+        if (level.mode == SearchLevel::Mode::BOTTOM_UP) ch = ch - 'A' + 'a';
+        std::cerr << ch;
+    }
+    std::cerr << '\n';
+    for (size_t i = 0; i < stats.levels.size(); ++i) {
+        const SearchLevel &level = stats.levels[i];
+        std::cerr << "  Level " << i + 1 << ": fringe " << level.fringe_size
+            << ", vertices expanded " << level.vertices_expanded
+            << ", edges expanded " << level.edges_expanded << '\n';
+    }
 }
 
-bool SearchClassic(Reader &reader, index_t start, index_t finish) {
+bool SearchClassic(Reader &reader, index_t start, index_t finish, const SearchOptions &search_options) {
     SearchStats stats;
-    std::vector<index_t> path = FindShortestPath(reader.Graph(), start, finish, &stats);
+    std::vector<index_t> path = FindShortestPath(reader.Graph(), start, finish, &stats, search_options).value;
     DumpSearchStats(stats);
     if (path.empty()) {
         std::cerr << "No path found!\n";
@@ -227,6 +254,9 @@ struct Options {
     bool random = false;
     int64_t skip = 0;
     int64_t max = std::numeric_limits<int64_t>::max();
+    int threads = 1;
+    int batch_width = 64;
+    int slack = 0;
 
     bool Parse(int argc, char *argv[]) {
         if (argc < 4) {
@@ -236,14 +266,34 @@ struct Options {
         graph_filename = argv[1];
         start = argv[2];
         finish = argv[3];
-        if (argc == 4) return true;
-        if (!ParseDagOutputType(argv[4], output_type)) {
-            std::cerr << "Invalid DAG output type: " << argv[4] << '\n';
-            return false;
+        int i = 4;
+        if (i < argc && !std::string_view(argv[i]).starts_with("--")) {
+            if (!ParseDagOutputType(argv[i], output_type)) {
+                std::cerr << "Invalid DAG output type: " << argv[i] << '\n';
+                return false;
+            }
+            ++i;
         }
-        for (int i = 5; i < argc; ++i) {
+        for (; i < argc; ++i) {
             std::string_view arg(argv[i]);
-            if (output_type == DagOutputType::PATH && arg == "--random") {
+            if (StripPrefix(arg, "--threads=")) {
+                if (!ParseArg(arg, threads) || threads < 0) {
+                    std::cerr << "Could not parse --threads value: " << arg << '\n';
+                    return false;
+                }
+            } else if (output_type == DagOutputType::MATRIX && StripPrefix(arg, "--batch_width=")) {
+                if (!ParseArg(arg, batch_width) ||
+                        (batch_width != 64 && batch_width != 128 && batch_width != 256)) {
+                    std::cerr << "Could not parse --batch_width value: " << arg << '\n';
+                    return false;
+                }
+            } else if (output_type != DagOutputType::NONE && output_type != DagOutputType::MATRIX
+                    && StripPrefix(arg, "--slack=")) {
+                if (!ParseArg(arg, slack) || slack < 0) {
+                    std::cerr << "Could not parse --slack value: " << arg << '\n';
+                    return false;
+                }
+            } else if (output_type == DagOutputType::PATH && arg == "--random") {
                 random = true;
             } else if (output_type == DagOutputType::PATHS && StripPrefix(arg, "--skip=")) {
                 if (!ParseArg(arg, skip)) {
@@ -285,7 +335,7 @@ struct Options {
 };
 
 void PrintUsage(const char *argv0) {
-    std::cout << "Usage: " << argv0 << " <wiki.graph> <Start|#id|?> <Finish|#id|?> [<dag-output>]\n\n"
+    std::cout << "Usage: " << argv0 << " <wiki.graph> <Start|#id|?> <Finish|#id|?> [<dag-output>] [<options>]\n\n"
         "If <dag-output> is present, the DAG-based algorithm is used instead of the classic\n"
         "algorithm. The value of <dag-output> determines what is printed:\n"
         "\n"
@@ -295,6 +345,19 @@ void PrintUsage(const char *argv0) {
         "  edges    the edges in the DAG, one per line\n"
         "  dot      the DAG in GraphViz DOT format\n"
         "\n"
+        "The special output type \"matrix\" instead interprets <Start> and <Finish> as\n"
+        "names of files that contain lists of pages (one per line, in the same format as\n"
+        "the command line arguments), and prints a tab-separated matrix of distances\n"
+        "from each start page (rows) to each finish page (columns), where \"-\" means\n"
+        "unreachable. The following option is available:\n"
+        "\n"
+        "  --batch_width=<N>  number of searches run simultaneously: 64 (default), 128 or 256\n"
+        "\n"
+        "For all other values of <dag-output>, the following option is available:\n"
+        "\n"
+        "  --slack=<K>  include paths that are up to K links longer than the shortest\n"
+        "               paths (default: 0). With K > 0, paths may visit a page twice.\n"
+        "\n"
         "When <dag-output> is \"path\", the following options are available:\n"
         "\n"
         "  --random     select a path uniformly at random\n"
@@ -316,34 +379,100 @@ void PrintUsage(const char *argv0) {
         "If <dag-output> is missing, then a single shortest path is printed, calculated using\n"
         "an older algorithm. The output is similar to \"path\", but slightly faster because it\n"
         "only calculates a single path and not the entire DAG of shortest paths.\n"
+        "\n"
+        "The following options are always available:\n"
+        "\n"
+        "  --threads=<N>  number of threads used to expand large search levels\n"
+        "                 (default: 1; 0 means one thread per core)\n"
         << std::flush;
 }
 
+// Reads a list of page arguments from the given file, one per line, ignoring
+// empty lines. Returns false if the file cannot be read or a page is invalid.
+bool ReadPageList(const wikipath::Reader &reader, const char *filename, std::vector<wikipath::index_t> &pages) {
+    std::ifstream is(filename);
+    if (!is) {
+        std::cerr << "Could not open " << filename << "!\n";
+        return false;
+    }
+    std::string line;
+    while (std::getline(is, line)) {
+        if (line.empty()) continue;
+        wikipath::index_t page = reader.ParsePageArgument(line.c_str());
+        if (page == 0) return false;
+        pages.push_back(page);
+    }
+    return true;
+}
+
+bool SearchMatrix(const wikipath::Reader &reader, const Options &options) {
+    using namespace wikipath;
+
+    std::vector<index_t> sources, targets;
+    if (!ReadPageList(reader, options.start, sources) || !ReadPageList(reader, options.finish, targets)) {
+        return false;
+    }
+    std::cerr << "Computing distances from " << sources.size() << " to " << targets.size() << " pages..." << std::endl;
+    DistanceMatrix matrix = ComputeDistanceMatrix(reader.Graph(), sources, targets, options.batch_width);
+
+    for (index_t target : targets) std::cout << '\t' << reader.PageRef(target);
+    std::cout << '\n';
+    for (size_t i = 0; i < sources.size(); ++i) {
+        std::cout << reader.PageRef(sources[i]);
+        for (size_t j = 0; j < targets.size(); ++j) {
+            std::cout << '\t';
+            if (matrix(i, j) == DistanceMatrix::UNREACHABLE) {
+                std::cout << '-';
+            } else {
+                std::cout << int{matrix(i, j)};
+            }
+        }
+        std::cout << '\n';
+    }
+    return true;
+}
+
 bool Main(const Options &options) {
     using namespace wikipath;
 
     std::unique_ptr<Reader> reader = Reader::Open(options.graph_filename, {});
     if (reader == nullptr) return false;
 
+    if (options.output_type == DagOutputType::MATRIX) {
+        return SearchMatrix(*reader, options);
+    }
+
     index_t start = reader->ParsePageArgument(options.start);
     index_t finish = reader->ParsePageArgument(options.finish);
     if (start == 0 || finish == 0) return false;
 
     std::cerr << "Searching shortest path from " << reader->PageRef(start) << " to " << reader->PageRef(finish) << "..." << std::endl;
 
+    const SearchOptions search_options = {.threads = options.threads};
+
     if (options.output_type == DagOutputType::NONE) {
-        return SearchClassic(*reader, start, finish);
+        return SearchClassic(*reader, start, finish, search_options);
     }
 
     SearchStats stats;
-    auto dag = FindShortestPathDag(reader->Graph(), start, finish, &stats);
+    std::optional<std::vector<std::pair<index_t, index_t>>> dag;
+    int max_length = -1;
+    if (options.slack > 0) {
+        if (auto paths = FindNearShortestPaths(reader->Graph(), start, finish, options.slack, &stats).value) {
+            dag = std::move(paths->edges);
+            max_length = paths->max_length;
+        }
+    } else {
+        dag = FindShortestPathDag(reader->Graph(), start, finish, &stats, search_options).value;
+    }
     DumpSearchStats(stats);
 
     if (dag) {
-        AnnotatedDag annotated_dag(reader.get(), start, finish, *dag);
+        AnnotatedDag annotated_dag(reader.get(), start, finish, *dag, max_length);
 
         switch (options.output_type) {
         case DagOutputType::NONE:  // already handled above
+        case DagOutputType::MATRIX:
             assert(false);
             return false;
 
@@ -182,8 +182,11 @@ void SearchApplication::Search() {
         return;
     }
 
+    // Wt runs event handlers on a pool of worker threads, so each thread gets
+    // its own workspace.
+    thread_local SearchWorkspace workspace;
     SearchStats stats;
-    std::vector<index_t> path = FindShortestPath(reader.Graph(), startPage->id, finishPage->id, &stats);
+    std::vector<index_t> path = workspace.FindShortestPath(reader.Graph(), startPage->id, finishPage->id, &stats).value;
 
     // Display stats.
     statsTemplate->bindString("vertices-reached", FormatNumber(stats.vertices_reached), Wt::TextFormat::Plain);
@@ -0,0 +1,146 @@
+#ifndef WIKIPATH_BENCHMARK_UTIL_H_INCLUDED
+#define WIKIPATH_BENCHMARK_UTIL_H_INCLUDED
+
+#include "wikipath/common.h"
+#include "wikipath/graph-reader.h"
+#include "wikipath/graph-writer.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Shared helpers for the benchmark binaries in this directory.
+
+namespace wikipath::benchmark {
+
+// Writes a random graph with `vertex_count` vertices (including vertex 0, which
+// has no edges) and an average out-degree of approximately `average_degree`.
+//
+// Half of the edges point to targets chosen with a strong bias towards low
+// vertex ids, which creates a small number of hub vertices with many incoming
+// links, similar to the country/city/year pages in Wikipedia. The other half
+// point to targets chosen uniformly at random.
+inline bool WriteSyntheticGraph(
+        const char *filename, index_t vertex_count, int average_degree, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> real_dist(0.0, 1.0);
+    std::geometric_distribution<int> degree_dist(1.0 / (average_degree + 1));
+    std::vector<std::vector<index_t>> outlinks(vertex_count), inlinks(vertex_count);
+    for (index_t v = 1; v < vertex_count; ++v) {
+        std::vector<index_t> &targets = outlinks[v];
+        for (int i = degree_dist(rng); i > 0; --i) {
+            double x = real_dist(rng);
+            if (i % 2 == 0) x = x * x * x * x;
+            index_t w = 1 + static_cast<index_t>(x * (vertex_count - 1));
+            if (w < vertex_count && w != v) targets.push_back(w);
+        }
+        std::sort(targets.begin(), targets.end());
+        targets.erase(std::unique(targets.begin(), targets.end()), targets.end());
+        for (index_t w : targets) inlinks[w].push_back(v);
+    }
+    return WriteGraphOutput(filename, outlinks, inlinks);
+}
+
+// Opens the graph file given on the command line. If the argument has the form
+// "synthetic:V,D" then a synthetic graph with V vertices and average degree D
+// is generated in a temporary file instead (see WriteSyntheticGraph()).
+inline std::unique_ptr<GraphReader> OpenBenchmarkGraph(
+        std::string_view arg, GraphReader::OpenOptions options = {}) {
+    if (!arg.starts_with("synthetic:")) {
+        std::string filename(arg);
+        auto graph = GraphReader::Open(filename.c_str(), options);
+        if (graph == nullptr) std::cerr << "Could not open graph file [" << filename << "]\n";
+        return graph;
+    }
+    arg.remove_prefix(std::string_view("synthetic:").size());
+    index_t vertex_count = 0;
+    int average_degree = 0;
+    std::string spec(arg);
+    if (sscanf(spec.c_str(), "%u,%d", &vertex_count, &average_degree) != 2 ||
+            vertex_count < 2 || average_degree < 1) {
+        std::cerr << "Invalid synthetic graph specification [" << spec << "]\n";
+        return nullptr;
+    }
+    std::string filename = (std::filesystem::temp_directory_path() /
+            ("wikipath-benchmark-" + std::to_string(getpid()) + ".graph")).string();
+    std::cerr << "Generating synthetic graph with " << vertex_count << " vertices "
+            << "and average degree " << average_degree << "..." << std::endl;
+    if (!WriteSyntheticGraph(filename.c_str(), vertex_count, average_degree, 1)) {
+        std::cerr << "Could not write synthetic graph to [" << filename << "]\n";
+        return nullptr;
+    }
+    auto graph = GraphReader::Open(filename.c_str(), options);
+    // The file stays mapped after it is removed.
+    std::filesystem::remove(filename);
+    return graph;
+}
+
+// Returns `count` pairs of vertices selected uniformly at random from all
+// vertices with at least one outgoing and one incoming edge, similar to
+// Reader::RandomPageId(). Pairs are deterministic given the seed.
+inline std::vector<std::pair<index_t, index_t>> RandomQueries(
+        const GraphReader &graph, int count, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<index_t> dist(1, graph.VertexCount() - 1);
+    auto random_vertex = [&]() {
+        index_t v = 0;
+        for (int attempt = 0; attempt < 20; ++attempt) {
+            v = dist(rng);
+            if (graph.ForwardDegree(v) > 0 && graph.BackwardDegree(v) > 0) break;
+        }
+        return v;
+    };
+    std::vector<std::pair<index_t, index_t>> queries;
+    for (int i = 0; i < count; ++i) {
+        index_t start = random_vertex();
+        index_t finish = random_vertex();
+        queries.push_back({start, finish});
+    }
+    return queries;
+}
+
+// Collects per-query latencies and prints a one-line summary.
+class LatencyRecorder {
+public:
+    template<class F> void Measure(F &&f) {
+        auto start_time = std::chrono::steady_clock::now();
+        f();
+        auto duration = std::chrono::steady_clock::now() - start_time;
+        latencies_us.push_back(std::chrono::duration<double, std::micro>(duration).count());
+    }
+
+    void Print(std::ostream &os, std::string_view label) {
+        std::sort(latencies_us.begin(), latencies_us.end());
+        double total = 0;
+        for (double us : latencies_us) total += us;
+        auto percentile = [this](double p) {
+            if (latencies_us.empty()) return 0.0;
+            return latencies_us[std::min(latencies_us.size() - 1, static_cast<size_t>(p * latencies_us.size()))];
+        };
+        os << std::left << std::setw(32) << label << std::right << std::fixed << std::setprecision(1)
+            << " mean " << std::setw(10) << (latencies_us.empty() ? 0.0 : total / latencies_us.size())
+            << " p50 " << std::setw(10) << percentile(0.50)
+            << " p90 " << std::setw(10) << percentile(0.90)
+            << " p99 " << std::setw(10) << percentile(0.99)
+            << " max " << std::setw(10) << percentile(1.00)
+            << " (us)\n";
+    }
+
+private:
+    std::vector<double> latencies_us;
+};
+
+}  // namespace wikipath::benchmark
+
+#endif  // ndef WIKIPATH_BENCHMARK_UTIL_H_INCLUDED
@@ -0,0 +1,1098 @@
+#include "benchmark-util.h"
+
+#include "wikipath/batch-search.h"
+#include "wikipath/common.h"
+#include "wikipath/distance-oracle.h"
+#include "wikipath/graph-reader.h"
+#include "wikipath/graph-writer.h"
+#include "wikipath/hub-distances.h"
+#include "wikipath/multi-source-search.h"
+#include "wikipath/neighbor-scan.h"
+#include "wikipath/numa.h"
+#include "wikipath/searcher.h"
+#include "wikipath/vertex-order.h"
+
+#include <fcntl.h>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <numeric>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using namespace wikipath;
+using namespace wikipath::benchmark;
+
+bool StripPrefix(std::string_view &sv, std::string_view prefix) {
+    if (!sv.starts_with(prefix)) return false;
+    sv.remove_prefix(prefix.size());
+    return true;
+}
+
+template <class T>
+bool ParseArg(std::string_view sv, T &value) {
+  std::istringstream iss((std::string(sv)));
+  return (iss >> value) && iss.peek() == std::istringstream::traits_type::eof();
+}
+
+template <class T>
+bool ParseList(std::string_view sv, std::vector<T> &values) {
+    values.clear();
+    while (!sv.empty()) {
+        auto pos = sv.find(',');
+        T value;
+        if (!ParseArg(sv.substr(0, pos), value)) return false;
+        values.push_back(value);
+        sv.remove_prefix(pos == std::string_view::npos ? sv.size() : pos + 1);
+    }
+    return !values.empty();
+}
+
+struct Options {
+    const char *graph = nullptr;
+    int queries = 1000;
+    unsigned seed = 1;
+    std::vector<double> sparse_fractions = {0, 0.0001, 0.001, 0.01, 0.1, 1};
+    std::vector<double> bottom_up_alphas = {0, 2, 14, 100};
+    std::vector<int> threads = {1};
+    std::vector<int> prefetch_distances = {0, 1, 2, 4, 8, 16};
+    bool mlock = false;
+    int cold_queries = 0;
+    const char *labels = nullptr;
+    const char *hubs = nullptr;
+    bool formats = false;
+    std::vector<VertexOrder> orders;
+    bool huge_pages = false;
+    std::vector<int> warm_up_threads;
+    bool numa = false;
+
+    bool Parse(int argc, char *argv[]) {
+        if (argc < 2) {
+            std::cerr << "Missing required arguments.\n";
+            return false;
+        }
+        graph = argv[1];
+        for (int i = 2; i < argc; ++i) {
+            std::string_view arg(argv[i]);
+            if (StripPrefix(arg, "--queries=")) {
+                if (!ParseArg(arg, queries) || queries < 1) {
+                    std::cerr << "Could not parse --queries value: " << arg << '\n';
+                    return false;
+                }
+            } else if (StripPrefix(arg, "--seed=")) {
+                if (!ParseArg(arg, seed)) {
+                    std::cerr << "Could not parse --seed value: " << arg << '\n';
+                    return false;
+                }
+            } else if (StripPrefix(arg, "--sparse_fractions=")) {
+                if (!ParseList(arg, sparse_fractions)) {
+                    std::cerr << "Could not parse --sparse_fractions value: " << arg << '\n';
+                    return false;
+                }
+            } else if (StripPrefix(arg, "--threads=")) {
+                if (!ParseList(arg, threads)) {
+                    std::cerr << "Could not parse --threads value: " << arg << '\n';
+                    return false;
+                }
+            } else if (StripPrefix(arg, "--prefetch_distances=")) {
+                if (!ParseList(arg, prefetch_distances)) {
+                    std::cerr << "Could not parse --prefetch_distances value: " << arg << '\n';
+                    return false;
+                }
+            } else if (StripPrefix(arg, "--cold=")) {
+                if (!ParseArg(arg, cold_queries) || cold_queries < 1) {
+                    std::cerr << "Could not parse --cold value: " << arg << '\n';
+                    return false;
+                }
+            } else if (arg == "--mlock") {
+                mlock = true;
+            } else if (arg == "--formats") {
+                formats = true;
+            } else if (arg == "--huge_pages") {
+                huge_pages = true;
+            } else if (arg == "--numa") {
+                numa = true;
+            } else if (StripPrefix(arg, "--warm_up=")) {
+                if (!ParseList(arg, warm_up_threads) ||
+                        std::ranges::any_of(warm_up_threads, [](int n) { return n < 1; })) {
+                    std::cerr << "Could not parse --warm_up value: " << arg << '\n';
+                    return false;
+                }
+            } else if (StripPrefix(arg, "--orders=")) {
+                orders.clear();
+                while (!arg.empty()) {
+                    auto pos = arg.find(',');
+                    std::optional<VertexOrder> order = ParseVertexOrder(arg.substr(0, pos));
+                    if (!order) {
+                        std::cerr << "Could not parse --orders value: " << arg << '\n';
+                        return false;
+                    }
+                    orders.push_back(*order);
+                    arg.remove_prefix(pos == std::string_view::npos ? arg.size() : pos + 1);
+                }
+            } else if (StripPrefix(arg, "--labels=")) {
+                labels = arg.data();
+            } else if (StripPrefix(arg, "--hubs=")) {
+                hubs = arg.data();
+            } else if (StripPrefix(arg, "--bottom_up_alphas=")) {
+                if (!ParseList(arg, bottom_up_alphas)) {
+                    std::cerr << "Could not parse --bottom_up_alphas value: " << arg << '\n';
+                    return false;
+                }
+            } else {
+                std::cerr << "Unrecognized argument: " << arg << '\n';
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+void PrintUsage(const char *argv0) {
+    std::cout << "Usage: " << argv0 << " <wiki.graph|synthetic:V,D> [<options>]\n\n"
+        "Runs FindShortestPath() and FindShortestPathDag() for random pairs of vertices\n"
+        "and reports latency percentiles for each search configuration, and the\n"
+        "throughput of FindShortestPaths() for the same queries.\n"
+        "\n"
+        "Instead of a graph file, synthetic:V,D generates a random graph with V vertices\n"
+        "and average out-degree D (e.g. synthetic:1000000,25).\n"
+        "\n"
+        "Options:\n"
+        "\n"
+        "  --queries=<N>   number of random queries (default: 1000)\n"
+        "  --seed=<N>      random seed used to select queries (default: 1)\n"
+        "  --sparse_fractions=<X,Y,..>\n"
+        "                  values of SearchOptions::sparse_visited_max_fraction to\n"
+        "                  compare (default: 0,0.0001,0.001,0.01,0.1,1)\n"
+        "  --bottom_up_alphas=<X,Y,..>\n"
+        "                  values of SearchOptions::bottom_up_alpha to compare\n"
+        "                  (default: 0,2,14,100)\n"
+        "  --prefetch_distances=<N,M,..>\n"
+        "                  values of SearchOptions::prefetch_distance to compare\n"
+        "                  (default: 0,1,2,4,8,16)\n"
+        "  --mlock         lock the graph into memory before running the queries, so\n"
+        "                  that the results do not depend on page faults\n"
+        "  --cold=<N>      instead of the other benchmarks, run the first N queries\n"
+        "                  with a cold page cache: before each search, the graph file\n"
+        "                  is evicted from the page cache and opened again, to compare\n"
+        "                  SearchOptions::sort_fringes (requires a graph file)\n"
+        "  --threads=<N,M,..>\n"
+        "                  values of SearchOptions::threads to compare (default: 1)\n"
+        "  --labels=<file> also measure DistanceOracle queries, using a label file\n"
+        "                  created by build-labels for the same graph\n"
+        "  --hubs=<file>   also measure FindShortestPath() with SearchOptions::hub_distances,\n"
+        "                  using a hub file created by build-hubs for the same graph\n"
+        "  --formats       also compare the resident memory and query latency of the\n"
+        "                  graph in the uncompressed and the compressed file format\n"
+        "  --orders=<X,Y,..>\n"
+        "                  also compare the graph renumbered in each of the given\n"
+        "                  vertex orders (bfs, rcm, degree, gorder) with the original\n"
+        "                  order, by query latency, page faults and cache misses\n"
+        "  --huge_pages    also compare query latency and dTLB misses with each\n"
+        "                  GraphReader::OpenOptions::HugePages mode\n"
+        "  --warm_up=<N,M,..>\n"
+        "                  also measure how long it takes to load the graph into\n"
+        "                  memory from a cold page cache, with MLock::BACKGROUND and\n"
+        "                  with MLock::PARALLEL with each number of threads\n"
+        "  --numa          also compare query latency on each NUMA node, between the\n"
+        "                  file mapping and GraphReader::OpenOptions::numa_replicas\n"
+        << std::flush;
+}
+
+// Compares values of SearchOptions::sparse_visited_max_fraction.
+void BenchmarkSparseFractions(const GraphReader &graph,
+        const std::vector<std::pair<index_t, index_t>> &queries,
+        const std::vector<double> &fractions) {
+    std::cout << "FindShortestPath() by sparse_visited_max_fraction:\n";
+    for (double fraction : fractions) {
+        SearchOptions options = {.sparse_visited_max_fraction = fraction};
+        LatencyRecorder recorder;
+        for (auto [start, finish] : queries) {
+            recorder.Measure([&]() { FindShortestPath(graph, start, finish, nullptr, options); });
+        }
+        recorder.Print(std::cout, "  fraction=" + std::to_string(fraction));
+    }
+}
+
+// Compares values of SearchOptions::bottom_up_alpha, and reports how many
+// levels were expanded bottom-up.
+void BenchmarkBottomUpAlphas(const GraphReader &graph,
+        const std::vector<std::pair<index_t, index_t>> &queries,
+        const std::vector<double> &alphas) {
+    std::cout << "FindShortestPath() and FindShortestPathDag() by bottom_up_alpha:\n";
+    for (double alpha : alphas) {
+        SearchOptions options = {.bottom_up_alpha = alpha};
+        SearchWorkspace workspace;
+        for (bool dag : {false, true}) {
+            LatencyRecorder recorder;
+            int64_t levels = 0, bottom_up_levels = 0;
+            for (auto [start, finish] : queries) {
+                SearchStats stats;
+                recorder.Measure([&]() {
+                    if (dag) {
+                        workspace.FindShortestPathDag(graph, start, finish, &stats, options);
+                    } else {
+                        workspace.FindShortestPath(graph, start, finish, &stats, options);
+                    }
+                });
+                for (const SearchLevel &level : stats.levels) {
+                    ++levels;
+                    bottom_up_levels += level.mode == SearchLevel::Mode::BOTTOM_UP;
+                }
+            }
+            recorder.Print(std::cout, std::string(dag ? "  dag" : "  path") + " alpha=" + std::to_string(alpha));
+            std::cout << "    " << bottom_up_levels << " of " << levels << " levels bottom-up\n";
+        }
+    }
+}
+
+// Compares the layered search (SearchOptions::layered and ShortestPathLength())
+// with the default search, and with the default search restricted to top-down
+// levels (like the layered search).
+void BenchmarkLayered(const GraphReader &graph,
+        const std::vector<std::pair<index_t, index_t>> &queries) {
+    std::cout << "Layered search:\n";
+    const std::pair<std::string, SearchOptions> configs[] = {
+        {"  FindShortestPath() default", {}},
+        {"  FindShortestPath() top-down", {.bottom_up_alpha = 0}},
+        {"  FindShortestPath() layered", {.layered = true}},
+    };
+    for (const auto &[name, options] : configs) {
+        SearchWorkspace workspace;
+        LatencyRecorder recorder;
+        for (auto [start, finish] : queries) {
+            recorder.Measure([&]() { workspace.FindShortestPath(graph, start, finish, nullptr, options); });
+        }
+        recorder.Print(std::cout, name);
+    }
+    SearchWorkspace workspace;
+    LatencyRecorder recorder;
+    for (auto [start, finish] : queries) {
+        recorder.Measure([&]() { workspace.ShortestPathLength(graph, start, finish, nullptr); });
+    }
+    recorder.Print(std::cout, "  ShortestPathLength()");
+}
+
+// Compares values of SearchOptions::prefetch_distance, with the flat visited
+// array (where misses on visited entries can be prefetched) and with the
+// default options.
+void BenchmarkPrefetchDistances(const GraphReader &graph,
+        const std::vector<std::pair<index_t, index_t>> &queries,
+        const std::vector<int> &distances) {
+    std::cout << "FindShortestPath() by prefetch_distance:\n";
+    for (int distance : distances) {
+        for (bool dense : {true, false}) {
+            SearchOptions options = {.prefetch_distance = distance};
+            if (dense) options.sparse_visited_max_fraction = 0;
+            SearchWorkspace workspace;
+            LatencyRecorder recorder;
+            for (auto [start, finish] : queries) {
+                recorder.Measure([&]() { workspace.FindShortestPath(graph, start, finish, nullptr, options); });
+            }
+            recorder.Print(std::cout, std::string(dense ? "  dense" : "  default") +
+                    " distance=" + std::to_string(distance));
+        }
+    }
+}
+
+// Measures the cost of SearchOptions::sort_fringes when the graph is in
+// memory (see BenchmarkColdCache() for when it is not).
+void BenchmarkSortFringes(const GraphReader &graph,
+        const std::vector<std::pair<index_t, index_t>> &queries) {
+    std::cout << "FindShortestPath() by sort_fringes (in memory):\n";
+    for (bool sort_fringes : {false, true}) {
+        SearchOptions options = {.sort_fringes = sort_fringes};
+        SearchWorkspace workspace;
+        LatencyRecorder recorder;
+        for (auto [start, finish] : queries) {
+            recorder.Measure([&]() { workspace.FindShortestPath(graph, start, finish, nullptr, options); });
+        }
+        recorder.Print(std::cout, sort_fringes ? "  sorted fringes" : "  discovery order");
+    }
+}
+
+// Compares values of SearchOptions::threads, with parallel_min_fringe set
+// low enough that every large level is expanded in parallel.
+void BenchmarkThreads(const GraphReader &graph,
+        const std::vector<std::pair<index_t, index_t>> &queries,
+        const std::vector<int> &thread_counts) {
+    std::cout << "FindShortestPath() and FindShortestPathDag() by threads:\n";
+    for (int threads : thread_counts) {
+        SearchOptions options = {.threads = threads, .parallel_min_fringe = 1000};
+        SearchWorkspace workspace;
+        for (bool dag : {false, true}) {
+            LatencyRecorder recorder;
+            for (auto [start, finish] : queries) {
+                recorder.Measure([&]() {
+                    if (dag) {
+                        workspace.FindShortestPathDag(graph, start, finish, nullptr, options);
+                    } else {
+                        workspace.FindShortestPath(graph, start, finish, nullptr, options);
+                    }
+                });
+            }
+            recorder.Print(std::cout, std::string(dag ? "  dag" : "  path") + " threads=" + std::to_string(threads));
+        }
+    }
+}
+
+// Measures ComputeDistances() in both directions, from the start vertices of
+// the first few queries, since each call traverses the entire graph.
+void BenchmarkComputeDistances(const GraphReader &graph,
+        const std::vector<std::pair<index_t, index_t>> &queries) {
+    std::cout << "ComputeDistances():\n";
+    const size_t count = std::min<size_t>(queries.size(), 10);
+    for (Direction direction : {Direction::FORWARD, Direction::BACKWARD}) {
+        SearchWorkspace workspace;
+        LatencyRecorder recorder;
+        for (size_t i = 0; i < count; ++i) {
+            recorder.Measure([&]() { workspace.ComputeDistances(graph, queries[i].first, direction); });
+        }
+        recorder.Print(std::cout, direction == Direction::FORWARD ? "  forward" : "  backward");
+    }
+}
+
+// Compares computing a distance matrix between the start and finish vertices
+// of the first 64 queries with ComputeDistances() from each start vertex and
+// with ComputeDistanceMatrix() at each batch width.
+void BenchmarkDistanceMatrix(const GraphReader &graph,
+        const std::vector<std::pair<index_t, index_t>> &queries) {
+    std::cout << "Distance matrix:\n";
+    std::vector<index_t> sources, targets;
+    for (size_t i = 0; i < std::min<size_t>(queries.size(), 64); ++i) {
+        sources.push_back(queries[i].first);
+        targets.push_back(queries[i].second);
+    }
+    {
+        SearchWorkspace workspace;
+        LatencyRecorder recorder;
+        recorder.Measure([&]() {
+            for (index_t source : sources) workspace.ComputeDistances(graph, source, Direction::FORWARD);
+        });
+        recorder.Print(std::cout, "  ComputeDistances() per source");
+    }
+    for (int batch_width : {64, 128, 256}) {
+        LatencyRecorder recorder;
+        recorder.Measure([&]() { ComputeDistanceMatrix(graph, sources, targets, batch_width); });
+        recorder.Print(std::cout, "  ComputeDistanceMatrix() width=" + std::to_string(batch_width));
+    }
+}
+
+// Compares the ScanNeighbors() kernels on the adjacency lists of the vertices
+// with the highest out-degree (the hubs, whose expansion dominates large
+// search levels), with about a third of all vertices already visited.
+void BenchmarkScanKernels(const GraphReader &graph) {
+    const index_t size = graph.VertexCount();
+    std::vector<index_t> hubs(size);
+    for (index_t v = 0; v < size; ++v) hubs[v] = v;
+    const size_t hub_count = std::min<size_t>(size, 100);
+    auto degree = [&graph](index_t v) { return graph.ForwardDegree(v); };
+    std::partial_sort(hubs.begin(), hubs.begin() + hub_count, hubs.end(),
+            [&](index_t v, index_t w) { return degree(v) > degree(w); });
+    hubs.resize(hub_count);
+    int64_t edges = 0;
+    for (index_t v : hubs) edges += degree(v);
+
+    std::mt19937 rng(1);
+    std::vector<index_t> initial(size);
+    for (index_t v = 1; v < size; ++v) {
+        if (rng() % 3 == 0) initial[v] = 1 + rng() % (size - 1);
+    }
+    std::vector<index_t> visited = initial;
+    std::vector<index_t> fringe;
+
+    std::cout << "ScanNeighbors() on the adjacency lists of " << hub_count << " hubs ("
+        << edges / static_cast<int64_t>(hub_count) << " edges on average):\n";
+    if (size > (index_t{1} << 31)) return;
+    for (ScanKernel kernel : {ScanKernel::SCALAR, ScanKernel::AVX2, ScanKernel::AVX512}) {
+        if (!ScanKernelSupported(kernel)) {
+            std::cout << "  " << ScanKernelName(kernel) << " not supported\n";
+            continue;
+        }
+        LatencyRecorder recorder;
+        for (int round = 0; round < 10; ++round) {
+            for (index_t v : hubs) {
+                auto neighbors = graph.ForwardEdges(v);
+                for (index_t w : neighbors) visited[w] = initial[w];
+                fringe.resize(neighbors.size());
+                recorder.Measure([&]() {
+                    ScanNeighbors(kernel, neighbors, visited.data(), v, ~(size - 1), size, fringe.data());
+                });
+            }
+        }
+        recorder.Print(std::cout, std::string("  ") + ScanKernelName(kernel) +
+                (kernel == BestScanKernel() ? " (used by searches)" : ""));
+    }
+}
+
+// Compares DistanceOracle::Distance() with FindShortestPath(), and checks that
+// they agree on the distance.
+bool BenchmarkDistanceOracle(const GraphReader &graph,
+        const std::vector<std::pair<index_t, index_t>> &queries, const char *labels) {
+    std::unique_ptr<DistanceOracle> oracle = DistanceOracle::Open(labels);
+    if (oracle == nullptr || oracle->VertexCount() != graph.VertexCount()) {
+        std::cerr << "Could not open label file [" << labels << "] for this graph\n";
+        return false;
+    }
+    std::cout << "DistanceOracle (" << oracle->Stats().file_size / 1e6 << " MB of labels):\n";
+    SearchWorkspace workspace;
+    LatencyRecorder search_recorder, oracle_recorder;
+    int mismatches = 0;
+    for (auto [start, finish] : queries) {
+        std::vector<index_t> path;
+        search_recorder.Measure([&]() { path = workspace.FindShortestPath(graph, start, finish, nullptr).value; });
+        uint8_t distance = 0;
+        oracle_recorder.Measure([&]() { distance = oracle->Distance(start, finish); });
+        if (distance != (path.empty() ? DistanceOracle::UNREACHABLE : path.size() - 1)) ++mismatches;
+    }
+    search_recorder.Print(std::cout, "  FindShortestPath()");
+    oracle_recorder.Print(std::cout, "  DistanceOracle::Distance()");
+    if (mismatches > 0) {
+        std::cerr << "DistanceOracle returned the wrong distance for " << mismatches << " queries!\n";
+        return false;
+    }
+    return true;
+}
+
+// Compares FindShortestPath() with and without SearchOptions::hub_distances,
+// and checks that they agree on the distance.
+bool BenchmarkHubDistances(const GraphReader &graph,
+        const std::vector<std::pair<index_t, index_t>> &queries, const char *filename) {
+    std::unique_ptr<HubDistances> hubs = HubDistances::Open(filename);
+    if (hubs == nullptr || hubs->VertexCount() != graph.VertexCount()) {
+        std::cerr << "Could not open hub file [" << filename << "] for this graph\n";
+        return false;
+    }
+    std::cout << "Hub distances (" << hubs->HubCount() << " hubs):\n";
+    const SearchOptions hub_options = {.hub_distances = hubs.get()};
+    SearchWorkspace workspace;
+    LatencyRecorder search_recorder, hub_recorder;
+    int64_t search_reached = 0, hub_reached = 0;
+    int mismatches = 0;
+    for (auto [start, finish] : queries) {
+        SearchStats stats;
+        std::vector<index_t> path, hub_path;
+        search_recorder.Measure([&]() { path = workspace.FindShortestPath(graph, start, finish, &stats).value; });
+        search_reached += stats.vertices_reached;
+        hub_recorder.Measure([&]() { hub_path = workspace.FindShortestPath(graph, start, finish, &stats, hub_options).value; });
+        hub_reached += stats.vertices_reached;
+        if (path.size() != hub_path.size()) ++mismatches;
+    }
+    search_recorder.Print(std::cout, "  FindShortestPath()");
+    hub_recorder.Print(std::cout, "  FindShortestPath() with hubs");
+    std::cout << "  average vertices reached: " << search_reached / static_cast<int64_t>(queries.size())
+        << " without hubs, " << hub_reached / static_cast<int64_t>(queries.size()) << " with hubs\n";
+    if (mismatches > 0) {
+        std::cerr << "Search with hub distances returned the wrong distance for " << mismatches << " queries!\n";
+        return false;
+    }
+    return true;
+}
+
+// Compares searches using a temporary workspace (as the free functions do)
+// with searches that reuse a single SearchWorkspace.
+void BenchmarkWorkspaceReuse(const GraphReader &graph,
+        const std::vector<std::pair<index_t, index_t>> &queries) {
+    std::cout << "Temporary vs. reused SearchWorkspace:\n";
+    {
+        LatencyRecorder recorder;
+        for (auto [start, finish] : queries) {
+            recorder.Measure([&]() { FindShortestPath(graph, start, finish, nullptr); });
+        }
+        recorder.Print(std::cout, "  path, temporary");
+    }
+    {
+        SearchWorkspace workspace;
+        LatencyRecorder recorder;
+        for (auto [start, finish] : queries) {
+            recorder.Measure([&]() { workspace.FindShortestPath(graph, start, finish, nullptr); });
+        }
+        recorder.Print(std::cout, "  path, reused");
+    }
+    {
+        LatencyRecorder recorder;
+        for (auto [start, finish] : queries) {
+            recorder.Measure([&]() { FindShortestPathDag(graph, start, finish, nullptr); });
+        }
+        recorder.Print(std::cout, "  dag, temporary");
+    }
+    {
+        SearchWorkspace workspace;
+        LatencyRecorder recorder;
+        for (auto [start, finish] : queries) {
+            recorder.Measure([&]() { workspace.FindShortestPathDag(graph, start, finish, nullptr); });
+        }
+        recorder.Print(std::cout, "  dag, reused");
+    }
+}
+
+// Compares the throughput of running all queries one after another with a
+// reused SearchWorkspace and with FindShortestPaths() at each interleave.
+void BenchmarkBatchSearch(const GraphReader &graph,
+        const std::vector<std::pair<index_t, index_t>> &queries) {
+    std::cout << "Sequential FindShortestPath() vs. FindShortestPaths():\n";
+    auto print = [&](const std::string &label, auto duration) {
+        double seconds = std::chrono::duration<double>(duration).count();
+        std::cout << std::left << std::setw(32) << label << std::right << std::fixed << std::setprecision(1)
+            << " " << std::setw(10) << queries.size() / seconds << " queries/s\n";
+    };
+    {
+        SearchWorkspace workspace;
+        auto start_time = std::chrono::steady_clock::now();
+        for (auto [start, finish] : queries) workspace.FindShortestPath(graph, start, finish, nullptr);
+        print("  sequential", std::chrono::steady_clock::now() - start_time);
+    }
+    {
+        // The search that FindShortestPaths() interleaves: top-down levels
+        // with a sparse visited map.
+        SearchWorkspace workspace;
+        const SearchOptions options = {.sparse_visited_max_fraction = 1, .bottom_up_alpha = 0};
+        auto start_time = std::chrono::steady_clock::now();
+        for (auto [start, finish] : queries) workspace.FindShortestPath(graph, start, finish, nullptr, options);
+        print("  sequential top-down", std::chrono::steady_clock::now() - start_time);
+    }
+    for (int interleave : {1, 4, 8, 16, 32}) {
+        auto start_time = std::chrono::steady_clock::now();
+        FindShortestPaths(graph, queries, {.interleave = interleave});
+        print("  batch interleave=" + std::to_string(interleave), std::chrono::steady_clock::now() - start_time);
+    }
+}
+
+// Returns the resident set size of the process in bytes, or -1 if unknown.
+int64_t ResidentBytes() {
+    std::ifstream statm("/proc/self/statm");
+    int64_t size = 0, resident = 0;
+    if (!(statm >> size >> resident)) return -1;
+    return resident * sysconf(_SC_PAGESIZE);
+}
+
+// Writes the graph in the uncompressed and the compressed format to a
+// temporary file, and for each, measures the memory that becomes resident when
+// the whole file is mapped (as with --mlock in the servers), and the latency
+// of the queries on it.
+bool BenchmarkGraphFormats(const GraphReader &graph,
+        const std::vector<std::pair<index_t, index_t>> &queries) {
+    std::cout << "Uncompressed vs. compressed graph format:\n";
+    const std::string filename = (std::filesystem::temp_directory_path() /
+            ("wikipath-benchmark-" + std::to_string(getpid()) + "-format.graph")).string();
+    auto outlinks = [&graph](index_t v) { return graph.ForwardEdges(v); };
+    auto inlinks = [&graph](index_t v) { return graph.BackwardEdges(v); };
+    for (bool compressed : {false, true}) {
+        const std::string name = compressed ? "compressed" : "uncompressed";
+        bool written = compressed
+            ? WriteCompressedGraphOutput(filename.c_str(), graph.VertexCount(), outlinks, inlinks)
+            : WriteGraphOutput(filename.c_str(), graph.VertexCount(), outlinks, inlinks);
+        if (!written) {
+            std::cerr << "Could not write " << name << " graph to [" << filename << "]\n";
+            std::filesystem::remove(filename);
+            return false;
+        }
+        const int64_t file_size = std::filesystem::file_size(filename);
+        const int64_t resident_before = ResidentBytes();
+        std::unique_ptr<GraphReader> copy = GraphReader::Open(filename.c_str(),
+                {.mlock = GraphReader::OpenOptions::MLock::POPULATE});
+        const int64_t resident_after = ResidentBytes();
+        std::filesystem::remove(filename);
+        if (copy == nullptr) {
+            std::cerr << "Could not open " << name << " graph\n";
+            return false;
+        }
+        std::cout << "  " << name << ": " << file_size / 1e6 << " MB file, "
+            << (resident_after - resident_before) / 1e6 << " MB resident\n";
+
+        SearchWorkspace workspace;
+        for (auto [start, finish] : queries) workspace.FindShortestPath(*copy, start, finish, nullptr);
+        LatencyRecorder path_recorder, dag_recorder;
+        for (auto [start, finish] : queries) {
+            path_recorder.Measure([&]() { workspace.FindShortestPath(*copy, start, finish, nullptr); });
+            dag_recorder.Measure([&]() { workspace.FindShortestPathDag(*copy, start, finish, nullptr); });
+        }
+        path_recorder.Print(std::cout, "  path, " + name);
+        dag_recorder.Print(std::cout, "  dag, " + name);
+    }
+    return true;
+}
+
+// Counts a hardware event of the calling thread with perf_event_open(), if the
+// kernel and hardware support it.
+class PerfCounter {
+public:
+    static PerfCounter CacheMisses() {
+        return PerfCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+    }
+
+    // Misses of the data TLB on loads.
+    static PerfCounter DtlbMisses() {
+        return PerfCounter(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_DTLB |
+                (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+    }
+
+    PerfCounter(PerfCounter &&other) : fd(other.fd) { other.fd = -1; }
+    PerfCounter(const PerfCounter&) = delete;
+    PerfCounter &operator=(const PerfCounter&) = delete;
+
+    ~PerfCounter() {
+        if (fd >= 0) close(fd);
+    }
+
+    bool Available() const { return fd >= 0; }
+
+    void Start() {
+        if (fd < 0) return;
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+
+    // Returns the number of events since Start(), or -1 if not available.
+    int64_t Stop() {
+        int64_t count = -1;
+        if (fd < 0) return count;
+        ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        if (read(fd, &count, sizeof(count)) != sizeof(count)) count = -1;
+        return count;
+    }
+
+private:
+    PerfCounter(uint32_t type, uint64_t config) {
+        perf_event_attr attr = {};
+        attr.type = type;
+        attr.size = sizeof(attr);
+        attr.config = config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    }
+
+    int fd = -1;
+};
+
+// Renumbers the graph in each of the given orders (and in the original order,
+// for reference), writes it to a temporary file in the same format as `graph`,
+// and measures on it:
+//
+//  - the size of the graph in the compressed format, since gaps between
+//    neighbor ids get smaller when linked vertices get nearby ids;
+//  - the latency of the queries (with their vertices renumbered), and the
+//    cache misses they cause, with the graph in memory;
+//  - the minor page faults per query when each query maps the graph afresh,
+//    which counts the distinct pages of the graph file that a search touches.
+bool BenchmarkVertexOrders(const GraphReader &graph,
+        const std::vector<std::pair<index_t, index_t>> &queries,
+        const std::vector<VertexOrder> &orders) {
+    std::cout << "FindShortestPath() by vertex order:\n";
+    const std::string filename = (std::filesystem::temp_directory_path() /
+            ("wikipath-benchmark-" + std::to_string(getpid()) + "-order.graph")).string();
+    std::vector<std::optional<VertexOrder>> configs = {std::nullopt};
+    configs.insert(configs.end(), orders.begin(), orders.end());
+    PerfCounter cache_misses = PerfCounter::CacheMisses();
+    for (const std::optional<VertexOrder> &order : configs) {
+        const std::string name = order ? VertexOrderName(*order) : "original";
+        std::vector<index_t> new_id(graph.VertexCount());
+        auto start_time = std::chrono::steady_clock::now();
+        if (order) {
+            new_id = ComputeVertexOrder(graph, *order);
+        } else {
+            std::iota(new_id.begin(), new_id.end(), 0);
+        }
+        auto order_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time);
+
+        auto [outlinks, inlinks] = RenumberedAdjacency(graph, new_id);
+        if (!WriteCompressedGraphOutput(filename.c_str(), graph.VertexCount(), outlinks, inlinks)) {
+            std::cerr << "Could not write " << name << " graph to [" << filename << "]\n";
+            std::filesystem::remove(filename);
+            return false;
+        }
+        const int64_t compressed_size = std::filesystem::file_size(filename);
+        if (!graph.Compressed() &&
+                !WriteGraphOutput(filename.c_str(), graph.VertexCount(), outlinks, inlinks)) {
+            std::cerr << "Could not write " << name << " graph to [" << filename << "]\n";
+            std::filesystem::remove(filename);
+            return false;
+        }
+        std::vector<std::pair<index_t, index_t>> renumbered;
+        for (auto [start, finish] : queries) renumbered.emplace_back(new_id[start], new_id[finish]);
+
+        // Latency and cache misses, with the graph in memory. This also warms
+        // up the workspace, which is reused below so that its arrays do not
+        // fault.
+        std::unique_ptr<GraphReader> copy = GraphReader::Open(filename.c_str(),
+                {.mlock = GraphReader::OpenOptions::MLock::POPULATE});
+        if (copy == nullptr) {
+            std::cerr << "Could not open " << name << " graph\n";
+            std::filesystem::remove(filename);
+            return false;
+        }
+        SearchWorkspace workspace;
+        for (auto [start, finish] : renumbered) workspace.FindShortestPath(*copy, start, finish, nullptr);
+        LatencyRecorder recorder;
+        cache_misses.Start();
+        for (auto [start, finish] : renumbered) {
+            recorder.Measure([&]() { workspace.FindShortestPath(*copy, start, finish, nullptr); });
+        }
+        const int64_t misses = cache_misses.Stop();
+        copy.reset();
+
+        // Page faults, with the graph mapped afresh for each query (the file
+        // stays in the page cache, so these are minor faults).
+        int64_t minor_faults = 0;
+        for (auto [start, finish] : renumbered) {
+            copy = GraphReader::Open(filename.c_str(), {});
+            if (copy == nullptr) break;
+            SearchStats stats;
+            workspace.FindShortestPath(*copy, start, finish, &stats);
+            minor_faults += stats.minor_faults;
+        }
+        std::filesystem::remove(filename);
+        if (copy == nullptr) {
+            std::cerr << "Could not open " << name << " graph\n";
+            return false;
+        }
+
+        recorder.Print(std::cout, "  " + name);
+        std::cout << "    order computed in " << order_s.count() << " s, "
+            << compressed_size / 1e6 << " MB compressed\n"
+            << "    " << static_cast<double>(minor_faults) / renumbered.size() << " page faults per query (cold mapping)\n"
+            << "    ";
+        if (misses >= 0) {
+            std::cout << static_cast<double>(misses) / renumbered.size() << " cache misses per query\n";
+        } else {
+            std::cout << "cache misses not available (perf_event_open failed)\n";
+        }
+    }
+    return true;
+}
+
+// Evicts the file from the page cache, so that it is read from disk when it
+// is accessed next. Returns false on failure.
+bool EvictFromPageCache(const std::string &filename) {
+    int fd = open(filename.c_str(), O_RDONLY);
+    bool success = fd >= 0 && fdatasync(fd) == 0 && posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) == 0;
+    if (!success) std::cerr << "Could not evict [" << filename << "] from the page cache\n";
+    if (fd >= 0) close(fd);
+    return success;
+}
+
+// Writes `graph` to a temporary file in the same format, and returns the
+// filename, or an empty string on failure.
+std::string WriteTemporaryCopy(const GraphReader &graph, const std::string &suffix) {
+    const std::string filename = (std::filesystem::temp_directory_path() /
+            ("wikipath-benchmark-" + std::to_string(getpid()) + suffix)).string();
+    auto outlinks = [&graph](index_t v) { return graph.ForwardEdges(v); };
+    auto inlinks = [&graph](index_t v) { return graph.BackwardEdges(v); };
+    bool written = graph.Compressed()
+        ? WriteCompressedGraphOutput(filename.c_str(), graph.VertexCount(), outlinks, inlinks)
+        : WriteGraphOutput(filename.c_str(), graph.VertexCount(), outlinks, inlinks);
+    if (!written) {
+        std::cerr << "Could not write graph to [" << filename << "]\n";
+        std::filesystem::remove(filename);
+        return "";
+    }
+    return filename;
+}
+
+const char *HugePagesName(GraphReader::OpenOptions::HugePages huge_pages) {
+    switch (huge_pages) {
+        case GraphReader::OpenOptions::HugePages::NONE: return "none";
+        case GraphReader::OpenOptions::HugePages::FILE: return "file";
+        case GraphReader::OpenOptions::HugePages::TRANSPARENT: return "transparent";
+        case GraphReader::OpenOptions::HugePages::HUGETLB: return "hugetlb";
+    }
+    return "unknown";
+}
+
+// Writes the graph to a temporary file in the same format, and opens it with
+// each GraphReader::OpenOptions::HugePages mode and MLock::POPULATE, to
+// measure how much of it gets huge pages, and the latency and dTLB misses of
+// the queries. Before each open, the file is evicted from the page cache, so
+// that HugePages::FILE can read it into large folios.
+bool BenchmarkHugePages(const GraphReader &graph,
+        const std::vector<std::pair<index_t, index_t>> &queries) {
+    using HugePages = GraphReader::OpenOptions::HugePages;
+    std::cout << "FindShortestPath() by huge pages mode:\n";
+    const std::string filename = WriteTemporaryCopy(graph, "-huge.graph");
+    if (filename.empty()) return false;
+    PerfCounter dtlb_misses = PerfCounter::DtlbMisses();
+    for (HugePages huge_pages : {HugePages::NONE, HugePages::FILE, HugePages::TRANSPARENT, HugePages::HUGETLB}) {
+        if (!EvictFromPageCache(filename)) {
+            std::filesystem::remove(filename);
+            return false;
+        }
+
+        auto start_time = std::chrono::steady_clock::now();
+        std::unique_ptr<GraphReader> copy = GraphReader::Open(filename.c_str(), {
+                .mlock = GraphReader::OpenOptions::MLock::POPULATE, .huge_pages = huge_pages});
+        auto open_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time);
+        if (copy == nullptr) {
+            std::cerr << "Could not open graph with huge_pages=" << HugePagesName(huge_pages) << "\n";
+            std::filesystem::remove(filename);
+            return false;
+        }
+
+        SearchWorkspace workspace;
+        for (auto [start, finish] : queries) workspace.FindShortestPath(*copy, start, finish, nullptr);
+        LatencyRecorder recorder;
+        dtlb_misses.Start();
+        for (auto [start, finish] : queries) {
+            recorder.Measure([&]() { workspace.FindShortestPath(*copy, start, finish, nullptr); });
+        }
+        const int64_t misses = dtlb_misses.Stop();
+
+        recorder.Print(std::cout, std::string("  ") + HugePagesName(huge_pages));
+        std::cout << "    opened in " << open_s.count() << " s as " << HugePagesName(copy->HugePagesMode())
+            << ", " << (copy->HugePageBytes() >> 20) << " MB in huge pages\n    ";
+        if (misses >= 0) {
+            std::cout << static_cast<double>(misses) / queries.size() << " dTLB load misses per query\n";
+        } else {
+            std::cout << "dTLB misses not available (perf_event_open failed)\n";
+        }
+    }
+    std::filesystem::remove(filename);
+    return true;
+}
+
+// Measures how long it takes to load the graph into memory from a cold page
+// cache with MLock::BACKGROUND (a single mlock() call) and with
+// MLock::PARALLEL with each number of threads, by polling GetLoadStatus().
+bool BenchmarkWarmUp(const GraphReader &graph, const std::vector<int> &thread_counts) {
+    using MLock = GraphReader::OpenOptions::MLock;
+    std::cout << "Loading the graph from a cold page cache:\n";
+    const std::string filename = WriteTemporaryCopy(graph, "-warm-up.graph");
+    if (filename.empty()) return false;
+    std::vector<std::pair<std::string, GraphReader::OpenOptions>> configs = {
+        {"BACKGROUND", {.mlock = MLock::BACKGROUND}},
+    };
+    for (int threads : thread_counts) {
+        configs.push_back({"PARALLEL threads=" + std::to_string(threads),
+                {.mlock = MLock::PARALLEL, .warm_up_threads = threads}});
+    }
+    for (const auto &[name, options] : configs) {
+        if (!EvictFromPageCache(filename)) {
+            std::filesystem::remove(filename);
+            return false;
+        }
+        std::unique_ptr<GraphReader> copy = GraphReader::Open(filename.c_str(), options);
+        if (copy == nullptr) {
+            std::cerr << "Could not open graph with " << name << "\n";
+            std::filesystem::remove(filename);
+            return false;
+        }
+        GraphReader::LoadStatus status;
+        while ((status = copy->GetLoadStatus()).state == GraphReader::LoadStatus::State::IN_PROGRESS) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        std::cout << "  " << std::left << std::setw(30) << name << std::right << std::fixed << std::setprecision(3)
+            << " " << std::setw(8) << status.elapsed_s << " s " << std::setprecision(1)
+            << std::setw(8) << status.bytes_total / 1e6 / status.elapsed_s << " MB/s"
+            << (status.state == GraphReader::LoadStatus::State::COMPLETED ? "" : " (failed)") << "\n";
+    }
+    std::filesystem::remove(filename);
+    return true;
+}
+
+// Runs the queries on a thread pinned to each NUMA node, on the file mapping
+// and on the graph copied to each node with OpenOptions::numa_replicas. The
+// file is loaded into the page cache from the first node, so that the mapping
+// is local to that node only. On a machine with a single node, the copy is
+// made anyway, which only shows its cost.
+bool BenchmarkNumaReplicas(const GraphReader &graph,
+        const std::vector<std::pair<index_t, index_t>> &queries) {
+    std::cout << "FindShortestPath() by NUMA node:\n";
+    std::vector<int> nodes;
+    for (int node : OnlineNumaNodes()) {
+        if (!NumaNodeCpus(node).empty()) nodes.push_back(node);  // skip memory-only nodes
+    }
+    const std::string filename = WriteTemporaryCopy(graph, "-numa.graph");
+    if (filename.empty()) return false;
+    if (nodes.empty() || !EvictFromPageCache(filename)) {
+        std::filesystem::remove(filename);
+        return false;
+    }
+
+    std::unique_ptr<GraphReader> mapped, replicated;
+    double copy_s = 0;
+    std::thread([&]() {
+        PinThreadToNumaNode(nodes.front());
+        mapped = GraphReader::Open(filename.c_str(), {.mlock = GraphReader::OpenOptions::MLock::POPULATE});
+        auto start_time = std::chrono::steady_clock::now();
+        replicated = GraphReader::Open(filename.c_str(), {.numa_replicas = true, .numa_nodes = nodes});
+        copy_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+    }).join();
+    std::filesystem::remove(filename);
+    if (mapped == nullptr || replicated == nullptr) {
+        std::cerr << "Could not open graph with NUMA replicas\n";
+        return false;
+    }
+    std::cout << "  copied to " << replicated->NumaReplicaNodes().size() << " of " << nodes.size()
+        << " nodes in " << std::setprecision(3) << copy_s << " s\n";
+
+    const std::pair<std::string, const GraphReader*> configs[] = {
+        {"file mapping", mapped.get()},
+        {"replicas", replicated.get()},
+    };
+    for (int node : nodes) {
+        for (const auto &[name, copy] : configs) {
+            LatencyRecorder recorder;
+            std::thread([&]() {
+                if (!PinThreadToNumaNode(node)) std::cerr << "Could not pin thread to NUMA node " << node << "\n";
+                SearchWorkspace workspace;
+                for (auto [start, finish] : queries) workspace.FindShortestPath(*copy, start, finish, nullptr);
+                for (auto [start, finish] : queries) {
+                    recorder.Measure([&]() { workspace.FindShortestPath(*copy, start, finish, nullptr); });
+                }
+            }).join();
+            recorder.Print(std::cout, "  node " + std::to_string(node) + ", " + name);
+        }
+    }
+    return true;
+}
+
+// Runs each query with and without SearchOptions::sort_fringes on a graph
+// that is not in memory: before each search, the file is evicted from the
+// page cache with posix_fadvise(), and opened again (without mlock), so that
+// every edge list is read from disk on first access.
+bool BenchmarkColdCache(const char *filename,
+        const std::vector<std::pair<index_t, index_t>> &queries, int count) {
+    std::cout << "FindShortestPath() with a cold page cache:\n";
+    const std::pair<std::string, SearchOptions> configs[] = {
+        {"  discovery order", {}},
+        {"  sorted fringes", {.sort_fringes = true}},
+    };
+    LatencyRecorder recorders[std::size(configs)];
+    int64_t major_faults[std::size(configs)] = {};
+    for (size_t i = 0; i < std::min<size_t>(queries.size(), count); ++i) {
+        for (size_t j = 0; j < std::size(configs); ++j) {
+            if (!EvictFromPageCache(filename)) return false;
+            std::unique_ptr<GraphReader> graph = GraphReader::Open(filename, {});
+            if (graph == nullptr) return false;
+            SearchStats stats;
+            recorders[j].Measure([&]() {
+                FindShortestPath(*graph, queries[i].first, queries[i].second, &stats, configs[j].second);
+            });
+            major_faults[j] += stats.major_faults;
+        }
+    }
+    for (size_t j = 0; j < std::size(configs); ++j) {
+        recorders[j].Print(std::cout, configs[j].first);
+        std::cout << "    " << major_faults[j] << " major page faults\n";
+    }
+    return true;
+}
+
+bool Main(const Options &options) {
+    GraphReader::OpenOptions open_options;
+    if (options.mlock) open_options.mlock = GraphReader::OpenOptions::MLock::FOREGROUND;
+    std::unique_ptr<GraphReader> graph = OpenBenchmarkGraph(options.graph, open_options);
+    if (graph == nullptr) return false;
+
+    auto queries = RandomQueries(*graph, options.queries, options.seed);
+
+    if (options.cold_queries > 0) {
+        if (std::string_view(options.graph).starts_with("synthetic:")) {
+            std::cerr << "--cold requires a graph file\n";
+            return false;
+        }
+        // Pages mapped by `graph` would not be evicted.
+        graph.reset();
+        return BenchmarkColdCache(options.graph, queries, options.cold_queries);
+    }
+
+    // Warm up: run all queries once, so that the benchmarks below measure
+    // in-memory performance, and report the size of the searches.
+    int64_t total_reached = 0, total_length = 0, paths_found = 0;
+    for (auto [start, finish] : queries) {
+        SearchStats stats;
+        auto path = FindShortestPath(*graph, start, finish, &stats).value;
+        total_reached += stats.vertices_reached;
+        if (!path.empty()) {
+            ++paths_found;
+            total_length += path.size() - 1;
+        }
+    }
+    std::cout << "Graph: " << graph->VertexCount() << " vertices, " << graph->EdgeCount() << " edges"
+        << (graph->Compressed() ? " (compressed)" : "") << "\n"
+        << "Queries: " << queries.size() << " (" << paths_found << " with a path, average length "
+        << (paths_found ? static_cast<double>(total_length) / paths_found : 0.0) << ")\n"
+        << "Average vertices reached: " << total_reached / static_cast<int64_t>(queries.size()) << "\n\n";
+
+    BenchmarkSparseFractions(*graph, queries, options.sparse_fractions);
+    std::cout << '\n';
+    BenchmarkWorkspaceReuse(*graph, queries);
+    std::cout << '\n';
+    BenchmarkBottomUpAlphas(*graph, queries, options.bottom_up_alphas);
+    std::cout << '\n';
+    BenchmarkLayered(*graph, queries);
+    std::cout << '\n';
+    BenchmarkPrefetchDistances(*graph, queries, options.prefetch_distances);
+    std::cout << '\n';
+    BenchmarkSortFringes(*graph, queries);
+    std::cout << '\n';
+    BenchmarkThreads(*graph, queries, options.threads);
+    std::cout << '\n';
+    BenchmarkBatchSearch(*graph, queries);
+    std::cout << '\n';
+    BenchmarkScanKernels(*graph);
+    std::cout << '\n';
+    BenchmarkComputeDistances(*graph, queries);
+    std::cout << '\n';
+    BenchmarkDistanceMatrix(*graph, queries);
+    if (options.labels != nullptr) {
+        std::cout << '\n';
+        if (!BenchmarkDistanceOracle(*graph, queries, options.labels)) return false;
+    }
+    if (options.hubs != nullptr) {
+        std::cout << '\n';
+        if (!BenchmarkHubDistances(*graph, queries, options.hubs)) return false;
+    }
+    if (options.formats) {
+        std::cout << '\n';
+        if (!BenchmarkGraphFormats(*graph, queries)) return false;
+    }
+    if (!options.orders.empty()) {
+        std::cout << '\n';
+        if (!BenchmarkVertexOrders(*graph, queries, options.orders)) return false;
+    }
+    if (options.huge_pages) {
+        std::cout << '\n';
+        if (!BenchmarkHugePages(*graph, queries)) return false;
+    }
+    if (!options.warm_up_threads.empty()) {
+        std::cout << '\n';
+        if (!BenchmarkWarmUp(*graph, options.warm_up_threads)) return false;
+    }
+    if (options.numa) {
+        std::cout << '\n';
+        if (!BenchmarkNumaReplicas(*graph, queries)) return false;
+    }
+    return true;
+}
+
+}  // namespace
+
+// Benchmarks the search algorithms on a real or synthetic graph.
+int main(int argc, char *argv[]) {
+    Options options;
+    if (!options.Parse(argc, argv)) {
+        PrintUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    return Main(options) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -94,6 +94,18 @@ private:
         return path_count;
     }
 
+    // Returns the number of paths from this page to `finish`, when this page is
+    // reached after `depth` edges, counting only paths with at most
+    // `max_length` edges in total (or all paths, if `max_length` is negative).
+    int64_t PathCount(const AnnotatedPage *finish, int max_length, size_t depth) const {
+        if (max_length < 0) return PathCount(finish);
+        return BoundedPathCount(finish, max_length - static_cast<int64_t>(depth));
+    }
+
+    // Returns the number of paths from this page to `finish` with at most
+    // `max_edges` edges.
+    int64_t BoundedPathCount(const AnnotatedPage *finish, int64_t max_edges) const;
+
     static int64_t CalculatePathCount(const AnnotatedPage *page, const AnnotatedPage *finish);
     static void SortLinks(std::vector<AnnotatedLink> &links, LinkOrder order);
 
@@ -104,6 +116,7 @@ private:
     mutable std::variant<const Reader*, std::string> reader_or_title;
     mutable std::vector<AnnotatedLink> links;
     mutable int64_t path_count = -1;
+    mutable std::vector<int64_t> bounded_path_counts;  // indexed by max_edges; -1 if unknown
     mutable LinkOrder links_order = LinkOrder::ID;
 };
 
@@ -117,16 +130,22 @@ private:
 //   - efficient enumeration of paths starting at an arbitrary offset
 //   - efficient enumeration of paths in lexicographical order
 //
+// Paths end when they reach Finish(). If a maximum length is given, the edges
+// may also form cycles (like the graphs produced by FindNearShortestPaths()),
+// and the "paths" are all walks from Start() to Finish() with at most that
+// many edges, which may visit a page more than once.
 class AnnotatedDag {
 public:
     // Constructs an AnnotatedDag using the given reader from an edge list that
-    // describes the page indices.
+    // describes the page indices. If `max_length` is not negative, only paths
+    // of at most `max_length` edges are counted and enumerated.
     //
     // Stores a copy of `reader` but does not take ownership! The caller must
     // ensure the reader instance stays valid for the lifetime of the AnnotatedDag.
     AnnotatedDag(
             const Reader *reader, index_t start_id, index_t finish_id,
-            const std::vector<std::pair<index_t, index_t>> &edge_list);
+            const std::vector<std::pair<index_t, index_t>> &edge_list,
+            int max_length = -1);
 
     // Movable but not copyable.
     AnnotatedDag(const AnnotatedDag&) = delete;
@@ -137,6 +156,9 @@ public:
     const AnnotatedPage *Start() const { return start; }
     const AnnotatedPage *Finish() const { return finish; }
 
+    // Maximum length of paths, or -1 if unbounded.
+    int MaxLength() const { return max_length; }
+
     // Returns a count of the number of paths from Start() to Finish(), without
     // explicitly enumerating all possible paths.
     int64_t CountPaths() const;
@@ -169,6 +191,7 @@ private:
         enumerate_paths_callback_t callback;
         int64_t offset;
         LinkOrder order;
+        int max_length;
         std::vector<const AnnotatedLink*> links;
 
         bool EnumeratePaths(const AnnotatedPage *page);
@@ -177,6 +200,7 @@ private:
     const Reader *reader;
     const AnnotatedPage *start;
     const AnnotatedPage *finish;
+    int max_length;
     std::vector<AnnotatedPage> pages;
 };
 
@@ -216,7 +240,7 @@ public:
 
     // Create a PathEnumerator that skips the first `skip` paths.
     PathEnumerator(const AnnotatedDag &dag, int64_t skip = 0, LinkOrder order = DEFAULT_LINK_ORDER)
-        : finish(dag.Finish()), order(order) {
+        : finish(dag.Finish()), order(order), max_length(dag.MaxLength()) {
         const AnnotatedPage *start = dag.Start();
         has_path = start == finish ? skip == 0 : FindPathToFinish(start, skip);
     }
@@ -240,6 +264,7 @@ private:
     bool has_path;
     const AnnotatedPage *finish;
     LinkOrder order;
+    int max_length;
     std::vector<const AnnotatedLink*> path;
     std::vector<const AnnotatedLink*> stack;
 };
@@ -0,0 +1,54 @@
+#ifndef WIKIPATH_BATCH_SEARCH_H_INCLUDED
+#define WIKIPATH_BATCH_SEARCH_H_INCLUDED
+
+#include "common.h"
+#include "graph-reader.h"
+
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace wikipath {
+
+struct BatchSearchOptions {
+    // Number of queries that are interleaved on the calling thread. 1 runs the
+    // queries one after another.
+    int interleave = 4;
+};
+
+// Finds a shortest path for each (start, finish) pair in `queries`, and
+// returns them in the same order. Like FindShortestPath(), a path is empty if
+// the finish is unreachable from the start.
+//
+// The queries run as C++20 coroutines, `options.interleave` at a time, on the
+// calling thread ("interleaved execution", Kocberber et al., 2015). Whenever a
+// search is about to access memory that is likely not in cache (the edge index,
+// the edge list or the visited entries of the first neighbors of the next
+// vertex), it prefetches that memory and suspends, and the next search
+// resumes. The cache misses of different queries therefore overlap, which
+// increases the throughput per core when the graph does not fit in cache, at
+// the cost of a few nanoseconds per suspension.
+//
+// Each search is the top-down bidirectional breadth-first search that
+// FindShortestPath() starts with, which stores visited vertices in a hash
+// table, so memory use is proportional to the number of vertices visited by
+// the searches in flight. It does not use SearchOptions: there are no
+// bottom-up or parallel levels, which makes this slower than
+// FindShortestPath() for queries that visit a large part of the graph. The paths have the same length as those of FindShortestPath(), but
+// may be different paths.
+//
+// This is experimental, and not exposed in the Python module: on a machine
+// with a 300 MB L3 cache, interleaving is only up to 10% faster than the same
+// top-down search run sequentially, and on graphs that do not fit in cache,
+// FindShortestPath() with the default SearchOptions is about twice as fast
+// (see BenchmarkBatchSearch() in search-benchmark). Use FindShortestPath()
+// with a SearchWorkspace unless search-benchmark shows a gain on the target
+// machine.
+std::vector<std::vector<index_t>> FindShortestPaths(
+        const GraphReader &graph,
+        std::span<const std::pair<index_t, index_t>> queries,
+        const BatchSearchOptions &options = {});
+
+}  // namespace wikipath
+
+#endif  // ndef WIKIPATH_BATCH_SEARCH_H_INCLUDED
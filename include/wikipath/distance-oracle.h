@@ -0,0 +1,116 @@
+#ifndef WIKIPATH_DISTANCE_ORACLE_H_INCLUDED
+#define WIKIPATH_DISTANCE_ORACLE_H_INCLUDED
+
+#include "common.h"
+#include "graph-reader.h"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+namespace wikipath {
+
+// Size of a set of distance labels, as reported by BuildDistanceLabels().
+struct DistanceLabelStats {
+    // Number of hubs (vertices) whose searches have completed.
+    index_t hubs_processed = 0;
+
+    // Total number of entries in the out-labels and in-labels of all vertices.
+    int64_t out_entries = 0;
+    int64_t in_entries = 0;
+
+    // Size of the label file in bytes, which is also the amount of memory
+    // needed to keep it resident.
+    int64_t file_size = 0;
+};
+
+struct DistanceLabelOptions {
+    // Number of threads used to build the labels. 0 means one thread per core.
+    int threads = 1;
+
+    // If set, called about once per second during the build (and once when it
+    // completes) with the size of the labels built so far.
+    std::function<void(const DistanceLabelStats&)> progress;
+};
+
+// Computes 2-hop distance labels for the graph with pruned landmark labeling
+// (Akiba et al., "Fast Exact Shortest-Path Distance Queries on Large Networks
+// by Pruned Landmark Labeling", 2013) and writes them to `filename`, to be
+// opened with DistanceOracle::Open().
+//
+// Every vertex v gets an out-label containing pairs (h, d(v, h)) and an
+// in-label containing pairs (h, d(h, v)), such that for every pair of vertices
+// (s, t) where t is reachable from s, some hub h on a shortest path from s to
+// t occurs in both the out-label of s and the in-label of t. Hubs are
+// processed in order of decreasing degree; a breadth-first search from each
+// hub is pruned at vertices whose distance is already covered by the labels
+// of earlier hubs, so most searches visit only a small part of the graph.
+//
+// With multiple threads, hubs are processed in batches, where each search
+// only prunes against labels from earlier batches. This produces somewhat
+// larger labels than a single thread does, but the results are still exact.
+//
+// Returns false if the file could not be written. If `stats` is not null,
+// the final size of the labels is stored there.
+bool BuildDistanceLabels(
+        const GraphReader &graph, const char *filename,
+        const DistanceLabelOptions &options = {},
+        DistanceLabelStats *stats = nullptr);
+
+// Answers distance queries using the labels written by BuildDistanceLabels().
+// The label file is mapped into memory, so opening it is fast, but the first
+// queries may be slow while pages are loaded. This class is thread-safe.
+//
+// Note: as with GraphReader, the label data is not validated. The label file
+// must have been built from the same graph that is used for searching.
+class DistanceOracle {
+public:
+    // Distance value when the finish vertex is unreachable from the start.
+    // Same as Distances::UNREACHABLE.
+    static constexpr uint8_t UNREACHABLE = 255;
+
+    ~DistanceOracle();
+
+    DistanceOracle(const DistanceOracle&) = delete;
+    DistanceOracle &operator=(const DistanceOracle&) = delete;
+
+    // Returns nullptr if the file could not be opened or is not a label file.
+    static std::unique_ptr<DistanceOracle> Open(const char *filename);
+
+    // Returns the length of a shortest path from `start` to `finish`, or
+    // UNREACHABLE if there is none. This takes time linear in the sizes of the
+    // out-label of `start` and the in-label of `finish`.
+    //
+    // Precondition: start and finish are between 0 and VertexCount() (exclusive)
+    uint8_t Distance(index_t start, index_t finish) const;
+
+    // Number of vertices, including 0. Should match GraphReader::VertexCount().
+    index_t VertexCount() const { return vertex_count; }
+
+    // Returns the size of the labels.
+    DistanceLabelStats Stats() const;
+
+private:
+    DistanceOracle(void *data, size_t data_len);
+
+    // Labels of all vertices in one direction. The label of vertex v consists
+    // of hubs[index[v]..index[v + 1]) and distances[index[v]..index[v + 1]),
+    // sorted by hub rank.
+    struct labels_t {
+        const uint64_t *index;
+        const uint32_t *hubs;
+        const uint8_t *distances;
+
+        size_t Size(index_t v) const { return index[v + 1] - index[v]; }
+    };
+
+    labels_t out_labels;
+    labels_t in_labels;
+    index_t vertex_count;
+    void *data;
+    size_t data_len;
+};
+
+}  // namespace wikipath
+
+#endif  // ndef WIKIPATH_DISTANCE_ORACLE_H_INCLUDED
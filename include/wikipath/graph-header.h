@@ -6,11 +6,15 @@
 namespace wikipath {
 
 const uint32_t graph_header_magic_value    = 0x68707247u;  // Grph
-const uint32_t graph_header_reserved_value = 0;
+
+// Values of the version field. The uncompressed format was written before the
+// field was used, when it was reserved and always 0.
+const uint32_t graph_header_version_1     = 0;
+const uint32_t graph_header_version_2     = 2;
 
 enum GraphHeaderFields {
     GRAPH_HEADER_MAGIC,
-    GRAPH_HEADER_RESERVED,
+    GRAPH_HEADER_VERSION,
     GRAPH_HEADER_VERTEX_COUNT,
     GRAPH_HEADER_EDGE_COUNT,
     GRAPH_HEADER_FIELD_COUNT
@@ -2,11 +2,15 @@
 #define WIKIPATH_GRAPH_READER_H_INCLUDED
 
 #include "common.h"
+#include "numa.h"
+#include "stream-vbyte.h"
 
 #include <stdint.h>
 
 #include <memory>
 #include <span>
+#include <utility>
+#include <vector>
 
 namespace wikipath {
 
@@ -84,6 +88,8 @@ public:
             // This mode is a compromise between NONE and FOREGROUND: Open() is
             // fast, and initial queries may be slow, but eventually the whole
             // file is mapped into memory and subsequent queries are fast.
+            // Since mlock() cannot be interrupted, destroying the reader
+            // blocks until it returns.
             BACKGROUND,
 
             // Add the MAP_POPULATE flag to mmap(). Like FOREGROUND this blocks
@@ -91,15 +97,144 @@ public:
             // Open() to fail, and there is no guarantee that pages will remain
             // locked into memory.
             POPULATE,
+
+            // Load pages into memory in the background, from `warm_up_threads`
+            // threads in parallel, and then lock them into memory if
+            // `warm_up_mlock` is true. Open() returns immediately, and
+            // GetLoadStatus() reports the progress.
+            //
+            // The file is split into chunks, which each thread takes in turn,
+            // and reads with MADV_WILLNEED and MADV_POPULATE_READ (or by
+            // touching every page, on kernels without MADV_POPULATE_READ).
+            // This keeps many reads in flight, so it is much faster than
+            // BACKGROUND on storage with high latency (e.g. network block
+            // devices), where the single mlock() call reads one page range
+            // at a time.
+            PARALLEL,
         };
         MLock mlock = MLock::NONE;
+
+        // Number of threads that load the file for MLock::PARALLEL. The
+        // threads mostly wait for I/O, so this may exceed the number of
+        // cores.
+        int warm_up_threads = 16;
+
+        // Whether MLock::PARALLEL locks the file into memory after loading
+        // it. Failure of mlock() is reported by GetLoadStatus().
+        bool warm_up_mlock = false;
+
+        // Searches access adjacency lists at random, so with normal (4 KB)
+        // pages, most accesses to a large graph miss the TLB. These modes
+        // back the graph data with huge (2 MB) pages instead, which need 512
+        // times fewer TLB entries. The mode that is in effect after Open() is
+        // returned by HugePagesMode(), and HugePageBytes() tells how much of
+        // the graph data actually got huge pages.
+        enum class HugePages {
+            // Map the file with normal pages.
+            NONE,
+
+            // Map the file at an address aligned to 2 MB, and advise the
+            // kernel to use transparent huge pages (MADV_HUGEPAGE). This only
+            // works if the file system caches the file in large folios, and
+            // only for parts of the file that are not in the page cache yet;
+            // otherwise it behaves like NONE. No alignment in the file itself
+            // is needed, because the file is mapped from offset 0.
+            FILE,
+
+            // Copy the file into anonymous memory aligned to 2 MB, with
+            // MADV_HUGEPAGE. This works if transparent huge pages are enabled
+            // ("always" or "madvise" in /sys/kernel/mm/transparent_hugepage/enabled),
+            // but Open() reads the whole file, and the copy takes memory in
+            // addition to the page cache. Falls back to NONE if the memory
+            // cannot be allocated.
+            TRANSPARENT,
+
+            // Copy the file into memory from the pool of huge pages
+            // (MAP_HUGETLB), which must have enough pages reserved (see
+            // /proc/sys/vm/nr_hugepages). Falls back to TRANSPARENT otherwise.
+            HUGETLB,
+        };
+        HugePages huge_pages = HugePages::NONE;
+
+        // On servers with multiple NUMA nodes (e.g. two sockets), the file
+        // mapping is in memory on whichever nodes the page cache happened to
+        // use, and searches on the other nodes pay the latency of remote
+        // memory on every adjacency list access. If this is true, Open()
+        // copies the graph into anonymous memory on each node in
+        // `numa_nodes` (or on each online node, if that is empty), bound to
+        // the node with mbind(), and ForCurrentNode() returns the copy for
+        // the node of the calling thread. The searches in searcher.h do this
+        // themselves.
+        //
+        // Each copy takes as much memory as the file, and Open() does not
+        // return until all copies are made (in parallel, by one thread per
+        // node). The copies always use transparent huge pages (their
+        // HugePagesMode() is TRANSPARENT), and are not affected by `mlock`,
+        // which applies to the file mapping only. Nodes that are not online
+        // are skipped. If mbind() is not supported, each copy is still made
+        // by a thread pinned to its node, so the kernel's default policy
+        // allocates it there. With a single online node and no `numa_nodes`,
+        // nothing is copied, since all memory is local.
+        bool numa_replicas = false;
+        std::vector<int> numa_nodes = {};
     };
 
     static std::unique_ptr<GraphReader> Open(const char *filename, OpenOptions options);
 
+    // Returns the successors (ForwardEdges) or predecessors (BackwardEdges) of
+    // vertex i. In a compressed graph, the edges are decoded into `buffer`,
+    // which is grown as needed, so the result is valid until the buffer is
+    // modified. Otherwise, the result points into the graph file, and `buffer`
+    // is not used.
+    //
     // Precondition: i is between 0 and VertexCount() (exclusive)
-    edges_t ForwardEdges(index_t i) const { return forward_edges.Edges(i); }
-    edges_t BackwardEdges(index_t i) const { return backward_edges.Edges(i); }
+    edges_t ForwardEdges(index_t i, std::vector<index_t> &buffer) const {
+        return compressed ? forward_lists.Decode(i, decode_kernel, buffer) : forward_edges.Edges(i);
+    }
+    edges_t BackwardEdges(index_t i, std::vector<index_t> &buffer) const {
+        return compressed ? backward_lists.Decode(i, decode_kernel, buffer) : backward_edges.Edges(i);
+    }
+
+    // As above, but a compressed graph decodes into a buffer of the calling
+    // thread, so the result is only valid until the next call of either
+    // function without a buffer on the same thread.
+    edges_t ForwardEdges(index_t i) const {
+        return compressed ? forward_lists.Decode(i, decode_kernel, ThreadBuffer()) : forward_edges.Edges(i);
+    }
+    edges_t BackwardEdges(index_t i) const {
+        return compressed ? backward_lists.Decode(i, decode_kernel, ThreadBuffer()) : backward_edges.Edges(i);
+    }
+
+    // Returns the number of successors or predecessors of vertex i, without
+    // decoding them.
+    index_t ForwardDegree(index_t i) const {
+        return compressed ? forward_lists.Degree(i) : forward_edges.Degree(i);
+    }
+    index_t BackwardDegree(index_t i) const {
+        return compressed ? backward_lists.Degree(i) : backward_edges.Degree(i);
+    }
+
+    // Hints that ForwardEdges(i) or BackwardEdges(i) will be called soon.
+    // The Index variants prefetch the entries that locate the edge list, and
+    // the Edges variants prefetch the start of the edge list itself, which
+    // reads the index, so they are best issued some time after the former.
+    void PrefetchForwardIndex(index_t i) const {
+        compressed ? forward_lists.PrefetchIndex(i) : forward_edges.PrefetchIndex(i);
+    }
+    void PrefetchBackwardIndex(index_t i) const {
+        compressed ? backward_lists.PrefetchIndex(i) : backward_edges.PrefetchIndex(i);
+    }
+    void PrefetchForwardEdges(index_t i) const {
+        compressed ? forward_lists.PrefetchEdges(i) : forward_edges.PrefetchEdges(i);
+    }
+    void PrefetchBackwardEdges(index_t i) const {
+        compressed ? backward_lists.PrefetchEdges(i) : backward_edges.PrefetchEdges(i);
+    }
+
+    // Returns whether the graph file uses the compressed format (version 2),
+    // where edges must be decoded before they are returned, and adjacency
+    // lists are sorted.
+    bool Compressed() const { return compressed; }
 
     // Number of vertices, including 0.
     index_t VertexCount() const { return vertex_count; }
@@ -108,12 +243,72 @@ public:
     // combined are twice this number).
     index_t EdgeCount() const { return edge_count; }
 
-    // Possible future improvement: expose the live status of MLock via an atomic
-    // variable. Status could be one of: NONE, FOREGROUND_COMPLETED,
-    // BACKGROUND_IN_PROGRESS, BACKGROUND_COMPLETED, BACKGROUND_FAILED.
+    // Returns the huge pages mode in effect, which is OpenOptions::huge_pages
+    // unless Open() had to fall back to another mode.
+    OpenOptions::HugePages HugePagesMode() const { return huge_pages; }
+
+    // Returns the number of bytes of the graph data that are currently mapped
+    // with huge pages, according to /proc/self/smaps, or 0 if unknown.
+    size_t HugePageBytes() const;
+
+    // Returns the copy of the graph on NUMA node `node` (see
+    // OpenOptions::numa_replicas), or this reader if there is none. Copies
+    // have the same contents, and live as long as this reader.
+    const GraphReader &ForNumaNode(int node) const;
+
+    // Returns the copy of the graph on the NUMA node that the calling thread
+    // is running on, or this reader if there is none. Threads that keep using
+    // the result should be pinned to their node (see PinThreadToNumaNode()),
+    // or the kernel may move them to another node.
+    const GraphReader &ForCurrentNode() const {
+        return replicas.empty() ? *this : ForNumaNode(CurrentNumaNode());
+    }
+
+    // Returns the NUMA nodes that have a copy of the graph, in increasing
+    // order, or an empty vector if the graph is not replicated.
+    std::vector<int> NumaReplicaNodes() const;
+
+    // Progress of loading the graph into memory, as requested with
+    // OpenOptions::mlock.
+    struct LoadStatus {
+        enum class State {
+            // Nothing was requested (MLock::NONE).
+            NONE,
+
+            // MLock::BACKGROUND or MLock::PARALLEL is still running.
+            IN_PROGRESS,
+
+            // The graph was loaded (and locked, if requested).
+            COMPLETED,
+
+            // mlock() or reading the file failed in the background. Pages
+            // are loaded on demand, as with MLock::NONE.
+            FAILED,
+        };
+        State state = State::NONE;
+
+        // Number of bytes loaded so far, out of `bytes_total`. Only
+        // MLock::PARALLEL reports progress; other modes report either 0 or
+        // `bytes_total`, when completed.
+        size_t bytes_loaded = 0;
+        size_t bytes_total = 0;
+
+        // Time since the start of loading, or the time it took, if done.
+        double elapsed_s = 0;
+
+        double BytesPerSecond() const { return elapsed_s > 0 ? bytes_loaded / elapsed_s : 0; }
+    };
+
+    // Returns the current status of loading the graph into memory. This may
+    // be called from any thread, while loading is in progress.
+    LoadStatus GetLoadStatus() const;
 
 private:
-    GraphReader(void *data, size_t data_len);
+    // State shared with the threads that load the graph in the background.
+    struct LoadProgress;
+
+    GraphReader(void *data, size_t data_len, size_t map_len, OpenOptions::HugePages huge_pages,
+            std::shared_ptr<LoadProgress> progress);
 
     static_assert(std::is_same<index_t, uint32_t>::value);
 
@@ -124,14 +319,48 @@ private:
         edges_t Edges(index_t i) const {
             return edges_t(&edges[index[i]], &edges[index[i + 1]]);
         }
+
+        index_t Degree(index_t i) const { return index[i + 1] - index[i]; }
+
+        void PrefetchIndex(index_t i) const { __builtin_prefetch(&index[i]); }
+        void PrefetchEdges(index_t i) const { __builtin_prefetch(&edges[index[i]]); }
+    };
+
+    // Compressed adjacency lists. The index stores two entries per vertex: the
+    // offset of its first edge, and the byte offset of its encoded list in
+    // `lists`.
+    struct compressed_index_t {
+        const uint32_t *index;
+        const uint8_t *lists;
+
+        edges_t Decode(index_t i, DecodeKernel kernel, std::vector<index_t> &buffer) const;
+
+        index_t Degree(index_t i) const { return index[2*i + 2] - index[2*i]; }
+
+        void PrefetchIndex(index_t i) const { __builtin_prefetch(&index[2*i]); }
+        void PrefetchEdges(index_t i) const { __builtin_prefetch(&lists[index[2*i + 1]]); }
     };
 
-    edges_index_t forward_edges;
-    edges_index_t backward_edges;
+    // Returns the buffer used by ForwardEdges(i) and BackwardEdges(i) on the
+    // calling thread.
+    static std::vector<index_t> &ThreadBuffer();
+
+    edges_index_t forward_edges = {};
+    edges_index_t backward_edges = {};
+    compressed_index_t forward_lists = {};
+    compressed_index_t backward_lists = {};
+    bool compressed = false;
+    DecodeKernel decode_kernel = DecodeKernel::SCALAR;
     uint32_t vertex_count;
     uint32_t edge_count;
     void *data;
     size_t data_len;
+    size_t map_len;  // length of the mapping at `data`, which may exceed data_len
+    OpenOptions::HugePages huge_pages;
+    std::shared_ptr<LoadProgress> progress;
+
+    // Copies of the graph on NUMA nodes, by increasing node.
+    std::vector<std::pair<int, std::unique_ptr<GraphReader>>> replicas;
 };
 
 }  // namespace wikipath
@@ -3,15 +3,44 @@
 
 #include "common.h"
 
+#include <functional>
+#include <span>
 #include <vector>
 
 namespace wikipath {
 
+// Returns the adjacency list of a vertex. The result only needs to remain valid
+// until the next call.
+using AdjacencyFn = std::function<std::span<const index_t>(index_t)>;
+
+// Writes the graph in the uncompressed format (version 1), which is described
+// in docs/graph-file-format.txt.
+bool WriteGraphOutput(
+        const char *filename,
+        const std::vector<std::vector<index_t>> &outlinks,
+        const std::vector<std::vector<index_t>> &inlinks);
+
+// As above, but reads the adjacency lists of `vertex_count` vertices one at a
+// time, e.g. from a GraphReader, so that the graph does not need to be copied
+// into memory first.
 bool WriteGraphOutput(
+        const char *filename, index_t vertex_count,
+        const AdjacencyFn &outlinks, const AdjacencyFn &inlinks);
+
+// Writes the graph in the compressed format (version 2), where each adjacency
+// list is sorted and encoded with EncodeSortedIndices(). The order of the edges
+// of a vertex is therefore not preserved. Fails if the encoded lists of either
+// direction take more than 4 GiB.
+bool WriteCompressedGraphOutput(
         const char *filename,
         const std::vector<std::vector<index_t>> &outlinks,
         const std::vector<std::vector<index_t>> &inlinks);
 
+// As above, but reads the adjacency lists one at a time.
+bool WriteCompressedGraphOutput(
+        const char *filename, index_t vertex_count,
+        const AdjacencyFn &outlinks, const AdjacencyFn &inlinks);
+
 }  // namespace wikipath
 
 #endif  // ndef WIKIPATH_GRAPH_WRITER_H_INCLUDED
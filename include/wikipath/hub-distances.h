@@ -0,0 +1,110 @@
+#ifndef WIKIPATH_HUB_DISTANCES_H_INCLUDED
+#define WIKIPATH_HUB_DISTANCES_H_INCLUDED
+
+#include "common.h"
+#include "graph-reader.h"
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace wikipath {
+
+struct HubDistanceOptions {
+    // Number of hubs: the vertices with the highest total degree. Each hub
+    // adds 2 bytes per vertex to the file.
+    int hub_count = 16;
+
+    // Number of threads used to run the searches. 0 means one thread per core.
+    int threads = 1;
+};
+
+// Runs a forward and a backward breadth-first search from each of the
+// `options.hub_count` vertices with the highest total degree, and writes the
+// distances to `filename`, to be opened with HubDistances::Open().
+//
+// Returns false if the file could not be written.
+bool BuildHubDistances(
+        const GraphReader &graph, const char *filename,
+        const HubDistanceOptions &options = {});
+
+// Distances between every vertex and a small set of hub vertices, written by
+// BuildHubDistances(). The file is mapped into memory. This class is
+// thread-safe.
+//
+// Since most shortest paths in a small-world graph pass through (or near) a
+// few high-degree vertices, the hubs give a good upper bound on the distance
+// between two vertices, and, by the triangle inequality, a lower bound on the
+// distance from any vertex to the finish. FindShortestPath() uses both when
+// SearchOptions::hub_distances is set.
+//
+// The distances of each vertex are stored together (HubCount() bytes to and
+// from the hubs), so with up to 32 hubs a bound touches one cache line per
+// vertex, besides those of the start and finish.
+//
+// Note: as with DistanceOracle, the file must have been built from the same
+// graph that is used for searching.
+class HubDistances {
+public:
+    // Distance value for vertices that are not connected to the hub. Same as
+    // Distances::UNREACHABLE.
+    static constexpr uint8_t UNREACHABLE = 255;
+
+    ~HubDistances();
+
+    HubDistances(const HubDistances&) = delete;
+    HubDistances &operator=(const HubDistances&) = delete;
+
+    // Returns nullptr if the file could not be opened or is not a hub file.
+    static std::unique_ptr<HubDistances> Open(const char *filename);
+
+    // Number of vertices, including 0. Should match GraphReader::VertexCount().
+    index_t VertexCount() const { return vertex_count; }
+
+    int HubCount() const { return hub_count; }
+
+    // Returns the vertex id of the i-th hub (0 <= i < HubCount()). Hubs are
+    // ordered by decreasing degree.
+    index_t Hub(int i) const { return hubs[i]; }
+
+    // Returns the distances from `v` to each hub, and from each hub to `v`,
+    // indexed by hub number, or UNREACHABLE.
+    std::span<const uint8_t> ToHubs(index_t v) const {
+        return {distances + size_t{v} * 2 * hub_count, static_cast<size_t>(hub_count)};
+    }
+    std::span<const uint8_t> FromHubs(index_t v) const {
+        return {distances + (size_t{v} * 2 + 1) * hub_count, static_cast<size_t>(hub_count)};
+    }
+
+    // Returns the length of a shortest path from `start` to `finish` that
+    // passes through a hub, and the number of that hub, or UNREACHABLE and -1
+    // if there is no such path.
+    std::pair<int, int> UpperBound(index_t start, index_t finish) const;
+
+    // Returns a lower bound on the distance from `start` to `finish`, derived
+    // from the distances to and from each hub with the triangle inequality.
+    // Returns UNREACHABLE if the hubs prove that there is no path.
+    int LowerBound(index_t start, index_t finish) const;
+
+    // Returns a shortest path from `start` to `finish` through the given hub,
+    // or an empty vector if the hub is not connected to both. The path is
+    // reconstructed by following edges along which the distance to (or from)
+    // the hub decreases.
+    std::vector<index_t> PathViaHub(const GraphReader &graph, index_t start, index_t finish, int hub) const;
+
+private:
+    HubDistances(void *data, size_t data_len);
+
+    index_t vertex_count;
+    int hub_count;
+    const uint32_t *hubs;
+    const uint8_t *distances;  // see ToHubs() and FromHubs()
+    void *data;
+    size_t data_len;
+};
+
+}  // namespace wikipath
+
+#endif  // ndef WIKIPATH_HUB_DISTANCES_H_INCLUDED
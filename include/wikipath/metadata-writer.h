@@ -6,6 +6,7 @@
 #include <sqlite3.h>
 
 #include <optional>
+#include <span>
 #include <string>
 #include <memory>
 
@@ -18,6 +19,13 @@ public:
     bool InsertPage(index_t page_id, const std::string &title);
     bool InsertLink(index_t from_page_id, index_t to_page_id, const std::optional<std::string> &title);
 
+    // Inserts all pages and links of the metadata file `source_filename`,
+    // with each page id `i` replaced by `new_page_id[i]`, which must be a
+    // permutation of the page ids in the source file (e.g. the result of
+    // ComputeVertexOrder()). Pages with ids outside of `new_page_id` are not
+    // copied.
+    bool InsertRenumbered(const char *source_filename, std::span<const index_t> new_page_id);
+
     ~MetadataWriter();
 
 private:
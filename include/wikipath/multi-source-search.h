@@ -0,0 +1,56 @@
+#ifndef WIKIPATH_MULTI_SOURCE_SEARCH_H_INCLUDED
+#define WIKIPATH_MULTI_SOURCE_SEARCH_H_INCLUDED
+
+#include "common.h"
+#include "graph-reader.h"
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace wikipath {
+
+// Shortest path lengths from each of a list of source vertices to each of a
+// list of target vertices.
+struct DistanceMatrix {
+    // Distance value of pairs where the target is unreachable from the source
+    // (or too far away). Same as Distances::UNREACHABLE.
+    static constexpr uint8_t UNREACHABLE = 255;
+
+    size_t source_count = 0;
+    size_t target_count = 0;
+
+    // Distances in row-major order: one row per source, one column per target.
+    std::vector<uint8_t> distance;
+
+    uint8_t operator()(size_t source_index, size_t target_index) const {
+        return distance[source_index * target_count + target_index];
+    }
+};
+
+// Computes the distance from each vertex in `sources` to each vertex in
+// `targets`, following forward edges.
+//
+// This uses multi-source breadth-first search (Then et al., "The More the
+// Merrier: Efficient Multi-Source Graph Traversal", 2014): the sources are
+// processed in batches of `batch_width` searches, which run simultaneously,
+// with one bitmask per vertex recording which searches have reached it. A
+// vertex in the fringe of several searches is therefore expanded only once
+// per level for all of them, which makes this much faster than one search per
+// pair when the sources are close to each other, or simply numerous.
+//
+// `batch_width` must be 64, 128 or 256. Wider batches share more work, but
+// take 3 * batch_width / 8 bytes of memory per vertex (72 MiB per million
+// vertices at 256); the bitmask operations vectorize when the compiler is
+// allowed to use AVX2 (e.g. with -march=native).
+//
+// Like ComputeDistances(), distances of 255 or more are reported as
+// unreachable.
+DistanceMatrix ComputeDistanceMatrix(
+    const GraphReader &graph,
+    std::span<const index_t> sources, std::span<const index_t> targets,
+    int batch_width = 64);
+
+}  // namespace wikipath
+
+#endif  // ndef WIKIPATH_MULTI_SOURCE_SEARCH_H_INCLUDED
@@ -0,0 +1,58 @@
+#ifndef WIKIPATH_NEIGHBOR_SCAN_H_INCLUDED
+#define WIKIPATH_NEIGHBOR_SCAN_H_INCLUDED
+
+#include "common.h"
+
+#include <cstddef>
+#include <span>
+
+namespace wikipath {
+
+// Implementations of ScanNeighbors(). The vectorized kernels gather the
+// visited entries of 8 (AVX2) or 16 (AVX-512) neighbors at a time, so that
+// their cache misses overlap, instead of testing one neighbor per iteration.
+enum class ScanKernel {
+    SCALAR,
+    AVX2,
+    AVX512,
+};
+
+// Returns the name of the kernel, e.g. "avx2".
+const char *ScanKernelName(ScanKernel kernel);
+
+// Returns whether the CPU supports the kernel.
+bool ScanKernelSupported(ScanKernel kernel);
+
+// Returns the fastest kernel supported by the CPU, as detected with CPUID on
+// the first call.
+ScanKernel BestScanKernel();
+
+struct ScanResult {
+    // Number of neighbors appended to the fringe.
+    size_t reached = 0;
+
+    // Index of the first neighbor that was already reached from the other
+    // side of the search, or neighbors.size() if there is none.
+    size_t meeting = 0;
+};
+
+// Scans `neighbors` of a vertex in a top-down search step. For each neighbor
+// `w` in order:
+//
+//  - if visited[w] == 0, sets visited[w] = mark and appends w to `fringe`;
+//  - if visited[w] - meet_min < meet_count (as unsigned integers), w was
+//    reached from the other side, and the scan stops at w;
+//  - otherwise w was already reached from this side, and is skipped.
+//
+// `fringe` must have room for neighbors.size() elements. The result is the
+// same for every kernel, including the order of the fringe.
+//
+// The vectorized kernels index `visited` with signed 32-bit offsets, so they
+// require that all neighbors are less than 2^31. `kernel` must be supported.
+ScanResult ScanNeighbors(
+        ScanKernel kernel, std::span<const index_t> neighbors, index_t *visited,
+        index_t mark, index_t meet_min, index_t meet_count, index_t *fringe);
+
+}  // namespace wikipath
+
+#endif  // ndef WIKIPATH_NEIGHBOR_SCAN_H_INCLUDED
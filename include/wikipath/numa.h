@@ -0,0 +1,51 @@
+#ifndef WIKIPATH_NUMA_H_INCLUDED
+#define WIKIPATH_NUMA_H_INCLUDED
+
+#include <cstddef>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace wikipath {
+
+// Helpers for servers with multiple NUMA nodes (typically one per socket),
+// where memory is attached to one node and is slower to access from the CPUs
+// of the other nodes.
+//
+// These use sysfs and raw system calls instead of libnuma, so they work on
+// any Linux kernel: without NUMA support, the machine has a single node 0.
+// Emulated NUMA topologies (e.g. the numa=fake=N boot option, or the -numa
+// option of QEMU) look like real ones through these interfaces.
+
+// Parses a list of CPUs or nodes in the format used by sysfs, e.g.
+// "0-3,8,10-11". Returns nullopt if the list is malformed.
+std::optional<std::vector<int>> ParseCpuList(std::string_view list);
+
+// Returns the NUMA nodes that are online, according to
+// /sys/devices/system/node/online, or {0} if that is unavailable.
+std::vector<int> OnlineNumaNodes();
+
+// Returns the CPUs of NUMA node `node`, according to
+// /sys/devices/system/node/node<N>/cpulist, or an empty vector if the node
+// does not exist. Without sysfs, node 0 has all CPUs.
+std::vector<int> NumaNodeCpus(int node);
+
+// Returns the NUMA node of the CPU that the calling thread is running on, or
+// 0 if unknown. Unless the thread is pinned to a node, the kernel may move it
+// to another node at any time.
+int CurrentNumaNode();
+
+// Restricts the calling thread to the CPUs of NUMA node `node`. Returns false
+// if the node has no CPUs, or the affinity could not be set.
+bool PinThreadToNumaNode(int node);
+
+// Sets the memory policy of the pages in [addr, addr + len) with mbind(), so
+// that they are allocated on NUMA node `node` when they are first touched.
+// `addr` must be page aligned. Returns false (with errno set) on failure,
+// e.g. ENOSYS on kernels without NUMA support, or EINVAL if the node is not
+// online.
+bool BindMemoryToNumaNode(void *addr, size_t len, int node);
+
+}  // namespace wikipath
+
+#endif  // ndef WIKIPATH_NUMA_H_INCLUDED
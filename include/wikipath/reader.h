@@ -5,6 +5,8 @@
 #include "graph-reader.h"
 #include "metadata-reader.h"
 
+#include <cstdint>
+#include <memory>
 #include <string>
 #include <string_view>
 
@@ -41,6 +43,12 @@ public:
     // Returns a reference to the open MetadataReader.
     const MetadataReader &Metadata() const { return *metadata; }
 
+    // Returns a hash of the identity (device, inode, size and modification
+    // time) of the graph and metadata files, as they were when opened. Used
+    // to key cached results, so that they are not reused after the files
+    // are replaced.
+    uint64_t FileIdentity() const { return file_identity; }
+
     // Returns whether `id` is a valid page id.
     bool IsValidPageId(index_t id) const {
         return 0 < id && id < graph->VertexCount();
@@ -82,10 +90,12 @@ public:
     std::string BackwardLinkRef(index_t from_page_id, index_t to_page_id) const;
 
 private:
-    Reader(std::unique_ptr<GraphReader> graph, std::unique_ptr<MetadataReader> metadata);
+    Reader(std::unique_ptr<GraphReader> graph, std::unique_ptr<MetadataReader> metadata,
+            uint64_t file_identity);
 
     std::unique_ptr<GraphReader> graph;
     std::unique_ptr<MetadataReader> metadata;
+    uint64_t file_identity;
 };
 
 }  // namespace wikipath
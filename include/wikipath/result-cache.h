@@ -0,0 +1,156 @@
+#ifndef WIKIPATH_RESULT_CACHE_H_INCLUDED
+#define WIKIPATH_RESULT_CACHE_H_INCLUDED
+
+#include "common.h"
+#include "reader.h"
+#include "searcher.h"
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace wikipath {
+
+// Kind of query whose result is cached. Part of the cache key, since the same
+// (start, finish) pair has a different result for each kind.
+enum class QueryKind : uint8_t {
+    SHORTEST_PATH,      // result of FindShortestPath()
+    SHORTEST_PATH_DAG,  // result of FindShortestPathDag()
+};
+
+struct ResultCacheKey {
+    // Identity of the graph and metadata files; see Reader::FileIdentity().
+    uint64_t file_identity = 0;
+    index_t start = 0;
+    index_t finish = 0;
+    QueryKind kind = QueryKind::SHORTEST_PATH;
+
+    bool operator==(const ResultCacheKey&) const = default;
+};
+
+// A cached search result, together with the titles needed to display it, so
+// that a cache hit requires neither a search nor metadata lookups.
+struct CachedResult {
+    // For SHORTEST_PATH queries: the path, or empty if there is none.
+    std::vector<index_t> path;
+
+    // For SHORTEST_PATH queries: titles[i] is the title of path[i], and
+    // link_texts[i] is the text of the link from path[i - 1] to path[i]
+    // (see Reader::LinkText()). link_texts[0] is empty.
+    //
+    // For SHORTEST_PATH_DAG queries: titles of the vertices in `dag` (or of
+    // the start, if start == finish), in order of increasing page id.
+    // link_texts is empty.
+    std::vector<std::string> titles;
+    std::vector<std::string> link_texts;
+
+    // For SHORTEST_PATH_DAG queries: the edges of the DAG, or nullopt if
+    // there is no path.
+    std::optional<std::vector<std::pair<index_t, index_t>>> dag;
+
+    // Returns the approximate number of bytes used by this result.
+    size_t ByteSize() const;
+};
+
+// Counters returned by ResultCache::Stats().
+struct ResultCacheStats {
+    int64_t hits = 0;
+    int64_t misses = 0;
+    int64_t insertions = 0;
+    int64_t evictions = 0;
+
+    // Current number of entries and their total size (as counted against
+    // the capacity).
+    int64_t entries = 0;
+    int64_t bytes = 0;
+};
+
+// In-process cache of shortest path results, shared between searches.
+//
+// The cache is split into shards, each with its own lock and least-recently-
+// used list, so that concurrent lookups of different keys rarely contend. The
+// capacity is given in bytes (of CachedResult::ByteSize() plus a fixed
+// overhead per entry) and divided evenly between the shards.
+//
+// Results are keyed by Reader::FileIdentity(), so a reader that opens
+// replaced graph or metadata files never sees stale results; the old entries
+// are evicted as they age.
+//
+// This class is thread-safe.
+class ResultCache {
+public:
+    explicit ResultCache(size_t capacity_bytes, int shard_count = 16);
+
+    ResultCache(const ResultCache&) = delete;
+    ResultCache &operator=(const ResultCache&) = delete;
+
+    // Returns the cached result for `key` and marks it as recently used, or
+    // returns nullptr if there is none.
+    std::shared_ptr<const CachedResult> Lookup(const ResultCacheKey &key);
+
+    // Adds a result to the cache, replacing any existing result for `key`,
+    // and evicts least recently used entries of the shard until it fits. A
+    // result larger than the capacity of a shard is not cached.
+    void Insert(const ResultCacheKey &key, std::shared_ptr<const CachedResult> result);
+
+    // Returns the cached shortest path from `start` to `finish`, or searches
+    // for it with FindShortestPath(), resolves the titles with `reader` and
+    // caches the result. Returns nullptr if the search was aborted because it
+    // exceeded `limits`; aborted searches are not cached.
+    //
+    // If `stats` is not null, it receives the statistics of the search, or is
+    // reset to all zeros on a cache hit.
+    //
+    // Concurrent misses for the same key may each run a search.
+    std::shared_ptr<const CachedResult> ShortestPath(
+            const Reader &reader, index_t start, index_t finish,
+            SearchStats *stats = nullptr, SearchWorkspace *workspace = nullptr,
+            const SearchLimits &limits = {});
+
+    // Same as ShortestPath(), but for FindShortestPathDag().
+    std::shared_ptr<const CachedResult> ShortestPathDag(
+            const Reader &reader, index_t start, index_t finish,
+            SearchStats *stats = nullptr, SearchWorkspace *workspace = nullptr,
+            const SearchLimits &limits = {});
+
+    // Removes all entries. The hit/miss counters are not reset.
+    void Clear();
+
+    ResultCacheStats Stats() const;
+
+    size_t CapacityBytes() const { return capacity_bytes; }
+
+private:
+    struct KeyHash {
+        size_t operator()(const ResultCacheKey &key) const;
+    };
+
+    using entry_t = std::pair<ResultCacheKey, std::shared_ptr<const CachedResult>>;
+
+    struct Shard {
+        mutable std::mutex mutex;
+        std::list<entry_t> lru;  // most recently used first
+        std::unordered_map<ResultCacheKey, std::list<entry_t>::iterator, KeyHash> index;
+        size_t bytes = 0;
+        int64_t hits = 0;
+        int64_t misses = 0;
+        int64_t insertions = 0;
+        int64_t evictions = 0;
+    };
+
+    Shard &ShardFor(const ResultCacheKey &key);
+
+    const size_t capacity_bytes;
+    const size_t shard_capacity_bytes;
+    std::vector<Shard> shards;
+};
+
+}  // namespace wikipath
+
+#endif  // ndef WIKIPATH_RESULT_CACHE_H_INCLUDED
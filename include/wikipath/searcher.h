@@ -4,18 +4,92 @@
 #include "common.h"
 #include "graph-reader.h"
 
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <initializer_list>
+#include <limits>
+#include <memory>
 #include <optional>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
 namespace wikipath {
 
+class HubDistances;
+
+// Direction in which a breadth-first search follows edges.
+enum class Direction : uint8_t {
+    FORWARD,   // from the start vertex, following forward edges
+    BACKWARD,  // from the finish vertex, following backward edges
+};
+
+// Describes how a single level of a breadth-first search was expanded.
+struct SearchLevel {
+    using Direction = wikipath::Direction;
+
+    enum class Mode : uint8_t {
+        TOP_DOWN,   // the edges of each fringe vertex were scanned
+        BOTTOM_UP,  // each unreached vertex looked for a neighbor in the fringe
+    };
+
+    Direction direction = Direction::FORWARD;
+    Mode mode = Mode::TOP_DOWN;
+
+    // Number of vertices in the fringe when the level started.
+    int64_t fringe_size = 0;
+
+    // Work done in this level; see SearchStats.
+    int64_t vertices_expanded = 0;
+    int64_t edges_expanded = 0;
+
+    bool operator==(const SearchLevel&) const = default;
+};
+
+// Reason why a search was aborted before it completed. See SearchLimits.
+enum class AbortReason : uint8_t {
+    NONE,          // the search was not aborted
+    VERTEX_LIMIT,  // more than max_vertices_expanded vertices were expanded
+    EDGE_LIMIT,    // more than max_edges_expanded edges were expanded
+    DEADLINE,      // the deadline passed
+    CANCELLED,     // the cancel flag was set
+};
+
 struct SearchStats {
+    // In bottom-up levels, vertices_expanded counts the vertices whose edges
+    // were scanned for a neighbor in the fringe, and edges_expanded counts the
+    // edges scanned.
     int64_t vertices_reached = 0;
     int64_t vertices_expanded = 0;
     int64_t edges_expanded = 0;
     int64_t time_taken_ms = 0;
 
+    // One element per level that was expanded, in order.
+    std::vector<SearchLevel> levels;
+
+    // Same as SearchResult::abort_reason. If set, the other fields describe
+    // the work done until the search was aborted.
+    AbortReason abort_reason = AbortReason::NONE;
+
+    // Wall-clock time in nanoseconds, in total and per phase: the
+    // bidirectional search itself, reconstructing the path (FindShortestPath()
+    // only), and collecting and sorting the edges of the DAG
+    // (FindShortestPathDag() only).
+    int64_t time_taken_ns = 0;
+    int64_t search_ns = 0;
+    int64_t reconstruct_ns = 0;
+    int64_t propagate_ns = 0;
+    int64_t sort_ns = 0;
+
+    // Page faults that occurred during the search, as reported by getrusage()
+    // for the searching thread, plus the worker threads of parallel levels
+    // (see SearchOptions::threads) while they expanded the level. Major faults
+    // required reading a page of the graph from disk; minor faults only mapped
+    // a page that was already in the page cache.
+    int64_t minor_faults = 0;
+    int64_t major_faults = 0;
+
     bool operator==(const SearchStats&) const = default;
 
     // Hash code. Only used by Python bindings.
@@ -25,19 +99,281 @@ struct SearchStats {
         hash = 8191*hash + vertices_expanded;
         hash = 8191*hash + edges_expanded;
         hash = 8191*hash + time_taken_ms;
+        for (const SearchLevel &level : levels) {
+            hash = 4*hash + 2*static_cast<int>(level.direction) + static_cast<int>(level.mode);
+            hash = 8191*hash + level.fringe_size;
+            hash = 8191*hash + level.vertices_expanded;
+            hash = 8191*hash + level.edges_expanded;
+        }
+        hash = 8191*hash + static_cast<int>(abort_reason);
+        for (int64_t value : {time_taken_ns, search_ns, reconstruct_ns, propagate_ns, sort_ns,
+                minor_faults, major_faults}) {
+            hash = 8191*hash + value;
+        }
         return hash;
     }
 };
 
+// Options that affect how a search is performed, but not its result.
+struct SearchOptions {
+    // FindShortestPath() initially stores visited vertices in a hash table,
+    // which takes memory proportional to the number of vertices visited, and
+    // switches to a flat array of VertexCount() elements when the number of
+    // visited vertices exceeds this fraction of the vertex count. This avoids
+    // allocating and clearing the array for searches that visit only a small
+    // part of the graph (which is the common case).
+    //
+    // 0 disables the hash table (the array is used from the start). The default
+    // was chosen with benchmarks/search-benchmark.cc.
+    double sparse_visited_max_fraction = 0.01;
+
+    // Direction-optimizing search (Beamer et al., 2012): a level is expanded
+    // bottom-up instead of top-down when the number of edges leaving the fringe
+    // exceeds 1/bottom_up_alpha of the number of edges that a bottom-up step
+    // would scan, and later levels stay bottom-up until the fringe shrinks below
+    // VertexCount()/bottom_up_beta vertices. 0 disables bottom-up steps.
+    //
+    // Bottom-up steps are only considered for fringes of at least
+    // bottom_up_min_fringe vertices, because they scan all vertices of the
+    // graph. In FindShortestPath(), they are only used after switching to the
+    // flat visited array.
+    double bottom_up_alpha = 14;
+    double bottom_up_beta = 24;
+    size_t bottom_up_min_fringe = 1000;
+
+    // Number of threads used to expand large top-down levels, which is useful
+    // for offline batch runs where a single expensive query (e.g. between
+    // unreachable or peripheral pages) can use all cores. 0 means one thread
+    // per core. The threads are owned by the SearchWorkspace, and only levels
+    // with at least parallel_min_fringe vertices are expanded in parallel (in
+    // FindShortestPath(), only after switching to the flat visited array).
+    //
+    // Parallel searches return a shortest path, but not necessarily the same
+    // one on each run. If the graph has NUMA replicas (see
+    // GraphReader::OpenOptions::numa_replicas), the threads are pinned to the
+    // node of the calling thread, whose copy of the graph is searched.
+    int threads = 1;
+    size_t parallel_min_fringe = 10000;
+
+    // If true, FindShortestPath() runs a layered search, which keeps only one
+    // visited bit per vertex and direction (instead of a 4-byte predecessor)
+    // plus the fringe of each level, and reconstructs the path afterwards by
+    // walking back through the levels. This touches much less memory at
+    // random in large searches, but the path reconstruction scans the earlier
+    // levels. Layered searches are always top-down and single-threaded, and
+    // ignore sparse_visited_max_fraction.
+    bool layered = false;
+
+    // Top-down levels of FindShortestPath() prefetch the edge index entries of
+    // the fringe vertex 2*prefetch_distance positions ahead, the edge list of
+    // the vertex prefetch_distance positions ahead, and the visited entries of
+    // the neighbors of the vertex about prefetch_distance/2 positions ahead,
+    // so that the cache misses of upcoming vertices overlap with the work on
+    // the current one. 0 disables prefetching, which is the default: in
+    // benchmarks/search-benchmark.cc with synthetic graphs locked in memory,
+    // out-of-order execution already overlapped most of these misses, so the
+    // effect was within noise (and slightly negative for small graphs).
+    int prefetch_distance = 0;
+
+    // If true, top-down levels of FindShortestPath() sort the fringe by vertex
+    // id before expanding it, so that the edge lists are read in the order in
+    // which they are stored in the graph file. When the graph is not locked
+    // into memory (GraphReader::OpenOptions::MLock::NONE), this lets the
+    // kernel's readahead fetch the pages of nearby edge lists together, and
+    // reduces TLB misses. Sorting costs time linear in the size of the fringe,
+    // and may change which shortest path is found.
+    bool sort_fringes = false;
+
+    // If not null, FindShortestPath() starts with the shortest path through a
+    // hub as an upper bound (see HubDistances), stops searching as soon as no
+    // shorter path can exist, and drops fringe vertices whose lower bound
+    // shows that they cannot lie on a shorter path. The hub distances must
+    // have been built from the same graph. Ignored by layered and filtered
+    // searches, and by the other search functions.
+    const HubDistances *hub_distances = nullptr;
+};
+
+// Limits on the work done by a single search, which allow servers to bound
+// the latency of pathological queries (e.g. between pages that are not
+// connected, which may visit the entire graph).
+//
+// Limits are checked once per chunk of vertices expanded (about 64), so they
+// may be exceeded slightly. A search that exceeds a limit returns a
+// SearchResult whose abort_reason says which limit it exceeded.
+struct SearchLimits {
+    // Counted the same way as in SearchStats.
+    int64_t max_vertices_expanded = std::numeric_limits<int64_t>::max();
+    int64_t max_edges_expanded = std::numeric_limits<int64_t>::max();
+
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+
+    // If not null, the search is aborted when this flag becomes true. The flag
+    // may be set from another thread.
+    const std::atomic<bool> *cancel = nullptr;
+};
+
+// Result of a search that takes SearchLimits, similar to std::expected<T,
+// AbortReason>: either the value the search computed (which may still say that
+// no path exists), or the reason the search was aborted. In the latter case,
+// `value` holds the same "no path" value as a completed search that found
+// nothing, so callers that do not distinguish the two can ignore
+// abort_reason.
+template<class T>
+struct SearchResult {
+    T value = {};
+    AbortReason abort_reason = AbortReason::NONE;
+
+    bool Aborted() const { return abort_reason != AbortReason::NONE; }
+
+    bool operator==(const SearchResult&) const = default;
+};
+
+// Vertices and edges that a search must avoid. FindShortestPath() and
+// FindShortestPathDag() behave as if banned vertices (with all their edges) and
+// banned edges were removed from the graph, so the graph file does not need to
+// be rebuilt for each filter. If the start or finish is banned, no path exists.
+//
+// Banned vertices are stored in a bitmap, so banning many vertices (e.g. all
+// pages about dates) is cheap. Banned edges are stored in a hash set, which is
+// intended for a small number of edges. Searches without a filter (or with an
+// empty one) do not check it at all.
+//
+// This class is thread-compatible: it can be used by concurrent searches as
+// long as it is not modified at the same time.
+class SearchFilter {
+public:
+    void BanVertex(index_t v) {
+        if (banned_vertices.size() <= v / 64) banned_vertices.resize(v / 64 + 1, 0);
+        banned_vertices[v / 64] |= uint64_t{1} << (v % 64);
+        has_banned_vertices = true;
+    }
+
+    void BanEdge(index_t v, index_t w) {
+        banned_edges.insert(EdgeKey(v, w));
+    }
+
+    bool IsVertexBanned(index_t v) const {
+        return v / 64 < banned_vertices.size() && (banned_vertices[v / 64] >> (v % 64)) & 1;
+    }
+
+    bool IsEdgeBanned(index_t v, index_t w) const {
+        return !banned_edges.empty() && banned_edges.contains(EdgeKey(v, w));
+    }
+
+    // Returns whether a search may follow the edge from v to w.
+    bool AllowsEdge(index_t v, index_t w) const {
+        return !IsVertexBanned(v) && !IsVertexBanned(w) && !IsEdgeBanned(v, w);
+    }
+
+    bool Empty() const { return !has_banned_vertices && banned_edges.empty(); }
+
+private:
+    static uint64_t EdgeKey(index_t v, index_t w) { return uint64_t{v} << 32 | w; }
+
+    std::vector<uint64_t> banned_vertices;  // bitmap; vertices beyond the end are allowed
+    bool has_banned_vertices = false;
+    std::unordered_set<uint64_t> banned_edges;
+};
+
+// Result of FindNearShortestPaths().
+struct NearShortestPaths {
+    // Length of a shortest path from start to finish.
+    int shortest_length = 0;
+
+    // Maximum length of the walks described by `edges`: shortest_length + slack.
+    int max_length = 0;
+
+    // Sorted list of (source, destination) pairs. Pass max_length to
+    // AnnotatedDag to count and enumerate the walks.
+    std::vector<std::pair<index_t, index_t>> edges;
+};
+
+// Result of ComputeDistances().
+struct Distances {
+    // Distance value of vertices that are unreachable, or too far away.
+    static constexpr uint8_t UNREACHABLE = 255;
+
+    // One element per vertex.
+    std::vector<uint8_t> distance;
+
+    // histogram[d] is the number of vertices at distance d.
+    std::vector<int64_t> histogram;
+};
+
+// Memory that is reused between searches, to avoid allocating (and clearing)
+// arrays proportional to the size of the graph for each search.
+//
+// After a search completes, the workspace is reset in time proportional to the
+// number of vertices that were touched by the search, so the next search can
+// start immediately. The workspace grows to fit the largest graph it has been
+// used with, and keeps that memory until it is destroyed.
+//
+// This class is thread-compatible, but not thread safe: the same instance
+// should not be accessed concurrently from multiple threads. Servers should
+// keep one instance per worker thread. If the graph has NUMA replicas, each
+// search uses the copy on the node of the calling thread, so servers should
+// also pin their worker threads to nodes (e.g. round-robin, with
+// PinThreadToNumaNode()), to keep them near their copy.
+class SearchWorkspace {
+public:
+    SearchWorkspace();
+    ~SearchWorkspace();
+
+    SearchWorkspace(const SearchWorkspace&) = delete;
+    SearchWorkspace &operator=(const SearchWorkspace&) = delete;
+
+    // Same as the FindShortestPath() function below, but reuses this workspace.
+    SearchResult<std::vector<index_t>> FindShortestPath(
+        const GraphReader &graph, index_t start, index_t finish, SearchStats *stats,
+        const SearchOptions &options = {}, const SearchLimits &limits = {},
+        const SearchFilter *filter = nullptr);
+
+    // Same as the FindShortestPathDag() function below, but reuses this workspace.
+    SearchResult<std::optional<std::vector<std::pair<index_t, index_t>>>>
+    FindShortestPathDag(
+        const GraphReader &graph, index_t start, index_t finish, SearchStats *stats,
+        const SearchOptions &options = {}, const SearchLimits &limits = {},
+        const SearchFilter *filter = nullptr);
+
+    // Same as the FindNearShortestPaths() function below, but reuses this workspace.
+    SearchResult<std::optional<NearShortestPaths>> FindNearShortestPaths(
+        const GraphReader &graph, index_t start, index_t finish, int slack, SearchStats *stats,
+        const SearchLimits &limits = {});
+
+    // Same as the ShortestPathLength() function below, but reuses this workspace.
+    SearchResult<std::optional<int>> ShortestPathLength(
+        const GraphReader &graph, index_t start, index_t finish, SearchStats *stats,
+        const SearchLimits &limits = {});
+
+    // Same as the ComputeDistances() function below, but reuses this workspace.
+    Distances ComputeDistances(
+        const GraphReader &graph, index_t source, Direction direction,
+        const SearchOptions &options = {});
+
+    // Implementation details, defined in searcher.cc.
+    struct Impl;
+
+private:
+    std::unique_ptr<Impl> impl;
+};
+
 // Finds a single shortest path from `start` to `finish` using bidirectional
 // breadth-first search.
 //
 // Returns the path as vector indices, including start and finish, or an
-// empty vector if no path exists.
+// empty vector if no path exists. If the search exceeded `limits`, the path is
+// empty and the result's abort_reason is set.
 //
 // If `stats` is not null, search statistics are written to *stats.
-std::vector<index_t> FindShortestPath(
-    const GraphReader &graph, index_t start, index_t finish, SearchStats *stats);
+//
+// If `filter` is not null, the path avoids the vertices and edges it bans.
+//
+// This uses a temporary SearchWorkspace. Use SearchWorkspace::FindShortestPath()
+// instead to reuse memory between searches.
+SearchResult<std::vector<index_t>> FindShortestPath(
+    const GraphReader &graph, index_t start, index_t finish, SearchStats *stats,
+    const SearchOptions &options = {}, const SearchLimits &limits = {},
+    const SearchFilter *filter = nullptr);
 
 // Finds all shortest paths from `start` to `finish` using bidirectional
 // breadth-first search, and returns the result as a DAG, represented as a
@@ -45,16 +381,82 @@ std::vector<index_t> FindShortestPath(
 // sources and `finish` is one of the destinations.
 //
 // If no path is found, an empty optional is returned instead. Note that the
-// optional contains an empty vector only if `start` == `finish`.
+// optional contains an empty vector only if `start` == `finish`. If the search
+// exceeded `limits`, the optional is empty and the result's abort_reason is
+// set.
 //
 // Every path through the DAG from `start` to `finish` has the same length, so
 // the DAG consists of layers corresponding with distances from the start/to the
 // finish, and only edges between consecutive layers are possible.
 //
 // If `stats` is not null, search statistics are written to *stats.
-std::optional<std::vector<std::pair<index_t, index_t>>>
+//
+// If `filter` is not null, the DAG contains the shortest paths that avoid the
+// vertices and edges it bans.
+//
+// This uses a temporary SearchWorkspace. Use SearchWorkspace::FindShortestPathDag()
+// instead to reuse memory between searches.
+SearchResult<std::optional<std::vector<std::pair<index_t, index_t>>>>
 FindShortestPathDag(
-    const GraphReader &graph, index_t start, index_t finish, SearchStats *stats);
+    const GraphReader &graph, index_t start, index_t finish, SearchStats *stats,
+    const SearchOptions &options = {}, const SearchLimits &limits = {},
+    const SearchFilter *filter = nullptr);
+
+// Finds all walks from `start` to `finish` that are at most `slack` edges
+// longer than a shortest path, e.g. alternative routes that take one or two
+// extra hops, and returns the edges that occur on them. If no path exists
+// (or the search exceeded `limits`, which sets the result's abort_reason), an
+// empty optional is returned instead.
+//
+// An edge (v, w) occurs on such a walk iff. dist(start, v) + 1 + dist(w,
+// finish) <= shortest_length + slack. The distances are computed with a
+// bidirectional search that continues after the searches meet, until the
+// radii of the two searches add up to shortest_length + slack - 1; then each
+// search is extended only through vertices reached by the other one, which
+// includes every vertex on a qualifying walk.
+//
+// With slack = 0, the edges are the same as returned by FindShortestPathDag().
+// Otherwise, the edges may form cycles, so the walks are only finite because
+// of their maximum length; AnnotatedDag can count and enumerate them when
+// given max_length. Edges leaving `finish` are omitted, since walks end there.
+//
+// If `stats` is not null, search statistics are written to *stats.
+//
+// This uses a temporary SearchWorkspace.
+SearchResult<std::optional<NearShortestPaths>> FindNearShortestPaths(
+    const GraphReader &graph, index_t start, index_t finish, int slack, SearchStats *stats,
+    const SearchLimits &limits = {});
+
+// Returns the length (number of edges) of a shortest path from `start` to
+// `finish`, or an empty optional if no path exists (or the search exceeded
+// `limits`, which sets the result's abort_reason). This runs the same search
+// as FindShortestPath() with SearchOptions::layered, but skips the path
+// reconstruction.
+//
+// If `stats` is not null, search statistics are written to *stats.
+//
+// This uses a temporary SearchWorkspace.
+SearchResult<std::optional<int>> ShortestPathLength(
+    const GraphReader &graph, index_t start, index_t finish, SearchStats *stats,
+    const SearchLimits &limits = {});
+
+// Computes the distance from `source` to every vertex (if `direction` is
+// FORWARD), or from every vertex to `source` (if `direction` is BACKWARD),
+// with a single breadth-first search. This is much cheaper than calling
+// FindShortestPath() for each vertex.
+//
+// Distances are stored as 8-bit integers to keep the result compact. Vertices
+// at distance 255 or more (which does not happen in real-world graphs) are
+// reported as unreachable, with a warning.
+//
+// The search uses bottom-up steps and multiple threads as configured by
+// `options`; sparse_visited_max_fraction is ignored, since every reachable
+// vertex is visited.
+//
+// This uses a temporary SearchWorkspace.
+Distances ComputeDistances(
+    const GraphReader &graph, index_t source, Direction direction,
+    const SearchOptions &options = {});
 
 }  // namespace wikipath
 
@@ -0,0 +1,56 @@
+#ifndef WIKIPATH_STREAM_VBYTE_H_INCLUDED
+#define WIKIPATH_STREAM_VBYTE_H_INCLUDED
+
+#include "common.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace wikipath {
+
+// Encoding of sorted lists of indices (like adjacency lists) as the gaps
+// between consecutive indices, in the StreamVByte format (Lemire et al.,
+// 2017): each gap is stored in 1 to 4 little-endian bytes, and its length is
+// stored separately in a 2-bit code. A list of n indices consists of
+// ceil(n / 4) control bytes, where the bits 2i and 2i + 1 of byte j hold the
+// length minus 1 of gap 4j + i, followed by the gap bytes. The first gap is
+// the first index itself.
+//
+// Since the lengths of 4 gaps are known from a single control byte, a
+// decoder can move them into place with one shuffle, and add them up with a
+// vectorized prefix sum, without branching on the individual lengths.
+
+// Number of bytes that must be readable after the end of an encoded list, since
+// the vectorized decoder loads 16 bytes of gaps at a time.
+constexpr size_t stream_vbyte_padding = 16;
+
+// Implementations of DecodeSortedIndices().
+enum class DecodeKernel {
+    SCALAR,
+    SSSE3,
+};
+
+// Returns the name of the kernel, e.g. "ssse3".
+const char *DecodeKernelName(DecodeKernel kernel);
+
+// Returns whether the CPU supports the kernel.
+bool DecodeKernelSupported(DecodeKernel kernel);
+
+// Returns the fastest kernel supported by the CPU, as detected with CPUID on
+// the first call.
+DecodeKernel BestDecodeKernel();
+
+// Appends the encoding of `indices`, which must be sorted in nondecreasing
+// order, to `output`.
+void EncodeSortedIndices(std::span<const index_t> indices, std::vector<uint8_t> &output);
+
+// Decodes `count` indices from the encoded list at `data` into `output`, and
+// returns the size of the encoding in bytes. `kernel` must be supported, and
+// `data` must be followed by stream_vbyte_padding readable bytes.
+size_t DecodeSortedIndices(DecodeKernel kernel, const uint8_t *data, size_t count, index_t *output);
+
+}  // namespace wikipath
+
+#endif  // ndef WIKIPATH_STREAM_VBYTE_H_INCLUDED
@@ -0,0 +1,69 @@
+#ifndef WIKIPATH_THREAD_POOL_H_INCLUDED
+#define WIKIPATH_THREAD_POOL_H_INCLUDED
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace wikipath {
+
+// A fixed set of threads that run a function in parallel, intended for
+// level-synchronous algorithms that alternate between parallel and serial
+// steps. The calling thread participates as thread 0, so a pool with a thread
+// count of N starts N - 1 worker threads.
+//
+// This class is thread-compatible: Run() and ParallelFor() must not be called
+// concurrently, or from inside a function that is being run by the pool.
+class ThreadPool {
+public:
+    explicit ThreadPool(int thread_count);
+    ~ThreadPool();
+
+    // Not copyable or assignable.
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool &operator=(const ThreadPool&) = delete;
+
+    int ThreadCount() const { return static_cast<int>(workers.size()) + 1; }
+
+    // Calls fn(i) for each thread index i in [0, ThreadCount()) concurrently,
+    // and returns when all calls have returned.
+    void Run(const std::function<void(int)> &fn);
+
+    // Calls fn(thread_index, b, e) for disjoint subranges [b, e) of at most
+    // `grain` elements that together cover [begin, end), and returns when all
+    // calls have returned.
+    //
+    // The range is initially divided evenly between the threads. A thread that
+    // runs out of work steals the second half of the remaining range of another
+    // thread, so the load stays balanced when elements differ in cost. Claims
+    // are made with atomic compare-and-swap; no locks are taken.
+    void ParallelFor(
+            size_t begin, size_t end, size_t grain,
+            const std::function<void(int, size_t, size_t)> &fn);
+
+    // Restricts the worker threads to the CPUs of NUMA node `node` (see
+    // PinThreadToNumaNode() in numa.h). The calling thread is not pinned; it
+    // should run on the same node. Returns false if any worker could not be
+    // pinned.
+    bool PinWorkersToNumaNode(int node);
+
+private:
+    void WorkerLoop(int thread_index);
+
+    std::vector<std::thread> workers;
+
+    std::mutex mutex;
+    std::condition_variable work_available;
+    std::condition_variable work_done;
+    const std::function<void(int)> *work = nullptr;  // guarded by mutex
+    int generation = 0;  // guarded by mutex
+    int running = 0;  // guarded by mutex
+    bool stopping = false;  // guarded by mutex
+};
+
+}  // namespace wikipath
+
+#endif  // ndef WIKIPATH_THREAD_POOL_H_INCLUDED
@@ -0,0 +1,70 @@
+#ifndef WIKIPATH_VERTEX_ORDER_H_INCLUDED
+#define WIKIPATH_VERTEX_ORDER_H_INCLUDED
+
+#include "common.h"
+#include "graph-reader.h"
+#include "graph-writer.h"
+
+#include <optional>
+#include <span>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace wikipath {
+
+// Orders in which the vertices of a graph can be renumbered, so that vertices
+// that are linked together get nearby ids. A search then touches fewer cache
+// lines and pages of the graph file (and of the visited arrays, which are
+// indexed by vertex), and gaps in compressed adjacency lists are smaller.
+enum class VertexOrder {
+    // Breadth-first search over edges in both directions, starting from the
+    // vertex with the most edges.
+    BFS,
+
+    // Reverse Cuthill-McKee: a breadth-first search over edges in both
+    // directions that starts from a vertex with the fewest edges, and visits
+    // the neighbors of each vertex by increasing degree, reversed. This is the
+    // classic bandwidth-reducing order for sparse matrices.
+    RCM,
+
+    // By decreasing number of edges (in both directions), so that the edge
+    // lists and visited entries of the most linked vertices, which are
+    // reached by most searches, share cache lines and pages.
+    DEGREE,
+
+    // Gorder (Wei et al., "Speedup Graph Processing by Graph Ordering", 2016):
+    // greedily appends the vertex with the highest score with respect to the
+    // last `gorder_window` vertices, where the score of a pair of vertices is
+    // the number of edges between them plus the number of common
+    // predecessors. Slowest to compute, but usually the best locality.
+    GORDER,
+};
+
+// Returns the name of the order, e.g. "rcm".
+const char *VertexOrderName(VertexOrder order);
+
+// Returns the order with the given name, or nullopt if there is none.
+std::optional<VertexOrder> ParseVertexOrder(std::string_view name);
+
+struct VertexOrderOptions {
+    // Number of previously placed vertices that the score of a candidate
+    // vertex is computed against, for VertexOrder::GORDER.
+    int gorder_window = 5;
+};
+
+// Returns the new id of each vertex of `graph` in the given order. The result
+// is a permutation of the vertex ids that maps 0 to 0, since vertex 0 is
+// reserved in the Wikipedia graph.
+std::vector<index_t> ComputeVertexOrder(
+        const GraphReader &graph, VertexOrder order, const VertexOrderOptions &options = {});
+
+// Returns the sorted successors (first) and predecessors (second) of the
+// vertices of `graph` after renumbering them with `new_id`, indexed by new id,
+// which can be passed to WriteGraphOutput() or WriteCompressedGraphOutput().
+// The functions refer to `graph` and `new_id`, which must outlive them.
+std::pair<AdjacencyFn, AdjacencyFn> RenumberedAdjacency(const GraphReader &graph, std::span<const index_t> new_id);
+
+}  // namespace wikipath
+
+#endif  // ndef WIKIPATH_VERTEX_ORDER_H_INCLUDED
@@ -21,7 +21,9 @@ class ClientError(Exception):
         self.status = status
 
 
-def Serve(*, graph_filename, mlock, host, port, docroot, wiki_base_url, thread_daemon=None):
+def Serve(*, graph_filename, mlock, huge_pages='NONE', warm_up_threads=16, warm_up_mlock=False, numa_replicas=False,
+        host, port, docroot, wiki_base_url, thread_daemon=None,
+        search_timeout_ms=None, max_edges_expanded=None, result_cache_mb=None):
     '''Runs the webserver.
 
     `docroot` is the directory from which static content is served. Careful!
@@ -30,15 +32,39 @@ def Serve(*, graph_filename, mlock, host, port, docroot, wiki_base_url, thread_d
 
     `wiki_base_url` is the base URL for Wikipedia links, e.g.,
     https://en.wikipedia.org/wiki/ for the English wikipedia.
+
+    `search_timeout_ms` and `max_edges_expanded`, if not None, limit the work
+    done by each shortest path search. Searches that exceed a limit are
+    aborted, and /api/shortest-path responds with status 503.
+
+    `result_cache_mb`, if not None, is the capacity of a cache of shortest path
+    results (including page titles and link texts) in megabytes. Searches with
+    avoided pages or links bypass the cache.
     '''
 
     reader = wikipath.Reader(
         graph_filename,
         wikipath.GraphReader.OpenOptions(
             mlock=wikipath.GraphReader.OpenOptions.MLock.__entries[mlock][0],
+            huge_pages=wikipath.GraphReader.OpenOptions.HugePages.__entries[huge_pages][0],
+            warm_up_threads=warm_up_threads,
+            warm_up_mlock=warm_up_mlock,
+            numa_replicas=numa_replicas,
         ),
     )
 
+    # Reused between searches to avoid reallocating the search buffers. This is
+    # safe because requests are handled one at a time.
+    search_workspace = wikipath.SearchWorkspace()
+
+    result_cache = None
+    if result_cache_mb is not None:
+        result_cache = wikipath.ResultCache(int(result_cache_mb * (1 << 20)))
+
+    search_limits = wikipath.SearchLimits(timeout_ms=search_timeout_ms)
+    if max_edges_expanded is not None:
+        search_limits.max_edges_expanded = max_edges_expanded
+
     # A static byte array that describes the serving corpus, returned by /api/corpus
     get_corpus_response_bytes = json.dumps({
         'corpus': {
@@ -116,6 +142,33 @@ def Serve(*, graph_filename, mlock, host, port, docroot, wiki_base_url, thread_d
         return reader.metadata.get_page_by_title(arg)
 
 
+    def GetSearchFilter(qs):
+        '''Returns a SearchFilter that excludes the pages given by `avoid`
+        arguments and the links given by `avoid_link` arguments (of the form
+        "A|B", meaning the link from page A to page B), or None if there are
+        none. Pages are parsed like in GetPage(), except that "?" is not
+        allowed. If a page does not exist, this method raises a ClientError.'''
+        def GetAvoidedPage(arg):
+            page = GetPage(arg) if arg and arg != '?' else None
+            if page is None:
+                raise ClientError(f'Invalid page to avoid: {arg}')
+            return page
+
+        avoid = qs.get('avoid', [])
+        avoid_link = qs.get('avoid_link', [])
+        if not avoid and not avoid_link:
+            return None
+        search_filter = wikipath.SearchFilter()
+        for arg in avoid:
+            search_filter.ban_vertex(GetAvoidedPage(arg).id)
+        for arg in avoid_link:
+            parts = arg.split('|')
+            if len(parts) != 2:
+                raise ClientError(f'Invalid link to avoid: {arg}')
+            search_filter.ban_edge(GetAvoidedPage(parts[0]).id, GetAvoidedPage(parts[1]).id)
+        return search_filter
+
+
     def ErrorDict(message):
         return {"error": {"message": message}}
 
@@ -148,6 +201,7 @@ def Serve(*, graph_filename, mlock, host, port, docroot, wiki_base_url, thread_d
         qs = parse_qs(query)
         start  = GetPage(GetQueryArg(qs, 'start'))
         finish = GetPage(GetQueryArg(qs, 'finish'))
+        search_filter = GetSearchFilter(qs)
         result = {
             "start": PageDict(start),
             "finish": PageDict(finish),
@@ -156,20 +210,42 @@ def Serve(*, graph_filename, mlock, host, port, docroot, wiki_base_url, thread_d
             result["error"] = {"message": "Page not found."}
             SendJsonResponse(req, result, header_only=header_only, status=(404, 'Not found'))
             return
-        path, stats = reader.graph.shortest_path_with_stats(start.id, finish.id)
         result_path = []
-        prev_page = None
-        for page_id in path:
-            page = GetPageById(page_id)
-            result_path.append(PageDict(page, prev_page))
-            prev_page = page
+        if result_cache is not None and search_filter is None:
+            # The cached result includes the titles and link texts, so a cache
+            # hit needs no metadata lookups. Its stats are all zero.
+            hits = result_cache.stats().hits
+            cached, stats = reader.cached_shortest_path_with_stats(
+                start.id, finish.id, result_cache, workspace=search_workspace, limits=search_limits)
+            if cached is not None:
+                for page_id, title, link_text in zip(cached.path, cached.titles, cached.link_texts):
+                    page_dict = {"page": {"id": page_id, "title": title}}
+                    if result_path and link_text != title:
+                        page_dict['displayed_as'] = link_text
+                    result_path.append(page_dict)
+            from_cache = result_cache.stats().hits > hits
+        else:
+            path, stats = reader.graph.shortest_path_with_stats(
+                start.id, finish.id, workspace=search_workspace, limits=search_limits,
+                filter=search_filter)
+            prev_page = None
+            for page_id in path:
+                page = GetPageById(page_id)
+                result_path.append(PageDict(page, prev_page))
+                prev_page = page
+            from_cache = False
         result["path"] = result_path
         result["stats"] = {
             "vertices_reached": stats.vertices_reached,
             "vertices_expanded": stats.vertices_expanded,
             "edges_expanded": stats.edges_expanded,
             "time_taken_ms": stats.time_taken_ms,
+            "cached": from_cache,
         }
+        if stats.abort_reason != wikipath.AbortReason.NONE:
+            result["error"] = {"message": "Search aborted."}
+            SendJsonResponse(req, result, header_only=header_only, status=(503, 'Service Unavailable'))
+            return
         SendJsonResponse(req, result, header_only=header_only)
 
 
@@ -246,17 +322,39 @@ def Main():
     parser.add_argument('-h', '--host', default="localhost", help='Host to bind to')
     parser.add_argument('-p', '--port', default="8001", help='Port to bind to')
     parser.add_argument('--mlock', default='NONE', choices=wikipath.GraphReader.OpenOptions.MLock.__entries.keys())
+    parser.add_argument('--huge_pages', default='NONE',
+            choices=wikipath.GraphReader.OpenOptions.HugePages.__entries.keys(),
+            help='Back the graph with huge pages to reduce TLB misses')
+    parser.add_argument('--warm_up_threads', type=int, default=16,
+            help='Number of threads that load the graph with --mlock=PARALLEL')
+    parser.add_argument('--warm_up_mlock', action='store_true',
+            help='Lock the graph into memory after loading it with --mlock=PARALLEL')
+    parser.add_argument('--numa_replicas', action='store_true',
+            help='Copy the graph to each NUMA node, and search the copy on the node of the server thread')
     parser.add_argument('--wiki_base_url', default='https://en.wikipedia.org/wiki/')
+    parser.add_argument('--search_timeout_ms', type=float, default=None,
+            help='Abort searches that take longer than this many milliseconds')
+    parser.add_argument('--max_edges_expanded', type=int, default=None,
+            help='Abort searches that expand more than this many edges')
+    parser.add_argument('--result_cache_mb', type=float, default=64,
+            help='Size of the cache of shortest path results in megabytes (0 to disable)')
     parser.add_argument('filename.graph')
     args = parser.parse_args()
 
     Serve(
         graph_filename = vars(args)['filename.graph'],
         mlock = args.mlock,
+        huge_pages = args.huge_pages,
+        warm_up_threads = args.warm_up_threads,
+        warm_up_mlock = args.warm_up_mlock,
+        numa_replicas = args.numa_replicas,
         host = args.host,
         port = int(args.port),
         docroot = args.docroot,
         wiki_base_url = args.wiki_base_url,
+        search_timeout_ms = args.search_timeout_ms,
+        max_edges_expanded = args.max_edges_expanded,
+        result_cache_mb = args.result_cache_mb or None,
     )
 
 if __name__ == '__main__':
@@ -57,6 +57,21 @@ int64_t AnnotatedPage::CalculatePathCount(const AnnotatedPage *page, const Annot
 	return res;
 }
 
+int64_t AnnotatedPage::BoundedPathCount(const AnnotatedPage *finish, int64_t max_edges) const {
+    if (max_edges < 0) return 0;
+    if (this == finish) return 1;
+    if (max_edges == 0) return 0;
+    if (bounded_path_counts.size() <= static_cast<size_t>(max_edges)) {
+        bounded_path_counts.resize(max_edges + 1, -1);
+    }
+    if (bounded_path_counts[max_edges] == -1) {
+        int64_t res = 0;
+        for (const auto &link : links) res += link.Dst()->BoundedPathCount(finish, max_edges - 1);
+        bounded_path_counts[max_edges] = res;
+    }
+    return bounded_path_counts[max_edges];
+}
+
 void AnnotatedPage::SortLinks(std::vector<AnnotatedLink> &links, LinkOrder order) {
 
     switch (order) {
@@ -79,8 +94,9 @@ void AnnotatedPage::SortLinks(std::vector<AnnotatedLink> &links, LinkOrder order
 
 AnnotatedDag::AnnotatedDag(
 		const Reader *reader, index_t start_id, index_t finish_id,
-		const std::vector<std::pair<index_t, index_t>> &edge_list)
-            : reader(reader) {
+		const std::vector<std::pair<index_t, index_t>> &edge_list,
+		int max_length)
+            : reader(reader), max_length(max_length) {
     std::unordered_map<index_t, size_t> page_index_by_id;
     auto reserve_page_index = [&](index_t v) {
         auto [it, inserted] = page_index_by_id.insert({v, 0});
@@ -120,12 +136,13 @@ bool AnnotatedDag::EnumeratePaths(
         .callback = std::move(callback),
         .offset = offset,
         .order = order,
+        .max_length = max_length,
         .links = {},
     }.EnumeratePaths(start);
 }
 
 int64_t AnnotatedDag::CountPaths() const {
-    return start->PathCount(finish);
+    return start->PathCount(finish, max_length, 0);
 }
 
 bool AnnotatedDag::EnumeratePathsContext::EnumeratePaths(const AnnotatedPage *page) {
@@ -136,7 +153,10 @@ bool AnnotatedDag::EnumeratePathsContext::EnumeratePaths(const AnnotatedPage *pa
     for (const AnnotatedLink &link : page->Links(order)) {
         links.push_back(&link);
         int64_t n;
-        if (offset > 0 && (n = link.Dst()->PathCount(finish)) <= offset) {
+        // With a maximum length, links may lead to pages from which the finish
+        // cannot be reached in time, so these must be skipped too.
+        if ((offset > 0 || max_length >= 0) &&
+                (n = link.Dst()->PathCount(finish, max_length, links.size())) <= offset) {
             offset -= n;
         } else {
             if (!EnumeratePaths(link.Dst())) return false;
@@ -193,7 +213,8 @@ const AnnotatedPage *PathEnumerator::AdvanceToNextPage(int64_t &skip) {
         } else {
             int64_t n;
             const AnnotatedPage *page = link->Dst();
-            if (skip > 0 && (n = page->PathCount(finish)) <= skip) {
+            if ((skip > 0 || max_length >= 0) &&
+                    (n = page->PathCount(finish, max_length, path.size())) <= skip) {
                 skip -= n;
             } else {
                 path.back() = link;
@@ -206,13 +227,16 @@ const AnnotatedPage *PathEnumerator::AdvanceToNextPage(int64_t &skip) {
 
 // Finds a path to the finish after skipping `skip` paths (phrased differently:
 // finds the (skip + 1)'th path), or returns false if that path does not exist.
+//
+// Note that `page` may be the finish itself, when AdvanceToNextPage() follows a
+// link that leads directly to the finish.
 bool PathEnumerator::FindPathToFinish(const AnnotatedPage *page, int64_t skip) {
-    assert(page != finish);
     while (page != finish) {
         auto links = page->Links(order);
         size_t i = 0;
         int64_t n;
-        while (i < links.size() && skip > 0 && (n = links[i].Dst()->PathCount(finish)) <= skip) {
+        while (i < links.size() && (skip > 0 || max_length >= 0) &&
+                (n = links[i].Dst()->PathCount(finish, max_length, path.size() + 1)) <= skip) {
             skip -= n;
             ++i;
         }
@@ -0,0 +1,146 @@
+#include "wikipath/batch-search.h"
+
+#include "bidirectional-search.h"
+
+#include <algorithm>
+#include <coroutine>
+#include <exception>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace wikipath {
+namespace {
+
+// Memory of one search in flight, reused by the queries that run in the same
+// slot of the batch. The search state includes the buffer for the decoded
+// adjacency lists of a compressed graph, which must not be shared with the
+// searches in the other slots, since they run while this one is suspended.
+struct QueryState {
+    SparseVisitedMap visited;
+    BidirectionalSearchState state;
+};
+
+// Coroutine that runs one search. It starts suspended, and is resumed by
+// FindShortestPaths() until it is done.
+class QueryTask {
+public:
+    struct promise_type {
+        QueryTask get_return_object() {
+            return QueryTask(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+
+    QueryTask() = default;
+
+    QueryTask(QueryTask &&other) noexcept : handle(std::exchange(other.handle, {})) {}
+
+    QueryTask &operator=(QueryTask &&other) noexcept {
+        std::swap(handle, other.handle);
+        return *this;
+    }
+
+    ~QueryTask() {
+        if (handle) handle.destroy();
+    }
+
+    bool Active() const { return handle && !handle.done(); }
+
+    void Resume() { handle.resume(); }
+
+private:
+    explicit QueryTask(std::coroutine_handle<promise_type> handle) : handle(handle) {}
+
+    std::coroutine_handle<promise_type> handle;
+};
+
+// Searches a shortest path from `start` to `finish` and stores it in `path`.
+// This is the top-down search of FindShortestPath() with a SparseVisitedMap,
+// paused before each vertex (see InterleavedFrontier) to prefetch its edge
+// index, its edge list and the visited entries of its first neighbors, and
+// suspended after each prefetch.
+QueryTask SearchQuery(
+        const GraphReader &graph, index_t start, index_t finish, QueryState &query, std::vector<index_t> &path) {
+    if (start == finish) {
+        path = {start};
+        co_return;
+    }
+    SparseVisitedMap &visited = query.visited;
+    visited.Clear();
+    visited.SetMaxSize(std::numeric_limits<size_t>::max());
+    visited[start] = start;
+    visited[finish] = ~finish;
+    query.state.Reset(start, finish);
+
+    ParentMarks marks(visited, graph.VertexCount());
+    InterleavedFrontier frontier;
+    const NoFilter filter;
+    DummyStatsCollector stats_collector;
+    const SearchLimits no_limits;
+    LimitChecker limits(no_limits);
+    BidirectionalSearch search(graph, marks, frontier, query.state, nullptr, nullptr, ExpansionOptions{},
+            filter, stats_collector, limits);
+    SearchStatus status;
+    while ((status = search.Run()) == SearchStatus::PAUSED) {
+        const index_t v = query.state.PausedVertex();
+        const bool forward = query.state.expand_forward;
+        forward ? graph.PrefetchForwardIndex(v) : graph.PrefetchBackwardIndex(v);
+        co_await std::suspend_always{};
+        forward ? graph.PrefetchForwardEdges(v) : graph.PrefetchBackwardEdges(v);
+        co_await std::suspend_always{};
+        // As in PrefetchFringe(), the neighbors in a compressed graph are not
+        // decoded just to prefetch their marks.
+        if (!graph.Compressed()) {
+            const auto edges = forward ? graph.ForwardEdges(v) : graph.BackwardEdges(v);
+            for (index_t w : edges.first(std::min(edges.size(), max_prefetched_neighbors))) visited.Prefetch(w);
+            co_await std::suspend_always{};
+        }
+    }
+    if (status == SearchStatus::FOUND) path = marks.Path(start, finish);
+}
+
+}  // namespace
+
+std::vector<std::vector<index_t>> FindShortestPaths(
+        const GraphReader &graph,
+        std::span<const std::pair<index_t, index_t>> queries,
+        const BatchSearchOptions &options) {
+    // Search the copy of the graph on the NUMA node of the calling thread, if
+    // there is one.
+    const GraphReader &local_graph = graph.ForCurrentNode();
+    std::vector<std::vector<index_t>> paths(queries.size());
+    const size_t slot_count = std::min<size_t>(std::max(options.interleave, 1), queries.size());
+    std::vector<QueryState> states(slot_count);
+    std::vector<QueryTask> tasks(slot_count);
+    size_t next_query = 0;
+    for (size_t slot = 0; slot < slot_count; ++slot, ++next_query) {
+        const auto [start, finish] = queries[next_query];
+        tasks[slot] = SearchQuery(local_graph, start, finish, states[slot], paths[next_query]);
+    }
+
+    // Resume the searches in round-robin order, and start the next query in
+    // each slot whose search is done.
+    for (size_t active = slot_count; active > 0; ) {
+        for (size_t slot = 0; slot < slot_count; ++slot) {
+            QueryTask &task = tasks[slot];
+            if (!task.Active()) continue;
+            task.Resume();
+            if (task.Active()) continue;
+            if (next_query < queries.size()) {
+                const auto [start, finish] = queries[next_query];
+                task = SearchQuery(local_graph, start, finish, states[slot], paths[next_query]);
+                ++next_query;
+            } else {
+                task = QueryTask();
+                --active;
+            }
+        }
+    }
+    return paths;
+}
+
+}  // namespace wikipath
@@ -0,0 +1,1213 @@
+#ifndef WIKIPATH_BIDIRECTIONAL_SEARCH_H_INCLUDED
+#define WIKIPATH_BIDIRECTIONAL_SEARCH_H_INCLUDED
+
+#include "wikipath/common.h"
+#include "wikipath/graph-reader.h"
+#include "wikipath/hub-distances.h"
+#include "wikipath/neighbor-scan.h"
+#include "wikipath/searcher.h"
+#include "wikipath/thread-pool.h"
+
+#include "visited-map.h"
+
+#include <assert.h>
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <optional>
+#include <span>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace wikipath {
+
+// The bidirectional breadth-first search at the core of searcher.cc, and its
+// policies. It is also used by the interleaved searches in batch-search.cc.
+
+// Phases of a search, timed separately by RealStatsCollector.
+enum class SearchPhase {
+    SEARCH,       // bidirectional search
+    RECONSTRUCT,  // path reconstruction
+    PROPAGATE,    // collection of DAG edges
+    SORT,         // sorting of DAG edges
+};
+
+// Returns the resource usage of the calling thread. Page faults are counted
+// per thread, so that concurrent searches (and threads that warm up the page
+// cache) do not affect each other's counts.
+inline rusage ThreadUsage() {
+    rusage usage = {};
+    getrusage(RUSAGE_THREAD, &usage);
+    return usage;
+}
+
+class DummyStatsCollector {
+public:
+    static constexpr bool counts_faults = false;
+
+    void VertexReached() {}
+    void VertexExpanded() {}
+    void EdgeExpanded() {}
+    void Add(int64_t, int64_t, int64_t) {}
+    void AddFaults(int64_t, int64_t) {}
+    void LevelStarted(SearchLevel::Direction, SearchLevel::Mode, size_t) {}
+    void PhaseStarted(SearchPhase) {}
+};
+
+// Counts the page faults of the thread that runs the search (which must
+// create and destroy the collector), plus those added with AddFaults().
+class RealStatsCollector {
+public:
+    static constexpr bool counts_faults = true;
+
+    RealStatsCollector(SearchStats &stats)
+            : stats(stats), start_time(std::chrono::steady_clock::now()), phase_start_time(start_time),
+              start_usage(ThreadUsage()) {}
+
+    ~RealStatsCollector() {
+        EndLevel();
+        PhaseStarted(SearchPhase::SEARCH);
+        const rusage end_usage = ThreadUsage();
+        auto duration = std::chrono::steady_clock::now() - start_time;
+        stats = {
+            .vertices_reached = vertices_reached,
+            .vertices_expanded = vertices_expanded,
+            .edges_expanded = edges_expanded,
+            .time_taken_ms = duration / std::chrono::milliseconds(1),
+            .levels = std::move(levels),
+            .time_taken_ns = duration / std::chrono::nanoseconds(1),
+            .search_ns = phase_ns[static_cast<int>(SearchPhase::SEARCH)],
+            .reconstruct_ns = phase_ns[static_cast<int>(SearchPhase::RECONSTRUCT)],
+            .propagate_ns = phase_ns[static_cast<int>(SearchPhase::PROPAGATE)],
+            .sort_ns = phase_ns[static_cast<int>(SearchPhase::SORT)],
+            .minor_faults = end_usage.ru_minflt - start_usage.ru_minflt + minor_faults,
+            .major_faults = end_usage.ru_majflt - start_usage.ru_majflt + major_faults,
+        };
+    }
+
+    void VertexReached() { ++vertices_reached; }
+    void VertexExpanded() { ++vertices_expanded; }
+    void EdgeExpanded() { ++edges_expanded; }
+
+    // Adds counts collected separately, e.g. by other threads.
+    void Add(int64_t reached, int64_t expanded, int64_t edges) {
+        vertices_reached += reached;
+        vertices_expanded += expanded;
+        edges_expanded += edges;
+    }
+
+    // Adds page faults that occurred in other threads on behalf of the search.
+    void AddFaults(int64_t minor, int64_t major) {
+        minor_faults += minor;
+        major_faults += major;
+    }
+
+    // Starts a new level. The work counted until the next level starts (or
+    // the search ends) is attributed to this level.
+    void LevelStarted(SearchLevel::Direction direction, SearchLevel::Mode mode, size_t fringe_size) {
+        EndLevel();
+        levels.push_back({.direction = direction, .mode = mode, .fringe_size = static_cast<int64_t>(fringe_size)});
+        level_vertices_expanded = vertices_expanded;
+        level_edges_expanded = edges_expanded;
+    }
+
+    // Ends the current phase and starts the given one. The search starts in
+    // the SEARCH phase.
+    void PhaseStarted(SearchPhase phase) {
+        auto now = std::chrono::steady_clock::now();
+        phase_ns[static_cast<int>(current_phase)] += (now - phase_start_time) / std::chrono::nanoseconds(1);
+        phase_start_time = now;
+        current_phase = phase;
+    }
+
+    // Not copyable or assignable.
+    RealStatsCollector(const RealStatsCollector&) = delete;
+    RealStatsCollector &operator=(const RealStatsCollector&) = delete;
+
+private:
+    void EndLevel() {
+        if (levels.empty()) return;
+        levels.back().vertices_expanded = vertices_expanded - level_vertices_expanded;
+        levels.back().edges_expanded = edges_expanded - level_edges_expanded;
+    }
+
+    SearchStats &stats;
+    int64_t vertices_reached = 0;
+    int64_t vertices_expanded = 0;
+    int64_t edges_expanded = 0;
+    std::vector<SearchLevel> levels;
+    int64_t level_vertices_expanded = 0;
+    int64_t level_edges_expanded = 0;
+    std::chrono::time_point<std::chrono::steady_clock> start_time;
+    std::chrono::time_point<std::chrono::steady_clock> phase_start_time;
+    SearchPhase current_phase = SearchPhase::SEARCH;
+    int64_t phase_ns[4] = {};
+    rusage start_usage;
+    int64_t minor_faults = 0;
+    int64_t major_faults = 0;
+};
+
+// Enforces SearchLimits. The searches call VertexExpanded() for each vertex
+// they expand (single-threaded) or Check() for each chunk of vertices (from
+// any thread), and abort when either returns false.
+class LimitChecker {
+public:
+    // Number of vertices expanded between checks by VertexExpanded().
+    static constexpr int64_t chunk_size = 64;
+
+    explicit LimitChecker(const SearchLimits &limits)
+        : limits(limits),
+          limited(limits.max_vertices_expanded < std::numeric_limits<int64_t>::max() ||
+                  limits.max_edges_expanded < std::numeric_limits<int64_t>::max() ||
+                  limits.deadline != std::chrono::steady_clock::time_point::max() ||
+                  limits.cancel != nullptr) {}
+
+    // Records that a vertex with `edges` edges is about to be expanded, and
+    // checks the limits once per chunk. Returns false if the search must stop.
+    bool VertexExpanded(int64_t edges) {
+        pending_edges += edges;
+        if (++pending_vertices < chunk_size) return true;
+        bool result = Check(pending_vertices, pending_edges);
+        pending_vertices = pending_edges = 0;
+        return result;
+    }
+
+    // Records that the given number of vertices and edges were expanded, and
+    // checks the limits. Returns false if the search must stop. Thread-safe.
+    bool Check(int64_t vertices, int64_t edges) {
+        if (!limited) return true;
+        int64_t total_vertices = vertices_expanded.fetch_add(vertices, std::memory_order_relaxed) + vertices;
+        int64_t total_edges = edges_expanded.fetch_add(edges, std::memory_order_relaxed) + edges;
+        AbortReason reason = AbortReason::NONE;
+        if (total_vertices > limits.max_vertices_expanded) {
+            reason = AbortReason::VERTEX_LIMIT;
+        } else if (total_edges > limits.max_edges_expanded) {
+            reason = AbortReason::EDGE_LIMIT;
+        } else if (limits.cancel != nullptr && limits.cancel->load(std::memory_order_relaxed)) {
+            reason = AbortReason::CANCELLED;
+        } else if (limits.deadline != std::chrono::steady_clock::time_point::max() &&
+                std::chrono::steady_clock::now() >= limits.deadline) {
+            reason = AbortReason::DEADLINE;
+        }
+        if (reason == AbortReason::NONE) return !Aborted();
+        AbortReason expected = AbortReason::NONE;
+        abort_reason.compare_exchange_strong(expected, reason, std::memory_order_relaxed);
+        return false;
+    }
+
+    bool Aborted() const { return Reason() != AbortReason::NONE; }
+
+    AbortReason Reason() const { return abort_reason.load(std::memory_order_relaxed); }
+
+private:
+    const SearchLimits &limits;
+    const bool limited;
+    int64_t pending_vertices = 0;
+    int64_t pending_edges = 0;
+    std::atomic<int64_t> vertices_expanded = 0;
+    std::atomic<int64_t> edges_expanded = 0;
+    std::atomic<AbortReason> abort_reason = AbortReason::NONE;
+};
+
+// Filter policies, which decide whether a search may follow an edge. Like the
+// stats collectors, the searches are templated on the policy, so that the
+// checks compile to nothing when there is no filter.
+class NoFilter {
+public:
+    bool AllowsVertex(index_t) const { return true; }
+    bool AllowsEdge(index_t, index_t) const { return true; }
+};
+
+class RealFilter {
+public:
+    explicit RealFilter(const SearchFilter &filter) : filter(filter) {}
+
+    bool AllowsVertex(index_t v) const { return !filter.IsVertexBanned(v); }
+    bool AllowsEdge(index_t v, index_t w) const { return filter.AllowsEdge(v, w); }
+
+private:
+    const SearchFilter &filter;
+};
+
+// Vertices reached in one direction of a breadth-first search, in the order
+// in which they were reached. The current fringe is queue[begin:end]; vertices
+// reached while expanding the fringe are appended to the queue.
+//
+// Since the queue is never truncated during a search, it also serves as a list
+// of all touched vertices, which is used to reset the workspace afterwards.
+struct SearchQueue {
+    std::vector<index_t> queue;
+    size_t begin = 0;
+    size_t end = 0;
+
+    void Reset(index_t v) {
+        queue.clear();
+        queue.push_back(v);
+        begin = 0;
+        end = 1;
+    }
+
+    size_t FringeSize() const { return end - begin; }
+
+    void NextLevel() {
+        begin = end;
+        end = queue.size();
+    }
+};
+
+// Set of vertices in the fringe that is being expanded bottom-up, with one bit
+// per vertex, so that membership tests are cheap and cache-friendly.
+//
+// The bits are owned by the SearchWorkspace. Between levels, all bits are zero.
+class FringeBitmap {
+public:
+    explicit FringeBitmap(std::vector<uint64_t> &words) : words(words) {}
+
+    // Adds the fringe of `queue`.
+    void Insert(const SearchQueue &queue) {
+        for (size_t k = queue.begin; k < queue.end; ++k) {
+            index_t v = queue.queue[k];
+            words[v / 64] |= uint64_t{1} << (v % 64);
+        }
+    }
+
+    // Removes the fringe of `queue`, which must have been added by Insert().
+    void Erase(const SearchQueue &queue) {
+        for (size_t k = queue.begin; k < queue.end; ++k) {
+            words[queue.queue[k] / 64] = 0;
+        }
+    }
+
+    bool Contains(index_t v) const {
+        return (words[v / 64] >> (v % 64)) & 1;
+    }
+
+private:
+    std::vector<uint64_t> &words;
+};
+
+// Decides for each level of one direction of a search whether to expand the
+// fringe top-down or bottom-up, using the heuristic of Beamer et al. described
+// at SearchOptions::bottom_up_alpha.
+//
+// The number of edges that a bottom-up step would scan is the total number of
+// edges, minus the edges of vertices that were already reached in this
+// direction. Those are subtracted lazily, when a decision is needed, so that
+// small searches don't pay for the bookkeeping.
+class BottomUpHeuristic {
+public:
+    BottomUpHeuristic(const GraphReader &graph, const SearchOptions &options)
+        : options(options), vertex_count(graph.VertexCount()), unexplored_edges(graph.EdgeCount()) {}
+
+    // Returns whether the fringe of `queue` should be expanded bottom-up.
+    // top_down_degree(v) and bottom_up_degree(v) must return the number of edges
+    // scanned for vertex `v` by a top-down and bottom-up step respectively.
+    template<class TopDownDegree, class BottomUpDegree>
+    bool UseBottomUp(
+            const SearchQueue &queue,
+            TopDownDegree top_down_degree, BottomUpDegree bottom_up_degree) {
+        const size_t fringe_size = queue.FringeSize();
+        if (options.bottom_up_alpha <= 0 || fringe_size < options.bottom_up_min_fringe) {
+            return bottom_up = false;
+        }
+        for (; accounted_end < queue.end; ++accounted_end) {
+            unexplored_edges -= bottom_up_degree(queue.queue[accounted_end]);
+        }
+        if (bottom_up) {
+            return bottom_up = fringe_size * options.bottom_up_beta >= vertex_count;
+        }
+        int64_t fringe_edges = 0;
+        for (size_t k = queue.begin; k < queue.end; ++k) {
+            fringe_edges += top_down_degree(queue.queue[k]);
+        }
+        return bottom_up = fringe_edges * options.bottom_up_alpha > unexplored_edges;
+    }
+
+private:
+    const SearchOptions &options;
+    const index_t vertex_count;
+    int64_t unexplored_edges;
+
+    // Number of vertices at the front of the queue that have been subtracted
+    // from `unexplored_edges`.
+    size_t accounted_end = 0;
+
+    // Whether the previous level was expanded bottom-up.
+    bool bottom_up = false;
+};
+
+// Expands large top-down levels on all threads of a ThreadPool.
+//
+// The fringe is divided between the threads with ThreadPool::ParallelFor().
+// Threads claim newly reached vertices with an atomic compare-and-swap on the
+// visited map (or distance array), so each vertex is added to the next fringe
+// exactly once, by the thread that claimed it. Each thread collects its part
+// of the next fringe in its own buffer; after the level, the buffers are copied
+// into the queue in parallel, at offsets computed from their sizes.
+class ParallelExpander {
+public:
+    // Per-thread buffers and counters. Aligned to avoid false sharing.
+    struct alignas(64) ThreadState {
+        std::vector<index_t> next;
+        std::vector<std::pair<index_t, index_t>> meetings;
+        int64_t reached = 0;
+        int64_t expanded = 0;
+        int64_t edges = 0;
+        rusage start_usage = {};
+        int64_t minor_faults = 0;
+        int64_t major_faults = 0;
+    };
+
+    // Number of fringe vertices claimed at a time by one thread.
+    static constexpr size_t grain = 64;
+
+    ParallelExpander(ThreadPool &pool, std::vector<ThreadState> &threads, size_t min_fringe)
+        : pool(pool), threads(threads), min_fringe(min_fringe) {
+        assert(threads.size() == static_cast<size_t>(pool.ThreadCount()));
+    }
+
+    bool ShouldExpand(const SearchQueue &queue) const {
+        return queue.FringeSize() >= min_fringe;
+    }
+
+    // Calls visit(v, w, thread_state) for each vertex v in the fringe of
+    // `queue` and each w in neighbors(v). `visit` must push w onto
+    // thread_state.next if it claims w, and may record meeting edges in
+    // thread_state.meetings. If it returns false, the level is aborted as soon
+    // as possible.
+    //
+    // Afterwards, the vertices claimed by all threads are appended to the queue
+    // (without advancing the fringe), and the meeting edges can be retrieved
+    // with Meetings().
+    //
+    // If `limits` is not null, each thread checks it after each chunk, and the
+    // level is aborted if a limit is exceeded.
+    template<class NeighborsFn, class VisitFn, class StatsCollectorT>
+    void ExpandLevel(
+            SearchQueue &queue, NeighborsFn neighbors, VisitFn visit,
+            StatsCollectorT &stats_collector, LimitChecker *limits = nullptr) {
+        for (ThreadState &thread : threads) {
+            thread.next.clear();
+            thread.meetings.clear();
+            thread.reached = thread.expanded = thread.edges = 0;
+        }
+        // The calling thread runs as thread 0, so its page faults are already
+        // counted by the stats collector. Those of the workers are measured
+        // from here until their part of the queue has been copied.
+        if constexpr (StatsCollectorT::counts_faults) {
+            pool.Run([&](int thread_index) {
+                if (thread_index > 0) threads[thread_index].start_usage = ThreadUsage();
+            });
+        }
+
+        std::atomic<bool> aborted = false;
+        pool.ParallelFor(queue.begin, queue.end, grain,
+            [&](int thread_index, size_t begin, size_t end) {
+                ThreadState &thread = threads[thread_index];
+                const int64_t expanded_before = thread.expanded;
+                const int64_t edges_before = thread.edges;
+                for (size_t k = begin; k < end && !aborted.load(std::memory_order_relaxed); ++k) {
+                    index_t v = queue.queue[k];
+                    ++thread.expanded;
+                    for (index_t w : neighbors(v)) {
+                        ++thread.edges;
+                        if (!visit(v, w, thread)) {
+                            aborted.store(true, std::memory_order_relaxed);
+                            break;
+                        }
+                    }
+                }
+                if (limits != nullptr &&
+                        !limits->Check(thread.expanded - expanded_before, thread.edges - edges_before)) {
+                    aborted.store(true, std::memory_order_relaxed);
+                }
+            });
+
+        std::vector<size_t> offsets(threads.size());
+        size_t total = queue.queue.size();
+        for (size_t i = 0; i < threads.size(); ++i) {
+            offsets[i] = total;
+            total += threads[i].next.size();
+            stats_collector.Add(threads[i].reached, threads[i].expanded, threads[i].edges);
+        }
+        queue.queue.resize(total);
+        pool.Run([&](int thread_index) {
+            ThreadState &thread = threads[thread_index];
+            std::copy(thread.next.begin(), thread.next.end(), queue.queue.begin() + offsets[thread_index]);
+            if constexpr (StatsCollectorT::counts_faults) {
+                if (thread_index > 0) {
+                    const rusage end_usage = ThreadUsage();
+                    thread.minor_faults = end_usage.ru_minflt - thread.start_usage.ru_minflt;
+                    thread.major_faults = end_usage.ru_majflt - thread.start_usage.ru_majflt;
+                }
+            }
+        });
+        if constexpr (StatsCollectorT::counts_faults) {
+            for (size_t i = 1; i < threads.size(); ++i) {
+                stats_collector.AddFaults(threads[i].minor_faults, threads[i].major_faults);
+            }
+        }
+    }
+
+    // Calls fn(v, w) for each meeting edge recorded during the last level.
+    template<class Fn>
+    void ForEachMeeting(Fn fn) const {
+        for (const ThreadState &thread : threads) {
+            for (auto [v, w] : thread.meetings) fn(v, w);
+        }
+    }
+
+private:
+    ThreadPool &pool;
+    std::vector<ThreadState> &threads;
+    const size_t min_fringe;
+};
+
+// State of a bidirectional search, excluding the set of visited vertices. This
+// is kept separate so that the search can be continued with a different type
+// of visited map.
+struct BidirectionalSearchState {
+    SearchQueue forward;
+    SearchQueue backward;
+
+    // Direction of the current level, and the queue index of the next vertex in
+    // the fringe to be expanded. The direction is chosen when a level starts.
+    // (Bottom-up levels are never interrupted, so next_index is only used for
+    // top-down levels.)
+    bool level_started = false;
+    bool expand_forward = false;
+    bool bottom_up = false;
+    bool parallel = false;
+    size_t next_index = 0;
+
+    // Number of levels expanded in each direction, which is the distance of
+    // the vertices in the fringe from `start` (or to `finish`).
+    int forward_depth = 0;
+    int backward_depth = 0;
+
+    // Scratch space for SortFringe().
+    std::vector<index_t> sort_buffer;
+
+    // Decoded adjacency lists of a compressed graph.
+    std::vector<index_t> edges_buffer;
+
+    // Whether the search returned SearchStatus::PAUSED before expanding the
+    // vertex at next_index (see InterleavedFrontier).
+    bool paused = false;
+
+    void Reset(index_t start, index_t finish) {
+        forward.Reset(start);
+        backward.Reset(finish);
+        level_started = false;
+        forward_depth = 0;
+        backward_depth = 0;
+        paused = false;
+    }
+
+    // Returns the vertex that a paused search expands when it is continued.
+    index_t PausedVertex() const {
+        assert(paused);
+        return (expand_forward ? forward : backward).queue[next_index];
+    }
+};
+
+// Options of BidirectionalSearch that change the order and memory access
+// pattern of top-down levels, but not the length of the path that is found.
+struct ExpansionOptions {
+    size_t prefetch_distance = 0;  // see SearchOptions::prefetch_distance
+    bool sort_fringes = false;     // see SearchOptions::sort_fringes
+};
+
+// Sorts a fringe of vertex ids less than `size` in increasing order, with an
+// LSD radix sort on 11-bit digits that uses `buffer` as scratch space. Small
+// fringes are sorted with std::sort() instead.
+inline void SortFringe(std::span<index_t> fringe, index_t size, std::vector<index_t> &buffer) {
+    constexpr size_t radix_sort_min_size = 4096;
+    if (fringe.size() < radix_sort_min_size) {
+        std::sort(fringe.begin(), fringe.end());
+        return;
+    }
+    constexpr int digit_bits = 11;
+    constexpr index_t digit_mask = (1u << digit_bits) - 1;
+    buffer.resize(fringe.size());
+    std::span<index_t> from = fringe, to = buffer;
+    const int bits = std::bit_width(size - 1);
+    for (int shift = 0; shift < bits; shift += digit_bits) {
+        std::array<size_t, digit_mask + 1> offsets = {};
+        for (index_t v : from) ++offsets[(v >> shift) & digit_mask];
+        size_t total = 0;
+        for (size_t &offset : offsets) total += std::exchange(offset, total);
+        for (index_t v : from) to[offsets[(v >> shift) & digit_mask]++] = v;
+        std::swap(from, to);
+    }
+    if (from.data() != fringe.data()) std::copy(from.begin(), from.end(), fringe.begin());
+}
+
+// Bounds on the length of a shortest path from the hub distances (see
+// SearchOptions::hub_distances).
+//
+// When no path is found after expanding the fringes to depths df and db,
+// every path is longer than df + db. Once that reaches the length of the
+// shortest path through a hub, that path is a shortest path. Until then, a
+// fringe vertex v at depth df whose lower bound d(v, finish) >= upper_bound
+// - df can only lie on paths that are no shorter, so it is not expanded
+// (it stays visited, so a path through it may still be found).
+class HubBound {
+public:
+    HubBound(const HubDistances &hubs, index_t start, index_t finish)
+            : hubs(hubs), start(start), finish(finish) {
+        std::tie(upper_bound, hub) = hubs.UpperBound(start, finish);
+    }
+
+    // Removes vertices that cannot lie on a path shorter than the upper bound
+    // from the forward or backward fringe, by moving them before the start of
+    // the fringe. Only the fringe that is about to be expanded is worth
+    // pruning, since checking a vertex costs about as much as expanding it.
+    void Prune(BidirectionalSearchState &state, bool forward) {
+        if (forward) {
+            Prune(state.forward, state.forward_depth, true);
+        } else {
+            Prune(state.backward, state.backward_depth, false);
+        }
+    }
+
+    // Returns whether the path through the hub is a shortest path.
+    bool Reached(const BidirectionalSearchState &state) const {
+        return hub >= 0 && (state.forward.FringeSize() == 0 || state.backward.FringeSize() == 0 ||
+                state.forward_depth + state.backward_depth + 1 >= upper_bound);
+    }
+
+    std::vector<index_t> Path(const GraphReader &graph) const {
+        return hubs.PathViaHub(graph, start, finish, hub);
+    }
+
+private:
+    void Prune(SearchQueue &queue, int depth, bool forward) {
+        for (size_t i = queue.begin; i < queue.end; ++i) {
+            index_t v = queue.queue[i];
+            int bound = forward ? hubs.LowerBound(v, finish) : hubs.LowerBound(start, v);
+            if (depth + bound >= upper_bound) std::swap(queue.queue[i], queue.queue[queue.begin++]);
+        }
+    }
+
+    const HubDistances &hubs;
+    const index_t start;
+    const index_t finish;
+    int upper_bound;  // HubDistances::UNREACHABLE if there is no path through a hub
+    int hub;
+};
+
+// Adjacency lists shorter than this are scanned with the scalar loop in
+// BidirectionalSearch, since a vectorized kernel would only run its scalar tail.
+constexpr size_t min_scan_kernel_degree = 16;
+
+// Returns the kernel used to scan adjacency lists in searches of `graph`,
+// which is scalar if vertex ids do not fit the kernels' 32-bit offsets.
+inline ScanKernel SearchScanKernel(const GraphReader &graph) {
+    return graph.VertexCount() <= (index_t{1} << 31) ? BestScanKernel() : ScanKernel::SCALAR;
+}
+
+// Scans the adjacency list `edges` of a fringe vertex with ScanNeighbors(),
+// appending the newly reached vertices to `queue`, and returns the index of
+// the neighbor where the search meets the other side, or edges.size().
+template<class StatsCollectorT>
+size_t ScanAdjacencyList(
+        ScanKernel kernel, std::span<const index_t> edges, DenseVisitedMap &visited, SearchQueue &queue,
+        index_t mark, index_t meet_min, index_t meet_count, StatsCollectorT &stats_collector) {
+    const size_t old_size = queue.queue.size();
+    queue.queue.resize(old_size + edges.size());
+    ScanResult result = ScanNeighbors(
+            kernel, edges, visited.Data(), mark, meet_min, meet_count, queue.queue.data() + old_size);
+    queue.queue.resize(old_size + result.reached);
+    stats_collector.Add(result.reached, 0, std::min(result.meeting + 1, edges.size()));
+    return result.meeting;
+}
+
+// Maximum number of neighbors of a single vertex whose marks are prefetched by
+// PrefetchFringe(). Prefetching the neighbors of a hub would only evict the
+// lines prefetched for the next few vertices.
+constexpr size_t max_prefetched_neighbors = 32;
+
+// Returns the neighbors of `v` in the direction of a search: its successors
+// in a forward search, and its predecessors in a backward search.
+template<bool forward>
+std::span<const index_t> Neighbors(const GraphReader &graph, index_t v) {
+    return forward ? graph.ForwardEdges(v) : graph.BackwardEdges(v);
+}
+
+// As above, but decodes the neighbors of a compressed graph into `buffer`.
+template<bool forward>
+std::span<const index_t> Neighbors(const GraphReader &graph, index_t v, std::vector<index_t> &buffer) {
+    return forward ? graph.ForwardEdges(v, buffer) : graph.BackwardEdges(v, buffer);
+}
+
+// Returns the edge (i, j) between a vertex `v` of a forward or backward
+// fringe and its neighbor `w`.
+template<bool forward>
+std::pair<index_t, index_t> FringeEdge(index_t v, index_t w) {
+    if constexpr (forward) {
+        return {v, w};
+    } else {
+        return {w, v};
+    }
+}
+
+// Issues prefetches for the fringe vertices after queue[next] when they are
+// expanded in the given direction; see SearchOptions::prefetch_distance.
+template<bool forward, class MarksT>
+inline void PrefetchFringe(
+        const GraphReader &graph, const SearchQueue &queue, size_t next, size_t distance, MarksT &marks) {
+    if (size_t k = next + 2 * distance; k < queue.end) {
+        forward ? graph.PrefetchForwardIndex(queue.queue[k]) : graph.PrefetchBackwardIndex(queue.queue[k]);
+    }
+    if (size_t k = next + distance; k < queue.end) {
+        forward ? graph.PrefetchForwardEdges(queue.queue[k]) : graph.PrefetchBackwardEdges(queue.queue[k]);
+    }
+    // The marks of a sparse map are in a hash table, whose slots are not known
+    // without probing. The neighbors in a compressed graph are not known
+    // without decoding them, which is not worth it for a prefetch.
+    if constexpr (MarksT::dense) {
+        if (size_t k = next + (distance + 1) / 2; k < queue.end && !graph.Compressed()) {
+            auto edges = Neighbors<forward>(graph, queue.queue[k]);
+            for (index_t w : edges.first(std::min(edges.size(), max_prefetched_neighbors))) marks.Prefetch(w);
+        }
+    }
+}
+
+// Result of visiting a vertex across an edge from the side being expanded.
+enum class Visit {
+    REACHED,  // the vertex was unvisited, and is now reached by this side
+    MEETING,  // the vertex was reached by the other side
+    SEEN,     // the vertex was already reached by this side
+};
+
+// Marks policies, which decide what BidirectionalSearch records for each
+// visited vertex, and what happens when the two sides meet. A marks policy
+// provides:
+//
+//  - constants `concurrent` (AtomicTopDown() may be called by several threads
+//    at once), `dense` (every vertex has a mark, which bottom-up levels and
+//    Prefetch() require), `can_scan` (Scan() is supported) and
+//    `stop_at_meeting` (the search ends at the first meeting edge, instead of
+//    finishing the level to find all of them);
+//  - HasRoomFor(n): whether n more vertices can be reached;
+//  - StartLevel(forward): called when a level starts; returns false if the
+//    search cannot continue;
+//  - TopDown<forward>(i, j) and AtomicTopDown<forward>(i, j): visit the end of
+//    edge (i, j) that is not in the fringe (j if forward, i otherwise);
+//  - Unreached<forward>(v): whether a bottom-up level must look for a
+//    neighbor of v in the fringe;
+//  - BottomUp<forward>(i, j): visits the unreached end of edge (i, j), whose
+//    other end is in the fringe;
+//  - Meet(i, j): records a meeting edge (i, j).
+
+// Marks of FindShortestPath(): for each vertex, the visited map stores
+//
+//  0 if vertex is unvisited
+//  0 < v < size: if vertex was reachable via a forward edge from `v`
+//  0 < ~v < size: if vertex was reachable via a backward edge from `v`
+//
+// The search stops at the first meeting edge, from which Path() reconstructs
+// the path.
+template<class VisitedMapT>
+class ParentMarks {
+public:
+    static constexpr bool concurrent = VisitedMapT::concurrent;
+    static constexpr bool dense = std::is_same_v<VisitedMapT, DenseVisitedMap>;
+    static constexpr bool can_scan = dense;
+    static constexpr bool stop_at_meeting = true;
+
+    ParentMarks(VisitedMapT &visited, index_t size) : visited(visited), size(size) {}
+
+    bool HasRoomFor(size_t n) const { return visited.HasRoomFor(n); }
+
+    bool StartLevel(bool) { return true; }
+
+    template<bool forward>
+    Visit TopDown(index_t i, index_t j) {
+        if constexpr (forward) {
+            index_t &visited_j = visited[j];
+            if (visited_j == 0) {
+                visited_j = i;
+                return Visit::REACHED;
+            }
+            if (~visited_j < size) return Visit::MEETING;
+            assert(visited_j < size);
+            return Visit::SEEN;
+        } else {
+            index_t &visited_i = visited[i];
+            if (visited_i == 0) {
+                visited_i = ~j;
+                return Visit::REACHED;
+            }
+            if (visited_i < size) return Visit::MEETING;
+            assert(~visited_i < size);
+            return Visit::SEEN;
+        }
+    }
+
+    template<bool forward>
+    Visit AtomicTopDown(index_t i, index_t j) {
+        auto mark = visited.AtomicRef(forward ? j : i);
+        index_t value = mark.load(std::memory_order_relaxed);
+        if (value == 0 && mark.compare_exchange_strong(value, forward ? i : ~j, std::memory_order_relaxed)) {
+            return Visit::REACHED;
+        }
+        return (forward ? ~value < size : value < size) ? Visit::MEETING : Visit::SEEN;
+    }
+
+    template<bool forward>
+    bool Unreached(index_t v) {
+        index_t value = visited[v];
+        return value == 0 || (forward ? value >= size : ~value >= size);
+    }
+
+    template<bool forward>
+    Visit BottomUp(index_t i, index_t j) {
+        index_t &value = visited[forward ? j : i];
+        if (value != 0) return Visit::MEETING;
+        value = forward ? i : ~j;
+        return Visit::REACHED;
+    }
+
+    void Meet(index_t i, index_t j) {
+        meet_i = i;
+        meet_j = j;
+    }
+
+    void Prefetch(index_t v) { visited.Prefetch(v); }
+
+    // Scans the neighbors `edges` of fringe vertex `v` with ScanNeighbors(),
+    // and returns the index of the neighbor where the search meets the other
+    // side, or edges.size().
+    template<bool forward, class StatsCollectorT>
+    size_t Scan(ScanKernel kernel, index_t v, std::span<const index_t> edges, SearchQueue &queue,
+            StatsCollectorT &stats_collector) {
+        // Forward marks are i for 0 < i < size, backward marks are ~j for j < size.
+        return forward
+            ? ScanAdjacencyList(kernel, edges, visited, queue, v, ~(size - 1), size, stats_collector)
+            : ScanAdjacencyList(kernel, edges, visited, queue, ~v, 1, size - 1, stats_collector);
+    }
+
+    // Returns the path from `start` to `finish` through the meeting edge.
+    std::vector<index_t> Path(index_t start, index_t finish) {
+        std::vector<index_t> path;
+        for (index_t i = meet_i; i != start; i = visited[i]) path.push_back(i);
+        path.push_back(start);
+        std::reverse(path.begin(), path.end());
+        for (index_t j = meet_j; j != finish; j = ~visited[j]) path.push_back(j);
+        path.push_back(finish);
+        return path;
+    }
+
+private:
+    VisitedMapT &visited;
+    const index_t size;
+    index_t meet_i = 0;
+    index_t meet_j = 0;
+};
+
+// Marks of FindShortestPathDag(): 8-bit distance labels, with start at 1 and
+// finish at 255, so dist[v] - 1 is the distance from start to v for vertices
+// reached by the forward search, and 255 - dist[v] the distance from v to
+// finish for vertices reached by the backward search, or dist[v] is 0 if v is
+// unvisited. This limits paths to 254 edges.
+//
+// The search finishes the level where the sides meet, and adds every meeting
+// edge to `edges`, and its ends to the propagation lists.
+class DistanceMarks {
+public:
+    using dist_t = std::uint_least8_t;
+
+    static constexpr bool concurrent = true;
+    static constexpr bool dense = true;
+    static constexpr bool can_scan = false;
+    static constexpr bool stop_at_meeting = false;
+
+    // Labels of the fringes of the forward and backward search.
+    dist_t forward_dist = 1;
+    dist_t backward_dist = std::numeric_limits<dist_t>::max();
+
+    DistanceMarks(std::vector<dist_t> &dist, std::vector<bool> &marked,
+            std::vector<index_t> &propagate_forward, std::vector<index_t> &propagate_backward,
+            std::vector<std::pair<index_t, index_t>> &edges)
+        : dist(dist), marked(marked), propagate_forward(propagate_forward),
+          propagate_backward(propagate_backward), edges(edges) {}
+
+    bool HasRoomFor(size_t) const { return true; }
+
+    bool StartLevel(bool forward) {
+        if (backward_dist - forward_dist < 2) {
+            // This happens when the path length is greater than fits in dist_t.
+            // This shouldn't happen in real-world graphs, where the maximum
+            // path length is relatively small (under the maximum of 254).
+            std::cerr << "WARNING: path length too great!\n";
+            return false;
+        }
+        forward ? ++forward_dist : --backward_dist;
+        return true;
+    }
+
+    template<bool forward>
+    Visit TopDown(index_t i, index_t j) {
+        if constexpr (forward) {
+            dist_t &dist_j = dist[j];
+            if (dist_j == 0) {
+                dist_j = forward_dist;
+                return Visit::REACHED;
+            }
+            return forward_dist < dist_j ? Visit::MEETING : Visit::SEEN;
+        } else {
+            dist_t &dist_i = dist[i];
+            if (dist_i == 0) {
+                dist_i = backward_dist;
+                return Visit::REACHED;
+            }
+            return dist_i < backward_dist ? Visit::MEETING : Visit::SEEN;
+        }
+    }
+
+    template<bool forward>
+    Visit AtomicTopDown(index_t i, index_t j) {
+        std::atomic_ref<dist_t> mark(dist[forward ? j : i]);
+        const dist_t new_dist = forward ? forward_dist : backward_dist;
+        dist_t value = mark.load(std::memory_order_relaxed);
+        if (value == 0 && mark.compare_exchange_strong(value, new_dist, std::memory_order_relaxed)) {
+            return Visit::REACHED;
+        }
+        return (forward ? forward_dist < value : value < backward_dist) ? Visit::MEETING : Visit::SEEN;
+    }
+
+    template<bool forward>
+    bool Unreached(index_t v) {
+        const dist_t dist_v = dist[v];
+        return forward ? dist_v == 0 || dist_v > forward_dist : dist_v < backward_dist;
+    }
+
+    template<bool forward>
+    Visit BottomUp(index_t i, index_t j) {
+        dist_t &value = dist[forward ? j : i];
+        if (value != 0) return Visit::MEETING;
+        value = forward ? forward_dist : backward_dist;
+        return Visit::REACHED;
+    }
+
+    // Marks i->j as an edge on a shortest path.
+    void Meet(index_t i, index_t j) {
+        edges.push_back({i, j});
+        if (!marked[i]) {
+            marked[i] = true;
+            propagate_backward.push_back(i);
+        }
+        if (!marked[j]) {
+            marked[j] = true;
+            propagate_forward.push_back(j);
+        }
+    }
+
+    void Prefetch(index_t v) { __builtin_prefetch(&dist[v], 1); }
+
+private:
+    std::vector<dist_t> &dist;
+    std::vector<bool> &marked;
+    std::vector<index_t> &propagate_forward;
+    std::vector<index_t> &propagate_backward;
+    std::vector<std::pair<index_t, index_t>> &edges;
+};
+
+// Frontier policies, which decide whether each level of a BidirectionalSearch
+// is expanded top-down from the fringe in the search queue, or bottom-up with
+// the fringe in a bitmap (which requires dense marks), and whether the search
+// pauses before each top-down vertex.
+class TopDownFrontier {
+public:
+    static constexpr bool bottom_up = false;
+    static constexpr bool pause = false;
+
+    bool UseBottomUp(const BidirectionalSearchState &, bool) { return false; }
+};
+
+class HybridFrontier {
+public:
+    static constexpr bool bottom_up = true;
+    static constexpr bool pause = false;
+
+    HybridFrontier(const GraphReader &graph, const SearchOptions &options, std::vector<uint64_t> &fringe_words)
+        : fringe(fringe_words), graph(graph), forward(graph, options), backward(graph, options) {
+        if (fringe_words.size() < graph.VertexCount() / 64 + 1) {
+            fringe_words.resize(graph.VertexCount() / 64 + 1, 0);
+        }
+    }
+
+    bool UseBottomUp(const BidirectionalSearchState &state, bool expand_forward) {
+        auto forward_degree = [this](index_t v) { return graph.ForwardDegree(v); };
+        auto backward_degree = [this](index_t v) { return graph.BackwardDegree(v); };
+        return expand_forward
+            ? forward.UseBottomUp(state.forward, forward_degree, backward_degree)
+            : backward.UseBottomUp(state.backward, backward_degree, forward_degree);
+    }
+
+    FringeBitmap fringe;
+
+private:
+    const GraphReader &graph;
+    BottomUpHeuristic forward;
+    BottomUpHeuristic backward;
+};
+
+// Frontier of the interleaved searches of FindShortestPaths(), which expands
+// levels top-down, but returns SearchStatus::PAUSED before each vertex. The
+// caller can then prefetch the memory of state.PausedVertex(), and run other
+// searches while it loads, before it continues the search with Run().
+class InterleavedFrontier : public TopDownFrontier {
+public:
+    static constexpr bool pause = true;
+};
+
+// Direction policy that expands the side with the smaller fringe, which keeps
+// the two searches balanced.
+class SmallerFringeFirst {
+public:
+    static bool ExpandForward(const BidirectionalSearchState &state) {
+        return state.forward.FringeSize() <= state.backward.FringeSize();
+    }
+};
+
+enum class SearchStatus {
+    FOUND,      // the searches met (see MarksT::Meet())
+    NOT_FOUND,  // no path exists
+    FULL,       // visited map is full; must continue with a different map
+    ABORTED,    // search exceeded its limits
+    HUB_PATH,   // the path through the hub of `hub_bound` is a shortest path
+    PAUSED,     // the search will expand state.PausedVertex() when continued
+};
+
+// Bidirectional breadth-first search from `start` to `finish`, which is the
+// core of FindShortestPath() and FindShortestPathDag(). It is composed of
+// policies (see above) for the marks of visited vertices, the frontier, the
+// direction of each level, the stats collector and the filter; like the
+// stats collectors, they are template parameters, so unused features compile
+// to nothing.
+//
+// Run() runs (or continues) the search until the searches meet, the search
+// space is exhausted, the marks are full, the search exceeds `limits`, or the
+// frontier pauses it.
+// The search can be continued with different marks and frontier, since its
+// state (besides the marks) is kept in `state`.
+//
+// If `parallel` is not null, large top-down levels are expanded in parallel,
+// which requires concurrent marks. Edges that `filter` does not allow are
+// skipped. If `hub_bound` is not null, fringes are pruned with it, and the
+// search stops when the path through its hub is a shortest path.
+// `expansion` selects prefetching and sorting of top-down fringes.
+template<class MarksT, class FrontierT, class FilterT, class StatsCollectorT, class DirectionT = SmallerFringeFirst>
+class BidirectionalSearch {
+public:
+    static_assert(!FrontierT::bottom_up || MarksT::dense, "bottom-up levels scan the marks of all vertices");
+
+    BidirectionalSearch(
+            const GraphReader &graph, MarksT &marks, FrontierT &frontier, BidirectionalSearchState &state,
+            ParallelExpander *parallel, HubBound *hub_bound, const ExpansionOptions &expansion,
+            const FilterT &filter, StatsCollectorT &stats_collector, LimitChecker &limits)
+        : graph(graph), size(graph.VertexCount()), marks(marks), frontier(frontier), state(state),
+          parallel(parallel), hub_bound(hub_bound), expansion(expansion), filter(filter),
+          stats_collector(stats_collector), limits(limits),
+          scan_kernel(can_scan ? SearchScanKernel(graph) : ScanKernel::SCALAR) {
+        assert(parallel == nullptr || MarksT::concurrent);
+    }
+
+    SearchStatus Run() {
+        for (;;) {
+            if (!state.level_started) {
+                if (hub_bound != nullptr) {
+                    hub_bound->Prune(state, DirectionT::ExpandForward(state));
+                    if (hub_bound->Reached(state)) return SearchStatus::HUB_PATH;
+                }
+                if (state.forward.FringeSize() == 0 || state.backward.FringeSize() == 0) {
+                    return SearchStatus::NOT_FOUND;
+                }
+                state.expand_forward = DirectionT::ExpandForward(state);
+                if (!marks.StartLevel(state.expand_forward)) return SearchStatus::NOT_FOUND;
+                state.level_started = true;
+                SearchQueue &queue = state.expand_forward ? state.forward : state.backward;
+                state.next_index = queue.begin;
+                state.bottom_up = frontier.UseBottomUp(state, state.expand_forward);
+                state.parallel = !state.bottom_up && parallel != nullptr && parallel->ShouldExpand(queue);
+                if (expansion.sort_fringes && !state.bottom_up) {
+                    SortFringe(std::span(queue.queue).subspan(queue.begin, queue.FringeSize()), size,
+                            state.sort_buffer);
+                }
+                stats_collector.LevelStarted(
+                    state.expand_forward ? SearchLevel::Direction::FORWARD : SearchLevel::Direction::BACKWARD,
+                    state.bottom_up ? SearchLevel::Mode::BOTTOM_UP : SearchLevel::Mode::TOP_DOWN,
+                    queue.FringeSize());
+            }
+            if (auto status = state.expand_forward ? ExpandLevel<true>() : ExpandLevel<false>()) return *status;
+            ++(state.expand_forward ? state.forward_depth : state.backward_depth);
+            state.level_started = false;
+        }
+    }
+
+private:
+    // Vectorized scans of large adjacency lists, when marks can be gathered
+    // from a flat array and every edge is allowed.
+    static constexpr bool can_scan = MarksT::can_scan && std::is_same_v<FilterT, NoFilter>;
+
+    // Expands the current level, and returns the status if the search ends.
+    template<bool forward>
+    std::optional<SearchStatus> ExpandLevel() {
+        SearchQueue &queue = forward ? state.forward : state.backward;
+        if constexpr (MarksT::concurrent) {
+            if (state.parallel) return ExpandInParallel<forward>(queue);
+        }
+        if constexpr (FrontierT::bottom_up) {
+            if (state.bottom_up) return ExpandBottomUp<forward>(queue);
+        }
+        return ExpandTopDown<forward>(queue);
+    }
+
+    // Called after a level was expanded without being aborted.
+    std::optional<SearchStatus> FinishLevel(SearchQueue &queue, bool met) {
+        if (met) return SearchStatus::FOUND;
+        queue.NextLevel();
+        return std::nullopt;
+    }
+
+    template<bool forward>
+    std::optional<SearchStatus> ExpandTopDown(SearchQueue &queue) {
+        bool met = false;
+        for (; state.next_index < queue.end; ++state.next_index) {
+            if constexpr (FrontierT::pause) {
+                state.paused = !state.paused;
+                if (state.paused) return SearchStatus::PAUSED;
+            }
+            if (expansion.prefetch_distance > 0) {
+                PrefetchFringe<forward>(graph, queue, state.next_index, expansion.prefetch_distance, marks);
+            }
+            const index_t v = queue.queue[state.next_index];
+            const auto edges = Neighbors<forward>(graph, v, state.edges_buffer);
+            if (!marks.HasRoomFor(edges.size())) return SearchStatus::FULL;
+            if (!limits.VertexExpanded(edges.size())) return SearchStatus::ABORTED;
+            stats_collector.VertexExpanded();
+            if constexpr (can_scan) {
+                static_assert(MarksT::stop_at_meeting);
+                if (scan_kernel != ScanKernel::SCALAR && edges.size() >= min_scan_kernel_degree) {
+                    size_t meeting = marks.template Scan<forward>(scan_kernel, v, edges, queue, stats_collector);
+                    if (meeting < edges.size()) {
+                        auto [i, j] = FringeEdge<forward>(v, edges[meeting]);
+                        marks.Meet(i, j);
+                        return SearchStatus::FOUND;
+                    }
+                    continue;
+                }
+            }
+            for (index_t w : edges) {
+                stats_collector.EdgeExpanded();
+                auto [i, j] = FringeEdge<forward>(v, w);
+                if (!filter.AllowsEdge(i, j)) continue;
+                Visit visit = marks.template TopDown<forward>(i, j);
+                if (visit == Visit::REACHED) {
+                    stats_collector.VertexReached();
+                    queue.queue.push_back(w);
+                } else if (visit == Visit::MEETING) {
+                    marks.Meet(i, j);
+                    if constexpr (MarksT::stop_at_meeting) return SearchStatus::FOUND;
+                    met = true;
+                }
+            }
+        }
+        return FinishLevel(queue, met);
+    }
+
+    // Expands the fringe bottom-up: each vertex that was not reached from this
+    // side yet looks for a neighbor (a predecessor in a forward search) in the
+    // fringe.
+    template<bool forward>
+    std::optional<SearchStatus> ExpandBottomUp(SearchQueue &queue) {
+        FringeBitmap &fringe = frontier.fringe;
+        fringe.Insert(queue);
+        bool met = false;
+        bool aborted = false;
+        for (index_t w = 1; w < size && !aborted && !(MarksT::stop_at_meeting && met); ++w) {
+            if (!marks.template Unreached<forward>(w)) continue;
+            if (!filter.AllowsVertex(w)) continue;
+            stats_collector.VertexExpanded();
+            int64_t edges_scanned = 0;
+            for (index_t v : Neighbors<!forward>(graph, w, state.edges_buffer)) {
+                stats_collector.EdgeExpanded();
+                ++edges_scanned;
+                auto [i, j] = FringeEdge<forward>(v, w);
+                if (!fringe.Contains(v) || !filter.AllowsEdge(i, j)) continue;
+                if (marks.template BottomUp<forward>(i, j) == Visit::REACHED) {
+                    stats_collector.VertexReached();
+                    queue.queue.push_back(w);
+                    break;
+                }
+                marks.Meet(i, j);
+                met = true;
+                if constexpr (MarksT::stop_at_meeting) break;
+            }
+            aborted = !limits.VertexExpanded(edges_scanned);
+        }
+        fringe.Erase(queue);
+        if (aborted && !(MarksT::stop_at_meeting && met)) return SearchStatus::ABORTED;
+        return FinishLevel(queue, met);
+    }
+
+    // Expands the fringe on all threads of `parallel`.
+    template<bool forward>
+    std::optional<SearchStatus> ExpandInParallel(SearchQueue &queue) {
+        parallel->ExpandLevel(queue,
+            [this](index_t v) { return Neighbors<forward>(graph, v); },
+            [this](index_t v, index_t w, ParallelExpander::ThreadState &thread) {
+                auto [i, j] = FringeEdge<forward>(v, w);
+                if (!filter.AllowsEdge(i, j)) return true;
+                Visit visit = marks.template AtomicTopDown<forward>(i, j);
+                if (visit == Visit::REACHED) {
+                    ++thread.reached;
+                    thread.next.push_back(w);
+                } else if (visit == Visit::MEETING) {
+                    thread.meetings.push_back({i, j});
+                    return !MarksT::stop_at_meeting;
+                }
+                return true;
+            },
+            stats_collector, &limits);
+        bool met = false;
+        parallel->ForEachMeeting([&](index_t i, index_t j) {
+            if (MarksT::stop_at_meeting && met) return;
+            marks.Meet(i, j);
+            met = true;
+        });
+        // A level that found a meeting edge and also exceeded a limit still
+        // found a path, but not necessarily all meeting edges.
+        if (limits.Aborted() && !(MarksT::stop_at_meeting && met)) return SearchStatus::ABORTED;
+        return FinishLevel(queue, met);
+    }
+
+    const GraphReader &graph;
+    const index_t size;
+    MarksT &marks;
+    FrontierT &frontier;
+    BidirectionalSearchState &state;
+    ParallelExpander *const parallel;
+    HubBound *const hub_bound;
+    const ExpansionOptions expansion;
+    const FilterT &filter;
+    StatsCollectorT &stats_collector;
+    LimitChecker &limits;
+    const ScanKernel scan_kernel;
+};
+
+}  // namespace wikipath
+
+#endif  // ndef WIKIPATH_BIDIRECTIONAL_SEARCH_H_INCLUDED
@@ -0,0 +1,357 @@
+#include "wikipath/distance-oracle.h"
+
+#include "wikipath/thread-pool.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <assert.h>
+#include <stdio.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace wikipath {
+namespace {
+
+// Label file format. All fields are in native byte order:
+//
+//   uint64_t header[LABEL_HEADER_FIELD_COUNT]
+//   uint64_t out_index[vertex_count + 1]
+//   uint64_t in_index[vertex_count + 1]
+//   uint32_t out_hubs[out_entry_count]
+//   uint32_t in_hubs[in_entry_count]
+//   uint8_t  out_distances[out_entry_count]
+//   uint8_t  in_distances[in_entry_count]
+//
+// Hubs are identified by their rank (0 is the hub that was processed first)
+// rather than their vertex id, so that labels are sorted by hub rank.
+const uint64_t label_header_magic_value = 0x6c6562614cu;  // Label
+
+enum LabelHeaderFields {
+    LABEL_HEADER_MAGIC,
+    LABEL_HEADER_VERTEX_COUNT,
+    LABEL_HEADER_OUT_ENTRY_COUNT,
+    LABEL_HEADER_IN_ENTRY_COUNT,
+    LABEL_HEADER_FIELD_COUNT
+};
+
+int64_t LabelFileSize(int64_t vertex_count, int64_t out_entries, int64_t in_entries) {
+    return LABEL_HEADER_FIELD_COUNT * 8 + (vertex_count + 1) * 16 + (out_entries + in_entries) * 5;
+}
+
+struct FdCloser {
+    const int fd;
+    ~FdCloser() { close(fd); }
+};
+
+struct LabelEntry {
+    uint32_t hub;  // rank of the hub
+    uint8_t distance;
+};
+
+using Label = std::vector<LabelEntry>;
+
+// Builds labels with pruned breadth-first searches from each hub.
+class LabelBuilder {
+public:
+    LabelBuilder(const GraphReader &graph, int threads)
+        : graph(graph), pool(threads), thread_states(threads),
+          out_labels(graph.VertexCount()), in_labels(graph.VertexCount()) {
+        // Order vertices by decreasing total degree, so that the first hubs
+        // cover as many shortest paths as possible.
+        const index_t vertex_count = graph.VertexCount();
+        hubs.reserve(vertex_count);
+        for (index_t v = 0; v < vertex_count; ++v) hubs.push_back(v);
+        std::stable_sort(hubs.begin(), hubs.end(), [&graph](index_t v, index_t w) {
+            return graph.ForwardDegree(v) + graph.BackwardDegree(v) >
+                    graph.ForwardDegree(w) + graph.BackwardDegree(w);
+        });
+        for (ThreadState &state : thread_states) {
+            state.hub_distance.assign(vertex_count, DistanceOracle::UNREACHABLE);
+            state.distance.assign(vertex_count, DistanceOracle::UNREACHABLE);
+        }
+    }
+
+    void Build(const std::function<void(const DistanceLabelStats&)> &progress) {
+        const index_t vertex_count = graph.VertexCount();
+        const int threads = pool.ThreadCount();
+        auto last_progress = std::chrono::steady_clock::now();
+        std::vector<HubResult> results;
+        for (index_t begin = 0; begin < vertex_count; ) {
+            // With a single thread, hubs are processed one at a time, which
+            // gives the smallest labels. With more threads, each hub in a batch
+            // cannot prune against the labels of the others, so batches start
+            // small (when hubs cover many paths) and grow as searches get
+            // smaller.
+            index_t batch_size = threads == 1 ? 1 :
+                    std::clamp<index_t>(begin / 16, threads, 64 * threads);
+            index_t end = std::min<index_t>(vertex_count, begin + batch_size);
+            results.resize(end - begin);
+            pool.ParallelFor(begin, end, 1, [&](int thread, size_t b, size_t e) {
+                for (size_t rank = b; rank < e; ++rank) {
+                    HubResult &result = results[rank - begin];
+                    Search(thread_states[thread], rank, true, result.in_entries);
+                    Search(thread_states[thread], rank, false, result.out_entries);
+                }
+            });
+
+            // Add the new entries in order of hub rank, so labels stay sorted.
+            for (index_t rank = begin; rank < end; ++rank) {
+                HubResult &result = results[rank - begin];
+                for (auto [v, d] : result.in_entries) in_labels[v].push_back({rank, d});
+                for (auto [v, d] : result.out_entries) out_labels[v].push_back({rank, d});
+                stats.in_entries += result.in_entries.size();
+                stats.out_entries += result.out_entries.size();
+                result.in_entries.clear();
+                result.out_entries.clear();
+            }
+            begin = end;
+            stats.hubs_processed = end;
+            stats.file_size = LabelFileSize(vertex_count, stats.out_entries, stats.in_entries);
+
+            auto now = std::chrono::steady_clock::now();
+            if (progress && (end == vertex_count || now - last_progress >= std::chrono::seconds(1))) {
+                progress(stats);
+                last_progress = now;
+            }
+        }
+        if (distance_overflow) {
+            std::cerr << "WARNING: distances too great!\n";
+        }
+    }
+
+    bool Write(const char *filename) const {
+        FILE *fp = fopen(filename, "wb");
+        if (fp == nullptr) return false;
+        bool success = Write(fp);
+        if (fclose(fp) != 0) success = false;
+        return success;
+    }
+
+    const DistanceLabelStats &Stats() const { return stats; }
+
+private:
+    // Per-thread search state.
+    struct ThreadState {
+        // Distances from (or to) the current hub to (or from) other hubs,
+        // according to the current hub's label, indexed by hub rank.
+        std::vector<uint8_t> hub_distance;
+
+        // Distances from (or to) the current hub, indexed by vertex.
+        std::vector<uint8_t> distance;
+
+        std::vector<index_t> queue;
+    };
+
+    // New label entries (vertex, distance) found by the searches from a hub.
+    struct HubResult {
+        std::vector<std::pair<index_t, uint8_t>> in_entries;
+        std::vector<std::pair<index_t, uint8_t>> out_entries;
+    };
+
+    // Runs a pruned breadth-first search from the hub with the given rank,
+    // following forward edges (to find in-label entries) or backward edges (to
+    // find out-label entries), and stores the new label entries in `entries`.
+    void Search(ThreadState &state, index_t rank, bool forward, std::vector<std::pair<index_t, uint8_t>> &entries) {
+        const index_t hub = hubs[rank];
+        const Label &hub_label = forward ? out_labels[hub] : in_labels[hub];
+        const std::vector<Label> &labels = forward ? in_labels : out_labels;
+
+        for (const LabelEntry &entry : hub_label) state.hub_distance[entry.hub] = entry.distance;
+        state.hub_distance[rank] = 0;
+
+        // Returns whether the distance d between the hub and v is already
+        // covered by the existing labels.
+        auto Covered = [&](index_t v, int d) {
+            for (const LabelEntry &entry : labels[v]) {
+                if (state.hub_distance[entry.hub] + entry.distance <= d) return true;
+            }
+            return false;
+        };
+
+        state.queue.clear();
+        state.queue.push_back(hub);
+        state.distance[hub] = 0;
+        for (size_t i = 0; i < state.queue.size(); ++i) {
+            index_t v = state.queue[i];
+            int d = state.distance[v];
+            if (Covered(v, d)) continue;
+            entries.emplace_back(v, d);
+            if (d + 1 >= DistanceOracle::UNREACHABLE) {
+                distance_overflow = true;
+                continue;
+            }
+            for (index_t w : forward ? graph.ForwardEdges(v) : graph.BackwardEdges(v)) {
+                if (state.distance[w] == DistanceOracle::UNREACHABLE) {
+                    state.distance[w] = d + 1;
+                    state.queue.push_back(w);
+                }
+            }
+        }
+
+        for (index_t v : state.queue) state.distance[v] = DistanceOracle::UNREACHABLE;
+        for (const LabelEntry &entry : hub_label) state.hub_distance[entry.hub] = DistanceOracle::UNREACHABLE;
+        state.hub_distance[rank] = DistanceOracle::UNREACHABLE;
+    }
+
+    static bool WriteIndex(FILE *fp, const std::vector<Label> &labels) {
+        uint64_t offset = 0;
+        if (fwrite(&offset, sizeof(offset), 1, fp) != 1) return false;
+        for (const Label &label : labels) {
+            offset += label.size();
+            if (fwrite(&offset, sizeof(offset), 1, fp) != 1) return false;
+        }
+        return true;
+    }
+
+    template<class T, class Field>
+    static bool WriteField(FILE *fp, const std::vector<Label> &labels, Field field) {
+        std::vector<T> buffer;
+        for (const Label &label : labels) {
+            buffer.clear();
+            for (const LabelEntry &entry : label) buffer.push_back(entry.*field);
+            if (fwrite(buffer.data(), sizeof(T), buffer.size(), fp) != buffer.size()) return false;
+        }
+        return true;
+    }
+
+    bool Write(FILE *fp) const {
+        uint64_t header[LABEL_HEADER_FIELD_COUNT] = {};
+        header[LABEL_HEADER_MAGIC] = label_header_magic_value;
+        header[LABEL_HEADER_VERTEX_COUNT] = graph.VertexCount();
+        header[LABEL_HEADER_OUT_ENTRY_COUNT] = stats.out_entries;
+        header[LABEL_HEADER_IN_ENTRY_COUNT] = stats.in_entries;
+        return fwrite(header, sizeof(header), 1, fp) == 1 &&
+            WriteIndex(fp, out_labels) &&
+            WriteIndex(fp, in_labels) &&
+            WriteField<uint32_t>(fp, out_labels, &LabelEntry::hub) &&
+            WriteField<uint32_t>(fp, in_labels, &LabelEntry::hub) &&
+            WriteField<uint8_t>(fp, out_labels, &LabelEntry::distance) &&
+            WriteField<uint8_t>(fp, in_labels, &LabelEntry::distance);
+    }
+
+    const GraphReader &graph;
+    ThreadPool pool;
+    std::vector<ThreadState> thread_states;
+
+    // Vertices in order of rank.
+    std::vector<index_t> hubs;
+
+    // Label of each vertex; entries are sorted by hub rank.
+    std::vector<Label> out_labels;
+    std::vector<Label> in_labels;
+
+    DistanceLabelStats stats;
+
+    // Set (possibly concurrently) when a search is cut off at the maximum
+    // distance, in which case the labels are incomplete.
+    std::atomic<bool> distance_overflow = false;
+};
+
+}  // namespace
+
+bool BuildDistanceLabels(
+        const GraphReader &graph, const char *filename,
+        const DistanceLabelOptions &options,
+        DistanceLabelStats *stats) {
+    int threads = options.threads > 0 ? options.threads : std::thread::hardware_concurrency();
+    LabelBuilder builder(graph, std::max(threads, 1));
+    builder.Build(options.progress);
+    if (stats) *stats = builder.Stats();
+    return builder.Write(filename);
+}
+
+DistanceOracle::DistanceOracle(void *data, size_t data_len) {
+    this->data = data;
+    this->data_len = data_len;
+
+    const uint64_t *header = reinterpret_cast<const uint64_t*>(data);
+    vertex_count = header[LABEL_HEADER_VERTEX_COUNT];
+    const uint64_t out_entry_count = header[LABEL_HEADER_OUT_ENTRY_COUNT];
+    const uint64_t in_entry_count = header[LABEL_HEADER_IN_ENTRY_COUNT];
+
+    out_labels.index = header + LABEL_HEADER_FIELD_COUNT;
+    in_labels.index = out_labels.index + vertex_count + 1;
+    out_labels.hubs = reinterpret_cast<const uint32_t*>(in_labels.index + vertex_count + 1);
+    in_labels.hubs = out_labels.hubs + out_entry_count;
+    out_labels.distances = reinterpret_cast<const uint8_t*>(in_labels.hubs + in_entry_count);
+    in_labels.distances = out_labels.distances + out_entry_count;
+    [[maybe_unused]] const uint8_t *end_of_file = in_labels.distances + in_entry_count;
+
+    // A few sanity checks. It's not feasible to check the entire file.
+    assert(static_cast<size_t>(end_of_file - reinterpret_cast<const uint8_t*>(data)) == data_len);
+    assert(out_labels.index[vertex_count] == out_entry_count);
+    assert(in_labels.index[vertex_count] == in_entry_count);
+}
+
+DistanceOracle::~DistanceOracle() {
+    munmap(data, data_len);
+}
+
+std::unique_ptr<DistanceOracle> DistanceOracle::Open(const char *filename) {
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) return nullptr;
+    FdCloser fd_closer{fd};
+
+    // Read file header.
+    uint64_t header[LABEL_HEADER_FIELD_COUNT] = {};
+    if (read(fd, &header, sizeof(header)) != sizeof(header)) return nullptr;
+    if (header[LABEL_HEADER_MAGIC] != label_header_magic_value) return nullptr;
+    if (header[LABEL_HEADER_VERTEX_COUNT] > std::numeric_limits<index_t>::max()) return nullptr;
+    uint64_t file_size = LabelFileSize(
+            header[LABEL_HEADER_VERTEX_COUNT],
+            header[LABEL_HEADER_OUT_ENTRY_COUNT],
+            header[LABEL_HEADER_IN_ENTRY_COUNT]);
+    if (file_size > std::numeric_limits<size_t>::max()) return nullptr;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<uint64_t>(st.st_size) != file_size) return nullptr;
+    size_t data_len = file_size;
+
+    void *data = mmap(nullptr, data_len, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) return nullptr;
+
+    return std::unique_ptr<DistanceOracle>(new DistanceOracle(data, data_len));
+}
+
+uint8_t DistanceOracle::Distance(index_t start, index_t finish) const {
+    assert(start < vertex_count && finish < vertex_count);
+
+    // Intersect the out-label of start with the in-label of finish. Both are
+    // sorted by hub rank.
+    uint64_t i = out_labels.index[start], i_end = out_labels.index[start + 1];
+    uint64_t j = in_labels.index[finish], j_end = in_labels.index[finish + 1];
+    int result = UNREACHABLE;
+    while (i < i_end && j < j_end) {
+        // Written without branches on the comparison, which is unpredictable.
+        uint32_t a = out_labels.hubs[i], b = in_labels.hubs[j];
+        int sum = out_labels.distances[i] + in_labels.distances[j];
+        result = std::min(result, a == b ? sum : int{UNREACHABLE});
+        i += a <= b;
+        j += b <= a;
+    }
+    return result;
+}
+
+DistanceLabelStats DistanceOracle::Stats() const {
+    DistanceLabelStats stats;
+    stats.hubs_processed = vertex_count;
+    stats.out_entries = out_labels.index[vertex_count];
+    stats.in_entries = in_labels.index[vertex_count];
+    stats.file_size = data_len;
+    return stats;
+}
+
+}  // namespace wikipath
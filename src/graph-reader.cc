@@ -1,6 +1,8 @@
 #include "wikipath/graph-reader.h"
 
 #include "wikipath/graph-header.h"
+#include "wikipath/numa.h"
+#include "wikipath/stream-vbyte.h"
 
 #include <fcntl.h>
 #include <sys/mman.h>
@@ -8,13 +10,22 @@
 #include <sys/stat.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <cerrno>
 #include <chrono>
+#include <cinttypes>
 #include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
 #include <iostream>
 #include <limits>
 #include <memory>
+#include <string>
 #include <thread>
+#include <vector>
 
 namespace wikipath {
 namespace {
@@ -35,16 +46,294 @@ static bool MLock(void *data, size_t data_len) {
     return true;
 }
 
+constexpr size_t huge_page_size = size_t{2} << 20;
+
+size_t RoundUpToHugePage(size_t len) {
+    return (len + huge_page_size - 1) & ~(huge_page_size - 1);
+}
+
+// Maps `len` bytes (a multiple of huge_page_size) of anonymous memory at an
+// address aligned to huge_page_size, by mapping more than needed and
+// unmapping the excess on either side. Returns MAP_FAILED on failure.
+void *MapAligned(size_t len, int prot) {
+    void *p = mmap(nullptr, len + huge_page_size, prot, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) return p;
+    const uintptr_t start = reinterpret_cast<uintptr_t>(p);
+    const uintptr_t aligned = (start + huge_page_size - 1) & ~uintptr_t{huge_page_size - 1};
+    if (aligned > start) munmap(p, aligned - start);
+    munmap(reinterpret_cast<void*>(aligned + len), huge_page_size - (aligned - start));
+    return reinterpret_cast<void*>(aligned);
+}
+
+// Reads `len` bytes from the start of the file into `dst`.
+bool ReadAll(int fd, void *dst, size_t len) {
+    char *p = static_cast<char*>(dst);
+    for (size_t pos = 0; pos < len; ) {
+        ssize_t n = pread(fd, p + pos, len - pos, pos);
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR) continue;
+            return false;
+        }
+        pos += n;
+    }
+    return true;
+}
+
+// Copies the file into anonymous memory as described for HugePages::HUGETLB
+// and HugePages::TRANSPARENT, and returns the address of the copy (of length
+// map_len), or MAP_FAILED on failure. Updates `huge_pages` to the mode used,
+// which is NONE on failure.
+void *CopyToHugePages(int fd, size_t data_len, size_t map_len, GraphReader::OpenOptions::HugePages &huge_pages) {
+    using HugePages = GraphReader::OpenOptions::HugePages;
+    void *data = MAP_FAILED;
+    if (huge_pages == HugePages::HUGETLB) {
+        // 21 is log2 of the huge page size (MAP_HUGE_2MB).
+        data = mmap(nullptr, map_len, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | (21 << MAP_HUGE_SHIFT), -1, 0);
+        if (data == MAP_FAILED) {
+            perror("mmap(MAP_HUGETLB)");
+            std::cerr << "Falling back to transparent huge pages\n";
+            huge_pages = HugePages::TRANSPARENT;
+        }
+    }
+    if (huge_pages == HugePages::TRANSPARENT) {
+        data = MapAligned(map_len, PROT_READ | PROT_WRITE);
+        if (data == MAP_FAILED) {
+            perror("mmap");
+        } else if (madvise(data, map_len, MADV_HUGEPAGE) != 0) {
+            // Not fatal: the kernel may still use huge pages, if transparent
+            // huge pages are enabled for all memory.
+            perror("madvise(MADV_HUGEPAGE)");
+        }
+    }
+    if (data != MAP_FAILED && !ReadAll(fd, data, data_len)) {
+        perror("read");
+        munmap(data, map_len);
+        data = MAP_FAILED;
+    }
+    if (data == MAP_FAILED) {
+        std::cerr << "Could not copy graph into huge pages; mapping the file instead\n";
+        huge_pages = HugePages::NONE;
+        return data;
+    }
+    mprotect(data, map_len, PROT_READ);
+    return data;
+}
+
+// Maps the file at an address aligned to huge_page_size, as described for
+// HugePages::FILE. The mapping is map_len bytes long, where the part beyond
+// the end of the file is inaccessible. Returns MAP_FAILED on failure.
+void *MapFileAligned(int fd, size_t data_len, size_t map_len, int mmap_flags) {
+    void *reserved = MapAligned(map_len, PROT_NONE);
+    if (reserved == MAP_FAILED) return reserved;
+    void *data = mmap(reserved, data_len, PROT_READ, mmap_flags | MAP_FIXED, fd, 0);
+    if (data == MAP_FAILED) {
+        munmap(reserved, map_len);
+        return data;
+    }
+    if (madvise(data, data_len, MADV_HUGEPAGE) != 0) perror("madvise(MADV_HUGEPAGE)");
+    return data;
+}
+
+// Returns the number of bytes of memory mapped with huge pages between `data`
+// and `data + len`, by summing the relevant fields of the mappings in
+// /proc/self/smaps that overlap this range.
+size_t HugePageBytesInRange(const void *data, size_t len) {
+    std::ifstream smaps("/proc/self/smaps");
+    const uintptr_t begin = reinterpret_cast<uintptr_t>(data);
+    const uintptr_t end = begin + len;
+    bool overlaps = false;
+    size_t bytes = 0;
+    std::string line;
+    while (std::getline(smaps, line)) {
+        uintptr_t start = 0, stop = 0;
+        if (sscanf(line.c_str(), "%" SCNxPTR "-%" SCNxPTR " ", &start, &stop) == 2) {
+            overlaps = start < end && stop > begin;
+            continue;
+        }
+        if (!overlaps) continue;
+        for (const char *field : {"AnonHugePages:", "FilePmdMapped:", "Private_Hugetlb:", "Shared_Hugetlb:"}) {
+            size_t kb = 0;
+            if (line.starts_with(field) && sscanf(line.c_str() + strlen(field), "%zu", &kb) == 1) {
+                bytes += kb << 10;
+            }
+        }
+    }
+    return bytes;
+}
+
+// Returns the NUMA nodes to copy the graph to, as described for
+// OpenOptions::numa_replicas.
+std::vector<int> SelectNumaNodes(std::vector<int> requested) {
+    const std::vector<int> online = OnlineNumaNodes();
+    if (requested.empty()) return online.size() > 1 ? online : std::vector<int>{};
+    std::sort(requested.begin(), requested.end());
+    requested.erase(std::unique(requested.begin(), requested.end()), requested.end());
+    std::vector<int> nodes;
+    for (int node : requested) {
+        if (std::find(online.begin(), online.end(), node) != online.end()) {
+            nodes.push_back(node);
+        } else {
+            std::cerr << "NUMA node " << node << " is not online; not copying the graph there\n";
+        }
+    }
+    return nodes;
+}
+
+// Copies `data_len` bytes at `data` into anonymous memory on NUMA node `node`,
+// as described for OpenOptions::numa_replicas, and returns the address of the
+// copy (of length map_len), or MAP_FAILED on failure. Pins the calling thread
+// to the node.
+void *CopyToNumaNode(const void *data, size_t data_len, size_t map_len, int node) {
+    if (!PinThreadToNumaNode(node)) {
+        std::cerr << "Could not pin thread to NUMA node " << node << "\n";
+    }
+    void *copy = MapAligned(map_len, PROT_READ | PROT_WRITE);
+    if (copy == MAP_FAILED) {
+        perror("mmap");
+        return copy;
+    }
+    if (!BindMemoryToNumaNode(copy, map_len, node)) {
+        // Not fatal: pages are allocated on the node of the thread that first
+        // touches them by default, and this thread is (normally) pinned to
+        // the node.
+        perror("mbind");
+    }
+    if (madvise(copy, map_len, MADV_HUGEPAGE) != 0) perror("madvise(MADV_HUGEPAGE)");
+    memcpy(copy, data, data_len);
+    mprotect(copy, map_len, PROT_READ);
+    return copy;
+}
+
+// Size of the chunks that MLock::PARALLEL loads at a time. Large enough that
+// MADV_WILLNEED issues large reads, and small enough to balance the load
+// between threads.
+constexpr size_t warm_up_chunk_size = size_t{4} << 20;
+
+// Faults in the pages in [begin, begin + len) for reading. Returns false on
+// failure.
+bool PopulateRead(char *begin, size_t len) {
+    if (madvise(begin, len, MADV_POPULATE_READ) == 0) return true;
+    if (errno != EINVAL) {
+        perror("madvise(MADV_POPULATE_READ)");
+        return false;
+    }
+    // MADV_POPULATE_READ is not supported (before Linux 5.14), so touch every
+    // page instead.
+    const size_t page_size = sysconf(_SC_PAGESIZE);
+    for (size_t i = 0; i < len; i += page_size) {
+        static_cast<void>(*static_cast<const volatile char*>(begin + i));
+    }
+    return true;
+}
+
 }  // namespace
 
-GraphReader::GraphReader(void *data, size_t data_len) {
+struct GraphReader::LoadProgress {
+    using State = LoadStatus::State;
+
+    std::atomic<State> state = State::NONE;
+    std::atomic<size_t> bytes_loaded = 0;
+    size_t bytes_total = 0;
+    const std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+    std::atomic<int64_t> elapsed_ns = -1;  // -1 until done
+
+    // Used by MLock::PARALLEL only.
+    std::atomic<size_t> next_chunk = 0;
+    std::atomic<int> running_threads = 0;
+    std::atomic<bool> failed = false;
+    std::atomic<bool> cancelled = false;
+
+    // Threads of MLock::BACKGROUND and MLock::PARALLEL, which are joined
+    // before the graph is unmapped.
+    std::vector<std::thread> threads;
+
+    void Finish(State final_state) {
+        elapsed_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start_time).count();
+        state = final_state;
+    }
+
+    // Starts loading `data` with `thread_count` threads, as described for
+    // MLock::PARALLEL.
+    void StartWarmUp(char *data, size_t len, int thread_count, bool lock) {
+        const size_t chunk_count = (len + warm_up_chunk_size - 1) / warm_up_chunk_size;
+        thread_count = std::clamp<int>(thread_count, 1, std::max<size_t>(chunk_count, 1));
+        state = State::IN_PROGRESS;
+        running_threads = thread_count;
+        for (int i = 0; i < thread_count; ++i) {
+            threads.emplace_back([this, data, len, thread_count, lock]() {
+                WarmUpThread(data, len, thread_count, lock);
+            });
+        }
+    }
+
+    void WarmUpThread(char *data, size_t len, int thread_count, bool lock) {
+        for (size_t chunk; !cancelled && (chunk = next_chunk++) * warm_up_chunk_size < len; ) {
+            const size_t offset = chunk * warm_up_chunk_size;
+            const size_t n = std::min(warm_up_chunk_size, len - offset);
+            madvise(data + offset, n, MADV_WILLNEED);
+            if (!PopulateRead(data + offset, n)) failed = true;
+            bytes_loaded += n;
+        }
+        if (--running_threads > 0 || cancelled) return;
+
+        // The last thread to finish locks the pages and reports the result.
+        bool success = !failed && (!lock || MLock(data, len));
+        const double elapsed_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+        std::cerr << "Loaded " << (bytes_loaded >> 20) << " MB of graph data with " << thread_count
+            << " threads in " << elapsed_s << " s (" << (bytes_loaded >> 20) / elapsed_s << " MB/s)"
+            << (success ? "" : ", with errors") << "\n";
+        Finish(success ? State::COMPLETED : State::FAILED);
+    }
+
+    // Stops loading, and waits for the threads to exit.
+    void Stop() {
+        cancelled = true;
+        for (std::thread &thread : threads) thread.join();
+        threads.clear();
+    }
+};
+
+GraphReader::GraphReader(void *data, size_t data_len, size_t map_len, OpenOptions::HugePages huge_pages,
+        std::shared_ptr<LoadProgress> progress) : progress(std::move(progress)) {
     this->data = data;
     this->data_len = data_len;
+    this->map_len = map_len;
+    this->huge_pages = huge_pages;
 
     const uint32_t *words = reinterpret_cast<const uint32_t*>(data);
 
     vertex_count = words[GRAPH_HEADER_VERTEX_COUNT];
     edge_count = words[GRAPH_HEADER_EDGE_COUNT];
+    compressed = words[GRAPH_HEADER_VERSION] == graph_header_version_2;
+
+    if (compressed) {
+        const uint32_t *forward_index = words + GRAPH_HEADER_FIELD_COUNT;
+        const uint32_t *backward_index = forward_index + 2*(vertex_count + 1);
+        const uint8_t *forward_data = reinterpret_cast<const uint8_t*>(backward_index + 2*(vertex_count + 1));
+        const uint8_t *backward_data = forward_data + forward_index[2*vertex_count + 1] + stream_vbyte_padding;
+        [[maybe_unused]] const uint8_t *end_of_file = backward_data + backward_index[2*vertex_count + 1] + stream_vbyte_padding;
+
+        forward_lists = compressed_index_t{
+            .index = forward_index,
+            .lists = forward_data,
+        };
+
+        backward_lists = compressed_index_t{
+            .index = backward_index,
+            .lists = backward_data,
+        };
+
+        decode_kernel = BestDecodeKernel();
+
+        assert(data_len == static_cast<size_t>(end_of_file - reinterpret_cast<const uint8_t*>(data)));
+        assert(forward_index[0] == 0 && forward_index[1] == 0);
+        assert(forward_index[2*vertex_count] == edge_count);
+        assert(backward_index[0] == 0 && backward_index[1] == 0);
+        assert(backward_index[2*vertex_count] == edge_count);
+        return;
+    }
 
     const uint32_t *forward_edges_index = words + GRAPH_HEADER_FIELD_COUNT;
     const uint32_t *forward_edges_edges = forward_edges_index + vertex_count + 1;
@@ -71,7 +360,9 @@ GraphReader::GraphReader(void *data, size_t data_len) {
 }
 
 GraphReader::~GraphReader() {
-    munmap(data, data_len);
+    // Threads that load the graph must not touch it after it is unmapped.
+    progress->Stop();
+    munmap(data, map_len);
 }
 
 std::unique_ptr<GraphReader> GraphReader::Open(const char *filename, OpenOptions options) {
@@ -83,42 +374,191 @@ std::unique_ptr<GraphReader> GraphReader::Open(const char *filename, OpenOptions
     uint32_t header[GRAPH_HEADER_FIELD_COUNT] = {};
     if (read(fd, &header, sizeof(header)) != sizeof(header)) return nullptr;
     if (header[GRAPH_HEADER_MAGIC] != graph_header_magic_value) return nullptr;
-    uint64_t file_size =
-        uint64_t{GRAPH_HEADER_FIELD_COUNT} * 4 +
-        uint64_t{header[GRAPH_HEADER_VERTEX_COUNT] + 1} * 8 +
-        uint64_t{header[GRAPH_HEADER_EDGE_COUNT]} * 8;
+    uint64_t file_size = 0;
+    switch (header[GRAPH_HEADER_VERSION]) {
+        case graph_header_version_1:
+            file_size =
+                uint64_t{GRAPH_HEADER_FIELD_COUNT} * 4 +
+                uint64_t{header[GRAPH_HEADER_VERTEX_COUNT] + 1} * 8 +
+                uint64_t{header[GRAPH_HEADER_EDGE_COUNT]} * 8;
+            break;
+
+        case graph_header_version_2:
+            {
+                // The size of the compressed lists of each direction is the
+                // byte offset in the last entry of its index.
+                const uint64_t index_size = uint64_t{header[GRAPH_HEADER_VERTEX_COUNT] + 1} * 8;
+                const uint64_t forward_end = uint64_t{GRAPH_HEADER_FIELD_COUNT} * 4 + index_size - 4;
+                const uint64_t backward_end = forward_end + index_size;
+                uint32_t forward_size = 0, backward_size = 0;
+                if (pread(fd, &forward_size, 4, forward_end) != 4) return nullptr;
+                if (pread(fd, &backward_size, 4, backward_end) != 4) return nullptr;
+                file_size =
+                    uint64_t{GRAPH_HEADER_FIELD_COUNT} * 4 + 2 * index_size +
+                    uint64_t{forward_size} + uint64_t{backward_size} + 2 * stream_vbyte_padding;
+            }
+            break;
+
+        default:
+            std::cerr << "Unsupported graph format version " << header[GRAPH_HEADER_VERSION] << "\n";
+            return nullptr;
+    }
     if (file_size > std::numeric_limits<size_t>::max()) return nullptr;
     size_t data_len = file_size;
 
-    // Map entire file into memory.
+    // Map entire file into memory, or copy it into huge pages.
+    auto start_time = std::chrono::steady_clock::now();
+    OpenOptions::HugePages huge_pages = options.huge_pages;
+    size_t map_len = RoundUpToHugePage(data_len);
+    void *data = MAP_FAILED;
+    if (huge_pages == OpenOptions::HugePages::HUGETLB || huge_pages == OpenOptions::HugePages::TRANSPARENT) {
+        data = CopyToHugePages(fd, data_len, map_len, huge_pages);
+    }
     int mmap_flags = MAP_PRIVATE;
     if (options.mlock == OpenOptions::MLock::POPULATE) mmap_flags |= MAP_POPULATE;
-    void *data = mmap(nullptr, data_len, PROT_READ, mmap_flags, fd, 0);
-    if (data == MAP_FAILED) return nullptr;
+    if (huge_pages == OpenOptions::HugePages::FILE) {
+        data = MapFileAligned(fd, data_len, map_len, mmap_flags);
+        if (data == MAP_FAILED) {
+            perror("mmap");
+            huge_pages = OpenOptions::HugePages::NONE;
+        }
+    }
+    if (data == MAP_FAILED) {
+        map_len = data_len;
+        data = mmap(nullptr, data_len, PROT_READ, mmap_flags, fd, 0);
+        if (data == MAP_FAILED) return nullptr;
+    }
+    if (huge_pages != OpenOptions::HugePages::NONE) {
+        auto elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - start_time);
+        std::cerr << (huge_pages == OpenOptions::HugePages::FILE ? "Mapped graph for huge pages in "
+                : huge_pages == OpenOptions::HugePages::HUGETLB ? "Copied graph into hugetlb pages in "
+                : "Copied graph into transparent huge pages in ")
+            << elapsed_ms.count() / 1000.0 << " s (" << (std::min(HugePageBytesInRange(data, map_len), data_len) >> 20) << " of "
+            << (data_len >> 20) << " MB in huge pages)\n";
+    }
 
     // Lock file into memory, if requested:
+    auto progress = std::make_shared<LoadProgress>();
+    progress->bytes_total = data_len;
     switch (options.mlock) {
         case OpenOptions::MLock::NONE:
+            break;
+
         case OpenOptions::MLock::POPULATE:
+            progress->bytes_loaded = data_len;
+            progress->Finish(LoadStatus::State::COMPLETED);
             break;
 
         case OpenOptions::MLock::FOREGROUND:
             if (!MLock(data, data_len)) {
-                munmap(data, data_len);
+                munmap(data, map_len);
                 return nullptr;
             }
+            progress->bytes_loaded = data_len;
+            progress->Finish(LoadStatus::State::COMPLETED);
             break;
 
         case OpenOptions::MLock::BACKGROUND:
             {
-                std::thread mlock_thread(&MLock, data, data_len);
-                mlock_thread.detach();
+                // Joined by the destructor (see LoadProgress::Stop()), since
+                // once the range is unmapped, it may be reused by another
+                // mapping that the thread must not lock. mlock() cannot be
+                // interrupted, so destroying the reader waits for it.
+                progress->state = LoadStatus::State::IN_PROGRESS;
+                LoadProgress *p = progress.get();
+                progress->threads.emplace_back([p, data, data_len]() {
+                    bool success = MLock(data, data_len);
+                    if (success) p->bytes_loaded = data_len;
+                    p->Finish(success ? LoadStatus::State::COMPLETED : LoadStatus::State::FAILED);
+                });
             }
             break;
+
+        case OpenOptions::MLock::PARALLEL:
+            progress->StartWarmUp(static_cast<char*>(data), data_len, options.warm_up_threads, options.warm_up_mlock);
+            break;
+    }
+
+    std::unique_ptr<GraphReader> reader(new GraphReader(data, data_len, map_len, huge_pages, std::move(progress)));
+
+    // Copy the graph to each NUMA node, if requested:
+    std::vector<int> nodes = options.numa_replicas ? SelectNumaNodes(options.numa_nodes) : std::vector<int>{};
+    if (!nodes.empty()) {
+        start_time = std::chrono::steady_clock::now();
+        const size_t copy_len = RoundUpToHugePage(data_len);
+        std::vector<void*> copies(nodes.size(), MAP_FAILED);
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            threads.emplace_back([&copies, &nodes, i, data, data_len, copy_len]() {
+                copies[i] = CopyToNumaNode(data, data_len, copy_len, nodes[i]);
+            });
+        }
+        for (std::thread &thread : threads) thread.join();
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            if (copies[i] == MAP_FAILED) {
+                std::cerr << "Could not copy graph to NUMA node " << nodes[i] << "\n";
+                continue;
+            }
+            auto copy_progress = std::make_shared<LoadProgress>();
+            copy_progress->bytes_total = copy_progress->bytes_loaded = data_len;
+            copy_progress->Finish(LoadStatus::State::COMPLETED);
+            reader->replicas.emplace_back(nodes[i], std::unique_ptr<GraphReader>(new GraphReader(
+                    copies[i], data_len, copy_len, OpenOptions::HugePages::TRANSPARENT, std::move(copy_progress))));
+        }
+        auto elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - start_time);
+        std::cerr << "Copied graph to " << reader->replicas.size() << " NUMA node(s) in "
+            << elapsed_ms.count() / 1000.0 << " s\n";
+    }
+    return reader;
+}
+
+GraphReader::LoadStatus GraphReader::GetLoadStatus() const {
+    LoadStatus status = {
+        .state = progress->state,
+        .bytes_loaded = progress->bytes_loaded,
+        .bytes_total = progress->bytes_total,
+    };
+    if (status.state != LoadStatus::State::NONE) {
+        int64_t elapsed_ns = progress->elapsed_ns;
+        if (elapsed_ns < 0) {
+            elapsed_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - progress->start_time).count();
+        }
+        status.elapsed_s = elapsed_ns / 1e9;
+    }
+    return status;
+}
+
+const GraphReader &GraphReader::ForNumaNode(int node) const {
+    for (const auto &[replica_node, replica] : replicas) {
+        if (replica_node == node) return *replica;
     }
+    return *this;
+}
+
+std::vector<int> GraphReader::NumaReplicaNodes() const {
+    std::vector<int> nodes;
+    for (const auto &[node, replica] : replicas) nodes.push_back(node);
+    return nodes;
+}
+
+size_t GraphReader::HugePageBytes() const {
+    return std::min(HugePageBytesInRange(data, map_len), data_len);
+}
+
+GraphReader::edges_t GraphReader::compressed_index_t::Decode(
+        index_t i, DecodeKernel kernel, std::vector<index_t> &buffer) const {
+    const index_t degree = Degree(i);
+    if (buffer.size() < degree) buffer.resize(degree);
+    DecodeSortedIndices(kernel, &lists[index[2*i + 1]], degree, buffer.data());
+    return edges_t(buffer.data(), degree);
+}
 
-    return std::unique_ptr<GraphReader>(
-        new GraphReader(data, data_len));
+std::vector<index_t> &GraphReader::ThreadBuffer() {
+    thread_local std::vector<index_t> buffer;
+    return buffer;
 }
 
 }  // namespace wikipath
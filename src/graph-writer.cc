@@ -1,20 +1,24 @@
-#include "wikipath/common.h"
+#include "wikipath/graph-writer.h"
 
 #include "wikipath/graph-header.h"
+#include "wikipath/stream-vbyte.h"
 
 #include <assert.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <sys/types.h>
 
+#include <algorithm>
+#include <span>
 #include <vector>
 
 namespace wikipath {
 namespace {
 
-int64_t CountEdges(const std::vector<std::vector<index_t>> &edgelist) {
+int64_t CountEdges(index_t vertex_count, const AdjacencyFn &edges) {
     int64_t edge_count = 0;
-    for (const auto &adj : edgelist) edge_count += adj.size();
+    for (index_t v = 0; v < vertex_count; ++v) edge_count += edges(v).size();
     return edge_count;
 }
 
@@ -27,28 +31,22 @@ bool WriteInt(FILE *fp, int64_t i) {
     return WriteInt(fp, (uint32_t) i);
 }
 
-bool WriteEdges(FILE *fp, const std::vector<std::vector<index_t>> &edgelist) {
+bool WriteEdges(FILE *fp, index_t vertex_count, const AdjacencyFn &edges) {
     int64_t offset = 0;
-    for (const auto &adj : edgelist) {
+    for (index_t v = 0; v < vertex_count; ++v) {
         if (!WriteInt(fp, offset)) return false;
-        offset += adj.size();
+        offset += edges(v).size();
     }
     if (!WriteInt(fp, offset)) return false;
-    for (const auto &adj : edgelist) {
-        for (index_t i : adj) {
+    for (index_t v = 0; v < vertex_count; ++v) {
+        for (index_t i : edges(v)) {
             if (!WriteInt(fp, i)) return false;
         }
     }
     return true;
 }
 
-bool WriteGraphOutput(FILE *fp,
-        const std::vector<std::vector<index_t>> &forward_edges,
-        const std::vector<std::vector<index_t>> &backward_edges) {
-    const int64_t vertex_count = forward_edges.size();  // includes vertex 0!
-    const int64_t edge_count = CountEdges(forward_edges);
-
-    // Write header.
+bool WriteHeader(FILE *fp, uint32_t version, int64_t vertex_count, int64_t edge_count) {
     // An exquisite application of the for-case paradigm!
     // See: https://thedailywtf.com/articles/The_FOR-CASE_paradigm
     for (int i = 0; i < GRAPH_HEADER_FIELD_COUNT; ++i) {
@@ -56,8 +54,8 @@ bool WriteGraphOutput(FILE *fp,
         case GRAPH_HEADER_MAGIC:
             if (!WriteInt(fp, graph_header_magic_value)) return false;
             break;
-        case GRAPH_HEADER_RESERVED:
-            if (!WriteInt(fp, graph_header_reserved_value)) return false;
+        case GRAPH_HEADER_VERSION:
+            if (!WriteInt(fp, version)) return false;
             break;
         case GRAPH_HEADER_VERTEX_COUNT:
             if (!WriteInt(fp, vertex_count)) return false;
@@ -69,10 +67,73 @@ bool WriteGraphOutput(FILE *fp,
             abort();
         }
     }
+    return true;
+}
+
+bool WriteGraphOutput(FILE *fp, index_t vertex_count, const AdjacencyFn &forward_edges, const AdjacencyFn &backward_edges) {
+    const int64_t edge_count = CountEdges(vertex_count, forward_edges);
+
+    if (!WriteHeader(fp, graph_header_version_1, vertex_count, edge_count)) return false;
 
     // Edge data
-    if (!WriteEdges(fp, forward_edges)) return false;
-    if (!WriteEdges(fp, backward_edges)) return false;
+    if (!WriteEdges(fp, vertex_count, forward_edges)) return false;
+    if (!WriteEdges(fp, vertex_count, backward_edges)) return false;
+    return true;
+}
+
+// Returns a function that returns the elements of `edgelist`.
+AdjacencyFn Adjacency(const std::vector<std::vector<index_t>> &edgelist) {
+    return [&edgelist](index_t v) { return std::span<const index_t>(edgelist[v]); };
+}
+
+// Writes the compressed adjacency lists of one direction at the current
+// position of the file, followed by the padding required by the decoder, and
+// stores the edge and byte offset of each list in `index`.
+bool WriteCompressedEdges(FILE *fp, index_t vertex_count, const AdjacencyFn &edges, std::vector<uint32_t> &index) {
+    std::vector<index_t> sorted;
+    std::vector<uint8_t> bytes;
+    int64_t edge_offset = 0, byte_offset = 0;
+    index.clear();
+    index.reserve(2 * (int64_t{vertex_count} + 1));
+    for (index_t v = 0; ; ++v) {
+        if (byte_offset > 0xffffffff) {
+            fputs("Compressed edges do not fit in 4 GiB!\n", stderr);
+            return false;
+        }
+        index.push_back(edge_offset);
+        index.push_back(byte_offset);
+        if (v == vertex_count) break;
+
+        std::span<const index_t> adj = edges(v);
+        sorted.assign(adj.begin(), adj.end());
+        std::sort(sorted.begin(), sorted.end());
+        bytes.clear();
+        EncodeSortedIndices(sorted, bytes);
+        if (fwrite(bytes.data(), 1, bytes.size(), fp) != bytes.size()) return false;
+        edge_offset += sorted.size();
+        byte_offset += bytes.size();
+        assert(edge_offset <= 0xffffffff);
+    }
+    static const uint8_t padding[stream_vbyte_padding] = {};
+    return fwrite(padding, 1, sizeof(padding), fp) == sizeof(padding);
+}
+
+bool WriteCompressedGraphOutput(FILE *fp, index_t vertex_count, const AdjacencyFn &outlinks, const AdjacencyFn &inlinks) {
+    // The size of the compressed lists is only known after writing them, so
+    // skip the header and the edge indices, and write them last.
+    const off_t data_offset = GRAPH_HEADER_FIELD_COUNT * 4 + 2 * (off_t{vertex_count} + 1) * 8;
+    if (fseeko(fp, data_offset, SEEK_SET) != 0) return false;
+    std::vector<uint32_t> forward_index, backward_index;
+    if (!WriteCompressedEdges(fp, vertex_count, outlinks, forward_index)) return false;
+    if (!WriteCompressedEdges(fp, vertex_count, inlinks, backward_index)) return false;
+    const int64_t edge_count = forward_index[2 * vertex_count];
+    assert(backward_index[2 * vertex_count] == edge_count);
+
+    if (fseeko(fp, 0, SEEK_SET) != 0) return false;
+    if (!WriteHeader(fp, graph_header_version_2, vertex_count, edge_count)) return false;
+    for (const std::vector<uint32_t> *index : {&forward_index, &backward_index}) {
+        if (fwrite(index->data(), sizeof(uint32_t), index->size(), fp) != index->size()) return false;
+    }
     return true;
 }
 
@@ -83,9 +144,34 @@ bool WriteGraphOutput(
         const std::vector<std::vector<index_t>> &outlinks,
         const std::vector<std::vector<index_t>> &inlinks) {
     assert(inlinks.size() == outlinks.size());
+    // Note: the vertex count includes vertex 0!
+    return WriteGraphOutput(filename, outlinks.size(), Adjacency(outlinks), Adjacency(inlinks));
+}
+
+bool WriteGraphOutput(
+        const char *filename, index_t vertex_count,
+        const AdjacencyFn &outlinks, const AdjacencyFn &inlinks) {
+    FILE *fp = fopen(filename, "wb");
+    if (fp == nullptr) return false;
+    bool success = WriteGraphOutput(fp, vertex_count, outlinks, inlinks);
+    if (fclose(fp) != 0) success = false;
+    return success;
+}
+
+bool WriteCompressedGraphOutput(
+        const char *filename,
+        const std::vector<std::vector<index_t>> &outlinks,
+        const std::vector<std::vector<index_t>> &inlinks) {
+    assert(inlinks.size() == outlinks.size());
+    return WriteCompressedGraphOutput(filename, outlinks.size(), Adjacency(outlinks), Adjacency(inlinks));
+}
+
+bool WriteCompressedGraphOutput(
+        const char *filename, index_t vertex_count,
+        const AdjacencyFn &outlinks, const AdjacencyFn &inlinks) {
     FILE *fp = fopen(filename, "wb");
     if (fp == nullptr) return false;
-    bool success = WriteGraphOutput(fp, outlinks, inlinks);
+    bool success = WriteCompressedGraphOutput(fp, vertex_count, outlinks, inlinks);
     if (fclose(fp) != 0) success = false;
     return success;
 }
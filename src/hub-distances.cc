@@ -0,0 +1,236 @@
+#include "wikipath/hub-distances.h"
+
+#include "wikipath/thread-pool.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <assert.h>
+#include <string.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace wikipath {
+namespace {
+
+// Hub file format. All fields are in native byte order:
+//
+//   uint64_t header[HUB_HEADER_FIELD_COUNT]
+//   uint32_t hubs[hub_count], padded with zeros to a multiple of 8 bytes
+//   uint8_t  distances[vertex_count][2][hub_count]
+//
+// where distances[v][0][i] is the distance from v to hub i, and
+// distances[v][1][i] the distance from hub i to v, so that all distances of a
+// vertex are adjacent in memory.
+const uint64_t hub_header_magic_value = 0x73627548u;  // Hubs
+
+enum HubHeaderFields {
+    HUB_HEADER_MAGIC,
+    HUB_HEADER_VERTEX_COUNT,
+    HUB_HEADER_HUB_COUNT,
+    HUB_HEADER_FIELD_COUNT
+};
+
+uint64_t HubListSize(uint64_t hub_count) {
+    return (hub_count * 4 + 7) / 8 * 8;
+}
+
+uint64_t HubFileSize(uint64_t vertex_count, uint64_t hub_count) {
+    return HUB_HEADER_FIELD_COUNT * 8 + HubListSize(hub_count) + vertex_count * 2 * hub_count;
+}
+
+struct FdCloser {
+    const int fd;
+    ~FdCloser() { close(fd); }
+};
+
+// Returns max(0, a - b), where either may be UNREACHABLE, as a lower bound on
+// a distance: 0 if b is unreachable (no information), UNREACHABLE if only a is.
+// Written without branches, so that loops over the hubs are vectorized.
+inline uint8_t BoundDifference(uint8_t a, uint8_t b) {
+    uint8_t difference = a > b ? a - b : 0;
+    return a == HubDistances::UNREACHABLE && b != HubDistances::UNREACHABLE
+            ? HubDistances::UNREACHABLE : difference;
+}
+
+}  // namespace
+
+bool BuildHubDistances(
+        const GraphReader &graph, const char *filename,
+        const HubDistanceOptions &options) {
+    const index_t vertex_count = graph.VertexCount();
+    const int hub_count = std::clamp<int64_t>(options.hub_count, 1, vertex_count);
+
+    // Select the vertices with the highest total degree.
+    std::vector<index_t> vertices(vertex_count);
+    for (index_t v = 0; v < vertex_count; ++v) vertices[v] = v;
+    auto degree = [&graph](index_t v) { return graph.ForwardDegree(v) + graph.BackwardDegree(v); };
+    std::partial_sort(vertices.begin(), vertices.begin() + hub_count, vertices.end(),
+            [&](index_t v, index_t w) { return degree(v) > degree(w) || (degree(v) == degree(w) && v < w); });
+    vertices.resize(hub_count);
+
+    int fd = open(filename, O_RDWR | O_CREAT | O_TRUNC, 0666);
+    if (fd < 0) return false;
+    FdCloser fd_closer{fd};
+    const size_t file_size = HubFileSize(vertex_count, hub_count);
+    if (ftruncate(fd, file_size) != 0) return false;
+    void *data = mmap(nullptr, file_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (data == MAP_FAILED) return false;
+
+    uint64_t *header = reinterpret_cast<uint64_t*>(data);
+    header[HUB_HEADER_MAGIC] = hub_header_magic_value;
+    header[HUB_HEADER_VERTEX_COUNT] = vertex_count;
+    header[HUB_HEADER_HUB_COUNT] = hub_count;
+    uint32_t *hubs = reinterpret_cast<uint32_t*>(header + HUB_HEADER_FIELD_COUNT);
+    std::copy(vertices.begin(), vertices.end(), hubs);
+    uint8_t *distances = reinterpret_cast<uint8_t*>(hubs) + HubListSize(hub_count);
+    const size_t stride = 2 * size_t(hub_count);
+    memset(distances, HubDistances::UNREACHABLE, vertex_count * stride);
+
+    // Each search writes one column of distances: backward from the hub (to
+    // the hub) or forward from the hub, which also serves as its visited set.
+    int threads = options.threads > 0 ? options.threads : std::thread::hardware_concurrency();
+    ThreadPool pool(std::max(threads, 1));
+    std::vector<std::vector<index_t>> queues(pool.ThreadCount());
+    std::atomic<bool> distance_overflow = false;
+    pool.ParallelFor(0, 2 * size_t(hub_count), 1, [&](int thread, size_t begin, size_t end) {
+        std::vector<index_t> &queue = queues[thread];
+        for (size_t search = begin; search < end; ++search) {
+            const int hub = search / 2;
+            const bool forward = search % 2 == 0;
+            uint8_t *distance = distances + (forward ? hub_count : 0) + hub;
+            queue.assign(1, hubs[hub]);
+            distance[hubs[hub] * stride] = 0;
+            for (size_t i = 0; i < queue.size(); ++i) {
+                index_t v = queue[i];
+                int d = distance[v * stride];
+                if (d + 1 >= HubDistances::UNREACHABLE) {
+                    distance_overflow = true;
+                    break;
+                }
+                for (index_t w : forward ? graph.ForwardEdges(v) : graph.BackwardEdges(v)) {
+                    uint8_t &dw = distance[w * stride];
+                    if (dw == HubDistances::UNREACHABLE) {
+                        dw = d + 1;
+                        queue.push_back(w);
+                    }
+                }
+            }
+        }
+    });
+
+    bool success = !distance_overflow;
+    if (distance_overflow) {
+        std::cerr << "Distances from hubs exceed " << HubDistances::UNREACHABLE - 1 << "!\n";
+    }
+    if (msync(data, file_size, MS_SYNC) != 0) success = false;
+    munmap(data, file_size);
+    return success;
+}
+
+HubDistances::HubDistances(void *data, size_t data_len) : data(data), data_len(data_len) {
+    const uint64_t *header = reinterpret_cast<const uint64_t*>(data);
+    vertex_count = header[HUB_HEADER_VERTEX_COUNT];
+    hub_count = header[HUB_HEADER_HUB_COUNT];
+    hubs = reinterpret_cast<const uint32_t*>(header + HUB_HEADER_FIELD_COUNT);
+    distances = reinterpret_cast<const uint8_t*>(hubs) + HubListSize(hub_count);
+    assert(static_cast<size_t>(distances + size_t{vertex_count} * 2 * hub_count -
+            reinterpret_cast<const uint8_t*>(data)) == data_len);
+}
+
+HubDistances::~HubDistances() {
+    munmap(data, data_len);
+}
+
+std::unique_ptr<HubDistances> HubDistances::Open(const char *filename) {
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) return nullptr;
+    FdCloser fd_closer{fd};
+
+    uint64_t header[HUB_HEADER_FIELD_COUNT] = {};
+    if (read(fd, &header, sizeof(header)) != sizeof(header)) return nullptr;
+    if (header[HUB_HEADER_MAGIC] != hub_header_magic_value) return nullptr;
+    if (header[HUB_HEADER_VERTEX_COUNT] > std::numeric_limits<index_t>::max()) return nullptr;
+    if (header[HUB_HEADER_HUB_COUNT] < 1 ||
+            header[HUB_HEADER_HUB_COUNT] > header[HUB_HEADER_VERTEX_COUNT]) return nullptr;
+    uint64_t file_size = HubFileSize(header[HUB_HEADER_VERTEX_COUNT], header[HUB_HEADER_HUB_COUNT]);
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<uint64_t>(st.st_size) != file_size) return nullptr;
+
+    void *data = mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) return nullptr;
+    return std::unique_ptr<HubDistances>(new HubDistances(data, file_size));
+}
+
+std::pair<int, int> HubDistances::UpperBound(index_t start, index_t finish) const {
+    const uint8_t *to = ToHubs(start).data();
+    const uint8_t *from = FromHubs(finish).data();
+    int best = UNREACHABLE, best_hub = -1;
+    for (int i = 0; i < hub_count; ++i) {
+        if (to[i] == UNREACHABLE || from[i] == UNREACHABLE) continue;
+        int d = to[i] + from[i];
+        if (d < best) {
+            best = d;
+            best_hub = i;
+        }
+    }
+    return {best, best_hub};
+}
+
+int HubDistances::LowerBound(index_t start, index_t finish) const {
+    // For each hub h: d(s, t) >= d(h, t) - d(h, s) and d(s, t) >= d(s, h) - d(t, h).
+    const uint8_t *start_to = ToHubs(start).data();
+    const uint8_t *start_from = FromHubs(start).data();
+    const uint8_t *finish_to = ToHubs(finish).data();
+    const uint8_t *finish_from = FromHubs(finish).data();
+    uint8_t bound = 0;
+    for (int i = 0; i < hub_count; ++i) {
+        bound = std::max(bound, BoundDifference(finish_from[i], start_from[i]));
+        bound = std::max(bound, BoundDifference(start_to[i], finish_to[i]));
+    }
+    return bound;
+}
+
+std::vector<index_t> HubDistances::PathViaHub(
+        const GraphReader &graph, index_t start, index_t finish, int hub) const {
+    const index_t h = hubs[hub];
+    auto to_hub = [this, hub](index_t v) { return ToHubs(v)[hub]; };
+    auto from_hub = [this, hub](index_t v) { return FromHubs(v)[hub]; };
+    if (to_hub(start) == UNREACHABLE || from_hub(finish) == UNREACHABLE) return {};
+
+    // Walk forward from the start to the hub.
+    std::vector<index_t> path = {start};
+    for (index_t v = start; v != h; ) {
+        auto edges = graph.ForwardEdges(v);
+        auto it = std::find_if(edges.begin(), edges.end(),
+                [&](index_t w) { return to_hub(w) + 1 == to_hub(v); });
+        assert(it != edges.end());
+        v = *it;
+        path.push_back(v);
+    }
+
+    // Walk backward from the finish to the hub, then append in reverse.
+    std::vector<index_t> tail;
+    for (index_t v = finish; v != h; ) {
+        tail.push_back(v);
+        auto edges = graph.BackwardEdges(v);
+        auto it = std::find_if(edges.begin(), edges.end(),
+                [&](index_t u) { return from_hub(u) + 1 == from_hub(v); });
+        assert(it != edges.end());
+        v = *it;
+    }
+    path.insert(path.end(), tail.rbegin(), tail.rend());
+    return path;
+}
+
+}  // namespace wikipath
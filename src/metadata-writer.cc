@@ -22,6 +22,27 @@ R"(CREATE TABLE links(
 constexpr const char *insert_page_sql = "INSERT INTO pages(page_id, title) VALUES (?, ?)";
 constexpr const char *insert_link_sql = "INSERT INTO links(from_page_id, to_page_id, title) VALUES (?, ?, ?)";
 
+constexpr const char *attach_source_sql = "ATTACH DATABASE ? AS source";
+constexpr const char *create_page_id_map_sql =
+    "CREATE TEMP TABLE page_id_map(old_page_id INTEGER NOT NULL PRIMARY KEY, new_page_id INTEGER NOT NULL)";
+constexpr const char *insert_page_id_map_sql = "INSERT INTO page_id_map(old_page_id, new_page_id) VALUES (?, ?)";
+
+// Rows are inserted in primary key order, which is much faster than random
+// order for large tables.
+constexpr const char *copy_renumbered_sql[] = {
+R"(INSERT INTO pages(page_id, title)
+    SELECT m.new_page_id, p.title
+    FROM source.pages p JOIN page_id_map m ON m.old_page_id = p.page_id
+    ORDER BY 1)",
+R"(INSERT INTO links(from_page_id, to_page_id, title)
+    SELECT f.new_page_id, t.new_page_id, l.title
+    FROM source.links l
+        JOIN page_id_map f ON f.old_page_id = l.from_page_id
+        JOIN page_id_map t ON t.old_page_id = l.to_page_id
+    ORDER BY 1, 2)",
+"DROP TABLE page_id_map",
+};
+
 MetadataWriter::MetadataWriter(sqlite3 *db) : db(db) {}
 
 MetadataWriter::~MetadataWriter() {
@@ -62,6 +83,41 @@ bool MetadataWriter::InsertLink(index_t from_page_id, index_t to_page_id, const
     return success;
 }
 
+bool MetadataWriter::InsertRenumbered(const char *source_filename, std::span<const index_t> new_page_id) {
+    // Databases cannot be attached inside a transaction.
+    if (!Execute("END TRANSACTION")) return false;
+    sqlite3_stmt *stmt = nullptr;
+    bool success = Prepare(&stmt, attach_source_sql);
+    if (success) {
+        sqlite3_bind_text(stmt, 1, source_filename, -1, nullptr);
+        success = sqlite3_step(stmt) == SQLITE_DONE;
+        if (!success) std::cerr << "Failed to attach database! " << sqlite3_errmsg(db) << std::endl;
+    }
+    sqlite3_finalize(stmt);
+    if (!success) {
+        Execute("BEGIN EXCLUSIVE TRANSACTION");
+        return false;
+    }
+
+    success = Execute("BEGIN EXCLUSIVE TRANSACTION") &&
+        Execute(create_page_id_map_sql) &&
+        Prepare(&stmt, insert_page_id_map_sql);
+    for (index_t i = 0; success && i < new_page_id.size(); ++i) {
+        sqlite3_reset(stmt);
+        sqlite3_bind_int64(stmt, 1, i);
+        sqlite3_bind_int64(stmt, 2, new_page_id[i]);
+        success = sqlite3_step(stmt) == SQLITE_DONE;
+        if (!success) std::cerr << "Failed to insert page id! " << sqlite3_errmsg(db) << std::endl;
+    }
+    sqlite3_finalize(stmt);
+    for (const char *sql : copy_renumbered_sql) {
+        success = success && Execute(sql);
+    }
+    success = Execute("END TRANSACTION") && success;
+    success = Execute("DETACH DATABASE source") && success;
+    return Execute("BEGIN EXCLUSIVE TRANSACTION") && success;
+}
+
 bool MetadataWriter::Execute(const char *sql) {
     int status = sqlite3_exec(db, sql, nullptr, nullptr, nullptr);
     if (status != SQLITE_OK) {
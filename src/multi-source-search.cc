@@ -0,0 +1,214 @@
+#include "wikipath/multi-source-search.h"
+
+#include <assert.h>
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <iostream>
+#include <unordered_map>
+#include <vector>
+
+namespace wikipath {
+namespace {
+
+// A set of up to 64*W searches, one bit per search.
+template<int W>
+struct BitMask {
+    uint64_t words[W] = {};
+
+    bool Empty() const {
+        uint64_t any = 0;
+        for (int i = 0; i < W; ++i) any |= words[i];
+        return any == 0;
+    }
+
+    int Count() const {
+        int count = 0;
+        for (int i = 0; i < W; ++i) count += std::popcount(words[i]);
+        return count;
+    }
+
+    void Set(int bit) { words[bit / 64] |= uint64_t{1} << (bit % 64); }
+
+    // Returns the bits in this mask that are not in `other`.
+    BitMask AndNot(const BitMask &other) const {
+        BitMask result;
+        for (int i = 0; i < W; ++i) result.words[i] = words[i] & ~other.words[i];
+        return result;
+    }
+
+    BitMask &operator|=(const BitMask &other) {
+        for (int i = 0; i < W; ++i) words[i] |= other.words[i];
+        return *this;
+    }
+
+    template<class Fn>
+    void ForEachBit(Fn fn) const {
+        for (int i = 0; i < W; ++i) {
+            for (uint64_t word = words[i]; word != 0; word &= word - 1) {
+                fn(64*i + std::countr_zero(word));
+            }
+        }
+    }
+};
+
+// Maps target vertices to their columns in the distance matrix. A vertex may
+// occur more than once in the target list.
+class TargetIndex {
+public:
+    TargetIndex(index_t vertex_count, std::span<const index_t> targets) : is_target(vertex_count) {
+        for (size_t column = 0; column < targets.size(); ++column) {
+            index_t v = targets[column];
+            is_target[v] = true;
+            columns[v].push_back(column);
+        }
+    }
+
+    bool IsTarget(index_t v) const { return is_target[v]; }
+
+    const std::vector<size_t> &Columns(index_t v) const { return columns.at(v); }
+
+    // Number of distinct target vertices.
+    size_t UniqueCount() const { return columns.size(); }
+
+private:
+    std::vector<bool> is_target;
+    std::unordered_map<index_t, std::vector<size_t>> columns;
+};
+
+// Runs batches of up to 64*W breadth-first searches simultaneously. The
+// per-vertex arrays are allocated once and reset after each batch.
+template<int W>
+class MultiSourceSearch {
+public:
+    static constexpr int width = 64*W;
+
+    MultiSourceSearch(const GraphReader &graph, const TargetIndex &targets, DistanceMatrix &matrix)
+        : graph(graph), targets(targets), matrix(matrix),
+          seen(graph.VertexCount()), visit(graph.VertexCount()), visit_next(graph.VertexCount()) {}
+
+    // Fills in the rows of the matrix starting at `first_row` for the given
+    // sources (at most `width` of them).
+    void RunBatch(std::span<const index_t> sources, size_t first_row) {
+        assert(sources.size() <= static_cast<size_t>(width));
+
+        // Number of (search, distinct target) pairs whose distance is unknown.
+        // The batch ends early when this reaches zero.
+        size_t remaining = sources.size() * targets.UniqueCount();
+
+        auto Reached = [&](index_t v, const BitMask<W> &searches, uint8_t distance) {
+            if (!targets.IsTarget(v)) return;
+            remaining -= searches.Count();
+            searches.ForEachBit([&](int bit) {
+                for (size_t column : targets.Columns(v)) {
+                    matrix.distance[(first_row + bit) * matrix.target_count + column] = distance;
+                }
+            });
+        };
+
+        for (int bit = 0; bit < static_cast<int>(sources.size()); ++bit) {
+            index_t v = sources[bit];
+            if (visit[v].Empty()) frontier.push_back(v);
+            visit[v].Set(bit);
+            seen[v].Set(bit);
+        }
+        touched = frontier;
+        for (index_t v : frontier) Reached(v, visit[v], 0);
+
+        for (uint8_t distance = 1; remaining > 0 && !frontier.empty(); ++distance) {
+            if (distance == DistanceMatrix::UNREACHABLE) {
+                std::cerr << "WARNING: distances too great!\n";
+                break;
+            }
+            for (index_t v : frontier) {
+                const BitMask<W> searches = visit[v];
+                for (index_t w : graph.ForwardEdges(v)) {
+                    BitMask<W> new_searches = searches.AndNot(seen[w]);
+                    if (new_searches.Empty()) continue;
+                    if (visit_next[w].Empty()) next_frontier.push_back(w);
+                    visit_next[w] |= new_searches;
+                    seen[w] |= new_searches;
+                    Reached(w, new_searches, distance);
+                }
+            }
+            for (index_t v : frontier) visit[v] = {};
+            touched.insert(touched.end(), next_frontier.begin(), next_frontier.end());
+            frontier.swap(next_frontier);
+            next_frontier.clear();
+            visit.swap(visit_next);
+        }
+
+        // Reset for the next batch.
+        for (index_t v : frontier) visit[v] = {};
+        for (index_t v : touched) seen[v] = {};
+        frontier.clear();
+    }
+
+private:
+    const GraphReader &graph;
+    const TargetIndex &targets;
+    DistanceMatrix &matrix;
+
+    // seen[v] contains the searches that have reached v; visit[v] those for
+    // which v is in the current fringe, and visit_next[v] those for which v is
+    // in the next fringe.
+    std::vector<BitMask<W>> seen;
+    std::vector<BitMask<W>> visit;
+    std::vector<BitMask<W>> visit_next;
+
+    // Vertices v where visit[v] and visit_next[v] are nonzero, respectively.
+    std::vector<index_t> frontier;
+    std::vector<index_t> next_frontier;
+
+    // All vertices reached in the current batch.
+    std::vector<index_t> touched;
+};
+
+template<int W>
+void ComputeDistanceMatrixImpl(
+        const GraphReader &graph, std::span<const index_t> sources,
+        const TargetIndex &targets, DistanceMatrix &matrix) {
+    MultiSourceSearch<W> search(graph, targets, matrix);
+    for (size_t begin = 0; begin < sources.size(); begin += search.width) {
+        size_t end = std::min(sources.size(), begin + search.width);
+        search.RunBatch(sources.subspan(begin, end - begin), begin);
+    }
+}
+
+}  // namespace
+
+DistanceMatrix ComputeDistanceMatrix(
+        const GraphReader &graph,
+        std::span<const index_t> sources, std::span<const index_t> targets,
+        int batch_width) {
+    DistanceMatrix matrix = {
+        .source_count = sources.size(),
+        .target_count = targets.size(),
+        .distance = std::vector<uint8_t>(sources.size() * targets.size(), DistanceMatrix::UNREACHABLE),
+    };
+    if (sources.empty() || targets.empty()) return matrix;
+
+    // Search the copy of the graph on the NUMA node of the calling thread, if
+    // there is one.
+    const GraphReader &local_graph = graph.ForCurrentNode();
+    TargetIndex target_index(graph.VertexCount(), targets);
+    switch (batch_width) {
+        case 64:
+            ComputeDistanceMatrixImpl<1>(local_graph, sources, target_index, matrix);
+            break;
+        case 128:
+            ComputeDistanceMatrixImpl<2>(local_graph, sources, target_index, matrix);
+            break;
+        case 256:
+            ComputeDistanceMatrixImpl<4>(local_graph, sources, target_index, matrix);
+            break;
+        default:
+            assert(false);
+            std::cerr << "Unsupported batch width: " << batch_width << "\n";
+            break;
+    }
+    return matrix;
+}
+
+}  // namespace wikipath
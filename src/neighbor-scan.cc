@@ -0,0 +1,168 @@
+#include "wikipath/neighbor-scan.h"
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+#include <assert.h>
+
+#include <bit>
+#include <cstdint>
+
+namespace wikipath {
+namespace {
+
+inline bool IsMeeting(index_t value, index_t meet_min, index_t meet_count) {
+    return static_cast<index_t>(value - meet_min) < meet_count;
+}
+
+ScanResult ScanScalar(
+        std::span<const index_t> neighbors, index_t *visited,
+        index_t mark, index_t meet_min, index_t meet_count, index_t *fringe) {
+    size_t reached = 0;
+    for (size_t k = 0; k < neighbors.size(); ++k) {
+        index_t w = neighbors[k];
+        index_t value = visited[w];
+        if (value == 0) {
+            visited[w] = mark;
+            fringe[reached++] = w;
+        } else if (IsMeeting(value, meet_min, meet_count)) {
+            return ScanResult{.reached = reached, .meeting = k};
+        }
+    }
+    return ScanResult{.reached = reached, .meeting = neighbors.size()};
+}
+
+#if defined(__x86_64__)
+
+// Marks the neighbors in `lanes` (a bitmask of positions relative to
+// `neighbors`) whose visited entries were 0 when they were gathered. Since a
+// neighbor may occur more than once, each entry is checked again.
+inline size_t MarkLanes(
+        const index_t *neighbors, uint32_t lanes, index_t *visited, index_t mark, index_t *fringe) {
+    size_t reached = 0;
+    for (; lanes != 0; lanes &= lanes - 1) {
+        index_t w = neighbors[std::countr_zero(lanes)];
+        if (visited[w] == 0) {
+            visited[w] = mark;
+            fringe[reached++] = w;
+        }
+    }
+    return reached;
+}
+
+__attribute__((target("avx2")))
+ScanResult ScanAvx2(
+        std::span<const index_t> neighbors, index_t *visited,
+        index_t mark, index_t meet_min, index_t meet_count, index_t *fringe) {
+    // Unsigned comparison x < meet_count as signed comparison with the sign
+    // bits flipped, since AVX2 has no unsigned compare.
+    const __m256i sign = _mm256_set1_epi32(INT32_MIN);
+    const __m256i min = _mm256_set1_epi32(meet_min);
+    const __m256i count = _mm256_xor_si256(_mm256_set1_epi32(meet_count), sign);
+    const __m256i zero = _mm256_setzero_si256();
+    const int *base = reinterpret_cast<const int*>(visited);
+    size_t reached = 0, k = 0;
+    for (; k + 8 <= neighbors.size(); k += 8) {
+        __m256i indices = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(neighbors.data() + k));
+        __m256i values = _mm256_i32gather_epi32(base, indices, 4);
+        __m256i offset = _mm256_xor_si256(_mm256_sub_epi32(values, min), sign);
+        uint32_t meeting = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(count, offset)));
+        uint32_t unvisited = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(values, zero)));
+        if (meeting != 0) {
+            int lane = std::countr_zero(meeting);
+            reached += MarkLanes(neighbors.data() + k, unvisited & ((1u << lane) - 1), visited, mark, fringe + reached);
+            return ScanResult{.reached = reached, .meeting = k + lane};
+        }
+        reached += MarkLanes(neighbors.data() + k, unvisited, visited, mark, fringe + reached);
+    }
+    ScanResult tail = ScanScalar(neighbors.subspan(k), visited, mark, meet_min, meet_count, fringe + reached);
+    return ScanResult{.reached = reached + tail.reached, .meeting = k + tail.meeting};
+}
+
+__attribute__((target("avx512f,avx512cd")))
+ScanResult ScanAvx512(
+        std::span<const index_t> neighbors, index_t *visited,
+        index_t mark, index_t meet_min, index_t meet_count, index_t *fringe) {
+    const __m512i min = _mm512_set1_epi32(meet_min);
+    const __m512i count = _mm512_set1_epi32(meet_count);
+    const __m512i marks = _mm512_set1_epi32(mark);
+    const __m512i zero = _mm512_setzero_si512();
+    size_t reached = 0, k = 0;
+    for (; k + 16 <= neighbors.size(); k += 16) {
+        __m512i indices = _mm512_loadu_si512(neighbors.data() + k);
+        __m512i values = _mm512_mask_i32gather_epi32(zero, 0xffff, indices, visited, 4);
+        __mmask16 meeting = _mm512_cmplt_epu32_mask(_mm512_sub_epi32(values, min), count);
+        __mmask16 unvisited = _mm512_cmpeq_epi32_mask(values, zero);
+        if (meeting != 0) unvisited &= (1u << std::countr_zero(static_cast<uint32_t>(meeting))) - 1;
+        if (unvisited != 0) {
+            // Only the first occurrence of a neighbor is marked. For each lane,
+            // the conflict mask has a bit for every earlier lane with the same
+            // neighbor.
+            __m512i conflicts = _mm512_maskz_conflict_epi32(unvisited, indices);
+            unvisited &= ~_mm512_test_epi32_mask(conflicts, _mm512_set1_epi32(unvisited));
+            _mm512_mask_i32scatter_epi32(visited, unvisited, indices, marks, 4);
+            _mm512_mask_compressstoreu_epi32(fringe + reached, unvisited, indices);
+            reached += std::popcount(static_cast<uint32_t>(unvisited));
+        }
+        if (meeting != 0) {
+            return ScanResult{.reached = reached, .meeting = k + std::countr_zero(static_cast<uint32_t>(meeting))};
+        }
+    }
+    ScanResult tail = ScanScalar(neighbors.subspan(k), visited, mark, meet_min, meet_count, fringe + reached);
+    return ScanResult{.reached = reached + tail.reached, .meeting = k + tail.meeting};
+}
+
+#endif  // defined(__x86_64__)
+
+}  // namespace
+
+const char *ScanKernelName(ScanKernel kernel) {
+    switch (kernel) {
+        case ScanKernel::SCALAR: return "scalar";
+        case ScanKernel::AVX2: return "avx2";
+        case ScanKernel::AVX512: return "avx512";
+    }
+    return "unknown";
+}
+
+bool ScanKernelSupported(ScanKernel kernel) {
+    switch (kernel) {
+        case ScanKernel::SCALAR:
+            return true;
+#if defined(__x86_64__)
+        case ScanKernel::AVX2:
+            return __builtin_cpu_supports("avx2");
+        case ScanKernel::AVX512:
+            return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512cd");
+#endif
+        default:
+            return false;
+    }
+}
+
+ScanKernel BestScanKernel() {
+    static const ScanKernel best =
+            ScanKernelSupported(ScanKernel::AVX512) ? ScanKernel::AVX512 :
+            ScanKernelSupported(ScanKernel::AVX2) ? ScanKernel::AVX2 :
+            ScanKernel::SCALAR;
+    return best;
+}
+
+ScanResult ScanNeighbors(
+        ScanKernel kernel, std::span<const index_t> neighbors, index_t *visited,
+        index_t mark, index_t meet_min, index_t meet_count, index_t *fringe) {
+    assert(ScanKernelSupported(kernel));
+    switch (kernel) {
+#if defined(__x86_64__)
+        case ScanKernel::AVX2:
+            return ScanAvx2(neighbors, visited, mark, meet_min, meet_count, fringe);
+        case ScanKernel::AVX512:
+            return ScanAvx512(neighbors, visited, mark, meet_min, meet_count, fringe);
+#endif
+        default:
+            return ScanScalar(neighbors, visited, mark, meet_min, meet_count, fringe);
+    }
+}
+
+}  // namespace wikipath
@@ -0,0 +1,110 @@
+#include "wikipath/numa.h"
+
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <charconv>
+#include <climits>
+#include <fstream>
+#include <string>
+#include <thread>
+
+namespace wikipath {
+namespace {
+
+// From <linux/mempolicy.h>, which is not included to avoid depending on the
+// kernel headers (or on <numaif.h> from libnuma).
+constexpr int mpol_bind = 2;
+
+// Reads the first line of a sysfs file. Returns nullopt if it can't be read.
+std::optional<std::string> ReadLine(const std::string &filename) {
+    std::ifstream is(filename);
+    std::string line;
+    if (!is || !std::getline(is, line)) return std::nullopt;
+    return line;
+}
+
+bool ParseInt(std::string_view sv, int &value) {
+    auto [ptr, ec] = std::from_chars(sv.data(), sv.data() + sv.size(), value);
+    return ec == std::errc() && ptr == sv.data() + sv.size() && value >= 0;
+}
+
+}  // namespace
+
+std::optional<std::vector<int>> ParseCpuList(std::string_view list) {
+    while (!list.empty() && (list.back() == '\n' || list.back() == ' ')) list.remove_suffix(1);
+    std::vector<int> result;
+    while (!list.empty()) {
+        auto comma = list.find(',');
+        std::string_view range = list.substr(0, comma);
+        list.remove_prefix(comma == std::string_view::npos ? list.size() : comma + 1);
+        auto dash = range.find('-');
+        int first = 0, last = 0;
+        if (!ParseInt(range.substr(0, dash), first)) return std::nullopt;
+        last = first;
+        if (dash != std::string_view::npos && (!ParseInt(range.substr(dash + 1), last) || last < first)) {
+            return std::nullopt;
+        }
+        for (int i = first; i <= last; ++i) result.push_back(i);
+    }
+    return result;
+}
+
+std::vector<int> OnlineNumaNodes() {
+    std::optional<std::string> line = ReadLine("/sys/devices/system/node/online");
+    std::optional<std::vector<int>> nodes = line ? ParseCpuList(*line) : std::nullopt;
+    if (!nodes || nodes->empty()) return {0};
+    return *nodes;
+}
+
+std::vector<int> NumaNodeCpus(int node) {
+    std::optional<std::string> line = ReadLine(
+            "/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+    if (!line) {
+        // Without sysfs (or without NUMA support), node 0 has all CPUs.
+        std::vector<int> cpus;
+        if (node == 0 && ReadLine("/sys/devices/system/node/online") == std::nullopt) {
+            for (int cpu = 0; cpu < static_cast<int>(std::thread::hardware_concurrency()); ++cpu) {
+                cpus.push_back(cpu);
+            }
+        }
+        return cpus;
+    }
+    return ParseCpuList(*line).value_or(std::vector<int>{});
+}
+
+int CurrentNumaNode() {
+    unsigned cpu = 0, node = 0;
+    if (getcpu(&cpu, &node) != 0) return 0;
+    return node;
+}
+
+bool PinThreadToNumaNode(int node) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    int count = 0;
+    for (int cpu : NumaNodeCpus(node)) {
+        if (cpu < CPU_SETSIZE) {
+            CPU_SET(cpu, &set);
+            ++count;
+        }
+    }
+    return count > 0 && sched_setaffinity(0, sizeof(set), &set) == 0;
+}
+
+bool BindMemoryToNumaNode(void *addr, size_t len, int node) {
+    if (node < 0) {
+        errno = EINVAL;
+        return false;
+    }
+    constexpr int bits = sizeof(unsigned long) * CHAR_BIT;
+    std::vector<unsigned long> mask(node / bits + 1);
+    mask[node / bits] = 1UL << (node % bits);
+    // The kernel reads one bit less than `maxnode`, so like libnuma, we pass
+    // one more than the number of bits in the mask.
+    return syscall(SYS_mbind, addr, len, mpol_bind, mask.data(), mask.size() * bits + 1, 0) == 0;
+}
+
+}  // namespace wikipath
@@ -18,6 +18,17 @@
 //  - shortest_path_with_stats() is a separate method that returns a pair of
 //    (path, stats) because Python does not support output arguments.
 //
+//  - the GraphReader search methods take an optional `workspace` argument
+//    (a SearchWorkspace) instead of being methods of SearchWorkspace.
+//
+//  - shortest_path() and shortest_path_dag() (and their _with_stats variants)
+//    take an optional `filter` argument (a SearchFilter).
+//
+//  - the GraphReader search methods also take an optional `limits` argument.
+//    Python's SearchLimits has a `timeout_ms` measured from the start of each
+//    search instead of an absolute deadline, and no cancel flag, since the
+//    GIL is held while searching.
+//
 //  - similarly, shortest_path_annotated_dag() and
 //    shortest_path_annotated_dag_with_stats() are
 //    defined as methods of Reader.
@@ -29,14 +40,17 @@
 #include "wikipath/graph-reader.h"
 #include "wikipath/metadata-reader.h"
 #include "wikipath/reader.h"
+#include "wikipath/result-cache.h"
 #include "wikipath/searcher.h"
 #include "wikipath/annotated-dag.h"
 
+#include <pybind11/numpy.h>
 #include <pybind11/operators.h>
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 #include <pybind11/stl_bind.h>
 
+#include <chrono>
 #include <iomanip>
 #include <iostream>
 #include <limits>
@@ -44,6 +58,7 @@
 #include <string>
 #include <string>
 #include <sstream>
+#include <tuple>
 #include <utility>
 #include <vector>
 
@@ -86,20 +101,117 @@ std::ostream &operator<<(std::ostream &os, GraphReader::OpenOptions::MLock mlock
         case GraphReader::OpenOptions::MLock::FOREGROUND: return os << "wikipath.GraphReader.OpenOptions.MLock.FOREGROUND";
         case GraphReader::OpenOptions::MLock::BACKGROUND: return os << "wikipath.GraphReader.OpenOptions.MLock.BACKGROUND";
         case GraphReader::OpenOptions::MLock::POPULATE:   return os << "wikipath.GraphReader.OpenOptions.MLock.POPULATE";
+        case GraphReader::OpenOptions::MLock::PARALLEL:   return os << "wikipath.GraphReader.OpenOptions.MLock.PARALLEL";
+    }
+    return os << "<invalid>";
+}
+
+std::ostream &operator<<(std::ostream &os, GraphReader::OpenOptions::HugePages huge_pages) {
+    switch (huge_pages) {
+        case GraphReader::OpenOptions::HugePages::NONE:        return os << "wikipath.GraphReader.OpenOptions.HugePages.NONE";
+        case GraphReader::OpenOptions::HugePages::FILE:        return os << "wikipath.GraphReader.OpenOptions.HugePages.FILE";
+        case GraphReader::OpenOptions::HugePages::TRANSPARENT: return os << "wikipath.GraphReader.OpenOptions.HugePages.TRANSPARENT";
+        case GraphReader::OpenOptions::HugePages::HUGETLB:     return os << "wikipath.GraphReader.OpenOptions.HugePages.HUGETLB";
     }
     return os << "<invalid>";
 }
 
 std::ostream &operator<<(std::ostream &os, const GraphReader::OpenOptions &options) {
-  return os << "wikipath.GraphReader.OpenOptions(mlock=" << options.mlock << ")";
+  os << "wikipath.GraphReader.OpenOptions(mlock=" << options.mlock
+      << ", huge_pages=" << options.huge_pages
+      << ", warm_up_threads=" << options.warm_up_threads
+      << ", warm_up_mlock=" << (options.warm_up_mlock ? "True" : "False")
+      << ", numa_replicas=" << (options.numa_replicas ? "True" : "False")
+      << ", numa_nodes=[";
+  for (size_t i = 0; i < options.numa_nodes.size(); ++i) {
+    os << (i > 0 ? ", " : "") << options.numa_nodes[i];
+  }
+  return os << "])";
 }
 
-std::ostream &operator<<(std::ostream &os, const SearchStats &stats) {
+std::ostream &operator<<(std::ostream &os, GraphReader::LoadStatus::State state) {
+    switch (state) {
+        case GraphReader::LoadStatus::State::NONE:        return os << "wikipath.GraphReader.LoadStatus.State.NONE";
+        case GraphReader::LoadStatus::State::IN_PROGRESS: return os << "wikipath.GraphReader.LoadStatus.State.IN_PROGRESS";
+        case GraphReader::LoadStatus::State::COMPLETED:   return os << "wikipath.GraphReader.LoadStatus.State.COMPLETED";
+        case GraphReader::LoadStatus::State::FAILED:      return os << "wikipath.GraphReader.LoadStatus.State.FAILED";
+    }
+    return os << "<invalid>";
+}
+
+std::ostream &operator<<(std::ostream &os, const GraphReader::LoadStatus &status) {
+  return os << "wikipath.GraphReader.LoadStatus(state=" << status.state
+      << ", bytes_loaded=" << status.bytes_loaded
+      << ", bytes_total=" << status.bytes_total
+      << ", elapsed_s=" << status.elapsed_s << ")";
+}
+
+std::ostream &operator<<(std::ostream &os, Direction direction) {
+  switch (direction) {
+    case Direction::FORWARD:  return os << "wikipath.Direction.FORWARD";
+    case Direction::BACKWARD: return os << "wikipath.Direction.BACKWARD";
+  }
+  return os << "<invalid>";
+}
+
+std::ostream &operator<<(std::ostream &os, SearchLevel::Mode mode) {
+  switch (mode) {
+    case SearchLevel::Mode::TOP_DOWN:  return os << "wikipath.SearchLevel.Mode.TOP_DOWN";
+    case SearchLevel::Mode::BOTTOM_UP: return os << "wikipath.SearchLevel.Mode.BOTTOM_UP";
+  }
+  return os << "<invalid>";
+}
+
+std::ostream &operator<<(std::ostream &os, const SearchLevel &level) {
   return os
+      << "wikipath.SearchLevel(direction=" << level.direction
+      << ", mode=" << level.mode
+      << ", fringe_size=" << level.fringe_size
+      << ", vertices_expanded=" << level.vertices_expanded
+      << ", edges_expanded=" << level.edges_expanded << ")";
+}
+
+std::ostream &operator<<(std::ostream &os, AbortReason reason) {
+  switch (reason) {
+    case AbortReason::NONE:         return os << "wikipath.AbortReason.NONE";
+    case AbortReason::VERTEX_LIMIT: return os << "wikipath.AbortReason.VERTEX_LIMIT";
+    case AbortReason::EDGE_LIMIT:   return os << "wikipath.AbortReason.EDGE_LIMIT";
+    case AbortReason::DEADLINE:     return os << "wikipath.AbortReason.DEADLINE";
+    case AbortReason::CANCELLED:    return os << "wikipath.AbortReason.CANCELLED";
+  }
+  return os << "<invalid>";
+}
+
+std::ostream &operator<<(std::ostream &os, const SearchStats &stats) {
+  os
       << "wikipath.SearchStats(vertices_reached=" << stats.vertices_reached
       << ", vertices_expanded=" << stats.vertices_expanded
       << ", edges_expanded=" << stats.edges_expanded
-      << ", time_taken_ms=" << stats.time_taken_ms << ")";
+      << ", time_taken_ms=" << stats.time_taken_ms
+      << ", levels=[";
+  for (size_t i = 0; i < stats.levels.size(); ++i) {
+    if (i > 0) os << ", ";
+    os << stats.levels[i];
+  }
+  return os
+      << "], abort_reason=" << stats.abort_reason
+      << ", time_taken_ns=" << stats.time_taken_ns
+      << ", search_ns=" << stats.search_ns
+      << ", reconstruct_ns=" << stats.reconstruct_ns
+      << ", propagate_ns=" << stats.propagate_ns
+      << ", sort_ns=" << stats.sort_ns
+      << ", minor_faults=" << stats.minor_faults
+      << ", major_faults=" << stats.major_faults << ")";
+}
+
+std::ostream &operator<<(std::ostream &os, const ResultCacheStats &stats) {
+  return os
+      << "wikipath.ResultCacheStats(hits=" << stats.hits
+      << ", misses=" << stats.misses
+      << ", insertions=" << stats.insertions
+      << ", evictions=" << stats.evictions
+      << ", entries=" << stats.entries
+      << ", bytes=" << stats.bytes << ")";
 }
 
 std::ostream &operator<<(std::ostream &os, const MetadataReader::Page &page) {
@@ -234,8 +346,8 @@ class AnnotatedDagWrapper {
 public:
   AnnotatedDagWrapper(
       const std::shared_ptr<Reader> &reader, index_t start, index_t finish,
-      std::vector<std::pair<index_t, index_t>> edges)
-    : dag(reader.get(), start, finish, std::move(edges)), reader(reader) {}
+      std::vector<std::pair<index_t, index_t>> edges, int max_length = -1)
+    : dag(reader.get(), start, finish, std::move(edges), max_length), reader(reader) {}
 
   ~AnnotatedDagWrapper() {}
 
@@ -250,6 +362,10 @@ public:
     return AnnotatedPageWrapper((*dag)->Finish(), dag);
   }
 
+  static int MaxLength(const std::shared_ptr<AnnotatedDagWrapper> &dag) {
+    return (*dag)->MaxLength();
+  }
+
   static int64_t CountPaths(const std::shared_ptr<AnnotatedDagWrapper> &dag) {
     return (*dag)->CountPaths();
   };
@@ -273,17 +389,125 @@ private:
   std::shared_ptr<Reader> reader;  // keep-alive
 };
 
+// Python version of SearchLimits. See the comment at the top of this file.
+struct PythonSearchLimits {
+  int64_t max_vertices_expanded = std::numeric_limits<int64_t>::max();
+  int64_t max_edges_expanded = std::numeric_limits<int64_t>::max();
+  std::optional<double> timeout_ms;
+
+  // Returns the limits for a search that starts now.
+  SearchLimits Start() const {
+    SearchLimits limits = {
+      .max_vertices_expanded = max_vertices_expanded,
+      .max_edges_expanded = max_edges_expanded,
+    };
+    if (timeout_ms) {
+      limits.deadline = std::chrono::steady_clock::now() +
+          std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+              std::chrono::duration<double, std::milli>(*timeout_ms));
+    }
+    return limits;
+  }
+};
+
+std::ostream &operator<<(std::ostream &os, const PythonSearchLimits &limits) {
+  os
+      << "wikipath.SearchLimits(max_vertices_expanded=" << limits.max_vertices_expanded
+      << ", max_edges_expanded=" << limits.max_edges_expanded
+      << ", timeout_ms=";
+  if (limits.timeout_ms) {
+    os << *limits.timeout_ms;
+  } else {
+    os << "None";
+  }
+  return os << ")";
+}
+
+std::vector<index_t> ShortestPath(
+    const GraphReader &graph, index_t start, index_t finish, SearchStats *stats,
+    SearchWorkspace *workspace, const PythonSearchLimits *python_limits, const SearchFilter *filter) {
+  const SearchLimits limits = python_limits != nullptr ? python_limits->Start() : SearchLimits{};
+  return workspace != nullptr
+      ? workspace->FindShortestPath(graph, start, finish, stats, {}, limits, filter).value
+      : FindShortestPath(graph, start, finish, stats, {}, limits, filter).value;
+}
+
+std::optional<std::vector<std::pair<index_t, index_t>>> ShortestPathDag(
+    const GraphReader &graph, index_t start, index_t finish, SearchStats *stats,
+    SearchWorkspace *workspace, const PythonSearchLimits *python_limits, const SearchFilter *filter) {
+  const SearchLimits limits = python_limits != nullptr ? python_limits->Start() : SearchLimits{};
+  return workspace != nullptr
+      ? workspace->FindShortestPathDag(graph, start, finish, stats, {}, limits, filter).value
+      : FindShortestPathDag(graph, start, finish, stats, {}, limits, filter).value;
+}
+
+std::optional<int> ShortestPathLength(
+    const GraphReader &graph, index_t start, index_t finish, SearchStats *stats,
+    SearchWorkspace *workspace, const PythonSearchLimits *python_limits) {
+  const SearchLimits limits = python_limits != nullptr ? python_limits->Start() : SearchLimits{};
+  return workspace != nullptr
+      ? workspace->ShortestPathLength(graph, start, finish, stats, limits).value
+      : ShortestPathLength(graph, start, finish, stats, limits).value;
+}
+
+std::optional<std::tuple<int, int, std::vector<std::pair<index_t, index_t>>>> NearShortestPaths(
+    const GraphReader &graph, index_t start, index_t finish, int slack,
+    SearchWorkspace *workspace, const PythonSearchLimits *python_limits) {
+  if (slack < 0) throw py::value_error("slack must not be negative");
+  const SearchLimits limits = python_limits != nullptr ? python_limits->Start() : SearchLimits{};
+  auto paths = workspace != nullptr
+      ? workspace->FindNearShortestPaths(graph, start, finish, slack, nullptr, limits).value
+      : FindNearShortestPaths(graph, start, finish, slack, nullptr, limits).value;
+  if (!paths) return {};
+  return std::make_tuple(paths->shortest_length, paths->max_length, std::move(paths->edges));
+}
+
+// Returns a mutable pointer, since pybind11 does not support holders of const
+// types. CachedResult is exposed with readonly properties only.
+std::shared_ptr<CachedResult> CachedShortestPath(
+    const Reader &reader, index_t start, index_t finish, ResultCache &cache, QueryKind kind,
+    SearchStats *stats, SearchWorkspace *workspace, const PythonSearchLimits *python_limits) {
+  ValidatePageIndex(reader.Graph().VertexCount(), start);
+  ValidatePageIndex(reader.Graph().VertexCount(), finish);
+  const SearchLimits limits = python_limits != nullptr ? python_limits->Start() : SearchLimits{};
+  return std::const_pointer_cast<CachedResult>(kind == QueryKind::SHORTEST_PATH
+      ? cache.ShortestPath(reader, start, finish, stats, workspace, limits)
+      : cache.ShortestPathDag(reader, start, finish, stats, workspace, limits));
+}
+
+// Returns a numpy array that takes ownership of the given vector, without
+// copying its contents.
+template<class T>
+py::array_t<T> ToNumpyArray(std::vector<T> values) {
+  auto *data = new std::vector<T>(std::move(values));
+  py::capsule owner(data, [](void *p) { delete static_cast<std::vector<T>*>(p); });
+  return py::array_t<T>(data->size(), data->data(), owner);
+}
+
 std::shared_ptr<AnnotatedDagWrapper>
 ShortestPathAnnotatedDag(
     const std::shared_ptr<Reader> &reader, index_t start, index_t finish, SearchStats *stats) {
   if (reader->IsValidPageId(start) && reader->IsValidPageId(finish)) {
-    if (auto dag = FindShortestPathDag(reader->Graph(), start, finish, stats)) {
+    if (auto dag = FindShortestPathDag(reader->Graph(), start, finish, stats).value) {
       return std::make_shared<AnnotatedDagWrapper>(reader, start, finish, std::move(*dag));
     }
   }
   return {};
 }
 
+std::shared_ptr<AnnotatedDagWrapper>
+NearShortestPathsAnnotatedDag(
+    const std::shared_ptr<Reader> &reader, index_t start, index_t finish, int slack) {
+  if (slack < 0) throw py::value_error("slack must not be negative");
+  if (reader->IsValidPageId(start) && reader->IsValidPageId(finish)) {
+    if (auto paths = FindNearShortestPaths(reader->Graph(), start, finish, slack, nullptr).value) {
+      return std::make_shared<AnnotatedDagWrapper>(
+          reader, start, finish, std::move(paths->edges), paths->max_length);
+    }
+  }
+  return {};
+}
+
 class PathEnumeratorWrapper {
 public:
   PathEnumeratorWrapper(PathEnumerator val, std::shared_ptr<AnnotatedDagWrapper> dag)
@@ -335,6 +559,12 @@ template<> struct std::hash<AnnotatedPageWrapper> {
 };
 
 PYBIND11_MODULE(wikipath, module) {
+  // Registered first, because it is used in default arguments below.
+  py::enum_<Direction>(module, "Direction")
+      .value("FORWARD", Direction::FORWARD)
+      .value("BACKWARD", Direction::BACKWARD)
+  ;
+
   py::class_<GraphReader> graph_reader(module, "GraphReader");
   py::class_<GraphReader::OpenOptions> open_options(graph_reader, "OpenOptions");
   py::enum_<GraphReader::OpenOptions::MLock>(open_options, "MLock")
@@ -342,25 +572,68 @@ PYBIND11_MODULE(wikipath, module) {
       .value("FOREGROUND", GraphReader::OpenOptions::MLock::FOREGROUND)
       .value("BACKGROUND", GraphReader::OpenOptions::MLock::BACKGROUND)
       .value("POPULATE", GraphReader::OpenOptions::MLock::POPULATE)
+      .value("PARALLEL", GraphReader::OpenOptions::MLock::PARALLEL)
+  ;
+  py::enum_<GraphReader::OpenOptions::HugePages>(open_options, "HugePages")
+      .value("NONE", GraphReader::OpenOptions::HugePages::NONE)
+      .value("FILE", GraphReader::OpenOptions::HugePages::FILE)
+      .value("TRANSPARENT", GraphReader::OpenOptions::HugePages::TRANSPARENT)
+      .value("HUGETLB", GraphReader::OpenOptions::HugePages::HUGETLB)
   ;
   open_options
       .def(
-          py::init([](GraphReader::OpenOptions::MLock mlock) {
+          py::init([](GraphReader::OpenOptions::MLock mlock, GraphReader::OpenOptions::HugePages huge_pages,
+                int warm_up_threads, bool warm_up_mlock, bool numa_replicas, std::vector<int> numa_nodes) {
             return GraphReader::OpenOptions{
               .mlock = mlock,
+              .huge_pages = huge_pages,
+              .warm_up_threads = warm_up_threads,
+              .warm_up_mlock = warm_up_mlock,
+              .numa_replicas = numa_replicas,
+              .numa_nodes = std::move(numa_nodes),
             };
           }),
           py::kw_only(),
-          py::arg("mlock") = GraphReader::OpenOptions::MLock::NONE)
+          py::arg("mlock") = GraphReader::OpenOptions::MLock::NONE,
+          py::arg("huge_pages") = GraphReader::OpenOptions::HugePages::NONE,
+          py::arg("warm_up_threads") = GraphReader::OpenOptions{}.warm_up_threads,
+          py::arg("warm_up_mlock") = GraphReader::OpenOptions{}.warm_up_mlock,
+          py::arg("numa_replicas") = GraphReader::OpenOptions{}.numa_replicas,
+          py::arg("numa_nodes") = std::vector<int>{})
       .def_readwrite("mlock", &GraphReader::OpenOptions::mlock)
+      .def_readwrite("huge_pages", &GraphReader::OpenOptions::huge_pages)
+      .def_readwrite("warm_up_threads", &GraphReader::OpenOptions::warm_up_threads)
+      .def_readwrite("warm_up_mlock", &GraphReader::OpenOptions::warm_up_mlock)
+      .def_readwrite("numa_replicas", &GraphReader::OpenOptions::numa_replicas)
+      .def_readwrite("numa_nodes", &GraphReader::OpenOptions::numa_nodes)
       .def("__repr__", &ToString<GraphReader::OpenOptions>)
   ;
+  py::class_<GraphReader::LoadStatus> load_status(graph_reader, "LoadStatus");
+  py::enum_<GraphReader::LoadStatus::State>(load_status, "State")
+      .value("NONE", GraphReader::LoadStatus::State::NONE)
+      .value("IN_PROGRESS", GraphReader::LoadStatus::State::IN_PROGRESS)
+      .value("COMPLETED", GraphReader::LoadStatus::State::COMPLETED)
+      .value("FAILED", GraphReader::LoadStatus::State::FAILED)
+  ;
+  load_status
+      .def_readonly("state", &GraphReader::LoadStatus::state)
+      .def_readonly("bytes_loaded", &GraphReader::LoadStatus::bytes_loaded)
+      .def_readonly("bytes_total", &GraphReader::LoadStatus::bytes_total)
+      .def_readonly("elapsed_s", &GraphReader::LoadStatus::elapsed_s)
+      .def_property_readonly("bytes_per_second", &GraphReader::LoadStatus::BytesPerSecond)
+      .def("__repr__", &ToString<GraphReader::LoadStatus>)
+  ;
   graph_reader
       .def(py::init(&GraphReader::Open),
           py::arg("filename"),
           py::arg("options") = GraphReader::OpenOptions{})
       .def_property_readonly("vertex_count", &GraphReader::VertexCount)
       .def_property_readonly("edge_count", &GraphReader::EdgeCount)
+      .def_property_readonly("compressed", &GraphReader::Compressed)
+      .def_property_readonly("huge_pages_mode", &GraphReader::HugePagesMode)
+      .def_property_readonly("huge_page_bytes", &GraphReader::HugePageBytes)
+      .def_property_readonly("load_status", &GraphReader::GetLoadStatus)
+      .def_property_readonly("numa_replica_nodes", &GraphReader::NumaReplicaNodes)
       .def("forward_edges",
           [](GraphReader &gr, index_t page_id) {
             ValidatePageIndex(gr.VertexCount(), page_id);
@@ -374,29 +647,201 @@ PYBIND11_MODULE(wikipath, module) {
           },
           py::arg("page_id"))
       .def("shortest_path",
-          [](GraphReader &reader, index_t start, index_t finish) {
-            return FindShortestPath(reader, start, finish, nullptr);
+          [](GraphReader &reader, index_t start, index_t finish,
+              SearchWorkspace *workspace, const PythonSearchLimits *limits,
+              const SearchFilter *filter) {
+            return ShortestPath(reader, start, finish, nullptr, workspace, limits, filter);
           },
-          py::arg("start"), py::arg("finish"))
+          py::arg("start"), py::arg("finish"), py::kw_only(),
+          py::arg("workspace") = static_cast<SearchWorkspace*>(nullptr),
+          py::arg("limits") = static_cast<const PythonSearchLimits*>(nullptr),
+          py::arg("filter") = static_cast<const SearchFilter*>(nullptr))
       .def("shortest_path_with_stats",
-          [](GraphReader &reader, index_t start, index_t finish) {
+          [](GraphReader &reader, index_t start, index_t finish,
+              SearchWorkspace *workspace, const PythonSearchLimits *limits,
+              const SearchFilter *filter) {
             SearchStats stats = {};
-            auto path = FindShortestPath(reader, start, finish, &stats);
+            auto path = ShortestPath(reader, start, finish, &stats, workspace, limits, filter);
             return std::make_pair(std::move(path), std::move(stats));
           },
-          py::arg("start"), py::arg("finish"))
+          py::arg("start"), py::arg("finish"), py::kw_only(),
+          py::arg("workspace") = static_cast<SearchWorkspace*>(nullptr),
+          py::arg("limits") = static_cast<const PythonSearchLimits*>(nullptr),
+          py::arg("filter") = static_cast<const SearchFilter*>(nullptr))
       .def("shortest_path_dag",
-          [](GraphReader &reader, index_t start, index_t finish) {
-            return FindShortestPathDag(reader, start, finish, nullptr);
+          [](GraphReader &reader, index_t start, index_t finish,
+              SearchWorkspace *workspace, const PythonSearchLimits *limits,
+              const SearchFilter *filter) {
+            return ShortestPathDag(reader, start, finish, nullptr, workspace, limits, filter);
           },
-          py::arg("start"), py::arg("finish"))
+          py::arg("start"), py::arg("finish"), py::kw_only(),
+          py::arg("workspace") = static_cast<SearchWorkspace*>(nullptr),
+          py::arg("limits") = static_cast<const PythonSearchLimits*>(nullptr),
+          py::arg("filter") = static_cast<const SearchFilter*>(nullptr))
       .def("shortest_path_dag_with_stats",
-          [](GraphReader &reader, index_t start, index_t finish) {
+          [](GraphReader &reader, index_t start, index_t finish,
+              SearchWorkspace *workspace, const PythonSearchLimits *limits,
+              const SearchFilter *filter) {
             SearchStats stats = {};
-            auto dag = FindShortestPathDag(reader, start, finish, &stats);
+            auto dag = ShortestPathDag(reader, start, finish, &stats, workspace, limits, filter);
             return std::make_pair(std::move(dag), std::move(stats));
           },
-          py::arg("start"), py::arg("finish"))
+          py::arg("start"), py::arg("finish"), py::kw_only(),
+          py::arg("workspace") = static_cast<SearchWorkspace*>(nullptr),
+          py::arg("limits") = static_cast<const PythonSearchLimits*>(nullptr),
+          py::arg("filter") = static_cast<const SearchFilter*>(nullptr))
+      .def("shortest_path_length",
+          [](GraphReader &reader, index_t start, index_t finish,
+              SearchWorkspace *workspace, const PythonSearchLimits *limits) {
+            return ShortestPathLength(reader, start, finish, nullptr, workspace, limits);
+          },
+          "Returns the length of a shortest path from `start` to `finish`, or None if\n"
+          "there is none. This is faster than shortest_path(), since it uses less memory\n"
+          "and does not reconstruct the path.\n",
+          py::arg("start"), py::arg("finish"), py::kw_only(),
+          py::arg("workspace") = static_cast<SearchWorkspace*>(nullptr),
+          py::arg("limits") = static_cast<const PythonSearchLimits*>(nullptr))
+      .def("near_shortest_paths",
+          [](GraphReader &reader, index_t start, index_t finish, int slack,
+              SearchWorkspace *workspace, const PythonSearchLimits *limits) {
+            return NearShortestPaths(reader, start, finish, slack, workspace, limits);
+          },
+          "Returns a tuple (shortest_length, max_length, edges), where max_length is\n"
+          "shortest_length + slack, and edges is the sorted list of edges that occur on\n"
+          "some walk from `start` to `finish` of at most max_length edges, or None if\n"
+          "there is no path from `start` to `finish`.\n",
+          py::arg("start"), py::arg("finish"), py::arg("slack"), py::kw_only(),
+          py::arg("workspace") = static_cast<SearchWorkspace*>(nullptr),
+          py::arg("limits") = static_cast<const PythonSearchLimits*>(nullptr))
+      .def("compute_distances",
+          [](GraphReader &reader, index_t source, Direction direction) {
+            ValidatePageIndex(reader.VertexCount(), source);
+            Distances distances = ComputeDistances(reader, source, direction);
+            return std::make_pair(ToNumpyArray(std::move(distances.distance)), std::move(distances.histogram));
+          },
+          "Returns a pair of:\n"
+          "  1. a numpy array of distances from `source` to each vertex (or from each\n"
+          "     vertex to `source`, if `direction` is BACKWARD), where 255 means unreachable.\n"
+          "  2. a list with the number of vertices at each distance.\n",
+          py::arg("source"), py::arg("direction") = Direction::FORWARD)
+  ;
+
+  py::class_<SearchWorkspace>(module, "SearchWorkspace")
+      .def(py::init<>())
+  ;
+
+  py::class_<SearchFilter>(module, "SearchFilter")
+      .def(
+          py::init([](
+                const std::vector<index_t> &banned_vertices,
+                const std::vector<std::pair<index_t, index_t>> &banned_edges) {
+              SearchFilter filter;
+              for (index_t v : banned_vertices) filter.BanVertex(v);
+              for (auto [v, w] : banned_edges) filter.BanEdge(v, w);
+              return filter;
+            }),
+          "Constructs a SearchFilter that excludes the given vertices and edges.",
+          py::kw_only(),
+          py::arg("banned_vertices") = std::vector<index_t>{},
+          py::arg("banned_edges") = std::vector<std::pair<index_t, index_t>>{})
+      .def("ban_vertex", &SearchFilter::BanVertex, py::arg("v"))
+      .def("ban_edge", &SearchFilter::BanEdge, py::arg("v"), py::arg("w"))
+      .def("is_vertex_banned", &SearchFilter::IsVertexBanned, py::arg("v"))
+      .def("is_edge_banned", &SearchFilter::IsEdgeBanned, py::arg("v"), py::arg("w"))
+      .def("empty", &SearchFilter::Empty)
+  ;
+
+  py::class_<PythonSearchLimits>(module, "SearchLimits")
+      .def(
+          py::init([](
+                int64_t max_vertices_expanded,
+                int64_t max_edges_expanded,
+                std::optional<double> timeout_ms) {
+              return PythonSearchLimits{
+                .max_vertices_expanded = max_vertices_expanded,
+                .max_edges_expanded = max_edges_expanded,
+                .timeout_ms = timeout_ms,
+              };
+            }),
+          "Constructs a SearchLimits object.",
+          py::kw_only(),
+          py::arg("max_vertices_expanded") = std::numeric_limits<int64_t>::max(),
+          py::arg("max_edges_expanded") = std::numeric_limits<int64_t>::max(),
+          py::arg("timeout_ms") = std::nullopt)
+      .def_readwrite("max_vertices_expanded", &PythonSearchLimits::max_vertices_expanded)
+      .def_readwrite("max_edges_expanded", &PythonSearchLimits::max_edges_expanded)
+      .def_readwrite("timeout_ms", &PythonSearchLimits::timeout_ms)
+      .def("__repr__", &ToString<PythonSearchLimits>)
+  ;
+
+  py::class_<ResultCache>(module, "ResultCache")
+      .def(py::init<size_t, int>(),
+          py::arg("capacity_bytes"), py::kw_only(), py::arg("shard_count") = 16)
+      .def_property_readonly("capacity_bytes", &ResultCache::CapacityBytes)
+      .def("stats", &ResultCache::Stats)
+      .def("clear", &ResultCache::Clear)
+  ;
+
+  py::class_<ResultCacheStats>(module, "ResultCacheStats")
+      .def_readonly("hits", &ResultCacheStats::hits)
+      .def_readonly("misses", &ResultCacheStats::misses)
+      .def_readonly("insertions", &ResultCacheStats::insertions)
+      .def_readonly("evictions", &ResultCacheStats::evictions)
+      .def_readonly("entries", &ResultCacheStats::entries)
+      .def_readonly("bytes", &ResultCacheStats::bytes)
+      .def("__repr__", &ToString<ResultCacheStats>)
+  ;
+
+  py::class_<CachedResult, std::shared_ptr<CachedResult>>(module, "CachedResult")
+      .def_readonly("path", &CachedResult::path)
+      .def_readonly("titles", &CachedResult::titles)
+      .def_readonly("link_texts", &CachedResult::link_texts)
+      .def_readonly("dag", &CachedResult::dag)
+  ;
+
+  py::enum_<AbortReason>(module, "AbortReason")
+      .value("NONE", AbortReason::NONE)
+      .value("VERTEX_LIMIT", AbortReason::VERTEX_LIMIT)
+      .value("EDGE_LIMIT", AbortReason::EDGE_LIMIT)
+      .value("DEADLINE", AbortReason::DEADLINE)
+      .value("CANCELLED", AbortReason::CANCELLED)
+  ;
+
+  py::class_<SearchLevel> search_level(module, "SearchLevel");
+  search_level.attr("Direction") = module.attr("Direction");
+  py::enum_<SearchLevel::Mode>(search_level, "Mode")
+      .value("TOP_DOWN", SearchLevel::Mode::TOP_DOWN)
+      .value("BOTTOM_UP", SearchLevel::Mode::BOTTOM_UP)
+  ;
+  search_level
+      .def(
+          py::init([](
+                SearchLevel::Direction direction,
+                SearchLevel::Mode mode,
+                int64_t fringe_size,
+                int64_t vertices_expanded,
+                int64_t edges_expanded) {
+              return SearchLevel{
+                .direction = direction,
+                .mode = mode,
+                .fringe_size = fringe_size,
+                .vertices_expanded = vertices_expanded,
+                .edges_expanded = edges_expanded,
+              };
+            }),
+          "Constructs a SearchLevel object.",
+          py::arg("direction"),
+          py::arg("mode"),
+          py::arg("fringe_size") = 0,
+          py::arg("vertices_expanded") = 0,
+          py::arg("edges_expanded") = 0)
+      .def_readonly("direction", &SearchLevel::direction)
+      .def_readonly("mode", &SearchLevel::mode)
+      .def_readonly("fringe_size", &SearchLevel::fringe_size)
+      .def_readonly("vertices_expanded", &SearchLevel::vertices_expanded)
+      .def_readonly("edges_expanded", &SearchLevel::edges_expanded)
+      .def(pybind11::self == pybind11::self)
+      .def("__repr__", &ToString<SearchLevel>)
   ;
 
   py::class_<SearchStats>(module, "SearchStats")
@@ -405,23 +850,59 @@ PYBIND11_MODULE(wikipath, module) {
                 int64_t vertices_reached,
                 int64_t vertices_expanded,
                 int64_t edges_expanded,
-                int64_t time_taken_ms) {
+                int64_t time_taken_ms,
+                std::vector<SearchLevel> levels,
+                AbortReason abort_reason,
+                int64_t time_taken_ns,
+                int64_t search_ns,
+                int64_t reconstruct_ns,
+                int64_t propagate_ns,
+                int64_t sort_ns,
+                int64_t minor_faults,
+                int64_t major_faults) {
               return SearchStats{
                 .vertices_reached = vertices_reached,
                 .vertices_expanded = vertices_expanded,
                 .edges_expanded = edges_expanded,
                 .time_taken_ms = time_taken_ms,
+                .levels = std::move(levels),
+                .abort_reason = abort_reason,
+                .time_taken_ns = time_taken_ns,
+                .search_ns = search_ns,
+                .reconstruct_ns = reconstruct_ns,
+                .propagate_ns = propagate_ns,
+                .sort_ns = sort_ns,
+                .minor_faults = minor_faults,
+                .major_faults = major_faults,
               };
             }),
           "Constructs a SearchStats object.",
           py::arg("vertices_reached") = 0,
           py::arg("vertices_expanded") = 0,
           py::arg("edges_expanded") = 0,
-          py::arg("time_taken_ms") = 0)
+          py::arg("time_taken_ms") = 0,
+          py::arg("levels") = std::vector<SearchLevel>{},
+          py::arg("abort_reason") = AbortReason::NONE,
+          py::arg("time_taken_ns") = 0,
+          py::arg("search_ns") = 0,
+          py::arg("reconstruct_ns") = 0,
+          py::arg("propagate_ns") = 0,
+          py::arg("sort_ns") = 0,
+          py::arg("minor_faults") = 0,
+          py::arg("major_faults") = 0)
       .def_readonly("vertices_reached", &SearchStats::vertices_reached)
       .def_readonly("vertices_expanded", &SearchStats::vertices_expanded)
       .def_readonly("edges_expanded", &SearchStats::edges_expanded)
       .def_readonly("time_taken_ms", &SearchStats::time_taken_ms)
+      .def_readonly("levels", &SearchStats::levels)
+      .def_readonly("abort_reason", &SearchStats::abort_reason)
+      .def_readonly("time_taken_ns", &SearchStats::time_taken_ns)
+      .def_readonly("search_ns", &SearchStats::search_ns)
+      .def_readonly("reconstruct_ns", &SearchStats::reconstruct_ns)
+      .def_readonly("propagate_ns", &SearchStats::propagate_ns)
+      .def_readonly("sort_ns", &SearchStats::sort_ns)
+      .def_readonly("minor_faults", &SearchStats::minor_faults)
+      .def_readonly("major_faults", &SearchStats::major_faults)
       .def(pybind11::self == pybind11::self)
       .def(hash(py::self))
       .def("__repr__", &ToString<SearchStats>)
@@ -510,6 +991,7 @@ PYBIND11_MODULE(wikipath, module) {
   py::class_<AnnotatedDagWrapper, std::shared_ptr<AnnotatedDagWrapper>>(module, "AnnotatedDag")
     .def_property_readonly("start", &AnnotatedDagWrapper::Start)
     .def_property_readonly("finish", &AnnotatedDagWrapper::Finish)
+    .def_property_readonly("max_length", &AnnotatedDagWrapper::MaxLength)
     .def("count_paths", &AnnotatedDagWrapper::CountPaths,
         "Returns the total number of shortest paths from start to finish.")
     .def("__len__", &AnnotatedDagWrapper::CountPaths,
@@ -586,5 +1068,59 @@ PYBIND11_MODULE(wikipath, module) {
           "Variant of shortest_path_annotated_dag_with_stats() that takes string arguments,\n"
           "which are interpreted by parse_page_argument().",
           py::arg("start"), py::arg("finish"))
+      .def_property_readonly("file_identity", &Reader::FileIdentity)
+      .def("cached_shortest_path",
+          [](const Reader &reader, index_t start, index_t finish, ResultCache &cache,
+              SearchWorkspace *workspace, const PythonSearchLimits *limits) {
+            return CachedShortestPath(reader, start, finish, cache, QueryKind::SHORTEST_PATH,
+                nullptr, workspace, limits);
+          },
+          "Returns a CachedResult with the shortest path from `start` to `finish` and the\n"
+          "titles and link texts of its pages, from `cache` if possible. Returns None if\n"
+          "the search was aborted because it exceeded `limits`.",
+          py::arg("start"), py::arg("finish"), py::arg("cache"), py::kw_only(),
+          py::arg("workspace") = static_cast<SearchWorkspace*>(nullptr),
+          py::arg("limits") = static_cast<const PythonSearchLimits*>(nullptr))
+      .def("cached_shortest_path_with_stats",
+          [](const Reader &reader, index_t start, index_t finish, ResultCache &cache,
+              SearchWorkspace *workspace, const PythonSearchLimits *limits) {
+            SearchStats stats = {};
+            auto result = CachedShortestPath(reader, start, finish, cache, QueryKind::SHORTEST_PATH,
+                &stats, workspace, limits);
+            return std::make_pair(std::move(result), std::move(stats));
+          },
+          "Returns a pair of the result of cached_shortest_path() and a SearchStats object\n"
+          "with statistics about the search, which are all zero on a cache hit.",
+          py::arg("start"), py::arg("finish"), py::arg("cache"), py::kw_only(),
+          py::arg("workspace") = static_cast<SearchWorkspace*>(nullptr),
+          py::arg("limits") = static_cast<const PythonSearchLimits*>(nullptr))
+      .def("cached_shortest_path_dag",
+          [](const Reader &reader, index_t start, index_t finish, ResultCache &cache,
+              SearchWorkspace *workspace, const PythonSearchLimits *limits) {
+            return CachedShortestPath(reader, start, finish, cache, QueryKind::SHORTEST_PATH_DAG,
+                nullptr, workspace, limits);
+          },
+          "Same as cached_shortest_path(), but returns a CachedResult with the DAG of all\n"
+          "shortest paths and the titles of its pages.",
+          py::arg("start"), py::arg("finish"), py::arg("cache"), py::kw_only(),
+          py::arg("workspace") = static_cast<SearchWorkspace*>(nullptr),
+          py::arg("limits") = static_cast<const PythonSearchLimits*>(nullptr))
+      .def("near_shortest_paths_annotated_dag",
+          [](const std::shared_ptr<Reader> &reader, index_t start, index_t finish, int slack) {
+            return NearShortestPathsAnnotatedDag(reader, start, finish, slack);
+          },
+          "Returns an AnnotatedDag representing all paths from `start` to `finish`\n"
+          "that are at most `slack` links longer than a shortest path (which may visit\n"
+          "a page more than once), or None if `finish` is not reachable from `start`.",
+          py::arg("start"), py::arg("finish"), py::arg("slack"))
+      .def("near_shortest_paths_annotated_dag",
+          [](const std::shared_ptr<Reader> &reader, const char *start_arg, const char *finish_arg, int slack) {
+            index_t start = reader->ParsePageArgument(start_arg);
+            index_t finish = reader->ParsePageArgument(finish_arg);
+            return NearShortestPathsAnnotatedDag(reader, start, finish, slack);
+          },
+          "Variant of near_shortest_paths_annotated_dag() that takes string arguments,\n"
+          "which are interpreted by parse_page_argument().",
+          py::arg("start"), py::arg("finish"), py::arg("slack"))
   ;
 }
@@ -5,6 +5,7 @@
 
 #include <assert.h>
 #include <stdlib.h>
+#include <sys/stat.h>
 
 #include <iostream>
 #include <optional>
@@ -17,6 +18,23 @@ std::string StripExtension(std::string s) {
     return s.substr(0, s.rfind('.'));
 }
 
+// Mixes the identity of the file into `hash`. Returns false if the file could
+// not be examined.
+bool HashFileIdentity(const std::string &filename, uint64_t &hash) {
+    struct stat st;
+    if (stat(filename.c_str(), &st) != 0) return false;
+    for (uint64_t value : {
+            static_cast<uint64_t>(st.st_dev),
+            static_cast<uint64_t>(st.st_ino),
+            static_cast<uint64_t>(st.st_size),
+            static_cast<uint64_t>(st.st_mtim.tv_sec),
+            static_cast<uint64_t>(st.st_mtim.tv_nsec)}) {
+        // FNV-1a over 64-bit words.
+        hash = (hash ^ value) * 0x100000001b3;
+    }
+    return true;
+}
+
 std::string LinkRef(index_t page_id, std::string_view title, std::string_view link_target, std::string_view link_text) {
     std::ostringstream oss;
     oss << '#' << page_id;
@@ -62,11 +80,19 @@ std::unique_ptr<Reader> Reader::Open(const char *graph_filename, GraphReader::Op
         return nullptr;
     }
 
-    return std::unique_ptr<Reader>(new Reader(std::move(graph_reader), std::move(metadata_reader)));
+    uint64_t file_identity = 0xcbf29ce484222325;
+    if (!HashFileIdentity(graph_filename, file_identity) ||
+            !HashFileIdentity(metadata_filename, file_identity)) {
+        std::cerr << "Could not stat graph or metadata file\n";
+        return nullptr;
+    }
+
+    return std::unique_ptr<Reader>(new Reader(std::move(graph_reader), std::move(metadata_reader), file_identity));
 }
 
-Reader::Reader(std::unique_ptr<GraphReader> graph, std::unique_ptr<MetadataReader> metadata)
-        : graph(std::move(graph)), metadata(std::move(metadata)) {
+Reader::Reader(std::unique_ptr<GraphReader> graph, std::unique_ptr<MetadataReader> metadata,
+        uint64_t file_identity)
+        : graph(std::move(graph)), metadata(std::move(metadata)), file_identity(file_identity) {
 }
 
 index_t Reader::RandomPageId() const {
@@ -85,8 +111,8 @@ index_t Reader::RandomPageId() const {
     index_t result = 0;
     for (int attempt = 0; attempt < 20; ++attempt) {
         result = RandInt<index_t>(1, size - 1);
-        if (graph->ForwardEdges(result).empty()) continue;
-        if (graph->BackwardEdges(result).empty()) continue;
+        if (graph->ForwardDegree(result) == 0) continue;
+        if (graph->BackwardDegree(result) == 0) continue;
         break;
     }
     return result;
@@ -0,0 +1,187 @@
+#include "wikipath/result-cache.h"
+
+#include <assert.h>
+
+#include <algorithm>
+
+namespace wikipath {
+namespace {
+
+// Approximate memory used per entry in addition to the CachedResult itself:
+// the list node, the hash table node and bucket, and the shared_ptr control
+// block.
+constexpr size_t ENTRY_OVERHEAD_BYTES = 160;
+
+size_t EntryBytes(const CachedResult &result) {
+    return ENTRY_OVERHEAD_BYTES + result.ByteSize();
+}
+
+// Returns the distinct vertices of the DAG in increasing order.
+std::vector<index_t> DagVertices(const std::vector<std::pair<index_t, index_t>> &edges) {
+    std::vector<index_t> vertices;
+    vertices.reserve(2 * edges.size());
+    for (auto [v, w] : edges) {
+        vertices.push_back(v);
+        vertices.push_back(w);
+    }
+    std::sort(vertices.begin(), vertices.end());
+    vertices.erase(std::unique(vertices.begin(), vertices.end()), vertices.end());
+    return vertices;
+}
+
+}  // namespace
+
+size_t CachedResult::ByteSize() const {
+    size_t bytes = sizeof(CachedResult);
+    bytes += path.capacity() * sizeof(index_t);
+    bytes += (titles.capacity() + link_texts.capacity()) * sizeof(std::string);
+    for (const std::string &s : titles) bytes += s.capacity();
+    for (const std::string &s : link_texts) bytes += s.capacity();
+    if (dag) bytes += dag->capacity() * sizeof(std::pair<index_t, index_t>);
+    return bytes;
+}
+
+size_t ResultCache::KeyHash::operator()(const ResultCacheKey &key) const {
+    // Combines the fields and mixes them with the splitmix64 finalizer.
+    uint64_t h = key.file_identity;
+    h ^= (uint64_t{key.start} << 32 | key.finish) + 0x9e3779b97f4a7c15 + (h << 6) + (h >> 2);
+    h ^= static_cast<uint64_t>(key.kind) + 0x9e3779b97f4a7c15 + (h << 6) + (h >> 2);
+    h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9;
+    h = (h ^ (h >> 27)) * 0x94d049bb133111eb;
+    return h ^ (h >> 31);
+}
+
+ResultCache::ResultCache(size_t capacity_bytes, int shard_count)
+        : capacity_bytes(capacity_bytes),
+          shard_capacity_bytes(capacity_bytes / std::max(shard_count, 1)),
+          shards(std::max(shard_count, 1)) {
+}
+
+ResultCache::Shard &ResultCache::ShardFor(const ResultCacheKey &key) {
+    // Use the high bits, since the low bits also select the hash table bucket.
+    return shards[(KeyHash()(key) >> 32) % shards.size()];
+}
+
+std::shared_ptr<const CachedResult> ResultCache::Lookup(const ResultCacheKey &key) {
+    Shard &shard = ShardFor(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.index.find(key);
+    if (it == shard.index.end()) {
+        ++shard.misses;
+        return nullptr;
+    }
+    ++shard.hits;
+    shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+    return it->second->second;
+}
+
+void ResultCache::Insert(const ResultCacheKey &key, std::shared_ptr<const CachedResult> result) {
+    assert(result != nullptr);
+    const size_t bytes = EntryBytes(*result);
+    Shard &shard = ShardFor(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    if (auto it = shard.index.find(key); it != shard.index.end()) {
+        shard.bytes -= EntryBytes(*it->second->second);
+        shard.lru.erase(it->second);
+        shard.index.erase(it);
+    }
+    if (bytes > shard_capacity_bytes) return;
+    while (shard.bytes + bytes > shard_capacity_bytes) {
+        assert(!shard.lru.empty());
+        const entry_t &victim = shard.lru.back();
+        shard.bytes -= EntryBytes(*victim.second);
+        shard.index.erase(victim.first);
+        shard.lru.pop_back();
+        ++shard.evictions;
+    }
+    shard.lru.emplace_front(key, std::move(result));
+    shard.index.emplace(key, shard.lru.begin());
+    shard.bytes += bytes;
+    ++shard.insertions;
+}
+
+std::shared_ptr<const CachedResult> ResultCache::ShortestPath(
+        const Reader &reader, index_t start, index_t finish,
+        SearchStats *stats, SearchWorkspace *workspace, const SearchLimits &limits) {
+    const ResultCacheKey key = {
+        .file_identity = reader.FileIdentity(),
+        .start = start,
+        .finish = finish,
+        .kind = QueryKind::SHORTEST_PATH,
+    };
+    if (auto cached = Lookup(key)) {
+        if (stats != nullptr) *stats = {};
+        return cached;
+    }
+
+    auto search_result = workspace != nullptr
+            ? workspace->FindShortestPath(reader.Graph(), start, finish, stats, {}, limits)
+            : FindShortestPath(reader.Graph(), start, finish, stats, {}, limits);
+    if (search_result.Aborted()) return nullptr;
+    auto result = std::make_shared<CachedResult>();
+    result->path = std::move(search_result.value);
+    result->titles.reserve(result->path.size());
+    result->link_texts.reserve(result->path.size());
+    for (size_t i = 0; i < result->path.size(); ++i) {
+        result->titles.push_back(reader.PageTitle(result->path[i]));
+        result->link_texts.push_back(i == 0 ? "" : reader.LinkText(result->path[i - 1], result->path[i]));
+    }
+    Insert(key, result);
+    return result;
+}
+
+std::shared_ptr<const CachedResult> ResultCache::ShortestPathDag(
+        const Reader &reader, index_t start, index_t finish,
+        SearchStats *stats, SearchWorkspace *workspace, const SearchLimits &limits) {
+    const ResultCacheKey key = {
+        .file_identity = reader.FileIdentity(),
+        .start = start,
+        .finish = finish,
+        .kind = QueryKind::SHORTEST_PATH_DAG,
+    };
+    if (auto cached = Lookup(key)) {
+        if (stats != nullptr) *stats = {};
+        return cached;
+    }
+
+    auto search_result = workspace != nullptr
+            ? workspace->FindShortestPathDag(reader.Graph(), start, finish, stats, {}, limits)
+            : FindShortestPathDag(reader.Graph(), start, finish, stats, {}, limits);
+    if (search_result.Aborted()) return nullptr;
+    auto result = std::make_shared<CachedResult>();
+    result->dag = std::move(search_result.value);
+    if (result->dag) {
+        // A DAG from a vertex to itself has no edges, but one vertex.
+        std::vector<index_t> vertices = result->dag->empty()
+                ? std::vector<index_t>{start} : DagVertices(*result->dag);
+        result->titles.reserve(vertices.size());
+        for (index_t v : vertices) result->titles.push_back(reader.PageTitle(v));
+    }
+    Insert(key, result);
+    return result;
+}
+
+void ResultCache::Clear() {
+    for (Shard &shard : shards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.lru.clear();
+        shard.index.clear();
+        shard.bytes = 0;
+    }
+}
+
+ResultCacheStats ResultCache::Stats() const {
+    ResultCacheStats stats;
+    for (const Shard &shard : shards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        stats.hits += shard.hits;
+        stats.misses += shard.misses;
+        stats.insertions += shard.insertions;
+        stats.evictions += shard.evictions;
+        stats.entries += shard.index.size();
+        stats.bytes += shard.bytes;
+    }
+    return stats;
+}
+
+}  // namespace wikipath
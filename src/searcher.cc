@@ -1,149 +1,321 @@
 #include "wikipath/searcher.h"
+#include "wikipath/hub-distances.h"
+#include "wikipath/neighbor-scan.h"
+#include "wikipath/numa.h"
+#include "wikipath/thread-pool.h"
+
+#include "bidirectional-search.h"
 
 #include <assert.h>
 
 #include <algorithm>
-#include <chrono>
+#include <atomic>
 #include <cstdint>
 #include <iostream>
+#include <initializer_list>
 #include <limits>
+#include <memory>
 #include <ranges>
+#include <span>
+#include <thread>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace wikipath {
 namespace {
 
-class DummyStatsCollector {
+// Visited sets of the forward and backward searches of a layered search, with
+// two bits per vertex, so that both can be tested with a single memory access.
+//
+// The bits are owned by the SearchWorkspace. Between searches, all bits are zero.
+class VisitedBits {
 public:
-    void VertexReached() {}
-    void VertexExpanded() {}
-    void EdgeExpanded() {}
+    static constexpr uint64_t FORWARD = 1;
+    static constexpr uint64_t BACKWARD = 2;
+
+    // Vertex v is stored in word v >> shift.
+    static constexpr int shift = 5;
+
+    explicit VisitedBits(std::vector<uint64_t> &words) : words(words) {}
+
+    // Returns the bits of vertex v: FORWARD, BACKWARD or both.
+    uint64_t Get(index_t v) const {
+        return (words[v >> shift] >> (2 * (v & 31))) & 3;
+    }
+
+    void Set(index_t v, uint64_t bit) {
+        words[v >> shift] |= bit << (2 * (v & 31));
+    }
+
+private:
+    std::vector<uint64_t> &words;
 };
 
-class RealStatsCollector {
-public:
-    RealStatsCollector(SearchStats &stats)
-            : stats(stats), start_time(std::chrono::steady_clock::now()) {}
-
-    ~RealStatsCollector() {
-        auto duration = std::chrono::steady_clock::now() - start_time;
-        stats = {
-            .vertices_reached = vertices_reached,
-            .vertices_expanded = vertices_expanded,
-            .edges_expanded = edges_expanded,
-            .time_taken_ms = duration / std::chrono::milliseconds(1),
-        };
+// Resets array[v >> shift] to zero for each vertex v in the given lists, which
+// must include every vertex where array[v >> shift] is nonzero. If the lists are
+// long, the entire array is cleared instead, since that's faster than random
+// access.
+template<class T>
+void ClearEntries(
+        std::vector<T> &array, std::initializer_list<std::span<const index_t>> touched, int shift = 0) {
+    size_t touched_count = 0;
+    for (auto vertices : touched) touched_count += vertices.size();
+    if (touched_count > array.size() / 16) {
+        std::fill(array.begin(), array.end(), T{});
+    } else {
+        for (auto vertices : touched) {
+            for (index_t v : vertices) array[v >> shift] = T{};
+        }
     }
+}
 
-    void VertexReached() { ++vertices_reached; }
-    void VertexExpanded() { ++vertices_expanded; }
-    void EdgeExpanded() { ++edges_expanded; }
+}  // namespace
 
-    // Not copyable or assignable.
-    RealStatsCollector(const RealStatsCollector&) = delete;
-    RealStatsCollector &operator=(const RealStatsCollector&) = delete;
+// Memory that is reused between searches. See SearchWorkspace in searcher.h.
+//
+// Between searches, all elements of `dense_visited`, `dist`, `marked`,
+// `fringe_words`, `visited_bits`, `forward_dist` and `backward_dist` are
+// zero/false, and `sparse_visited` is empty. After each search, only the
+// entries that were touched are reset, using the search queues (which contain
+// all reached vertices) and the propagation lists (which contain all marked
+// vertices, besides start and finish). If a search is interrupted by an
+// exception, the workspace is marked dirty and fully cleared before the next
+// search instead.
+struct SearchWorkspace::Impl {
+    bool dirty = false;
 
-private:
-    SearchStats &stats;
-    int64_t vertices_reached = 0;
-    int64_t vertices_expanded = 0;
-    int64_t edges_expanded = 0;
-    std::chrono::time_point<std::chrono::steady_clock> start_time;
+    BidirectionalSearchState state;
+
+    // Used by bottom-up steps (see FringeBitmap), and by the path reconstruction
+    // of layered searches.
+    std::vector<uint64_t> fringe_words;
+
+    // Used by parallel steps (see ParallelExpander). Created on first use.
+    std::unique_ptr<ThreadPool> pool;
+    std::vector<ParallelExpander::ThreadState> thread_states;
+
+    // NUMA node of the copy of the graph that the current search uses, or -1
+    // if the graph is not replicated, and the node that the workers of `pool`
+    // are pinned to, or -1 if they are not pinned.
+    int numa_node = -1;
+    int pool_numa_node = -1;
+
+    // Used by FindShortestPath().
+    SparseVisitedMap sparse_visited;
+    std::vector<index_t> dense_visited;
+    bool dense_visited_used = false;
+
+    // Used by FindShortestPathDag().
+    std::vector<uint8_t> dist;
+    std::vector<bool> marked;
+    std::vector<index_t> propagate_forward;
+    std::vector<index_t> propagate_backward;
+    bool dag_arrays_used = false;
+
+    // Used by layered searches (see VisitedBits). The levels vectors contain
+    // the queue index where each level starts.
+    std::vector<uint64_t> visited_bits;
+    std::vector<size_t> forward_levels;
+    std::vector<size_t> backward_levels;
+    bool visited_bits_used = false;
+
+    // Used by FindNearShortestPaths().
+    std::vector<uint8_t> forward_dist;
+    std::vector<uint8_t> backward_dist;
+    bool near_arrays_used = false;
+
+    // Returns a ParallelExpander for the given options, creating the thread
+    // pool if necessary, or an empty optional if the search should only run
+    // on the calling thread.
+    std::optional<ParallelExpander> Parallel(const SearchOptions &options) {
+        int threads = options.threads > 0 ? options.threads : std::thread::hardware_concurrency();
+        if (threads <= 1) return {};
+        if (pool == nullptr || pool->ThreadCount() != threads) {
+            pool.reset();
+            pool = std::make_unique<ThreadPool>(threads);
+            thread_states = std::vector<ParallelExpander::ThreadState>(threads);
+            pool_numa_node = -1;
+        }
+        if (numa_node >= 0 && numa_node != pool_numa_node) {
+            // Run the workers on the node of the graph copy that is searched.
+            pool->PinWorkersToNumaNode(numa_node);
+            pool_numa_node = numa_node;
+        }
+        return ParallelExpander(*pool, thread_states, options.parallel_min_fringe);
+    }
+
+    // Called at the start of each search. Returns the graph to search, which
+    // is the copy of `graph` on the NUMA node of the calling thread, if there
+    // is one (see GraphReader::OpenOptions::numa_replicas).
+    const GraphReader &Begin(const GraphReader &graph, index_t start, index_t finish) {
+        if (dirty) {
+            // The previous search did not finish normally.
+            sparse_visited.Clear();
+            std::fill(dense_visited.begin(), dense_visited.end(), 0);
+            std::fill(dist.begin(), dist.end(), 0);
+            std::fill(marked.begin(), marked.end(), false);
+            std::fill(fringe_words.begin(), fringe_words.end(), 0);
+            std::fill(visited_bits.begin(), visited_bits.end(), 0);
+            std::fill(forward_dist.begin(), forward_dist.end(), 0);
+            std::fill(backward_dist.begin(), backward_dist.end(), 0);
+        }
+        dirty = true;
+        state.Reset(start, finish);
+        dense_visited_used = false;
+        dag_arrays_used = false;
+        visited_bits_used = false;
+        near_arrays_used = false;
+        propagate_forward.clear();
+        propagate_backward.clear();
+
+        const int node = CurrentNumaNode();
+        const GraphReader &local_graph = graph.ForNumaNode(node);
+        numa_node = &local_graph != &graph ? node : -1;
+        return local_graph;
+    }
+
+    // Called at the end of FindShortestPath().
+    void EndPathSearch() {
+        if (dense_visited_used) {
+            ClearEntries(dense_visited, {state.forward.queue, state.backward.queue});
+        }
+        sparse_visited.Clear();
+        dirty = false;
+    }
+
+    // Called at the end of a layered search.
+    void EndLayeredSearch() {
+        if (visited_bits_used) {
+            ClearEntries(visited_bits, {state.forward.queue, state.backward.queue}, VisitedBits::shift);
+        }
+        dirty = false;
+    }
+
+    // Called at the end of FindNearShortestPaths().
+    void EndNearShortestSearch() {
+        if (near_arrays_used) {
+            ClearEntries(forward_dist, {state.forward.queue});
+            ClearEntries(backward_dist, {state.backward.queue});
+        }
+        dirty = false;
+    }
+
+    // Called at the end of ComputeDistances(), which only uses the queue.
+    void EndDistancesSearch() {
+        dirty = false;
+    }
+
+    // Called at the end of FindShortestPathDag().
+    void EndDagSearch() {
+        if (dag_arrays_used) {
+            ClearEntries(dist, {state.forward.queue, state.backward.queue});
+            ClearEntries(marked, {propagate_forward, propagate_backward});
+            marked[state.forward.queue.front()] = false;
+            marked[state.backward.queue.front()] = false;
+        }
+        dirty = false;
+    }
 };
 
-template<class StatsCollectorT>
-std::vector<index_t> FindShortestPathImpl(const GraphReader &graph, index_t start, index_t finish, StatsCollectorT stats_collector) {
+namespace {
+
+template<class FilterT, class StatsCollectorT>
+std::vector<index_t> FindShortestPathImpl(
+        SearchWorkspace::Impl &workspace,
+        const GraphReader &graph, index_t start, index_t finish,
+        const SearchOptions &options, LimitChecker &limits, const FilterT &filter,
+        StatsCollectorT stats_collector) {
     const index_t size = graph.VertexCount();
     assert(~size > size);
     assert(start < size);
     assert(finish < size);
 
+    if (!filter.AllowsVertex(start) || !filter.AllowsVertex(finish)) return {};
+
     if (start == finish) {
         stats_collector.VertexReached();
         return {start};
     }
 
-    // For each vertex, visited[v] can be:
-    //
-    //  0 if vertex is unvisited
-    //  1 < v < size: if vertex was reachable via a forward edge from `v`
-    //  1 < ~v < size: if vertex was reachable via a backward edge from `v`
-    std::vector<index_t> visited(size, 0);
-
-    // Reconstructs the path from start to finish, assuming there is an edge
-    // (i, j), a forward path from `start` to `i`, and a backward path from
-    // `j` to `finish`.
-    auto ReconstructPath = [start, finish, &visited](index_t i, index_t j) {
-        std::vector<index_t> path;
-        while (i != start) {
-            path.push_back(i);
-            i = visited[i];
-        }
-        path.push_back(start);
-        std::reverse(path.begin(), path.end());
-        while (j != finish) {
-            path.push_back(j);
-            j = ~visited[j];
+    BidirectionalSearchState &state = workspace.state;
+    stats_collector.VertexReached();
+    stats_collector.VertexReached();
+
+    std::vector<index_t> path;
+
+    // Hub distances describe the unfiltered graph, so they don't give valid
+    // bounds for filtered searches.
+    std::optional<HubBound> hub_bound;
+    if constexpr (std::is_same_v<FilterT, NoFilter>) {
+        if (options.hub_distances != nullptr) {
+            assert(options.hub_distances->VertexCount() == size);
+            hub_bound.emplace(*options.hub_distances, start, finish);
         }
-        path.push_back(finish);
-        return path;
+    }
+
+    // Start with a hash table, and switch to a flat array only if the search
+    // visits a significant fraction of the graph. See SearchOptions.
+    SearchStatus status = SearchStatus::FULL;
+    const ExpansionOptions expansion = {
+        .prefetch_distance = static_cast<size_t>(std::max(options.prefetch_distance, 0)),
+        .sort_fringes = options.sort_fringes,
     };
+    HubBound *const hub = hub_bound ? &*hub_bound : nullptr;
+    const size_t sparse_max_size = options.sparse_visited_max_fraction * size;
+    if (sparse_max_size > 0) {
+        SparseVisitedMap &visited = workspace.sparse_visited;
+        visited.SetMaxSize(sparse_max_size);
+        visited[start] = start;
+        visited[finish] = ~finish;
+        ParentMarks marks(visited, size);
+        TopDownFrontier frontier;
+        status = BidirectionalSearch(graph, marks, frontier, state, nullptr, hub, expansion,
+                filter, stats_collector, limits).Run();
+        if (status == SearchStatus::FOUND) {
+            stats_collector.PhaseStarted(SearchPhase::RECONSTRUCT);
+            path = marks.Path(start, finish);
+        }
+    }
 
-    std::vector<index_t> forward_fringe;
-    std::vector<index_t> backward_fringe;
-    visited[start] = start;
-    visited[finish] = ~finish;
-    forward_fringe.push_back(start);
-    backward_fringe.push_back(finish);
-    stats_collector.VertexReached();
-    stats_collector.VertexReached();
-    while (!forward_fringe.empty() && !backward_fringe.empty()) {
-        if (forward_fringe.size() <= backward_fringe.size()) {
-            // Expand forward fringe.
-            std::vector<index_t> new_fringe;
-            for (index_t i : forward_fringe) {
-                stats_collector.VertexExpanded();
-                for (index_t j : graph.ForwardEdges(i)) {
-                    stats_collector.EdgeExpanded();
-                    if (visited[j] == 0) {
-                        stats_collector.VertexReached();
-                        visited[j] = i;
-                        new_fringe.push_back(j);
-                    } else if (~visited[j] < size) {
-                        return ReconstructPath(i, j);  // path found!
-                    } else {
-                        assert(visited[j] < size);
-                    }
-                }
-            }
-            forward_fringe.swap(new_fringe);
+    if (status == SearchStatus::FULL) {
+        std::vector<index_t> &dense_visited = workspace.dense_visited;
+        if (dense_visited.size() < size) dense_visited.resize(size, 0);
+        workspace.dense_visited_used = true;
+        DenseVisitedMap visited(dense_visited);
+        if (sparse_max_size > 0) {
+            workspace.sparse_visited.CopyTo(visited);
         } else {
-            // Expand backward fringe.
-            std::vector<index_t> new_fringe;
-            for (index_t j : backward_fringe) {
-                stats_collector.VertexExpanded();
-                for (index_t i : graph.BackwardEdges(j)) {
-                    stats_collector.EdgeExpanded();
-                    if (visited[i] == 0) {
-                        stats_collector.VertexReached();
-                        visited[i] = ~j;
-                        new_fringe.push_back(i);
-                    } else if (visited[i] < size) {
-                        return ReconstructPath(i, j);  // path found!
-                    } else {
-                        assert(~visited[i] < size);
-                    }
-                }
-            }
-            backward_fringe.swap(new_fringe);
+            visited[start] = start;
+            visited[finish] = ~finish;
+        }
+        ParentMarks marks(visited, size);
+        HybridFrontier frontier(graph, options, workspace.fringe_words);
+        std::optional<ParallelExpander> parallel = workspace.Parallel(options);
+        status = BidirectionalSearch(graph, marks, frontier, state, parallel ? &*parallel : nullptr, hub,
+                expansion, filter, stats_collector, limits).Run();
+        if (status == SearchStatus::FOUND) {
+            stats_collector.PhaseStarted(SearchPhase::RECONSTRUCT);
+            path = marks.Path(start, finish);
         }
     }
-    return {};  // no path found!
+
+    if (status == SearchStatus::HUB_PATH) {
+        stats_collector.PhaseStarted(SearchPhase::RECONSTRUCT);
+        path = hub_bound->Path(graph);
+    }
+    return path;
 }
 
-template<class StatsCollectorT, class DistT = uint8_t>
+template<class FilterT, class StatsCollectorT>
 std::optional<std::vector<std::pair<index_t, index_t>>>
-FindShortestPathDagImpl(const GraphReader &graph, index_t start, index_t finish, StatsCollectorT stats_collector) {
+FindShortestPathDagImpl(
+        SearchWorkspace::Impl &workspace,
+        const GraphReader &graph, index_t start, index_t finish,
+        const SearchOptions &options, LimitChecker &limits, const FilterT &filter,
+        StatsCollectorT stats_collector) {
+    if (!filter.AllowsVertex(start) || !filter.AllowsVertex(finish)) return {};
+
     // List of all edges that occur on a shortest path from `start` to `finish`.
     std::vector<std::pair<index_t, index_t>> edges;
 
@@ -152,124 +324,51 @@ FindShortestPathDagImpl(const GraphReader &graph, index_t start, index_t finish,
         return edges;
     }
 
-    // We use an 8-bit integer to represent distances, with start at 1 and
-    // finish at 255. This means we can only the shortest paths that consist of
-    // at most 254 edges. It's trivial to raise this restriction by chosing a
-    // bigger integer type here, but in real-world graphs it does not seem
-    // necessary because most paths are relatively short (think: less than 20).
-    using dist_t = std::uint_least8_t;
+    // We use an 8-bit integer to represent distances (see DistanceMarks). This
+    // means we can only find the shortest paths that consist of at most 254
+    // edges. It's trivial to raise this restriction by chosing a bigger integer
+    // type there, but in real-world graphs it does not seem necessary because
+    // most paths are relatively short (think: less than 20).
+    using dist_t = DistanceMarks::dist_t;
+
+    const index_t size = graph.VertexCount();
 
-    // If dist[v] == 0, distance to v is not known.
-    // If dist[v] >= 1, then dist[v] - 1 is the distance from start to finish.
-    std::vector<dist_t> dist(graph.VertexCount(), 0);
+    std::vector<dist_t> &dist = workspace.dist;
+    if (dist.size() < size) dist.resize(size, 0);
 
     // List of vertices that occur on a shortest path, which must have their
     // predecessors/successors added to the DAG.
-    std::vector<index_t> propagate_forward, propagate_backward;
+    std::vector<index_t> &propagate_forward = workspace.propagate_forward;
+    std::vector<index_t> &propagate_backward = workspace.propagate_backward;
 
     // marked[v] is true iff. v == start or v == finish or v is an element of
     // propagate_forward or propagate_backward.
-    std::vector<bool> marked(graph.VertexCount());
+    std::vector<bool> &marked = workspace.marked;
+    if (marked.size() < size) marked.resize(size, false);
+    workspace.dag_arrays_used = true;
     marked[start] = true;
     marked[finish] = true;
 
-    // Bidirectional search to find distances and initial edges.
+    // Bidirectional search to find distances and the edges where the searches
+    // meet.
     {
-        std::vector<index_t> forward_fringe;
-        std::vector<index_t> backward_fringe;
-        dist_t forward_dist = 1;
-        dist_t backward_dist = std::numeric_limits<dist_t>::max();
-        dist[start]  = forward_dist;
-        dist[finish] = backward_dist;
-        forward_fringe.push_back(start);
-        backward_fringe.push_back(finish);
+        DistanceMarks marks(dist, marked, propagate_forward, propagate_backward, edges);
+        dist[start] = marks.forward_dist;
+        dist[finish] = marks.backward_dist;
         stats_collector.VertexReached();
         stats_collector.VertexReached();
-        bool shortest_path_found = false;
-        while (!shortest_path_found) {
-            if (backward_dist - forward_dist < 2) {
-                // This happens when the path length is greater than fits in dist_t.
-                // This shouldn't happen in real-world graphs, where the maximum
-                // path length is relatively small (under the maximum of 254).
-                std::cerr << "WARNING: path length too great!\n";
-                return {};
-            }
-            if (forward_fringe.empty() || backward_fringe.empty()) {
-                // No path exists.
-                return {};
-            }
-            if (forward_fringe.size() <= backward_fringe.size()) {
-                // Expand forward fringe.
-                ++forward_dist;
-                std::vector<index_t> new_fringe;
-                for (index_t v : forward_fringe) {
-                    stats_collector.VertexExpanded();
-                    assert(dist[v] == forward_dist - 1);
-                    for (index_t w : graph.ForwardEdges(v)) {
-                        stats_collector.EdgeExpanded();
-                        if (dist[w] == 0) {
-                            // Vertex w is an unvisted successor of v.
-                            stats_collector.VertexReached();
-                            dist[w] = forward_dist;
-                            if (propagate_backward.empty()) new_fringe.push_back(w);
-                        } else if (forward_dist < dist[w]) {
-                            // There is a shortest path containing edge v->w.
-                            shortest_path_found = true;
-                            edges.push_back({v, w});
-                            if (!marked[v]) {
-                                marked[v] = true;
-                                propagate_backward.push_back(v);
-                            }
-                            if (!marked[w]) {
-                                marked[w] = true;
-                                propagate_forward.push_back(w);
-                            }
-                        } else {
-                            assert(dist[w] <= forward_dist);
-                        }
-                    }
-                }
-                forward_fringe.swap(new_fringe);
-            } else {
-                // Expand backward fringe.
-                --backward_dist;
-                std::vector<index_t> new_fringe;
-                for (index_t w : backward_fringe) {
-                    assert(dist[w] == backward_dist + 1);
-                    stats_collector.VertexExpanded();
-                    for (index_t v : graph.BackwardEdges(w)) {
-                        stats_collector.EdgeExpanded();
-                        if (dist[v] == 0) {
-                            // Vertex v is an unvisted predecessor of w.
-                            stats_collector.VertexReached();
-                            dist[v] = backward_dist;
-                            if (propagate_forward.empty()) new_fringe.push_back(v);
-                        } else if (dist[v] < backward_dist) {
-                            // There is a shortest path containing edge v->w.
-                            shortest_path_found = true;
-                            if (!marked[w]) {
-                                marked[w] = true;
-                                propagate_forward.push_back(w);
-                            }
-                            if (!marked[v]) {
-                                marked[v] = true;
-                                propagate_backward.push_back(v);
-                            }
-                            edges.push_back({v, w});
-                        } else {
-                            assert(dist[v] >= backward_dist);
-                        }
-                    }
-                }
-                backward_fringe.swap(new_fringe);
-            }
-        }
+        HybridFrontier frontier(graph, options, workspace.fringe_words);
+        std::optional<ParallelExpander> parallel = workspace.Parallel(options);
+        SearchStatus status = BidirectionalSearch(graph, marks, frontier, workspace.state,
+                parallel ? &*parallel : nullptr, nullptr, ExpansionOptions{}, filter, stats_collector, limits).Run();
+        if (status != SearchStatus::FOUND) return {};
     }
 
+    stats_collector.PhaseStarted(SearchPhase::PROPAGATE);
     for (size_t i = 0; i < propagate_backward.size(); ++i) {
         index_t w = propagate_backward[i];
         for (index_t v : graph.BackwardEdges(w)) {
-            if (dist[v] + 1 == dist[w]) {
+            if (dist[v] + 1 == dist[w] && filter.AllowsEdge(v, w)) {
                 edges.push_back({v, w});
                 if (!marked[v]) {
                     marked[v] = true;
@@ -282,7 +381,7 @@ FindShortestPathDagImpl(const GraphReader &graph, index_t start, index_t finish,
     for (size_t i = 0; i < propagate_forward.size(); ++i) {
         index_t v = propagate_forward[i];
         for (index_t w : graph.ForwardEdges(v)) {
-            if (dist[v] + 1 == dist[w]) {
+            if (dist[v] + 1 == dist[w] && filter.AllowsEdge(v, w)) {
                 edges.push_back({v, w});
                 if (!marked[w]) {
                     marked[w] = true;
@@ -292,24 +391,492 @@ FindShortestPathDagImpl(const GraphReader &graph, index_t start, index_t finish,
         }
     }
 
+    stats_collector.PhaseStarted(SearchPhase::SORT);
     std::ranges::sort(edges);
 
     return edges;
 }
 
+// See FindNearShortestPaths() in searcher.h for a description of the algorithm.
+template<class StatsCollectorT>
+std::optional<NearShortestPaths> FindNearShortestPathsImpl(
+        SearchWorkspace::Impl &workspace,
+        const GraphReader &graph, index_t start, index_t finish, int slack,
+        LimitChecker &limits, StatsCollectorT stats_collector) {
+    const index_t size = graph.VertexCount();
+    assert(start < size);
+    assert(finish < size);
+    assert(slack >= 0);
+
+    if (start == finish) {
+        stats_collector.VertexReached();
+        return NearShortestPaths{.shortest_length = 0, .max_length = slack, .edges = {}};
+    }
+
+    // forward_dist[v] is the distance from start to v plus 1, and
+    // backward_dist[v] the distance from v to finish plus 1, or 0 if unknown.
+    std::vector<uint8_t> &forward_dist = workspace.forward_dist;
+    std::vector<uint8_t> &backward_dist = workspace.backward_dist;
+    if (forward_dist.size() < size) forward_dist.resize(size, 0);
+    if (backward_dist.size() < size) backward_dist.resize(size, 0);
+    workspace.near_arrays_used = true;
+    forward_dist[start] = 1;
+    backward_dist[finish] = 1;
+    stats_collector.VertexReached();
+    stats_collector.VertexReached();
+
+    SearchQueue &forward = workspace.state.forward;
+    SearchQueue &backward = workspace.state.backward;
+    int forward_radius = 0;
+    int backward_radius = 0;
+
+    // Expands the fringe of the forward or backward search by one level,
+    // adding only unvisited vertices w where accept(w, dist) returns true,
+    // where dist is the distance of w from start (or to finish). Returns false
+    // if the search was aborted.
+    auto ExpandLevel = [&](bool expand_forward, auto accept) {
+        SearchQueue &queue = expand_forward ? forward : backward;
+        std::vector<uint8_t> &dist = expand_forward ? forward_dist : backward_dist;
+        if ((expand_forward ? forward_radius : backward_radius) + 1 >= std::numeric_limits<uint8_t>::max() - 1) {
+            // The labels of the next level would not fit in 8 bits. Paths
+            // this long are rejected below anyway, so stop before they wrap.
+            std::cerr << "WARNING: path length too great!\n";
+            return false;
+        }
+        stats_collector.LevelStarted(
+                expand_forward ? SearchLevel::Direction::FORWARD : SearchLevel::Direction::BACKWARD,
+                SearchLevel::Mode::TOP_DOWN, queue.FringeSize());
+        const int new_dist = expand_forward ? ++forward_radius : ++backward_radius;
+        for (size_t k = queue.begin; k < queue.end; ++k) {
+            index_t v = queue.queue[k];
+            std::span<const index_t> neighbors = expand_forward ? graph.ForwardEdges(v) : graph.BackwardEdges(v);
+            if (!limits.VertexExpanded(neighbors.size())) return false;
+            stats_collector.VertexExpanded();
+            for (index_t w : neighbors) {
+                stats_collector.EdgeExpanded();
+                if (dist[w] == 0 && accept(w, new_dist)) {
+                    stats_collector.VertexReached();
+                    dist[w] = new_dist + 1;
+                    queue.queue.push_back(w);
+                }
+            }
+        }
+        queue.NextLevel();
+        return true;
+    };
+    auto AcceptAll = [](index_t, int) { return true; };
+
+    // Bidirectional search, which continues after the searches meet until the
+    // sum of their radii is at least max_length - 1.
+    int shortest_length = -1;
+    int max_length = -1;
+    while (shortest_length < 0 || forward_radius + backward_radius < max_length - 1) {
+        const bool forward_done = forward.FringeSize() == 0;
+        const bool backward_done = backward.FringeSize() == 0;
+        if (shortest_length < 0 && (forward_done || backward_done)) return {};  // no path exists
+        if (forward_done && backward_done) break;
+        const bool expand_forward = !forward_done &&
+                (backward_done || forward.FringeSize() <= backward.FringeSize());
+        if (!ExpandLevel(expand_forward, AcceptAll)) return {};
+        if (shortest_length < 0) {
+            // The searches meet at the vertices just reached that were already
+            // reached by the other search.
+            const SearchQueue &queue = expand_forward ? forward : backward;
+            const std::vector<uint8_t> &other_dist = expand_forward ? backward_dist : forward_dist;
+            for (size_t k = queue.begin; k < queue.end; ++k) {
+                index_t v = queue.queue[k];
+                if (other_dist[v] == 0) continue;
+                int length = forward_dist[v] - 1 + backward_dist[v] - 1;
+                if (shortest_length < 0 || length < shortest_length) shortest_length = length;
+            }
+            if (shortest_length >= 0) {
+                max_length = shortest_length + slack;
+                if (max_length >= std::numeric_limits<uint8_t>::max() - 1) {
+                    std::cerr << "WARNING: path length too great!\n";
+                    return {};
+                }
+            }
+        }
+    }
+
+    // Every vertex v on a qualifying walk has dist(start, v) + dist(v, finish)
+    // <= max_length, so it was reached by at least one of the searches. Extend
+    // each search through the vertices reached by the other search, to find
+    // the distances that are still missing.
+    const int forward_ball_radius = forward_radius;
+    while (forward.FringeSize() > 0 && forward_radius < max_length - 1) {
+        if (!ExpandLevel(true, [&](index_t w, int dist) {
+                return backward_dist[w] != 0 && dist + backward_dist[w] - 1 <= max_length;
+            })) {
+            return {};
+        }
+    }
+    while (backward.FringeSize() > 0 && backward_radius < max_length - 1) {
+        if (!ExpandLevel(false, [&](index_t v, int dist) {
+                return forward_dist[v] != 0 && forward_dist[v] - 1 <= forward_ball_radius &&
+                        forward_dist[v] - 1 + dist <= max_length;
+            })) {
+            return {};
+        }
+    }
+
+    stats_collector.PhaseStarted(SearchPhase::PROPAGATE);
+    NearShortestPaths result = {.shortest_length = shortest_length, .max_length = max_length, .edges = {}};
+    for (index_t v : forward.queue) {
+        if (v == finish) continue;
+        const int dist_v = forward_dist[v] - 1;
+        for (index_t w : graph.ForwardEdges(v)) {
+            if (backward_dist[w] != 0 && dist_v + 1 + backward_dist[w] - 1 <= max_length) {
+                result.edges.push_back({v, w});
+            }
+        }
+    }
+
+    stats_collector.PhaseStarted(SearchPhase::SORT);
+    std::ranges::sort(result.edges);
+    return result;
+}
+
+// Finds a path from `start` with a layered search: the forward and backward
+// searches only record which vertices they have visited (see VisitedBits), and
+// the fringe of each level, which is a contiguous range of the search queue.
+//
+// Returns the length of a shortest path, or an empty optional if no path exists
+// or the search was aborted. If `path` is not null, a shortest path is stored
+// there.
+template<class FilterT, class StatsCollectorT>
+std::optional<int> LayeredSearchImpl(
+        SearchWorkspace::Impl &workspace,
+        const GraphReader &graph, index_t start, index_t finish,
+        LimitChecker &limits, const FilterT &filter, StatsCollectorT stats_collector,
+        std::vector<index_t> *path) {
+    const index_t size = graph.VertexCount();
+    assert(start < size);
+    assert(finish < size);
+
+    if (!filter.AllowsVertex(start) || !filter.AllowsVertex(finish)) return {};
+
+    if (start == finish) {
+        stats_collector.VertexReached();
+        if (path != nullptr) *path = {start};
+        return 0;
+    }
+
+    std::vector<uint64_t> &words = workspace.visited_bits;
+    if (words.size() < (size >> VisitedBits::shift) + 1) words.resize((size >> VisitedBits::shift) + 1, 0);
+    workspace.visited_bits_used = true;
+    VisitedBits visited(words);
+    visited.Set(start, VisitedBits::FORWARD);
+    visited.Set(finish, VisitedBits::BACKWARD);
+    stats_collector.VertexReached();
+    stats_collector.VertexReached();
+
+    SearchQueue &forward = workspace.state.forward;
+    SearchQueue &backward = workspace.state.backward;
+    std::vector<size_t> &forward_levels = workspace.forward_levels;
+    std::vector<size_t> &backward_levels = workspace.backward_levels;
+    forward_levels.assign({0});
+    backward_levels.assign({0});
+
+    // Set to an edge (i, j) where i is in the fringe of the forward search and
+    // j in the fringe of the backward search, once the searches meet.
+    index_t meet_i = 0, meet_j = 0;
+    while (meet_i == 0) {
+        if (forward.FringeSize() == 0 || backward.FringeSize() == 0) return {};
+        const bool expand_forward = forward.FringeSize() <= backward.FringeSize();
+        SearchQueue &queue = expand_forward ? forward : backward;
+        const uint64_t own_bit = expand_forward ? VisitedBits::FORWARD : VisitedBits::BACKWARD;
+        stats_collector.LevelStarted(
+                expand_forward ? SearchLevel::Direction::FORWARD : SearchLevel::Direction::BACKWARD,
+                SearchLevel::Mode::TOP_DOWN, queue.FringeSize());
+        for (size_t k = queue.begin; k < queue.end && meet_i == 0; ++k) {
+            index_t v = queue.queue[k];
+            std::span<const index_t> neighbors = expand_forward ? graph.ForwardEdges(v) : graph.BackwardEdges(v);
+            if (!limits.VertexExpanded(neighbors.size())) return {};
+            stats_collector.VertexExpanded();
+            for (index_t w : neighbors) {
+                stats_collector.EdgeExpanded();
+                if (!(expand_forward ? filter.AllowsEdge(v, w) : filter.AllowsEdge(w, v))) continue;
+                uint64_t bits = visited.Get(w);
+                if (bits & ~own_bit) {
+                    // The searches meet. Vertex w must be in the fringe of the
+                    // other search, since otherwise it would have been expanded
+                    // already, and reached v.
+                    meet_i = expand_forward ? v : w;
+                    meet_j = expand_forward ? w : v;
+                    break;
+                }
+                if (bits == 0) {
+                    stats_collector.VertexReached();
+                    visited.Set(w, own_bit);
+                    queue.queue.push_back(w);
+                }
+            }
+        }
+        if (meet_i == 0) {
+            queue.NextLevel();
+            (expand_forward ? forward_levels : backward_levels).push_back(queue.begin);
+        }
+    }
+
+    // The fringe of each search is its last level.
+    const int forward_dist = forward_levels.size() - 1;
+    const int backward_dist = backward_levels.size() - 1;
+    if (path == nullptr) return forward_dist + 1 + backward_dist;
+
+    stats_collector.PhaseStarted(SearchPhase::RECONSTRUCT);
+
+    // Returns a vertex in levels[level] of `queue` that is a predecessor of `v`
+    // (for the forward search) or a successor (for the backward search). The
+    // neighbors that were visited by the same search are marked in the
+    // (otherwise unused) fringe bitmap words, so that the level can be scanned
+    // with one bit test per vertex.
+    std::vector<uint64_t> &marked = workspace.fringe_words;
+    if (marked.size() < size / 64 + 1) marked.resize(size / 64 + 1, 0);
+    auto FindInLevel = [&](const SearchQueue &queue, const std::vector<size_t> &levels, int level,
+            index_t v, uint64_t bit) {
+        const bool forward = bit == VisitedBits::FORWARD;
+        std::span<const index_t> neighbors = forward ? graph.BackwardEdges(v) : graph.ForwardEdges(v);
+        for (index_t u : neighbors) {
+            if ((visited.Get(u) & bit) && (forward ? filter.AllowsEdge(u, v) : filter.AllowsEdge(v, u))) {
+                marked[u / 64] |= uint64_t{1} << (u % 64);
+            }
+        }
+        index_t result = 0;
+        for (size_t k = levels[level]; k < levels[level + 1]; ++k) {
+            index_t u = queue.queue[k];
+            if (marked[u / 64] & (uint64_t{1} << (u % 64))) {
+                result = u;
+                break;
+            }
+        }
+        for (index_t u : neighbors) marked[u / 64] = 0;
+        assert(result != 0);
+        return result;
+    };
+
+    path->resize(forward_dist + 1 + backward_dist + 1);
+    index_t v = meet_i;
+    (*path)[forward_dist] = v;
+    for (int level = forward_dist - 1; level >= 0; --level) {
+        v = FindInLevel(forward, forward_levels, level, v, VisitedBits::FORWARD);
+        (*path)[level] = v;
+    }
+    v = meet_j;
+    (*path)[forward_dist + 1] = v;
+    for (int level = backward_dist - 1; level >= 0; --level) {
+        v = FindInLevel(backward, backward_levels, level, v, VisitedBits::BACKWARD);
+        (*path)[path->size() - 1 - level] = v;
+    }
+    return forward_dist + 1 + backward_dist;
+}
+
+Distances ComputeDistancesImpl(
+        SearchWorkspace::Impl &workspace,
+        const GraphReader &graph, index_t source, Direction direction,
+        const SearchOptions &options) {
+    const index_t size = graph.VertexCount();
+    assert(source < size);
+
+    const bool forward = direction == Direction::FORWARD;
+    auto neighbors = [&](index_t v) { return forward ? graph.ForwardEdges(v) : graph.BackwardEdges(v); };
+    auto reverse_neighbors = [&](index_t v) { return forward ? graph.BackwardEdges(v) : graph.ForwardEdges(v); };
+    auto degree = [&](index_t v) { return forward ? graph.ForwardDegree(v) : graph.BackwardDegree(v); };
+    auto reverse_degree = [&](index_t v) { return forward ? graph.BackwardDegree(v) : graph.ForwardDegree(v); };
+
+    constexpr uint8_t unreachable = Distances::UNREACHABLE;
+    Distances result = {
+        .distance = std::vector<uint8_t>(size, unreachable),
+        .histogram = {1},
+    };
+    std::vector<uint8_t> &dist = result.distance;
+    dist[source] = 0;
+
+    SearchQueue &queue = workspace.state.forward;
+    BottomUpHeuristic heuristic(graph, options);
+    std::optional<ParallelExpander> parallel = workspace.Parallel(options);
+    for (uint8_t d = 1; queue.FringeSize() > 0; ++d) {
+        if (d == unreachable) {
+            std::cerr << "WARNING: distances too great!\n";
+            break;
+        }
+        if (heuristic.UseBottomUp(queue, degree, reverse_degree)) {
+            // Each unreached vertex looks for a neighbor in the fringe, which
+            // consists exactly of the vertices at distance d - 1.
+            for (index_t w = 1; w < size; ++w) {
+                if (dist[w] != unreachable) continue;
+                for (index_t v : reverse_neighbors(w)) {
+                    if (dist[v] == d - 1) {
+                        dist[w] = d;
+                        queue.queue.push_back(w);
+                        break;
+                    }
+                }
+            }
+        } else if (parallel && parallel->ShouldExpand(queue)) {
+            DummyStatsCollector stats_collector;
+            parallel->ExpandLevel(queue, neighbors,
+                [&](index_t, index_t w, ParallelExpander::ThreadState &thread) {
+                    std::atomic_ref<uint8_t> dist_w(dist[w]);
+                    uint8_t value = dist_w.load(std::memory_order_relaxed);
+                    if (value == unreachable &&
+                            dist_w.compare_exchange_strong(value, d, std::memory_order_relaxed)) {
+                        thread.next.push_back(w);
+                    }
+                    return true;
+                },
+                stats_collector);
+        } else {
+            for (size_t k = queue.begin; k < queue.end; ++k) {
+                for (index_t w : neighbors(queue.queue[k])) {
+                    if (dist[w] == unreachable) {
+                        dist[w] = d;
+                        queue.queue.push_back(w);
+                    }
+                }
+            }
+        }
+        queue.NextLevel();
+        if (queue.FringeSize() > 0) result.histogram.push_back(queue.FringeSize());
+    }
+    return result;
+}
+
+// Calls fn(filter) with the filter policy for `filter`, so that unfiltered
+// searches don't pay for the checks.
+template<class Fn>
+auto WithFilterPolicy(const SearchFilter *filter, Fn fn) {
+    if (filter == nullptr || filter->Empty()) return fn(NoFilter());
+    return fn(RealFilter(*filter));
+}
+
+bool Found(const std::vector<index_t> &path) { return !path.empty(); }
+template<class T> bool Found(const std::optional<T> &value) { return value.has_value(); }
+
+// Returns the result of a search that returned `value`. A search that found
+// nothing was aborted if it exceeded a limit. (A parallel level may find a
+// path and exceed a limit at the same time; that search completed.)
+template<class T>
+SearchResult<T> MakeResult(T value, const LimitChecker &limit_checker, SearchStats *stats) {
+    const AbortReason reason = Found(value) ? AbortReason::NONE : limit_checker.Reason();
+    SearchResult<T> result = {std::move(value), reason};
+    if (stats != nullptr) stats->abort_reason = result.abort_reason;
+    return result;
+}
+
 } // namespace
 
-std::vector<index_t> FindShortestPath(const GraphReader &graph, index_t start, index_t finish, SearchStats *stats) {
-    return stats == nullptr ?
-            FindShortestPathImpl(graph, start, finish, DummyStatsCollector()) :
-            FindShortestPathImpl(graph, start, finish, RealStatsCollector(*stats));
+SearchWorkspace::SearchWorkspace() : impl(std::make_unique<Impl>()) {}
+
+SearchWorkspace::~SearchWorkspace() = default;
+
+SearchResult<std::vector<index_t>> SearchWorkspace::FindShortestPath(
+        const GraphReader &graph, index_t start, index_t finish, SearchStats *stats,
+        const SearchOptions &options, const SearchLimits &limits, const SearchFilter *filter) {
+    const GraphReader &local_graph = impl->Begin(graph, start, finish);
+    LimitChecker limit_checker(limits);
+    if (options.layered) {
+        std::vector<index_t> path;
+        WithFilterPolicy(filter, [&](const auto &filter_policy) {
+            return stats == nullptr ?
+                    LayeredSearchImpl(*impl, local_graph, start, finish, limit_checker, filter_policy,
+                            DummyStatsCollector(), &path) :
+                    LayeredSearchImpl(*impl, local_graph, start, finish, limit_checker, filter_policy,
+                            RealStatsCollector(*stats), &path);
+        });
+        impl->EndLayeredSearch();
+        return MakeResult(std::move(path), limit_checker, stats);
+    }
+    auto path = WithFilterPolicy(filter, [&](const auto &filter_policy) {
+        return stats == nullptr ?
+                FindShortestPathImpl(*impl, local_graph, start, finish, options, limit_checker, filter_policy,
+                        DummyStatsCollector()) :
+                FindShortestPathImpl(*impl, local_graph, start, finish, options, limit_checker, filter_policy,
+                        RealStatsCollector(*stats));
+    });
+    impl->EndPathSearch();
+    return MakeResult(std::move(path), limit_checker, stats);
+}
+
+SearchResult<std::optional<std::vector<std::pair<index_t, index_t>>>>
+SearchWorkspace::FindShortestPathDag(
+        const GraphReader &graph, index_t start, index_t finish, SearchStats *stats,
+        const SearchOptions &options, const SearchLimits &limits, const SearchFilter *filter) {
+    const GraphReader &local_graph = impl->Begin(graph, start, finish);
+    LimitChecker limit_checker(limits);
+    auto dag = WithFilterPolicy(filter, [&](const auto &filter_policy) {
+        return stats == nullptr ?
+                FindShortestPathDagImpl(*impl, local_graph, start, finish, options, limit_checker, filter_policy,
+                        DummyStatsCollector()) :
+                FindShortestPathDagImpl(*impl, local_graph, start, finish, options, limit_checker, filter_policy,
+                        RealStatsCollector(*stats));
+    });
+    impl->EndDagSearch();
+    return MakeResult(std::move(dag), limit_checker, stats);
 }
 
-std::optional<std::vector<std::pair<index_t, index_t>>>
-FindShortestPathDag(const GraphReader &graph, index_t start, index_t finish, SearchStats *stats) {
-    return stats == nullptr ?
-            FindShortestPathDagImpl(graph, start, finish, DummyStatsCollector()) :
-            FindShortestPathDagImpl(graph, start, finish, RealStatsCollector(*stats));
+SearchResult<std::optional<NearShortestPaths>> SearchWorkspace::FindNearShortestPaths(
+        const GraphReader &graph, index_t start, index_t finish, int slack, SearchStats *stats,
+        const SearchLimits &limits) {
+    const GraphReader &local_graph = impl->Begin(graph, start, finish);
+    LimitChecker limit_checker(limits);
+    auto result = stats == nullptr ?
+            FindNearShortestPathsImpl(*impl, local_graph, start, finish, slack, limit_checker, DummyStatsCollector()) :
+            FindNearShortestPathsImpl(*impl, local_graph, start, finish, slack, limit_checker, RealStatsCollector(*stats));
+    impl->EndNearShortestSearch();
+    return MakeResult(std::move(result), limit_checker, stats);
+}
+
+SearchResult<std::optional<int>> SearchWorkspace::ShortestPathLength(
+        const GraphReader &graph, index_t start, index_t finish, SearchStats *stats,
+        const SearchLimits &limits) {
+    const GraphReader &local_graph = impl->Begin(graph, start, finish);
+    LimitChecker limit_checker(limits);
+    std::optional<int> length = stats == nullptr ?
+            LayeredSearchImpl(*impl, local_graph, start, finish, limit_checker, NoFilter(), DummyStatsCollector(), nullptr) :
+            LayeredSearchImpl(*impl, local_graph, start, finish, limit_checker, NoFilter(), RealStatsCollector(*stats), nullptr);
+    impl->EndLayeredSearch();
+    return MakeResult(length, limit_checker, stats);
+}
+
+Distances SearchWorkspace::ComputeDistances(
+        const GraphReader &graph, index_t source, Direction direction,
+        const SearchOptions &options) {
+    const GraphReader &local_graph = impl->Begin(graph, source, source);
+    Distances distances = ComputeDistancesImpl(*impl, local_graph, source, direction, options);
+    impl->EndDistancesSearch();
+    return distances;
+}
+
+SearchResult<std::vector<index_t>> FindShortestPath(
+        const GraphReader &graph, index_t start, index_t finish, SearchStats *stats,
+        const SearchOptions &options, const SearchLimits &limits, const SearchFilter *filter) {
+    return SearchWorkspace().FindShortestPath(graph, start, finish, stats, options, limits, filter);
+}
+
+SearchResult<std::optional<std::vector<std::pair<index_t, index_t>>>>
+FindShortestPathDag(
+        const GraphReader &graph, index_t start, index_t finish, SearchStats *stats,
+        const SearchOptions &options, const SearchLimits &limits, const SearchFilter *filter) {
+    return SearchWorkspace().FindShortestPathDag(graph, start, finish, stats, options, limits, filter);
+}
+
+SearchResult<std::optional<NearShortestPaths>> FindNearShortestPaths(
+        const GraphReader &graph, index_t start, index_t finish, int slack, SearchStats *stats,
+        const SearchLimits &limits) {
+    return SearchWorkspace().FindNearShortestPaths(graph, start, finish, slack, stats, limits);
+}
+
+SearchResult<std::optional<int>> ShortestPathLength(
+        const GraphReader &graph, index_t start, index_t finish, SearchStats *stats,
+        const SearchLimits &limits) {
+    return SearchWorkspace().ShortestPathLength(graph, start, finish, stats, limits);
+}
+
+Distances ComputeDistances(
+        const GraphReader &graph, index_t source, Direction direction,
+        const SearchOptions &options) {
+    return SearchWorkspace().ComputeDistances(graph, source, direction, options);
 }
 
 }  // namespace wikipath
@@ -0,0 +1,146 @@
+#include "wikipath/stream-vbyte.h"
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+#include <assert.h>
+
+#include <cstdint>
+
+namespace wikipath {
+namespace {
+
+// Returns the number of bytes needed to store `gap`.
+inline int GapLength(index_t gap) {
+    return gap < (1u << 8) ? 1 : gap < (1u << 16) ? 2 : gap < (1u << 24) ? 3 : 4;
+}
+
+// Decodes indices `k` to `count` (exclusive), where `control` and `gaps` point
+// to the control byte and the gap bytes of index `k`, and `previous` is the
+// index before it (or 0). Returns a pointer past the last gap byte.
+const uint8_t *DecodeScalar(
+        const uint8_t *control, const uint8_t *gaps, size_t k, size_t count, index_t previous, index_t *output) {
+    for (; k < count; ++k) {
+        int length = ((*control >> (2 * (k % 4))) & 3) + 1;
+        index_t gap = 0;
+        for (int i = 0; i < length; ++i) gap |= index_t{gaps[i]} << (8 * i);
+        gaps += length;
+        previous += gap;
+        output[k] = previous;
+        if (k % 4 == 3) ++control;
+    }
+    return gaps;
+}
+
+#if defined(__x86_64__)
+
+// For each control byte: the shuffle that moves the gap bytes of 4 indices
+// into 32-bit lanes (0xff clears a byte), and the total length of the gaps.
+struct DecodeTables {
+    uint8_t shuffle[256][16];
+    uint8_t length[256];
+};
+
+constexpr DecodeTables MakeDecodeTables() {
+    DecodeTables tables = {};
+    for (int control = 0; control < 256; ++control) {
+        int offset = 0;
+        for (int lane = 0; lane < 4; ++lane) {
+            int length = ((control >> (2 * lane)) & 3) + 1;
+            for (int i = 0; i < 4; ++i) {
+                tables.shuffle[control][4 * lane + i] = i < length ? offset + i : 0xff;
+            }
+            offset += length;
+        }
+        tables.length[control] = offset;
+    }
+    return tables;
+}
+
+alignas(16) constexpr DecodeTables decode_tables = MakeDecodeTables();
+
+__attribute__((target("ssse3")))
+const uint8_t *DecodeSsse3(const uint8_t *control, const uint8_t *gaps, size_t count, index_t *output) {
+    __m128i previous = _mm_setzero_si128();
+    size_t k = 0;
+    for (; k + 4 <= count; k += 4, ++control) {
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(gaps));
+        const __m128i shuffle = _mm_load_si128(reinterpret_cast<const __m128i*>(decode_tables.shuffle[*control]));
+        gaps += decode_tables.length[*control];
+
+        // Prefix sum of the 4 gaps, plus the last index of the previous group.
+        __m128i x = _mm_shuffle_epi8(bytes, shuffle);
+        x = _mm_add_epi32(x, _mm_slli_si128(x, 4));
+        x = _mm_add_epi32(x, _mm_slli_si128(x, 8));
+        x = _mm_add_epi32(x, previous);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(output + k), x);
+        previous = _mm_shuffle_epi32(x, 0xff);
+    }
+    return DecodeScalar(control, gaps, k, count, k > 0 ? output[k - 1] : 0, output);
+}
+
+#endif  // defined(__x86_64__)
+
+}  // namespace
+
+const char *DecodeKernelName(DecodeKernel kernel) {
+    switch (kernel) {
+        case DecodeKernel::SCALAR: return "scalar";
+        case DecodeKernel::SSSE3: return "ssse3";
+    }
+    return "unknown";
+}
+
+bool DecodeKernelSupported(DecodeKernel kernel) {
+    switch (kernel) {
+        case DecodeKernel::SCALAR:
+            return true;
+#if defined(__x86_64__)
+        case DecodeKernel::SSSE3:
+            return __builtin_cpu_supports("ssse3");
+#endif
+        default:
+            return false;
+    }
+}
+
+DecodeKernel BestDecodeKernel() {
+    static const DecodeKernel best =
+            DecodeKernelSupported(DecodeKernel::SSSE3) ? DecodeKernel::SSSE3 :
+            DecodeKernel::SCALAR;
+    return best;
+}
+
+void EncodeSortedIndices(std::span<const index_t> indices, std::vector<uint8_t> &output) {
+    const size_t control_begin = output.size();
+    output.resize(control_begin + (indices.size() + 3) / 4, 0);
+    index_t previous = 0;
+    for (size_t k = 0; k < indices.size(); ++k) {
+        assert(indices[k] >= previous);
+        const index_t gap = indices[k] - previous;
+        const int length = GapLength(gap);
+        output[control_begin + k / 4] |= (length - 1) << (2 * (k % 4));
+        for (int i = 0; i < length; ++i) output.push_back(gap >> (8 * i));
+        previous = indices[k];
+    }
+}
+
+size_t DecodeSortedIndices(DecodeKernel kernel, const uint8_t *data, size_t count, index_t *output) {
+    assert(DecodeKernelSupported(kernel));
+    const uint8_t *gaps = data + (count + 3) / 4;
+    const uint8_t *end;
+    switch (kernel) {
+#if defined(__x86_64__)
+        case DecodeKernel::SSSE3:
+            end = DecodeSsse3(data, gaps, count, output);
+            break;
+#endif
+        default:
+            end = DecodeScalar(data, gaps, 0, count, 0, output);
+            break;
+    }
+    return end - data;
+}
+
+}  // namespace wikipath
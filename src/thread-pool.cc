@@ -0,0 +1,157 @@
+#include "wikipath/thread-pool.h"
+
+#include "wikipath/numa.h"
+
+#include <assert.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <memory>
+
+namespace wikipath {
+namespace {
+
+// The unclaimed part [lo, hi) of one thread's share of a ParallelFor() range,
+// packed in a single atomic word so both ends can be updated with a single
+// compare-and-swap. Offsets are relative to the start of the range.
+struct alignas(64) PackedRange {
+    std::atomic<uint64_t> value;
+
+    static uint64_t Pack(uint32_t lo, uint32_t hi) { return (uint64_t{lo} << 32) | hi; }
+    static uint32_t Lo(uint64_t value) { return value >> 32; }
+    static uint32_t Hi(uint64_t value) { return static_cast<uint32_t>(value); }
+};
+
+}  // namespace
+
+ThreadPool::ThreadPool(int thread_count) {
+    for (int i = 1; i < thread_count; ++i) {
+        workers.emplace_back(&ThreadPool::WorkerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    work_available.notify_all();
+    for (std::thread &worker : workers) worker.join();
+}
+
+void ThreadPool::WorkerLoop(int thread_index) {
+    int seen_generation = 0;
+    for (;;) {
+        const std::function<void(int)> *fn;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            work_available.wait(lock, [&]() { return stopping || generation != seen_generation; });
+            if (stopping) return;
+            seen_generation = generation;
+            fn = work;
+        }
+        (*fn)(thread_index);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--running == 0) work_done.notify_one();
+        }
+    }
+}
+
+void ThreadPool::Run(const std::function<void(int)> &fn) {
+    if (workers.empty()) {
+        fn(0);
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        assert(running == 0);
+        work = &fn;
+        running = static_cast<int>(workers.size());
+        ++generation;
+    }
+    work_available.notify_all();
+    fn(0);
+    std::unique_lock<std::mutex> lock(mutex);
+    work_done.wait(lock, [&]() { return running == 0; });
+    work = nullptr;
+}
+
+void ThreadPool::ParallelFor(
+        size_t begin, size_t end, size_t grain,
+        const std::function<void(int, size_t, size_t)> &fn) {
+    if (begin >= end) return;
+    assert(end - begin <= std::numeric_limits<uint32_t>::max());
+    grain = std::max<size_t>(grain, 1);
+    const int thread_count = ThreadCount();
+    const uint32_t size = end - begin;
+    if (thread_count == 1 || size <= grain) {
+        for (size_t b = begin; b < end; b += grain) fn(0, b, std::min(b + grain, end));
+        return;
+    }
+
+    std::unique_ptr<PackedRange[]> ranges(new PackedRange[thread_count]);
+    for (int i = 0; i < thread_count; ++i) {
+        uint32_t lo = uint64_t{size} * i / thread_count;
+        uint32_t hi = uint64_t{size} * (i + 1) / thread_count;
+        ranges[i].value.store(PackedRange::Pack(lo, hi), std::memory_order_relaxed);
+    }
+
+    Run([&](int thread_index) {
+        PackedRange &own = ranges[thread_index];
+        for (;;) {
+            // Claim chunks from the front of our own range.
+            uint64_t value = own.value.load(std::memory_order_relaxed);
+            while (PackedRange::Lo(value) < PackedRange::Hi(value)) {
+                uint32_t lo = PackedRange::Lo(value);
+                uint32_t hi = PackedRange::Hi(value);
+                uint32_t mid = std::min<uint64_t>(hi, uint64_t{lo} + grain);
+                if (own.value.compare_exchange_weak(value, PackedRange::Pack(mid, hi), std::memory_order_relaxed)) {
+                    fn(thread_index, begin + lo, begin + mid);
+                    value = own.value.load(std::memory_order_relaxed);
+                }
+            }
+
+            // Steal the back half of the largest remaining range of another thread.
+            bool stolen = false;
+            while (!stolen) {
+                int victim = -1;
+                uint64_t victim_value = 0;
+                uint32_t victim_remaining = grain;
+                for (int i = 0; i < thread_count; ++i) {
+                    if (i == thread_index) continue;
+                    uint64_t value = ranges[i].value.load(std::memory_order_relaxed);
+                    uint32_t remaining = PackedRange::Hi(value) - std::min(PackedRange::Lo(value), PackedRange::Hi(value));
+                    if (remaining > victim_remaining) {
+                        victim = i;
+                        victim_value = value;
+                        victim_remaining = remaining;
+                    }
+                }
+                if (victim < 0) return;  // all remaining work is claimed or too small to split
+                uint32_t lo = PackedRange::Lo(victim_value);
+                uint32_t hi = PackedRange::Hi(victim_value);
+                uint32_t mid = lo + (hi - lo) / 2;
+                if (ranges[victim].value.compare_exchange_strong(
+                        victim_value, PackedRange::Pack(lo, mid), std::memory_order_relaxed)) {
+                    // Our own range is empty, and other threads only modify it
+                    // when it is not, so a plain store is safe here.
+                    own.value.store(PackedRange::Pack(mid, hi), std::memory_order_relaxed);
+                    stolen = true;
+                }
+            }
+        }
+    });
+}
+
+bool ThreadPool::PinWorkersToNumaNode(int node) {
+    std::atomic<bool> success = true;
+    Run([&](int thread_index) {
+        if (thread_index > 0 && !PinThreadToNumaNode(node)) success = false;
+    });
+    return success;
+}
+
+}  // namespace wikipath
@@ -0,0 +1,246 @@
+#include "wikipath/vertex-order.h"
+
+#include <assert.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <numeric>
+
+namespace wikipath {
+namespace {
+
+constexpr index_t none = std::numeric_limits<index_t>::max();
+
+// Returns the number of edges of `v` in both directions.
+index_t Degree(const GraphReader &graph, index_t v) {
+    return graph.ForwardDegree(v) + graph.BackwardDegree(v);
+}
+
+// Returns the vertices except 0, ordered by decreasing degree (and by id, for
+// vertices of the same degree).
+std::vector<index_t> VerticesByDegree(const GraphReader &graph) {
+    std::vector<index_t> vertices(graph.VertexCount() - 1);
+    std::iota(vertices.begin(), vertices.end(), 1);
+    std::stable_sort(vertices.begin(), vertices.end(),
+            [&](index_t v, index_t w) { return Degree(graph, v) > Degree(graph, w); });
+    return vertices;
+}
+
+// Converts a list of vertices in their new order to the new id of each vertex.
+std::vector<index_t> NewIds(index_t size, std::span<const index_t> order) {
+    assert(order.size() + 1 == size);
+    std::vector<index_t> new_id(size, 0);
+    for (size_t i = 0; i < order.size(); ++i) new_id[order[i]] = i + 1;
+    return new_id;
+}
+
+// Returns the vertices in order of a breadth-first search over edges in both
+// directions, which starts from each unvisited vertex of `seeds` in turn. If
+// `by_degree` is true, the neighbors of a vertex are visited by increasing
+// degree, as in the Cuthill-McKee algorithm, and otherwise by id.
+std::vector<index_t> BreadthFirstOrder(const GraphReader &graph, std::span<const index_t> seeds, bool by_degree) {
+    std::vector<bool> visited(graph.VertexCount(), false);
+    std::vector<index_t> order;
+    order.reserve(graph.VertexCount() - 1);
+    std::vector<index_t> buffer, neighbors;
+    for (index_t seed : seeds) {
+        if (visited[seed]) continue;
+        visited[seed] = true;
+        order.push_back(seed);
+        for (size_t i = order.size() - 1; i < order.size(); ++i) {
+            const index_t v = order[i];
+            neighbors.clear();
+            for (index_t w : graph.ForwardEdges(v, buffer)) neighbors.push_back(w);
+            for (index_t w : graph.BackwardEdges(v, buffer)) neighbors.push_back(w);
+            if (by_degree) {
+                std::sort(neighbors.begin(), neighbors.end(), [&](index_t w, index_t x) {
+                    index_t dw = Degree(graph, w), dx = Degree(graph, x);
+                    return dw != dx ? dw < dx : w < x;
+                });
+            } else {
+                std::sort(neighbors.begin(), neighbors.end());
+            }
+            for (index_t w : neighbors) {
+                if (w == 0 || visited[w]) continue;
+                visited[w] = true;
+                order.push_back(w);
+            }
+        }
+    }
+    return order;
+}
+
+// Priority queue of vertices whose keys only change by 1 at a time, as used by
+// Gorder: each key has a bucket (a doubly linked list of vertices), so that
+// keys are updated in constant time.
+class UnitHeap {
+public:
+    // Inserts `vertices` with key 0. PopMax() returns vertices with equal keys
+    // in reverse order of insertion (or of their last update).
+    UnitHeap(index_t size, std::span<const index_t> vertices)
+        : key(size, -1), prev(size, none), next(size, none), head(1, none) {
+        for (index_t v : vertices) Link(v, 0);
+    }
+
+    void Increment(index_t v) {
+        if (key[v] < 0) return;
+        Unlink(v);
+        Link(v, key[v] + 1);
+    }
+
+    void Decrement(index_t v) {
+        if (key[v] < 0) return;
+        assert(key[v] > 0);
+        Unlink(v);
+        Link(v, key[v] - 1);
+    }
+
+    // Removes and returns a vertex with the highest key, or `none` if the heap
+    // is empty.
+    index_t PopMax() {
+        while (top > 0 && head[top] == none) --top;
+        index_t v = head[top];
+        if (v == none) return none;
+        Unlink(v);
+        key[v] = -1;
+        return v;
+    }
+
+private:
+    void Link(index_t v, int k) {
+        if (static_cast<size_t>(k) >= head.size()) head.resize(k + 1, none);
+        key[v] = k;
+        prev[v] = none;
+        next[v] = head[k];
+        if (head[k] != none) prev[head[k]] = v;
+        head[k] = v;
+        top = std::max(top, k);
+    }
+
+    void Unlink(index_t v) {
+        if (prev[v] != none) {
+            next[prev[v]] = next[v];
+        } else {
+            head[key[v]] = next[v];
+        }
+        if (next[v] != none) prev[next[v]] = prev[v];
+    }
+
+    std::vector<int> key;  // -1 if not in the heap
+    std::vector<index_t> prev;
+    std::vector<index_t> next;
+    std::vector<index_t> head;
+    int top = 0;
+};
+
+std::vector<index_t> GorderOrder(const GraphReader &graph, int window) {
+    const index_t size = graph.VertexCount();
+
+    // Insert the vertices by increasing degree, so that when no candidate has a
+    // positive score, the next vertex is the one with the most edges.
+    std::vector<index_t> vertices = VerticesByDegree(graph);
+    std::reverse(vertices.begin(), vertices.end());
+    UnitHeap heap(size, vertices);
+
+    // Siblings (vertices with a common predecessor) are not counted through
+    // predecessors with many successors, like the original implementation,
+    // since each such predecessor would add a score to a large part of the
+    // graph every time one of its successors is placed.
+    const index_t max_sibling_degree = std::max<index_t>(std::sqrt(static_cast<double>(size)), 1);
+
+    // Increments or decrements the score of every vertex that has an edge to
+    // or from `u`, or a common predecessor with it.
+    std::vector<index_t> buffer, predecessors;
+    auto update_scores = [&](index_t u, bool increment) {
+        auto update = [&](index_t w) { increment ? heap.Increment(w) : heap.Decrement(w); };
+        for (index_t w : graph.ForwardEdges(u, buffer)) update(w);
+        auto backward = graph.BackwardEdges(u, buffer);
+        predecessors.assign(backward.begin(), backward.end());
+        for (index_t p : predecessors) {
+            update(p);
+            if (graph.ForwardDegree(p) > max_sibling_degree) continue;
+            for (index_t w : graph.ForwardEdges(p, buffer)) {
+                if (w != u) update(w);
+            }
+        }
+    };
+
+    std::vector<index_t> order;
+    order.reserve(size - 1);
+    for (index_t v; (v = heap.PopMax()) != none; ) {
+        if (order.size() >= static_cast<size_t>(window)) update_scores(order[order.size() - window], false);
+        order.push_back(v);
+        update_scores(v, true);
+    }
+    return order;
+}
+
+}  // namespace
+
+const char *VertexOrderName(VertexOrder order) {
+    switch (order) {
+        case VertexOrder::BFS: return "bfs";
+        case VertexOrder::RCM: return "rcm";
+        case VertexOrder::DEGREE: return "degree";
+        case VertexOrder::GORDER: return "gorder";
+    }
+    return "unknown";
+}
+
+std::optional<VertexOrder> ParseVertexOrder(std::string_view name) {
+    for (VertexOrder order : {VertexOrder::BFS, VertexOrder::RCM, VertexOrder::DEGREE, VertexOrder::GORDER}) {
+        if (name == VertexOrderName(order)) return order;
+    }
+    return std::nullopt;
+}
+
+std::vector<index_t> ComputeVertexOrder(
+        const GraphReader &graph, VertexOrder order, const VertexOrderOptions &options) {
+    const index_t size = graph.VertexCount();
+    if (size == 0) return {};
+    switch (order) {
+        case VertexOrder::BFS:
+            return NewIds(size, BreadthFirstOrder(graph, VerticesByDegree(graph), false));
+
+        case VertexOrder::RCM:
+            {
+                std::vector<index_t> seeds = VerticesByDegree(graph);
+                std::reverse(seeds.begin(), seeds.end());
+                std::vector<index_t> vertices = BreadthFirstOrder(graph, seeds, true);
+                std::reverse(vertices.begin(), vertices.end());
+                return NewIds(size, vertices);
+            }
+
+        case VertexOrder::DEGREE:
+            return NewIds(size, VerticesByDegree(graph));
+
+        case VertexOrder::GORDER:
+            return NewIds(size, GorderOrder(graph, std::max(options.gorder_window, 1)));
+    }
+    return {};
+}
+
+std::pair<AdjacencyFn, AdjacencyFn> RenumberedAdjacency(const GraphReader &graph, std::span<const index_t> new_id) {
+    assert(new_id.size() == graph.VertexCount());
+    auto old_id = std::make_shared<std::vector<index_t>>(new_id.size());
+    for (index_t v = 0; v < new_id.size(); ++v) (*old_id)[new_id[v]] = v;
+
+    auto make_adjacency = [&graph, new_id, old_id](bool forward) -> AdjacencyFn {
+        auto buffer = std::make_shared<std::vector<index_t>>();
+        auto edges = std::make_shared<std::vector<index_t>>();
+        return [&graph, new_id, old_id, forward, buffer, edges](index_t v) {
+            const index_t u = (*old_id)[v];
+            edges->clear();
+            for (index_t w : forward ? graph.ForwardEdges(u, *buffer) : graph.BackwardEdges(u, *buffer)) {
+                edges->push_back(new_id[w]);
+            }
+            std::sort(edges->begin(), edges->end());
+            return std::span<const index_t>(*edges);
+        };
+    };
+    return {make_adjacency(true), make_adjacency(false)};
+}
+
+}  // namespace wikipath
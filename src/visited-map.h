@@ -0,0 +1,152 @@
+#ifndef WIKIPATH_VISITED_MAP_H_INCLUDED
+#define WIKIPATH_VISITED_MAP_H_INCLUDED
+
+#include "wikipath/common.h"
+
+#include <assert.h>
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace wikipath {
+
+// Visited sets of the bidirectional searches in searcher.cc and
+// batch-search.cc, which map each visited vertex to its predecessor.
+
+// Stores predecessor information of visited vertices (see ParentMarks in
+// searcher.cc for the encoding) in a flat array with one element per vertex.
+//
+// The array is owned by the SearchWorkspace, so it can be reused between
+// searches. It must contain at least VertexCount() elements.
+class DenseVisitedMap {
+public:
+    // Whether AtomicRef() is supported, so that the map can be updated by
+    // multiple threads concurrently.
+    static constexpr bool concurrent = true;
+
+    explicit DenseVisitedMap(std::vector<index_t> &data) : data(data) {}
+
+    // The array never needs to be replaced with a different data structure.
+    bool HasRoomFor(size_t) const { return true; }
+
+    index_t &operator[](index_t v) { return data[v]; }
+
+    void Prefetch(index_t v) const { __builtin_prefetch(&data[v], 1); }
+
+    index_t *Data() { return data.data(); }
+
+    std::atomic_ref<index_t> AtomicRef(index_t v) { return std::atomic_ref<index_t>(data[v]); }
+
+private:
+    std::vector<index_t> &data;
+};
+
+// Stores the same information as DenseVisitedMap, but in an open-addressing
+// hash table with linear probing, so memory use is proportional to the number
+// of visited vertices instead of the number of vertices in the graph. Absent
+// vertices have value 0, just like in DenseVisitedMap.
+//
+// HasRoomFor(n) returns false if inserting n more vertices could exceed
+// `max_size`, which signals that the search should switch to a DenseVisitedMap.
+class SparseVisitedMap {
+public:
+    static constexpr bool concurrent = false;
+
+    SparseVisitedMap() {
+        Rehash(min_capacity);
+    }
+
+    // Removes all entries. This takes time proportional to the size before
+    // clearing, since the table shrinks to the capacity needed for that many
+    // elements.
+    void Clear() {
+        size_t capacity = std::bit_ceil(std::max(min_capacity, 4*size));
+        if (capacity < slots.size()) {
+            slots.resize(capacity);
+            shift = 64 - std::countr_zero(capacity);
+        }
+        std::fill(slots.begin(), slots.end(), Slot{});
+        size = 0;
+    }
+
+    void SetMaxSize(size_t new_max_size) { max_size = new_max_size; }
+
+    bool HasRoomFor(size_t n) const { return size + n <= max_size; }
+
+    // Returns a reference to the value for `v`, inserting a zero value if `v`
+    // is absent. The reference is invalidated by the next call.
+    index_t &operator[](index_t v) {
+        size_t i = Find(v);
+        if (slots[i].key == empty_key) {
+            if (2*(size + 1) > slots.size()) {
+                Rehash(2*slots.size());
+                i = Find(v);
+            }
+            slots[i].key = v;
+            ++size;
+        }
+        return slots[i].value;
+    }
+
+    // Prefetches the slot where the lookup of `v` starts. Usually, that is
+    // the slot of `v`, or where it would be inserted.
+    void Prefetch(index_t v) const {
+        __builtin_prefetch(&slots[Hash(v)], 1);
+    }
+
+    // Copies all entries into the given map.
+    template<class VisitedMapT>
+    void CopyTo(VisitedMapT &visited) const {
+        for (const Slot &slot : slots) {
+            if (slot.key != empty_key) visited[slot.key] = slot.value;
+        }
+    }
+
+private:
+    static constexpr size_t min_capacity = 1024;
+    static constexpr index_t empty_key = std::numeric_limits<index_t>::max();
+
+    struct Slot {
+        index_t key = empty_key;
+        index_t value = 0;
+    };
+
+    // Fibonacci hashing: multiply by 2^64 / phi, and keep the high bits.
+    size_t Hash(index_t v) const {
+        return (uint64_t{v} * 11400714819323198485ull) >> shift;
+    }
+
+    // Returns the index of the slot containing `v`, or the empty slot where
+    // `v` should be inserted.
+    size_t Find(index_t v) const {
+        size_t i = Hash(v);
+        while (slots[i].key != v && slots[i].key != empty_key) {
+            i = (i + 1) & (slots.size() - 1);
+        }
+        return i;
+    }
+
+    // Resizes the table to `capacity` slots, which must be a power of 2.
+    void Rehash(size_t capacity) {
+        assert((capacity & (capacity - 1)) == 0);
+        std::vector<Slot> old_slots(capacity);
+        old_slots.swap(slots);
+        shift = 64 - std::countr_zero(capacity);
+        for (const Slot &slot : old_slots) {
+            if (slot.key != empty_key) slots[Find(slot.key)] = slot;
+        }
+    }
+
+    size_t max_size = 0;
+    size_t size = 0;
+    int shift = 0;
+    std::vector<Slot> slots;
+};
+
+}  // namespace wikipath
+
+#endif  // ndef WIKIPATH_VISITED_MAP_H_INCLUDED
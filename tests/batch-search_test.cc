@@ -0,0 +1,95 @@
+#include "wikipath/batch-search.h"
+#include "wikipath/graph-reader.h"
+#include "wikipath/graph-writer.h"
+#include "wikipath/searcher.h"
+
+#include "test-util.h"
+
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <stdlib.h>
+
+namespace wikipath {
+namespace {
+
+// Runs all pairs of vertices (including pairs of the same vertex, and vertex 0
+// which has no edges) as one batch, and compares with FindShortestPath().
+void TestAllPairs(const std::string &graph_name, const GraphReader &graph) {
+    std::vector<std::pair<index_t, index_t>> queries;
+    for (index_t start = 0; start < graph.VertexCount(); ++start) {
+        for (index_t finish = 0; finish < graph.VertexCount(); ++finish) {
+            queries.emplace_back(start, finish);
+        }
+    }
+    for (int interleave : {1, 3, 16, 1000000}) {
+        auto paths = FindShortestPaths(graph, queries, {.interleave = interleave});
+        if (paths.size() != queries.size()) {
+            Check(false, graph_name, "FindShortestPaths() result count");
+            continue;
+        }
+        int mismatches = 0;
+        for (size_t i = 0; i < queries.size(); ++i) {
+            auto [start, finish] = queries[i];
+            // The length of the expected path, or -1 if there is none.
+            const int d = static_cast<int>(FindShortestPath(graph, start, finish, nullptr).value.size()) - 1;
+            if (!IsShortestPath(graph, start, finish, d, paths[i])) {
+                if (mismatches++ == 0) {
+                    Check(false, graph_name, "FindShortestPaths() from " + std::to_string(start) +
+                            " to " + std::to_string(finish) + " with interleave=" + std::to_string(interleave));
+                }
+            }
+        }
+        Check(mismatches == 0, graph_name, "FindShortestPaths() with interleave=" + std::to_string(interleave));
+    }
+    Check(FindShortestPaths(graph, {}).empty(), graph_name, "FindShortestPaths() without queries");
+}
+
+void TestRandomGraph(index_t size, int edges_per_vertex, bool compressed = false) {
+    std::string filename = TempFilename("batch-search_test", ".graph");
+    if (!WriteRandomGraph(filename.c_str(), size, edges_per_vertex, 42, compressed)) {
+        Check(false, filename, "write random graph");
+        return;
+    }
+    std::unique_ptr<GraphReader> graph = GraphReader::Open(filename.c_str(), {});
+    std::filesystem::remove(filename);
+    if (graph == nullptr) {
+        Check(false, filename, "open random graph");
+        return;
+    }
+    TestAllPairs("random (" + std::to_string(size) + " vertices, " +
+            std::to_string(edges_per_vertex) + " edges per vertex" + (compressed ? ", compressed)" : ")"), *graph);
+}
+
+}  // namespace
+}  // namespace wikipath
+
+int main() {
+    using namespace wikipath;
+    for (const char *filename : {"testdata/example-1.graph", "testdata/example-2.graph", "testdata/example-3.graph"}) {
+        std::unique_ptr<GraphReader> graph = GraphReader::Open(filename, {});
+        if (graph == nullptr) {
+            std::cout << "Could not open " << filename << "!\n";
+            return EXIT_FAILURE;
+        }
+        TestAllPairs(filename, *graph);
+    }
+    // A sparse graph with many unreachable pairs, and a denser one with
+    // vertices of high degree (which are scanned in several batches).
+    TestRandomGraph(200, 2);
+    TestRandomGraph(150, 40);
+    // The searches in flight decode adjacency lists into their own buffers.
+    TestRandomGraph(150, 40, true);
+
+    if (failures > 0) {
+        std::cout << failures << " tests failed!\n";
+        return EXIT_FAILURE;
+    } else {
+        std::cout << "All " << successes << " tests passed.\n";
+        return EXIT_SUCCESS;
+    }
+}
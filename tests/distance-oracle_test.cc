@@ -0,0 +1,97 @@
+#include "wikipath/distance-oracle.h"
+#include "wikipath/graph-reader.h"
+#include "wikipath/graph-writer.h"
+
+#include "test-util.h"
+
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <stdlib.h>
+
+namespace wikipath {
+namespace {
+
+// Builds labels with the given number of threads and checks that the oracle
+// returns the correct distance for all pairs of vertices.
+void TestOracle(const std::string &graph_name, const GraphReader &graph, int threads) {
+    const std::string what = "threads=" + std::to_string(threads) + ": ";
+    const std::string filename = TempFilename("distance-oracle_test", ".labels");
+    DistanceLabelStats build_stats;
+    int progress_calls = 0;
+    DistanceLabelOptions options = {
+        .threads = threads,
+        .progress = [&](const DistanceLabelStats&) { ++progress_calls; },
+    };
+    bool built = BuildDistanceLabels(graph, filename.c_str(), options, &build_stats);
+    Check(built, graph_name, what + "BuildDistanceLabels()");
+    std::unique_ptr<DistanceOracle> oracle = DistanceOracle::Open(filename.c_str());
+    std::filesystem::remove(filename);
+    Check(oracle != nullptr, graph_name, what + "DistanceOracle::Open()");
+    if (!built || oracle == nullptr) return;
+
+    Check(progress_calls > 0, graph_name, what + "progress reported");
+    Check(build_stats.hubs_processed == graph.VertexCount(), graph_name, what + "all hubs processed");
+    DistanceLabelStats stats = oracle->Stats();
+    Check(oracle->VertexCount() == graph.VertexCount(), graph_name, what + "VertexCount()");
+    Check(stats.out_entries == build_stats.out_entries && stats.in_entries == build_stats.in_entries &&
+            stats.file_size == build_stats.file_size, graph_name, what + "Stats()");
+
+    for (index_t start = 1; start < graph.VertexCount(); ++start) {
+        std::vector<int> expected = ReferenceDistances(graph, start, Direction::FORWARD, DistanceOracle::UNREACHABLE);
+        for (index_t finish = 1; finish < graph.VertexCount(); ++finish) {
+            if (oracle->Distance(start, finish) != expected[finish]) {
+                Check(false, graph_name, what + "Distance(" + std::to_string(start) + ", " +
+                        std::to_string(finish) + ")");
+                return;
+            }
+        }
+    }
+    Check(true, graph_name, what + "Distance() for all pairs");
+}
+
+void TestRandomGraph() {
+    std::string filename = TempFilename("distance-oracle_test", ".graph");
+    if (!WriteRandomGraph(filename.c_str(), 500, 2, 42)) {
+        Check(false, filename, "write random graph");
+        return;
+    }
+    std::unique_ptr<GraphReader> graph = GraphReader::Open(filename.c_str(), {});
+    std::filesystem::remove(filename);
+    if (graph == nullptr) {
+        Check(false, filename, "open random graph");
+        return;
+    }
+    for (int threads : {1, 3}) TestOracle("random", *graph, threads);
+}
+
+}  // namespace
+}  // namespace wikipath
+
+int main() {
+    using namespace wikipath;
+    for (const char *filename : {"testdata/example-1.graph", "testdata/example-2.graph", "testdata/example-3.graph"}) {
+        std::unique_ptr<GraphReader> graph = GraphReader::Open(filename, {});
+        if (graph == nullptr) {
+            std::cout << "Could not open " << filename << "!\n";
+            return EXIT_FAILURE;
+        }
+        for (int threads : {1, 3}) TestOracle(filename, *graph, threads);
+    }
+    TestRandomGraph();
+
+    if (DistanceOracle::Open("testdata/example-1.graph") != nullptr) {
+        Check(false, "testdata/example-1.graph", "DistanceOracle::Open() rejects a graph file");
+    }
+
+    if (failures > 0) {
+        std::cout << failures << " tests failed!\n";
+        return EXIT_FAILURE;
+    } else {
+        std::cout << "All " << successes << " tests passed.\n";
+        return EXIT_SUCCESS;
+    }
+}
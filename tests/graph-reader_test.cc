@@ -0,0 +1,305 @@
+#include "wikipath/graph-header.h"
+#include "wikipath/graph-reader.h"
+#include "wikipath/graph-writer.h"
+#include "wikipath/numa.h"
+
+#include "test-util.h"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <stdlib.h>
+
+namespace wikipath {
+namespace {
+
+std::string ReadFile(const std::string &filename) {
+    std::ifstream ifs(filename, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+}
+
+bool WriteCompressed(const std::string &filename, const GraphReader &graph) {
+    return WriteCompressedGraphOutput(filename.c_str(), graph.VertexCount(),
+            [&graph](index_t v) { return graph.ForwardEdges(v); },
+            [&graph](index_t v) { return graph.BackwardEdges(v); });
+}
+
+std::vector<index_t> Sorted(std::span<const index_t> edges) {
+    std::vector<index_t> result(edges.begin(), edges.end());
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+// Checks that `compressed` has the same edges as `graph`, in sorted order.
+void CheckSameEdges(const std::string &graph_name, const GraphReader &graph, const GraphReader &compressed) {
+    Check(!graph.Compressed() && compressed.Compressed(), graph_name, "Compressed()");
+    Check(compressed.VertexCount() == graph.VertexCount(), graph_name, "VertexCount()");
+    Check(compressed.EdgeCount() == graph.EdgeCount(), graph_name, "EdgeCount()");
+    if (compressed.VertexCount() != graph.VertexCount()) return;
+
+    std::vector<index_t> buffer, unused;
+    bool degrees_match = true, forward_match = true, backward_match = true, buffer_unused = true;
+    for (index_t v = 0; v < graph.VertexCount(); ++v) {
+        degrees_match &= compressed.ForwardDegree(v) == graph.ForwardDegree(v) &&
+                compressed.BackwardDegree(v) == graph.BackwardDegree(v) &&
+                graph.ForwardDegree(v) == graph.ForwardEdges(v).size() &&
+                graph.BackwardDegree(v) == graph.BackwardEdges(v).size();
+        auto expected_forward = Sorted(graph.ForwardEdges(v, unused));
+        auto expected_backward = Sorted(graph.BackwardEdges(v, unused));
+        forward_match &= std::ranges::equal(compressed.ForwardEdges(v, buffer), expected_forward) &&
+                std::ranges::equal(compressed.ForwardEdges(v), expected_forward);
+        backward_match &= std::ranges::equal(compressed.BackwardEdges(v, buffer), expected_backward) &&
+                std::ranges::equal(compressed.BackwardEdges(v), expected_backward);
+        buffer_unused &= unused.empty();
+    }
+    Check(degrees_match, graph_name, "degrees");
+    Check(forward_match, graph_name, "forward edges");
+    Check(backward_match, graph_name, "backward edges");
+    Check(buffer_unused, graph_name, "uncompressed graph does not use the buffer");
+}
+
+void TestCompress(const char *filename) {
+    std::unique_ptr<GraphReader> graph = GraphReader::Open(filename, {});
+    if (graph == nullptr) {
+        Check(false, filename, "open");
+        return;
+    }
+    const std::string compressed_filename = TempFilename("graph-reader_test", ".graph");
+    const std::string recompressed_filename = TempFilename("graph-reader_test", "-2.graph");
+    if (!WriteCompressed(compressed_filename, *graph)) {
+        Check(false, filename, "write compressed graph");
+        return;
+    }
+    std::unique_ptr<GraphReader> compressed = GraphReader::Open(compressed_filename.c_str(), {});
+    if (compressed == nullptr) {
+        Check(false, filename, "open compressed graph");
+    } else {
+        CheckSameEdges(filename, *graph, *compressed);
+
+        // Compressing a compressed graph gives the same file.
+        Check(WriteCompressed(recompressed_filename, *compressed) &&
+                ReadFile(recompressed_filename) == ReadFile(compressed_filename),
+                filename, "recompress");
+    }
+    std::filesystem::remove(compressed_filename);
+    std::filesystem::remove(recompressed_filename);
+}
+
+// Opens the graph file with each huge pages mode, and checks that the edges
+// are the same as with normal pages. Whether huge pages are actually used
+// depends on the system, so only the fallbacks are checked.
+void TestHugePages(const std::string &filename) {
+    using HugePages = GraphReader::OpenOptions::HugePages;
+    std::unique_ptr<GraphReader> graph = GraphReader::Open(filename.c_str(), {});
+    if (graph == nullptr) {
+        Check(false, filename, "open");
+        return;
+    }
+    Check(graph->HugePagesMode() == HugePages::NONE, filename, "HugePagesMode() by default");
+    for (HugePages huge_pages : {HugePages::FILE, HugePages::TRANSPARENT, HugePages::HUGETLB}) {
+        const std::string what = "huge_pages=" + std::to_string(static_cast<int>(huge_pages)) + ": ";
+        std::unique_ptr<GraphReader> copy = GraphReader::Open(filename.c_str(), {.huge_pages = huge_pages});
+        if (copy == nullptr) {
+            Check(false, filename, what + "open");
+            continue;
+        }
+        const HugePages mode = copy->HugePagesMode();
+        Check(mode == huge_pages || mode == HugePages::NONE ||
+                (huge_pages == HugePages::HUGETLB && mode == HugePages::TRANSPARENT),
+                filename, what + "HugePagesMode()");
+        Check(copy->VertexCount() == graph->VertexCount() && copy->EdgeCount() == graph->EdgeCount() &&
+                copy->Compressed() == graph->Compressed(), filename, what + "header");
+        if (copy->VertexCount() != graph->VertexCount()) continue;
+        std::vector<index_t> buffer, copy_buffer;
+        bool edges_match = true;
+        for (index_t v = 0; v < graph->VertexCount(); ++v) {
+            edges_match &= std::ranges::equal(copy->ForwardEdges(v, copy_buffer), graph->ForwardEdges(v, buffer)) &&
+                    std::ranges::equal(copy->BackwardEdges(v, copy_buffer), graph->BackwardEdges(v, buffer));
+        }
+        Check(edges_match, filename, what + "edges");
+    }
+}
+
+// Waits until the graph is no longer loading, for at most 10 seconds.
+GraphReader::LoadStatus WaitForLoad(const GraphReader &graph) {
+    for (int i = 0; i < 1000 && graph.GetLoadStatus().state == GraphReader::LoadStatus::State::IN_PROGRESS; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return graph.GetLoadStatus();
+}
+
+void TestLoadStatus(const std::string &filename) {
+    using MLock = GraphReader::OpenOptions::MLock;
+    using State = GraphReader::LoadStatus::State;
+    const size_t file_size = std::filesystem::file_size(filename);
+    {
+        std::unique_ptr<GraphReader> graph = GraphReader::Open(filename.c_str(), {});
+        GraphReader::LoadStatus status = graph->GetLoadStatus();
+        Check(status.state == State::NONE && status.bytes_loaded == 0 && status.bytes_total == file_size &&
+                status.elapsed_s == 0, filename, "load status without mlock");
+    }
+    {
+        std::unique_ptr<GraphReader> graph = GraphReader::Open(filename.c_str(), {.mlock = MLock::POPULATE});
+        GraphReader::LoadStatus status = graph->GetLoadStatus();
+        Check(status.state == State::COMPLETED && status.bytes_loaded == file_size, filename,
+                "load status with MLock::POPULATE");
+    }
+    for (int threads : {1, 3}) {
+        for (bool lock : {false, true}) {
+            const std::string what = "MLock::PARALLEL threads=" + std::to_string(threads) +
+                (lock ? " with mlock: " : ": ");
+            std::unique_ptr<GraphReader> graph = GraphReader::Open(filename.c_str(), {
+                    .mlock = MLock::PARALLEL, .warm_up_threads = threads, .warm_up_mlock = lock});
+            GraphReader::LoadStatus status = WaitForLoad(*graph);
+            // mlock() may fail without privileges.
+            Check(status.state == State::COMPLETED || (lock && status.state == State::FAILED),
+                    filename, what + "state");
+            Check(status.bytes_loaded == file_size && status.bytes_total == file_size, filename, what + "bytes");
+            Check(status.elapsed_s > 0 && status.elapsed_s == graph->GetLoadStatus().elapsed_s,
+                    filename, what + "elapsed time");
+        }
+    }
+
+    // Destroying the reader stops loading, before the graph is unmapped.
+    for (int i = 0; i < 10; ++i) {
+        GraphReader::Open(filename.c_str(), {.mlock = MLock::PARALLEL, .warm_up_threads = 4}).reset();
+    }
+    // Destroying the reader waits for a background mlock() to return.
+    for (int i = 0; i < 10; ++i) {
+        GraphReader::Open(filename.c_str(), {.mlock = MLock::BACKGROUND}).reset();
+    }
+    {
+        std::unique_ptr<GraphReader> graph = GraphReader::Open(filename.c_str(), {.mlock = MLock::BACKGROUND});
+        GraphReader::LoadStatus status = WaitForLoad(*graph);
+        Check(status.state == State::COMPLETED || status.state == State::FAILED, filename,
+                "load status with MLock::BACKGROUND");
+    }
+}
+
+// Copies the graph to NUMA nodes. The machine may have any number of nodes,
+// so copies are requested explicitly for the first online node (which always
+// works, even without NUMA support) and for a node that is not online.
+void TestNumaReplicas(const std::string &filename) {
+    using HugePages = GraphReader::OpenOptions::HugePages;
+    const std::vector<int> online = OnlineNumaNodes();
+    const int offline = online.back() + 1;
+    std::unique_ptr<GraphReader> graph = GraphReader::Open(filename.c_str(), {});
+    if (graph == nullptr) {
+        Check(false, filename, "open");
+        return;
+    }
+    Check(graph->NumaReplicaNodes().empty(), filename, "no NUMA replicas by default");
+    Check(&graph->ForCurrentNode() == graph.get(), filename, "ForCurrentNode() without replicas");
+    {
+        std::unique_ptr<GraphReader> copy = GraphReader::Open(filename.c_str(), {.numa_replicas = true});
+        Check(copy != nullptr && copy->NumaReplicaNodes() == (online.size() > 1 ? online : std::vector<int>{}),
+                filename, "NUMA replicas on all online nodes");
+    }
+    for (HugePages huge_pages : {HugePages::NONE, HugePages::TRANSPARENT}) {
+        const std::string what = "huge_pages=" + std::to_string(static_cast<int>(huge_pages)) + ": ";
+        std::unique_ptr<GraphReader> copy = GraphReader::Open(filename.c_str(), {
+                .huge_pages = huge_pages, .numa_replicas = true, .numa_nodes = {offline, online[0], online[0]}});
+        if (copy == nullptr) {
+            Check(false, filename, what + "open with NUMA replicas");
+            continue;
+        }
+        Check(copy->NumaReplicaNodes() == std::vector<int>{online[0]}, filename, what + "NumaReplicaNodes()");
+        Check(&copy->ForNumaNode(offline) == copy.get(), filename, what + "ForNumaNode() without a replica");
+        const GraphReader &replica = copy->ForNumaNode(online[0]);
+        Check(&replica != copy.get(), filename, what + "ForNumaNode() with a replica");
+        Check(CurrentNumaNode() != online[0] || &copy->ForCurrentNode() == &replica,
+                filename, what + "ForCurrentNode()");
+        Check(&replica.ForCurrentNode() == &replica && replica.NumaReplicaNodes().empty(),
+                filename, what + "replicas are not replicated");
+        Check(replica.GetLoadStatus().state == GraphReader::LoadStatus::State::COMPLETED,
+                filename, what + "replica load status");
+        Check(replica.HugePagesMode() == HugePages::TRANSPARENT, filename, what + "replica HugePagesMode()");
+        Check(replica.VertexCount() == graph->VertexCount() && replica.EdgeCount() == graph->EdgeCount() &&
+                replica.Compressed() == graph->Compressed(), filename, what + "replica header");
+        if (replica.VertexCount() != graph->VertexCount()) continue;
+        std::vector<index_t> buffer, replica_buffer;
+        bool edges_match = true;
+        for (index_t v = 0; v < graph->VertexCount(); ++v) {
+            edges_match &= std::ranges::equal(replica.ForwardEdges(v, replica_buffer), graph->ForwardEdges(v, buffer)) &&
+                    std::ranges::equal(replica.BackwardEdges(v, replica_buffer), graph->BackwardEdges(v, buffer));
+        }
+        Check(edges_match, filename, what + "replica edges");
+    }
+}
+
+// Vertices with more edges than a SIMD block, and large gaps. Both files are
+// larger than a huge page (2 MB).
+void TestLargeGraph() {
+    const index_t size = 300000;
+    std::vector<std::vector<index_t>> outlinks(size), inlinks(size);
+    for (index_t v = 1; v < size; v += 997) {
+        for (index_t w = size - 1; w > 0; w /= 3) {
+            outlinks[v].push_back(w);
+            inlinks[w].push_back(v);
+        }
+    }
+    const std::string filename = TempFilename("graph-reader_test", ".graph");
+    const std::string compressed_filename = TempFilename("graph-reader_test", "-2.graph");
+    if (!WriteGraphOutput(filename.c_str(), outlinks, inlinks) ||
+            !WriteCompressedGraphOutput(compressed_filename.c_str(), outlinks, inlinks)) {
+        Check(false, "large", "write graphs");
+        return;
+    }
+    std::unique_ptr<GraphReader> graph = GraphReader::Open(filename.c_str(), {});
+    std::unique_ptr<GraphReader> compressed = GraphReader::Open(compressed_filename.c_str(), {});
+    if (graph == nullptr || compressed == nullptr) {
+        Check(false, "large", "open graphs");
+    } else {
+        CheckSameEdges("large", *graph, *compressed);
+        TestHugePages(filename);
+        TestHugePages(compressed_filename);
+        TestLoadStatus(filename);
+        TestNumaReplicas(compressed_filename);
+    }
+    std::filesystem::remove(filename);
+    std::filesystem::remove(compressed_filename);
+}
+
+void TestUnsupportedVersion() {
+    const std::string filename = TempFilename("graph-reader_test", ".graph");
+    {
+        std::ofstream ofs(filename, std::ios::binary);
+        const uint32_t header[GRAPH_HEADER_FIELD_COUNT] = {graph_header_magic_value, 3, 1, 0};
+        ofs.write(reinterpret_cast<const char*>(header), sizeof(header));
+        const uint32_t index[4] = {};
+        ofs.write(reinterpret_cast<const char*>(index), sizeof(index));
+    }
+    Check(GraphReader::Open(filename.c_str(), {}) == nullptr, filename, "unsupported version");
+    std::filesystem::remove(filename);
+}
+
+}  // namespace
+}  // namespace wikipath
+
+int main() {
+    using namespace wikipath;
+    for (const char *filename : {"testdata/example-1.graph", "testdata/example-2.graph", "testdata/example-3.graph"}) {
+        TestCompress(filename);
+        TestHugePages(filename);
+        TestNumaReplicas(filename);
+    }
+    TestLargeGraph();
+    TestUnsupportedVersion();
+
+    if (failures > 0) {
+        std::cout << failures << " tests failed!\n";
+        return EXIT_FAILURE;
+    } else {
+        std::cout << "All " << successes << " tests passed.\n";
+        return EXIT_SUCCESS;
+    }
+}
@@ -0,0 +1,139 @@
+#include "wikipath/graph-reader.h"
+#include "wikipath/graph-writer.h"
+#include "wikipath/hub-distances.h"
+#include "wikipath/searcher.h"
+
+#include "test-util.h"
+
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <stdlib.h>
+
+namespace wikipath {
+namespace {
+
+// Builds hub distances and checks the bounds for all pairs of vertices, and
+// that searches that use them still find shortest paths.
+void TestHubs(const std::string &graph_name, const GraphReader &graph, int hub_count, int threads) {
+    const std::string what = "hubs=" + std::to_string(hub_count) + " threads=" + std::to_string(threads) + ": ";
+    const std::string filename = TempFilename("hub-distances_test", ".hubs");
+    bool built = BuildHubDistances(graph, filename.c_str(), {.hub_count = hub_count, .threads = threads});
+    Check(built, graph_name, what + "BuildHubDistances()");
+    std::unique_ptr<HubDistances> hubs = HubDistances::Open(filename.c_str());
+    std::filesystem::remove(filename);
+    Check(hubs != nullptr, graph_name, what + "HubDistances::Open()");
+    if (!built || hubs == nullptr) return;
+
+    const index_t size = graph.VertexCount();
+    Check(hubs->VertexCount() == size, graph_name, what + "VertexCount()");
+    Check(hubs->HubCount() == std::min<int>(hub_count, size), graph_name, what + "HubCount()");
+
+    std::vector<std::vector<int>> dist;
+    for (index_t v = 0; v < size; ++v) dist.push_back(ReferenceDistances(graph, v, Direction::FORWARD, HubDistances::UNREACHABLE));
+
+    bool distances_ok = true;
+    for (int i = 0; i < hubs->HubCount(); ++i) {
+        const index_t h = hubs->Hub(i);
+        for (index_t v = 0; v < size; ++v) {
+            distances_ok &= hubs->FromHubs(v)[i] == dist[h][v] && hubs->ToHubs(v)[i] == dist[v][h];
+        }
+    }
+    Check(distances_ok, graph_name, what + "distances to and from hubs");
+
+    const std::pair<std::string, SearchOptions> search_options[] = {
+        {"default", {.hub_distances = hubs.get()}},
+        {"dense", {.sparse_visited_max_fraction = 0, .hub_distances = hubs.get()}},
+        {"bottom-up", {.bottom_up_alpha = 1e9, .bottom_up_beta = 1e9, .bottom_up_min_fringe = 0,
+                .hub_distances = hubs.get()}},
+        {"parallel", {.bottom_up_alpha = 0, .threads = 3, .parallel_min_fringe = 0,
+                .hub_distances = hubs.get()}},
+    };
+    SearchWorkspace workspace;
+    int bound_errors = 0, path_errors = 0, path_via_hub_errors = 0;
+    for (index_t start = 1; start < size; ++start) {
+        for (index_t finish = 1; finish < size; ++finish) {
+            const int d = dist[start][finish];
+            auto [upper, hub] = hubs->UpperBound(start, finish);
+            if (upper < d || hubs->LowerBound(start, finish) > d) ++bound_errors;
+            if (hub >= 0 && !IsShortestPath(graph, start, finish, upper,
+                        hubs->PathViaHub(graph, start, finish, hub), HubDistances::UNREACHABLE)) {
+                ++path_via_hub_errors;
+            }
+            for (const auto &[name, options] : search_options) {
+                std::vector<index_t> path = workspace.FindShortestPath(graph, start, finish, nullptr, options).value;
+                if (!IsShortestPath(graph, start, finish, d, path, HubDistances::UNREACHABLE)) {
+                    if (path_errors++ == 0) {
+                        Check(false, graph_name, what + name + " FindShortestPath(" +
+                                std::to_string(start) + ", " + std::to_string(finish) + ")");
+                    }
+                }
+            }
+        }
+    }
+    Check(bound_errors == 0, graph_name, what + "UpperBound() and LowerBound() for all pairs");
+    Check(path_via_hub_errors == 0, graph_name, what + "PathViaHub() for all pairs");
+    Check(path_errors == 0, graph_name, what + "FindShortestPath() with hub distances for all pairs");
+
+    // Filtered searches ignore the hubs, whose distances would be wrong.
+    SearchFilter filter;
+    filter.BanVertex(hubs->Hub(0));
+    for (index_t start = 1; start < size; ++start) {
+        for (index_t finish = 1; finish < size; ++finish) {
+            std::vector<index_t> path = workspace.FindShortestPath(
+                    graph, start, finish, nullptr, search_options[0].second, {}, &filter).value;
+            std::vector<index_t> expected = FindShortestPath(graph, start, finish, nullptr, {}, {}, &filter).value;
+            if (path.size() != expected.size()) ++path_errors;
+        }
+    }
+    Check(path_errors == 0, graph_name, what + "filtered FindShortestPath() with hub distances");
+}
+
+void TestRandomGraph(int edges_per_vertex) {
+    std::string filename = TempFilename("hub-distances_test", ".graph");
+    if (!WriteRandomGraph(filename.c_str(), 300, edges_per_vertex, 42)) {
+        Check(false, filename, "write random graph");
+        return;
+    }
+    std::unique_ptr<GraphReader> graph = GraphReader::Open(filename.c_str(), {});
+    std::filesystem::remove(filename);
+    if (graph == nullptr) {
+        Check(false, filename, "open random graph");
+        return;
+    }
+    const std::string graph_name = "random (" + std::to_string(edges_per_vertex) + " edges per vertex)";
+    TestHubs(graph_name, *graph, 1, 1);
+    TestHubs(graph_name, *graph, 16, 3);
+}
+
+}  // namespace
+}  // namespace wikipath
+
+int main() {
+    using namespace wikipath;
+    for (const char *filename : {"testdata/example-1.graph", "testdata/example-2.graph", "testdata/example-3.graph"}) {
+        std::unique_ptr<GraphReader> graph = GraphReader::Open(filename, {});
+        if (graph == nullptr) {
+            std::cout << "Could not open " << filename << "!\n";
+            return EXIT_FAILURE;
+        }
+        for (int hub_count : {1, 3, 100}) TestHubs(filename, *graph, hub_count, 2);
+    }
+    for (int edges_per_vertex : {1, 2, 4}) TestRandomGraph(edges_per_vertex);
+
+    if (HubDistances::Open("testdata/example-1.graph") != nullptr) {
+        Check(false, "testdata/example-1.graph", "HubDistances::Open() rejects a graph file");
+    }
+
+    if (failures > 0) {
+        std::cout << failures << " tests failed!\n";
+        return EXIT_FAILURE;
+    } else {
+        std::cout << "All " << successes << " tests passed.\n";
+        return EXIT_SUCCESS;
+    }
+}
@@ -0,0 +1,114 @@
+#include "wikipath/neighbor-scan.h"
+
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <stdlib.h>
+
+namespace wikipath {
+namespace {
+
+int successes = 0, failures = 0;
+
+void Check(bool condition, const std::string &what) {
+    if (condition) {
+        ++successes;
+    } else {
+        ++failures;
+        std::cout << "Test failed!\n"
+            << "\tCheck: " << what << "\n";
+    }
+}
+
+// Runs the same scan with `kernel` and the scalar kernel, and checks that the
+// results, the fringes and the visited arrays are identical.
+void CheckSame(ScanKernel kernel, const std::vector<index_t> &neighbors, const std::vector<index_t> &visited,
+        index_t mark, index_t meet_min, index_t meet_count, const std::string &what) {
+    std::vector<index_t> expected_visited = visited, actual_visited = visited;
+    std::vector<index_t> expected_fringe(neighbors.size()), actual_fringe(neighbors.size());
+    ScanResult expected = ScanNeighbors(ScanKernel::SCALAR, neighbors, expected_visited.data(),
+            mark, meet_min, meet_count, expected_fringe.data());
+    ScanResult actual = ScanNeighbors(kernel, neighbors, actual_visited.data(),
+            mark, meet_min, meet_count, actual_fringe.data());
+    expected_fringe.resize(expected.reached);
+    actual_fringe.resize(actual.reached);
+    const std::string prefix = std::string(ScanKernelName(kernel)) + " " + what + ": ";
+    Check(actual.reached == expected.reached && actual.meeting == expected.meeting, prefix + "result");
+    Check(actual_fringe == expected_fringe, prefix + "fringe");
+    Check(actual_visited == expected_visited, prefix + "visited");
+}
+
+void TestScalar() {
+    // Vertex 2 is unvisited, 3 was reached from this side (mark 5) and 4 from
+    // the other side (marks >= 100).
+    std::vector<index_t> visited = {0, 0, 0, 5, 100};
+    std::vector<index_t> fringe(4);
+    std::vector<index_t> neighbors = {2, 3, 2, 4};
+    ScanResult result = ScanNeighbors(ScanKernel::SCALAR, neighbors, visited.data(), 7, 100, 10, fringe.data());
+    Check(result.reached == 1 && fringe[0] == 2 && visited[2] == 7, "scalar marks unvisited neighbors once");
+    Check(result.meeting == 3, "scalar stops at the meeting");
+
+    neighbors = {3, 1};
+    result = ScanNeighbors(ScanKernel::SCALAR, neighbors, visited.data(), 7, 100, 10, fringe.data());
+    Check(result.reached == 1 && result.meeting == 2 && fringe[0] == 1, "scalar without a meeting");
+}
+
+void TestKernel(ScanKernel kernel) {
+    if (!ScanKernelSupported(kernel)) {
+        std::cout << "Skipping unsupported kernel " << ScanKernelName(kernel) << ".\n";
+        return;
+    }
+    std::mt19937 rng(42);
+    const index_t size = 1000;
+    // Forward search: the forward marks are vertex ids, the backward marks are
+    // their complements, as in ContinueSearch().
+    const index_t forward_meet_min = ~(size - 1);
+    for (int round = 0; round < 200; ++round) {
+        const int degree = round % 70;
+        const int range = round % 2 == 0 ? size - 1 : 40;  // small range: many duplicates
+        std::uniform_int_distribution<index_t> vertex(1, range);
+        std::vector<index_t> neighbors(degree);
+        for (index_t &w : neighbors) w = vertex(rng);
+
+        std::vector<index_t> visited(size);
+        std::uniform_int_distribution<int> percent(0, 99);
+        const int backward_percent = round % 3 == 0 ? 0 : round % 3;
+        for (index_t v = 1; v < size; ++v) {
+            int p = percent(rng);
+            if (p < 30) {
+                visited[v] = 1 + v % (size - 1);
+            } else if (p < 30 + backward_percent) {
+                visited[v] = ~(v % size);
+            }
+        }
+        const std::string what = "round " + std::to_string(round) + " (degree " + std::to_string(degree) + ")";
+        CheckSame(kernel, neighbors, visited, 17, forward_meet_min, size, "forward " + what);
+
+        // Backward search: the other side's marks are 0 < v < size.
+        for (index_t &v : visited) {
+            if (v >= size) v = 0;
+            else if (v != 0 && percent(rng) < 50 + backward_percent * 20) v = ~v;
+        }
+        CheckSame(kernel, neighbors, visited, ~index_t{17}, 1, size - 1, "backward " + what);
+    }
+}
+
+}  // namespace
+}  // namespace wikipath
+
+int main() {
+    using namespace wikipath;
+    TestScalar();
+    for (ScanKernel kernel : {ScanKernel::SCALAR, ScanKernel::AVX2, ScanKernel::AVX512}) TestKernel(kernel);
+    Check(ScanKernelSupported(BestScanKernel()), "BestScanKernel() is supported");
+
+    if (failures > 0) {
+        std::cout << failures << " tests failed!\n";
+        return EXIT_FAILURE;
+    } else {
+        std::cout << "All " << successes << " tests passed.\n";
+        return EXIT_SUCCESS;
+    }
+}
@@ -0,0 +1,111 @@
+#include "wikipath/numa.h"
+
+#include <sched.h>
+#include <sys/mman.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <stdlib.h>
+
+namespace {
+
+using namespace wikipath;
+
+int successes = 0, failures = 0;
+
+void Check(bool condition, const std::string &what) {
+    if (condition) {
+        ++successes;
+    } else {
+        ++failures;
+        std::cout << "Test failed!\n"
+            << "\tCheck: " << what << "\n";
+    }
+}
+
+void TestParseCpuList() {
+    struct TestCase {
+        std::string_view list;
+        std::optional<std::vector<int>> expected;
+    };
+    const TestCase test_cases[] = {
+        {"", std::vector<int>{}},
+        {"\n", std::vector<int>{}},
+        {"0\n", std::vector<int>{0}},
+        {"0-3", std::vector<int>{0, 1, 2, 3}},
+        {"0-1,8,10-11\n", std::vector<int>{0, 1, 8, 10, 11}},
+        {"3-3", std::vector<int>{3}},
+        {"3-1", std::nullopt},
+        {"1,,2", std::nullopt},
+        {"0-", std::nullopt},
+        {"-1", std::nullopt},
+        {"x", std::nullopt},
+    };
+    for (const TestCase &test_case : test_cases) {
+        Check(ParseCpuList(test_case.list) == test_case.expected,
+                "ParseCpuList(\"" + std::string(test_case.list) + "\")");
+    }
+}
+
+// Checks the topology of the machine that the test runs on, which may have
+// any number of (real or emulated) nodes.
+void TestTopology() {
+    const std::vector<int> nodes = OnlineNumaNodes();
+    Check(!nodes.empty(), "OnlineNumaNodes() is not empty");
+    Check(std::is_sorted(nodes.begin(), nodes.end()), "OnlineNumaNodes() is sorted");
+
+    const int node = CurrentNumaNode();
+    Check(std::ranges::find(nodes, node) != nodes.end(), "CurrentNumaNode() is online");
+    const std::vector<int> cpus = NumaNodeCpus(node);
+    Check(!cpus.empty(), "NumaNodeCpus(CurrentNumaNode()) is not empty");
+    Check(NumaNodeCpus(nodes.back() + 1).empty(), "NumaNodeCpus() of an offline node is empty");
+
+    for (int n : nodes) {
+        if (NumaNodeCpus(n).empty()) continue;  // memory-only node
+        Check(PinThreadToNumaNode(n), "PinThreadToNumaNode(" + std::to_string(n) + ")");
+        Check(CurrentNumaNode() == n, "CurrentNumaNode() after PinThreadToNumaNode(" + std::to_string(n) + ")");
+    }
+    Check(!PinThreadToNumaNode(nodes.back() + 1), "PinThreadToNumaNode() of an offline node fails");
+}
+
+void TestBindMemory() {
+    const size_t len = 1 << 20;
+    void *p = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) {
+        Check(false, "mmap");
+        return;
+    }
+    const std::vector<int> nodes = OnlineNumaNodes();
+    // Kernels without NUMA support have no mbind() (ENOSYS), and sandboxes
+    // may forbid it (EPERM); both are handled by callers, so are accepted here.
+    bool bound = BindMemoryToNumaNode(p, len, nodes.front());
+    Check(bound || errno == ENOSYS || errno == EPERM, "BindMemoryToNumaNode() to an online node");
+    if (bound) {
+        Check(!BindMemoryToNumaNode(p, len, nodes.back() + 1) && errno == EINVAL,
+                "BindMemoryToNumaNode() to an offline node fails");
+    }
+    Check(!BindMemoryToNumaNode(p, len, -1), "BindMemoryToNumaNode() to a negative node fails");
+    munmap(p, len);
+}
+
+}  // namespace
+
+int main() {
+    TestParseCpuList();
+    TestTopology();
+    TestBindMemory();
+
+    if (failures > 0) {
+        std::cout << failures << " tests failed!\n";
+        return EXIT_FAILURE;
+    } else {
+        std::cout << "All " << successes << " tests passed.\n";
+        return EXIT_SUCCESS;
+    }
+}
@@ -56,7 +56,8 @@ class TestHttpServer(unittest.TestCase):
             graph_filename=GRAPH_FILEPATH,
             host=HOST, port=port,
             docroot='htdocs/',
-            thread_daemon=True)
+            thread_daemon=True,
+            result_cache_mb=1)
         # Verify that the server is running and serving requests.
         with urlopen(Request(self.url_prefix, method='HEAD')) as response:
             assert response.status == 200
@@ -119,6 +120,41 @@ class TestHttpServer(unittest.TestCase):
             self.assertEqual(json['stats']['edges_expanded'], 3)
             self.assertTrue(json['stats']['time_taken_ms'] >= 0)
 
+    def test__api_shortest_path__cached(self):
+        url = f'{self.url_prefix}/api/shortest-path?start={quote(PAGE_RED_TITLE)}&finish={quote(PAGE_BLUE_TITLE)}'
+        responses = []
+        for _ in range(2):
+            with urlopen(url) as response:
+                responses.append(self.responseToJson(response))
+        self.assertEqual(responses[0]['path'], [PAGE_RED, PAGE_BLUE])
+        self.assertEqual(responses[1]['path'], responses[0]['path'])
+        self.assertFalse(responses[0]['stats']['cached'])
+        self.assertTrue(responses[1]['stats']['cached'])
+        self.assertEqual(responses[1]['stats']['vertices_reached'], 0)
+
+    def test__api_shortest_path__avoid(self):
+        url = (f'{self.url_prefix}/api/shortest-path?start={quote(PAGE_ROSE_TITLE)}&finish={quote(PAGE_BLUE_TITLE)}'
+               f'&avoid={quote(PAGE_RED_TITLE)}')
+        with urlopen(url) as response:
+            json = self.responseToJson(response)
+            self.assertEqual([page['page']['id'] for page in json['path']], [PAGE_ROSE_ID, 5, 6, PAGE_BLUE_ID])
+
+    def test__api_shortest_path__avoid_link(self):
+        url = (f'{self.url_prefix}/api/shortest-path?start={quote(PAGE_ROSE_TITLE)}&finish={quote(PAGE_BLUE_TITLE)}'
+               f'&avoid_link={quote(PAGE_RED_TITLE + "|" + PAGE_BLUE_TITLE)}&avoid_link={quote("#6|#3")}')
+        with urlopen(url) as response:
+            json = self.responseToJson(response)
+            self.assertEqual([page['page']['id'] for page in json['path']], [PAGE_ROSE_ID, PAGE_RED_ID, 2, PAGE_BLUE_ID])
+
+    def test__api_shortest_path__avoid_unknown_page(self):
+        url = (f'{self.url_prefix}/api/shortest-path?start={quote(PAGE_ROSE_TITLE)}&finish={quote(PAGE_BLUE_TITLE)}'
+               f'&avoid=nonexistent')
+        try:
+            with urlopen(url) as response:
+                assert False
+        except HTTPError as e:
+            self.assertEqual(e.status, 400)
+
     def test__api_shortest_path__path_not_found(self):
         url = f'{self.url_prefix}/api/shortest-path?start={quote(PAGE_BLUE_TITLE)}&finish={quote(PAGE_ROSE_TITLE)}'
         with urlopen(url) as response:
@@ -1,5 +1,6 @@
 #!/usr/bin/env python3
 
+import time
 import unittest
 import wikipath
 
@@ -15,6 +16,9 @@ class Test_GraphReader(unittest.TestCase):
     def test__edge_count(self):
         self.assertEqual(self.reader.edge_count, 10)
 
+    def test__compressed(self):
+        self.assertEqual(self.reader.compressed, False)
+
     def test__forward_edges(self):
         self.assertEqual(self.reader.forward_edges(1), [2, 3])
 
@@ -40,6 +44,21 @@ class Test_GraphReader(unittest.TestCase):
         self.assertEqual(stats.vertices_expanded, 2)
         self.assertEqual(stats.edges_expanded, 3)
         self.assertTrue(stats.time_taken_ms >= 0)
+        self.assertEqual(stats.levels, [
+            wikipath.SearchLevel(
+                direction=wikipath.SearchLevel.Direction.FORWARD,
+                mode=wikipath.SearchLevel.Mode.TOP_DOWN,
+                fringe_size=1, vertices_expanded=1, edges_expanded=2),
+            wikipath.SearchLevel(
+                direction=wikipath.SearchLevel.Direction.BACKWARD,
+                mode=wikipath.SearchLevel.Mode.TOP_DOWN,
+                fringe_size=1, vertices_expanded=1, edges_expanded=1),
+        ])
+        self.assertTrue(stats.time_taken_ns >= stats.search_ns + stats.reconstruct_ns)
+        self.assertEqual(stats.propagate_ns, 0)
+        self.assertEqual(stats.sort_ns, 0)
+        self.assertTrue(stats.minor_faults >= 0)
+        self.assertTrue(stats.major_faults >= 0)
 
     def test__shortest_path_with_stats__not_found(self):
         path, stats = self.reader.shortest_path_with_stats(1, 4)
@@ -49,6 +68,72 @@ class Test_GraphReader(unittest.TestCase):
         self.assertEqual(stats.edges_expanded, 2)
         self.assertTrue(stats.time_taken_ms >= 0)
 
+    def test__shortest_path__workspace(self):
+        workspace = wikipath.SearchWorkspace()
+        for _ in range(2):
+            self.assertEqual(self.reader.shortest_path(5, 2, workspace=workspace), [5, 6, 3, 2])
+            self.assertEqual(self.reader.shortest_path(1, 4, workspace=workspace), [])
+            path, stats = self.reader.shortest_path_with_stats(4, 2, workspace=workspace)
+            self.assertEqual(path, [4, 1, 2])
+            self.assertEqual(stats.vertices_reached, 4)
+            self.assertEqual(self.reader.shortest_path_dag(4, 2, workspace=workspace), [(1, 2), (4, 1)])
+
+    def test__shortest_path__limits(self):
+        # Limits are checked once per chunk of expanded vertices, so searches
+        # in this tiny graph complete even with a zero timeout.
+        limits = wikipath.SearchLimits(max_edges_expanded=1000, timeout_ms=0)
+        self.assertEqual(repr(limits),
+            'wikipath.SearchLimits(max_vertices_expanded=9223372036854775807, max_edges_expanded=1000, timeout_ms=0)')
+        self.assertEqual(self.reader.shortest_path(5, 2, limits=limits), [5, 6, 3, 2])
+        path, stats = self.reader.shortest_path_with_stats(1, 4, limits=limits)
+        self.assertEqual(path, [])
+        self.assertEqual(stats.abort_reason, wikipath.AbortReason.NONE)
+        edges, stats = self.reader.shortest_path_dag_with_stats(4, 2, limits=limits)
+        self.assertEqual(edges, [(1, 2), (4, 1)])
+        self.assertEqual(stats.abort_reason, wikipath.AbortReason.NONE)
+
+    def test__shortest_path__filter(self):
+        no_red = wikipath.SearchFilter(banned_vertices=[1])
+        self.assertTrue(no_red.is_vertex_banned(1))
+        self.assertFalse(no_red.is_vertex_banned(2))
+        self.assertEqual(self.reader.shortest_path(4, 2, filter=no_red), [4, 5, 6, 3, 2])
+        self.assertEqual(self.reader.shortest_path(4, 1, filter=no_red), [])
+        self.assertEqual(self.reader.shortest_path(1, 1, filter=no_red), [])
+        no_edge = wikipath.SearchFilter(banned_edges=[(1, 2)])
+        self.assertTrue(no_edge.is_edge_banned(1, 2))
+        self.assertFalse(no_edge.is_edge_banned(2, 1))
+        workspace = wikipath.SearchWorkspace()
+        self.assertEqual(self.reader.shortest_path(4, 2, workspace=workspace, filter=no_edge), [4, 1, 3, 2])
+        path, stats = self.reader.shortest_path_with_stats(4, 2, filter=no_edge)
+        self.assertEqual(path, [4, 1, 3, 2])
+        self.assertEqual(self.reader.shortest_path_dag(4, 2, filter=no_edge), [(1, 3), (3, 2), (4, 1)])
+        edges, stats = self.reader.shortest_path_dag_with_stats(4, 2, filter=no_red)
+        self.assertEqual(edges, [(3, 2), (4, 5), (5, 6), (6, 3)])
+        # An empty filter does not change the results.
+        empty = wikipath.SearchFilter()
+        self.assertTrue(empty.empty())
+        self.assertEqual(self.reader.shortest_path(4, 2, filter=empty), [4, 1, 2])
+        empty.ban_vertex(1)
+        empty.ban_edge(6, 3)
+        self.assertEqual(self.reader.shortest_path(4, 2, filter=empty), [])
+
+    def test__shortest_path_length(self):
+        self.assertEqual(self.reader.shortest_path_length(5, 2), 3)
+        self.assertEqual(self.reader.shortest_path_length(4, 4), 0)
+        self.assertEqual(self.reader.shortest_path_length(1, 4), None)
+        workspace = wikipath.SearchWorkspace()
+        self.assertEqual(self.reader.shortest_path_length(5, 2, workspace=workspace), 3)
+
+    def test__compute_distances(self):
+        distances, histogram = self.reader.compute_distances(4)
+        self.assertEqual(list(distances), [255, 1, 2, 2, 0, 1, 2])
+        self.assertEqual(histogram, [1, 2, 3])
+
+    def test__compute_distances__backward(self):
+        distances, histogram = self.reader.compute_distances(4, wikipath.Direction.BACKWARD)
+        self.assertEqual(list(distances), [255, 255, 255, 255, 0, 255, 255])
+        self.assertEqual(histogram, [1])
+
 
 class Test_MetadataReader(unittest.TestCase):
 
@@ -203,11 +288,46 @@ class Test_Reader_OpenOptions(unittest.TestCase):
     def test__mlock(self):
         OpenOptions = wikipath.GraphReader.OpenOptions
         MLock = OpenOptions.MLock
-        for mlock in [MLock.NONE, MLock.FOREGROUND, MLock.BACKGROUND, MLock.POPULATE]:
+        for mlock in [MLock.NONE, MLock.FOREGROUND, MLock.BACKGROUND, MLock.POPULATE, MLock.PARALLEL]:
             reader = wikipath.Reader('testdata/example-1.graph', OpenOptions(mlock=mlock))
             dag = reader.shortest_path_annotated_dag('Rose', 'Red')
             self.assertEqual(len(dag), 1)
 
+    def test__load_status(self):
+        OpenOptions = wikipath.GraphReader.OpenOptions
+        State = wikipath.GraphReader.LoadStatus.State
+        graph = wikipath.GraphReader('testdata/example-1.graph')
+        self.assertEqual(graph.load_status.state, State.NONE)
+        graph = wikipath.GraphReader('testdata/example-1.graph',
+                OpenOptions(mlock=OpenOptions.MLock.PARALLEL, warm_up_threads=4))
+        deadline = time.monotonic() + 10
+        while graph.load_status.state == State.IN_PROGRESS and time.monotonic() < deadline:
+            time.sleep(0.01)
+        status = graph.load_status
+        self.assertEqual(status.state, State.COMPLETED)
+        self.assertEqual(status.bytes_loaded, status.bytes_total)
+
+    def test__huge_pages(self):
+        OpenOptions = wikipath.GraphReader.OpenOptions
+        HugePages = OpenOptions.HugePages
+        for huge_pages in [HugePages.NONE, HugePages.FILE, HugePages.TRANSPARENT, HugePages.HUGETLB]:
+            reader = wikipath.Reader('testdata/example-1.graph', OpenOptions(huge_pages=huge_pages))
+            dag = reader.shortest_path_annotated_dag('Rose', 'Red')
+            self.assertEqual(len(dag), 1)
+            # HUGETLB falls back to TRANSPARENT when no huge pages are reserved.
+            self.assertIn(reader.graph.huge_pages_mode, [huge_pages, HugePages.TRANSPARENT, HugePages.NONE])
+            self.assertGreaterEqual(reader.graph.huge_page_bytes, 0)
+
+    def test__numa_replicas(self):
+        OpenOptions = wikipath.GraphReader.OpenOptions
+        reader = wikipath.Reader('testdata/example-1.graph')
+        self.assertEqual(reader.graph.numa_replica_nodes, [])
+        # Node 0 is online on every machine; node 1000 is not.
+        reader = wikipath.Reader('testdata/example-1.graph', OpenOptions(numa_replicas=True, numa_nodes=[1000, 0]))
+        self.assertEqual(reader.graph.numa_replica_nodes, [0])
+        dag = reader.shortest_path_annotated_dag('Rose', 'Red')
+        self.assertEqual(len(dag), 1)
+
 
 class Test_GraphReader_shortest_path_dag(unittest.TestCase):
 
@@ -247,6 +367,23 @@ class Test_GraphReader_shortest_path_dag(unittest.TestCase):
         self.assertEqual(stats.edges_expanded,    2)
         self.assertTrue(stats.time_taken_ms >= 0)
 
+    def test__near_shortest_paths(self):
+        shortest_length, max_length, edges = self.graph.near_shortest_paths(self.start, self.finish, 0)
+        self.assertEqual((shortest_length, max_length), (5, 5))
+        self.assertEqual(edges, self.graph.shortest_path_dag(self.start, self.finish))
+        shortest_length, max_length, edges = self.graph.near_shortest_paths(self.start, self.finish, 1)
+        self.assertEqual((shortest_length, max_length), (5, 6))
+        self.assertEqual(len(edges), 25)
+        workspace = wikipath.SearchWorkspace()
+        self.assertEqual(self.graph.near_shortest_paths(self.start, self.finish, 1, workspace=workspace)[2], edges)
+
+    def test__near_shortest_paths__not_found(self):
+        self.assertEqual(self.graph.near_shortest_paths(self.finish, self.start, 2), None)
+
+    def test__near_shortest_paths__negative_slack(self):
+        with self.assertRaises(ValueError):
+            self.graph.near_shortest_paths(self.start, self.finish, -1)
+
 
 
 class Test_Reader_shortest_path_annotated_dag(unittest.TestCase):
@@ -271,6 +408,15 @@ class Test_Reader_shortest_path_annotated_dag(unittest.TestCase):
         self.assertEqual(self.reader.shortest_path_annotated_dag(0,   self.finish), None)
         self.assertEqual(self.reader.shortest_path_annotated_dag(999, self.finish), None)
 
+    def test__near_shortest_paths_annotated_dag(self):
+        counts = [len(self.reader.near_shortest_paths_annotated_dag(self.start, self.finish, slack))
+                  for slack in range(3)]
+        self.assertEqual(counts, [7, 22, 53])
+        dag = self.reader.near_shortest_paths_annotated_dag('A2', 'F2', 1)
+        self.assertEqual(dag.max_length, 6)
+        self.assertEqual(len(dag.paths(maxlen=100)), 22)
+        self.assertEqual(self.reader.near_shortest_paths_annotated_dag(self.finish, self.start, 1), None)
+
     def test__shortest_path_annotated_dag__by_name(self):
         self.assertEqual(len(self.reader.shortest_path_annotated_dag('A2', 'F2')), 7)
         self.assertEqual(self.reader.shortest_path_annotated_dag('A2', 'Nonexistent'), None)
@@ -302,6 +448,56 @@ class Test_Reader_shortest_path_annotated_dag(unittest.TestCase):
         self.assertTrue(stats.time_taken_ms >= 0)
 
 
+class Test_ResultCache(unittest.TestCase):
+
+    def setUp(self):
+        self.reader = wikipath.Reader('testdata/example-1.graph')
+        self.cache = wikipath.ResultCache(1 << 20, shard_count=4)
+
+    def test__cached_shortest_path(self):
+        result = self.reader.cached_shortest_path(4, 2, self.cache)
+        self.assertEqual(result.path, [4, 1, 2])
+        self.assertEqual(result.titles, [self.reader.page_title(id) for id in [4, 1, 2]])
+        self.assertEqual(result.link_texts, ['', self.reader.link_text(4, 1), self.reader.link_text(1, 2)])
+        workspace = wikipath.SearchWorkspace()
+        self.assertEqual(self.reader.cached_shortest_path(4, 2, self.cache, workspace=workspace).path, [4, 1, 2])
+        self.assertEqual(self.reader.cached_shortest_path(1, 4, self.cache).path, [])
+        stats = self.cache.stats()
+        self.assertEqual((stats.hits, stats.misses, stats.entries), (1, 2, 2))
+        self.assertTrue(0 < stats.bytes <= self.cache.capacity_bytes)
+
+    def test__cached_shortest_path_with_stats(self):
+        result, stats = self.reader.cached_shortest_path_with_stats(4, 2, self.cache)
+        self.assertEqual(result.path, [4, 1, 2])
+        self.assertEqual(stats.vertices_reached, 4)
+        result, stats = self.reader.cached_shortest_path_with_stats(4, 2, self.cache)
+        self.assertEqual(result.path, [4, 1, 2])
+        self.assertEqual(stats.vertices_reached, 0)
+
+    def test__cached_shortest_path_dag(self):
+        result = self.reader.cached_shortest_path_dag(4, 2, self.cache)
+        self.assertEqual(result.dag, [(1, 2), (4, 1)])
+        self.assertEqual(result.titles, [self.reader.page_title(id) for id in [1, 2, 4]])
+        self.assertEqual(self.reader.cached_shortest_path_dag(1, 4, self.cache).dag, None)
+
+    def test__cached_shortest_path__other_reader(self):
+        self.reader.cached_shortest_path(4, 2, self.cache)
+        same = wikipath.Reader('testdata/example-1.graph')
+        self.assertEqual(same.file_identity, self.reader.file_identity)
+        same.cached_shortest_path(4, 2, self.cache)
+        self.assertEqual(self.cache.stats().hits, 1)
+
+    def test__cached_shortest_path__invalid_page(self):
+        with self.assertRaises(IndexError):
+            self.reader.cached_shortest_path(0, 2, self.cache)
+
+    def test__clear(self):
+        self.reader.cached_shortest_path(4, 2, self.cache)
+        self.cache.clear()
+        stats = self.cache.stats()
+        self.assertEqual((stats.misses, stats.entries, stats.bytes), (1, 0, 0))
+
+
 class Test_AnnotatedPage(unittest.TestCase):
 
     def setUp(self):
@@ -0,0 +1,192 @@
+#include "wikipath/reader.h"
+#include "wikipath/result-cache.h"
+#include "wikipath/searcher.h"
+#include "wikipath/thread-pool.h"
+
+#include <atomic>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <stdlib.h>
+
+namespace wikipath {
+namespace {
+
+int successes = 0, failures = 0;
+
+void Check(bool condition, const std::string &what) {
+    if (condition) {
+        ++successes;
+    } else {
+        ++failures;
+        std::cout << "Test failed!\n"
+            << "\tCheck: " << what << "\n";
+    }
+}
+
+ResultCacheKey Key(index_t start, index_t finish) {
+    return ResultCacheKey{.file_identity = 1, .start = start, .finish = finish};
+}
+
+std::shared_ptr<const CachedResult> PathResult(std::vector<index_t> path) {
+    auto result = std::make_shared<CachedResult>();
+    result->path = std::move(path);
+    return result;
+}
+
+void TestLru() {
+    // Capacity for about 3 small entries in a single shard.
+    auto first = PathResult({1, 2});
+    const size_t capacity = 3 * (first->ByteSize() + 200);
+    ResultCache cache(capacity, 1);
+    Check(cache.CapacityBytes() == capacity, "CapacityBytes()");
+    Check(cache.Lookup(Key(1, 2)) == nullptr, "Lookup() in empty cache");
+
+    cache.Insert(Key(1, 2), first);
+    cache.Insert(Key(2, 3), PathResult({2, 3}));
+    cache.Insert(Key(3, 4), PathResult({3, 4}));
+    Check(cache.Lookup(Key(1, 2)) == first, "Lookup() returns inserted result");
+
+    // Key(2, 3) is now the least recently used entry.
+    cache.Insert(Key(4, 5), PathResult({4, 5}));
+    Check(cache.Lookup(Key(2, 3)) == nullptr, "least recently used entry evicted");
+    Check(cache.Lookup(Key(1, 2)) == first, "recently used entry kept");
+    Check(cache.Lookup(Key(4, 5)) != nullptr, "new entry kept");
+
+    // Keys differ by kind and file identity.
+    Check(cache.Lookup({.file_identity = 1, .start = 1, .finish = 2, .kind = QueryKind::SHORTEST_PATH_DAG}) == nullptr,
+            "Lookup() with different kind");
+    Check(cache.Lookup({.file_identity = 2, .start = 1, .finish = 2}) == nullptr,
+            "Lookup() with different file identity");
+
+    // Replacing an entry does not evict others.
+    auto replacement = PathResult({1, 3, 2});
+    cache.Insert(Key(1, 2), replacement);
+    Check(cache.Lookup(Key(1, 2)) == replacement, "Insert() replaces existing entry");
+
+    // A result larger than the capacity is not cached.
+    auto huge = std::make_shared<CachedResult>();
+    huge->path.resize(capacity);
+    cache.Insert(Key(5, 6), huge);
+    Check(cache.Lookup(Key(5, 6)) == nullptr, "oversized result is not cached");
+
+    ResultCacheStats stats = cache.Stats();
+    Check(stats.hits == 4, "Stats().hits");
+    Check(stats.misses == 5, "Stats().misses");
+    Check(stats.insertions == 5, "Stats().insertions");
+    Check(stats.evictions == 1, "Stats().evictions");
+    Check(stats.entries == 3, "Stats().entries");
+    Check(stats.bytes > 0 && static_cast<size_t>(stats.bytes) <= capacity, "Stats().bytes");
+
+    cache.Clear();
+    stats = cache.Stats();
+    Check(stats.entries == 0 && stats.bytes == 0, "Clear() removes entries");
+    Check(stats.hits == 4, "Clear() keeps counters");
+}
+
+void TestReader() {
+    std::unique_ptr<Reader> reader = Reader::Open("testdata/example-1.graph", {});
+    std::unique_ptr<Reader> reader2 = Reader::Open("testdata/example-1.graph", {});
+    std::unique_ptr<Reader> other_reader = Reader::Open("testdata/example-2.graph", {});
+    if (reader == nullptr || reader2 == nullptr || other_reader == nullptr) {
+        Check(false, "Reader::Open()");
+        return;
+    }
+    Check(reader->FileIdentity() == reader2->FileIdentity(), "FileIdentity() of the same files");
+    Check(reader->FileIdentity() != other_reader->FileIdentity(), "FileIdentity() of different files");
+
+    ResultCache cache(1 << 20);
+    SearchWorkspace workspace;
+    auto result = cache.ShortestPath(*reader, 4, 2, nullptr, &workspace);
+    if (result == nullptr) {
+        Check(false, "ShortestPath() returns a result");
+        return;
+    }
+    Check(result->path == std::vector<index_t>{4, 1, 2}, "ShortestPath() path");
+    bool titles_ok = result->titles.size() == 3 && result->link_texts.size() == 3 && result->link_texts[0].empty();
+    for (size_t i = 0; titles_ok && i < 3; ++i) {
+        titles_ok = result->titles[i] == reader->PageTitle(result->path[i]) &&
+                (i == 0 || result->link_texts[i] == reader->LinkText(result->path[i - 1], result->path[i]));
+    }
+    Check(titles_ok, "ShortestPath() titles and link texts");
+    SearchStats stats;
+    Check(cache.ShortestPath(*reader2, 4, 2, &stats) == result, "ShortestPath() hit with another reader of the same files");
+    Check(stats.vertices_reached == 0, "ShortestPath() resets stats on a hit");
+    Check(cache.ShortestPath(*other_reader, 4, 2) != result, "ShortestPath() miss with different files");
+
+    auto not_found = cache.ShortestPath(*reader, 1, 4, &stats);
+    Check(stats.vertices_reached == 4, "ShortestPath() returns stats on a miss");
+    Check(not_found != nullptr && not_found->path.empty() && not_found->titles.empty(),
+            "ShortestPath() without a path");
+    Check(cache.ShortestPath(*reader, 1, 4) == not_found, "ShortestPath() caches that there is no path");
+
+    auto dag = cache.ShortestPathDag(*reader, 4, 2);
+    Check(dag != nullptr && dag->dag == FindShortestPathDag(reader->Graph(), 4, 2, nullptr).value, "ShortestPathDag() edges");
+    Check(dag != nullptr && dag->titles == std::vector<std::string>{
+            reader->PageTitle(1), reader->PageTitle(2), reader->PageTitle(4)}, "ShortestPathDag() titles");
+    Check(cache.ShortestPathDag(*reader, 4, 2) == dag, "ShortestPathDag() hit");
+    auto self_dag = cache.ShortestPathDag(*reader, 3, 3);
+    Check(self_dag != nullptr && self_dag->dag && self_dag->dag->empty() &&
+            self_dag->titles == std::vector<std::string>{reader->PageTitle(3)}, "ShortestPathDag() from a vertex to itself");
+    auto no_dag = cache.ShortestPathDag(*reader, 1, 4);
+    Check(no_dag != nullptr && !no_dag->dag, "ShortestPathDag() without a path");
+
+    ResultCacheStats cache_stats = cache.Stats();
+    Check(cache_stats.hits == 3 && cache_stats.misses == 6, "Stats() after searches");
+}
+
+// Runs the same queries from multiple threads on a small cache, so that
+// entries are evicted concurrently with lookups.
+void TestConcurrent() {
+    std::unique_ptr<Reader> reader = Reader::Open("testdata/example-3.graph", {});
+    if (reader == nullptr) {
+        Check(false, "Reader::Open()");
+        return;
+    }
+    const index_t size = reader->Graph().VertexCount();
+    std::vector<std::vector<index_t>> expected;
+    for (index_t start = 1; start < size; ++start) {
+        for (index_t finish = 1; finish < size; ++finish) {
+            expected.push_back(FindShortestPath(reader->Graph(), start, finish, nullptr).value);
+        }
+    }
+
+    ResultCache cache(4096, 4);
+    ThreadPool pool(4);
+    std::vector<SearchWorkspace> workspaces(pool.ThreadCount());
+    std::atomic<int> mismatches = 0;
+    const size_t rounds = 20;
+    pool.ParallelFor(0, rounds * expected.size(), 7, [&](int thread_index, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const size_t j = i % expected.size();
+            const index_t start = 1 + j / (size - 1);
+            const index_t finish = 1 + j % (size - 1);
+            auto result = cache.ShortestPath(*reader, start, finish, nullptr, &workspaces[thread_index]);
+            if (result == nullptr || result->path != expected[j]) ++mismatches;
+        }
+    });
+    Check(mismatches == 0, "concurrent ShortestPath() results");
+    ResultCacheStats stats = cache.Stats();
+    Check(stats.hits + stats.misses == static_cast<int64_t>(rounds * expected.size()), "concurrent Stats() counts");
+    Check(stats.evictions > 0, "concurrent evictions");
+    Check(static_cast<size_t>(stats.bytes) <= cache.CapacityBytes(), "concurrent Stats().bytes");
+}
+
+}  // namespace
+}  // namespace wikipath
+
+int main() {
+    wikipath::TestLru();
+    wikipath::TestReader();
+    wikipath::TestConcurrent();
+
+    if (wikipath::failures > 0) {
+        std::cout << wikipath::failures << " tests failed!\n";
+        return EXIT_FAILURE;
+    } else {
+        std::cout << "All " << wikipath::successes << " tests passed.\n";
+        return EXIT_SUCCESS;
+    }
+}
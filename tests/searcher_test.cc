@@ -0,0 +1,672 @@
+#include "wikipath/annotated-dag.h"
+#include "wikipath/graph-reader.h"
+#include "wikipath/graph-writer.h"
+#include "wikipath/multi-source-search.h"
+#include "wikipath/numa.h"
+#include "wikipath/searcher.h"
+
+#include "test-util.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <random>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <stdlib.h>
+
+namespace wikipath {
+namespace {
+
+// Returns the edges that occur on some shortest path from `start` to `finish`,
+// calculated from the forward distances of all vertices.
+std::vector<std::pair<index_t, index_t>> ReferenceDag(
+        const GraphReader &graph, const std::vector<std::vector<int>> &dist,
+        index_t start, index_t finish) {
+    std::vector<std::pair<index_t, index_t>> edges;
+    int d = dist[start][finish];
+    for (index_t v = 0; v < graph.VertexCount(); ++v) {
+        if (dist[start][v] < 0) continue;
+        for (index_t w : graph.ForwardEdges(v)) {
+            if (dist[w][finish] >= 0 && dist[start][v] + 1 + dist[w][finish] == d) {
+                edges.push_back({v, w});
+            }
+        }
+    }
+    return edges;
+}
+
+// Searches are run both with a temporary workspace and with `workspace`, which
+// is shared between all graphs to verify that it is reset correctly.
+void TestAllPairs(const std::string &graph_name, const GraphReader &graph, SearchWorkspace &workspace) {
+    const index_t size = graph.VertexCount();
+    std::vector<std::vector<int>> dist;
+    for (index_t v = 0; v < size; ++v) dist.push_back(ReferenceDistances(graph, v));
+
+    const double sparse_fractions[] = {0.0, 0.01, 0.3, 1.0};
+
+    // Top-down only, the default heuristic without a minimum fringe size,
+    // bottom-up whenever possible, and top-down levels on multiple threads.
+    const std::pair<std::string, SearchOptions> search_options[] = {
+        {"top-down", {.bottom_up_alpha = 0}},
+        {"heuristic", {.bottom_up_min_fringe = 0}},
+        {"bottom-up", {.bottom_up_alpha = 1e9, .bottom_up_beta = 1e9, .bottom_up_min_fringe = 0}},
+        {"parallel", {.bottom_up_alpha = 0, .threads = 3, .parallel_min_fringe = 0}},
+        {"layered", {.layered = true}},
+        {"sorted", {.bottom_up_alpha = 0, .sort_fringes = true}},
+    };
+
+    for (index_t start = 1; start < size; ++start) {
+        for (index_t finish = 1; finish < size; ++finish) {
+            int d = dist[start][finish];
+            std::optional<std::vector<std::pair<index_t, index_t>>> expected_dag;
+            if (d >= 0) expected_dag = ReferenceDag(graph, dist, start, finish);
+
+            // d is -1 if no path exists.
+            Check(ShortestPathLength(graph, start, finish, nullptr).value.value_or(-1) == d,
+                    graph_name, "ShortestPathLength()", start, finish);
+            Check(workspace.ShortestPathLength(graph, start, finish, nullptr).value.value_or(-1) == d,
+                    graph_name, "SearchWorkspace::ShortestPathLength()", start, finish);
+
+            for (auto [name, options] : search_options) {
+                // Starting threads for every search is slow, so parallel
+                // searches only use the shared workspace.
+                const bool temporary = options.threads == 1;
+
+                for (double fraction : sparse_fractions) {
+                    options.sparse_visited_max_fraction = fraction;
+                    std::string what = "FindShortestPath() " + name +
+                            " with sparse_visited_max_fraction=" + std::to_string(fraction);
+                    if (temporary) {
+                        std::vector<index_t> path = FindShortestPath(graph, start, finish, nullptr, options).value;
+                        Check(IsShortestPath(graph, start, finish, d, path), graph_name, what, start, finish);
+                    }
+                    std::vector<index_t> path = workspace.FindShortestPath(graph, start, finish, nullptr, options).value;
+                    Check(IsShortestPath(graph, start, finish, d, path), graph_name,
+                            "SearchWorkspace::" + what, start, finish);
+                }
+
+                std::string what = "FindShortestPathDag() " + name + " returns all shortest path edges";
+                if (temporary) {
+                    Check(FindShortestPathDag(graph, start, finish, nullptr, options).value == expected_dag,
+                            graph_name, what, start, finish);
+                }
+                Check(workspace.FindShortestPathDag(graph, start, finish, nullptr, options).value == expected_dag,
+                        graph_name, "SearchWorkspace::" + what, start, finish);
+            }
+        }
+    }
+}
+
+// Checks that filtered searches return the same results as searches in a copy
+// of the graph from which the banned vertices and edges were removed.
+void TestFilter(const std::string &graph_name, const GraphReader &graph, SearchWorkspace &workspace, unsigned seed) {
+    const index_t size = graph.VertexCount();
+    std::mt19937 rng(seed);
+    SearchFilter filter;
+    for (index_t v = 1; v < size; ++v) {
+        if (rng() % 8 == 0) filter.BanVertex(v);
+    }
+    for (index_t v = 1; v < size; ++v) {
+        for (index_t w : graph.ForwardEdges(v)) {
+            if (rng() % 16 == 0) filter.BanEdge(v, w);
+        }
+    }
+
+    std::vector<std::vector<index_t>> outlinks(size), inlinks(size);
+    for (index_t v = 1; v < size; ++v) {
+        for (index_t w : graph.ForwardEdges(v)) {
+            if (filter.AllowsEdge(v, w)) {
+                outlinks[v].push_back(w);
+                inlinks[w].push_back(v);
+            }
+        }
+    }
+    std::string filename = TempFilename("searcher_test", "-filtered.graph");
+    if (!WriteGraphOutput(filename.c_str(), outlinks, inlinks)) {
+        Check(false, graph_name, "write filtered graph", 0, 0);
+        return;
+    }
+    std::unique_ptr<GraphReader> filtered = GraphReader::Open(filename.c_str(), {});
+    std::filesystem::remove(filename);
+    if (filtered == nullptr) {
+        Check(false, graph_name, "open filtered graph", 0, 0);
+        return;
+    }
+
+    std::vector<std::vector<int>> dist;
+    for (index_t v = 0; v < size; ++v) dist.push_back(ReferenceDistances(*filtered, v));
+
+    const std::pair<std::string, SearchOptions> search_options[] = {
+        {"top-down", {.bottom_up_alpha = 0}},
+        {"bottom-up", {.bottom_up_alpha = 1e9, .bottom_up_beta = 1e9, .bottom_up_min_fringe = 0}},
+        {"parallel", {.bottom_up_alpha = 0, .threads = 3, .parallel_min_fringe = 0}},
+        {"sparse", {.sparse_visited_max_fraction = 1.0}},
+        {"layered", {.layered = true}},
+    };
+    for (index_t start = 1; start < size; ++start) {
+        for (index_t finish = 1; finish < size; ++finish) {
+            // Banned vertices are isolated in the filtered graph, but even the
+            // empty path from a banned vertex to itself is not allowed.
+            const bool banned = filter.IsVertexBanned(start) || filter.IsVertexBanned(finish);
+            const int d = banned ? -1 : dist[start][finish];
+            std::optional<std::vector<std::pair<index_t, index_t>>> expected_dag;
+            if (d >= 0) expected_dag = ReferenceDag(*filtered, dist, start, finish);
+            for (const auto &[name, options] : search_options) {
+                std::vector<index_t> path = workspace.FindShortestPath(graph, start, finish, nullptr, options, {}, &filter).value;
+                Check(IsShortestPath(*filtered, start, finish, d, path), graph_name,
+                        "FindShortestPath() " + name + " with filter", start, finish);
+                Check(workspace.FindShortestPathDag(graph, start, finish, nullptr, options, {}, &filter).value == expected_dag,
+                        graph_name, "FindShortestPathDag() " + name + " with filter", start, finish);
+            }
+        }
+    }
+    Check(FindShortestPath(graph, 1, 1, nullptr, {}, {}, &filter).value.empty() == filter.IsVertexBanned(1),
+            graph_name, "FindShortestPath() with filter and a temporary workspace", 1, 1);
+}
+
+// Returns the number of walks from `start` of at most `max_length` edges that
+// end when they first reach `finish`, calculated by dynamic programming.
+int64_t ReferenceWalkCount(const GraphReader &graph, index_t start, index_t finish, int max_length) {
+    std::vector<int64_t> count(graph.VertexCount(), 0);
+    count[start] = 1;
+    int64_t total = 0;
+    for (int length = 0; length <= max_length; ++length) {
+        total += count[finish];
+        std::vector<int64_t> next(graph.VertexCount(), 0);
+        for (index_t v = 0; v < graph.VertexCount(); ++v) {
+            if (v == finish || count[v] == 0) continue;
+            for (index_t w : graph.ForwardEdges(v)) next[w] += count[v];
+        }
+        count.swap(next);
+    }
+    return total;
+}
+
+// Returns whether `path` is a walk from `start` to `finish` in `graph` of at
+// most `max_length` edges, that reaches `finish` only at the end.
+bool IsNearShortestWalk(
+        const GraphReader &graph, index_t start, index_t finish, int max_length,
+        AnnotatedDag::path_t path) {
+    if (path.empty() || path.size() > static_cast<size_t>(max_length)) return false;
+    if (path.front()->Src()->Id() != start || path.back()->Dst()->Id() != finish) return false;
+    for (size_t i = 0; i < path.size(); ++i) {
+        index_t v = path[i]->Src()->Id(), w = path[i]->Dst()->Id();
+        if (v == finish || !HasEdge(graph, v, w)) return false;
+        if (i > 0 && path[i - 1]->Dst()->Id() != v) return false;
+    }
+    return true;
+}
+
+// Checks FindNearShortestPaths() against distances calculated with a simple
+// breadth-first search, and checks that AnnotatedDag counts and enumerates the
+// walks of the result correctly. Walks are only enumerated if there are at
+// most `max_enumerate` of them.
+void TestNearShortestPaths(
+        const std::string &graph_name, const GraphReader &graph, SearchWorkspace &workspace,
+        int64_t max_enumerate) {
+    const index_t size = graph.VertexCount();
+    std::vector<std::vector<int>> forward_dist, backward_dist;
+    for (index_t v = 0; v < size; ++v) {
+        forward_dist.push_back(ReferenceDistances(graph, v, Direction::FORWARD));
+        backward_dist.push_back(ReferenceDistances(graph, v, Direction::BACKWARD));
+    }
+    for (index_t start = 1; start < size; ++start) {
+        for (index_t finish = 1; finish < size; ++finish) {
+            const int d = forward_dist[start][finish];
+            for (int slack = 0; slack <= 2; ++slack) {
+                const std::string what = "FindNearShortestPaths() with slack=" + std::to_string(slack);
+                std::optional<NearShortestPaths> result =
+                        workspace.FindNearShortestPaths(graph, start, finish, slack, nullptr).value;
+                Check(FindNearShortestPaths(graph, start, finish, slack, nullptr).value.has_value() == result.has_value(),
+                        graph_name, what + " with a temporary workspace", start, finish);
+                if (d < 0) {
+                    Check(!result, graph_name, what + " returns nothing without a path", start, finish);
+                    continue;
+                }
+                if (!result) {
+                    Check(false, graph_name, what + " returns a result", start, finish);
+                    continue;
+                }
+                const int max_length = d + slack;
+                Check(result->shortest_length == d && result->max_length == max_length,
+                        graph_name, what + " lengths", start, finish);
+
+                // Walks end when they reach finish, so if start == finish,
+                // only the empty walk remains.
+                std::vector<std::pair<index_t, index_t>> expected_edges;
+                for (index_t v = 0; v < size && start != finish; ++v) {
+                    if (v == finish || forward_dist[start][v] < 0) continue;
+                    for (index_t w : graph.ForwardEdges(v)) {
+                        const int dist_w = backward_dist[finish][w];
+                        if (dist_w >= 0 && forward_dist[start][v] + 1 + dist_w <= max_length) {
+                            expected_edges.push_back({v, w});
+                        }
+                    }
+                }
+                Check(result->edges == expected_edges, graph_name, what + " edges", start, finish);
+                if (slack == 0) {
+                    Check(result->edges == FindShortestPathDag(graph, start, finish, nullptr).value,
+                            graph_name, what + " matches FindShortestPathDag()", start, finish);
+                }
+
+                AnnotatedDag dag(nullptr, start, finish, result->edges, result->max_length);
+                const int64_t count = dag.CountPaths();
+                Check(count == ReferenceWalkCount(graph, start, finish, max_length),
+                        graph_name, what + " CountPaths()", start, finish);
+                if (count > max_enumerate) continue;
+
+                int64_t enumerated = 0;
+                bool valid = true;
+                dag.EnumeratePaths([&](AnnotatedDag::path_t path) {
+                    ++enumerated;
+                    if (start != finish) valid = valid && IsNearShortestWalk(graph, start, finish, max_length, path);
+                    return true;
+                });
+                Check(enumerated == count && valid, graph_name, what + " EnumeratePaths()", start, finish);
+
+                int64_t enumerated_with_skip = 0;
+                for (PathEnumerator enumerator(dag, 1); enumerator.HasPath(); enumerator.Advance(1)) {
+                    ++enumerated_with_skip;
+                }
+                Check(enumerated_with_skip == count / 2, graph_name, what + " PathEnumerator with skip",
+                        start, finish);
+            }
+        }
+    }
+}
+
+// Returns whether `distances` matches `expected` (from ReferenceDistances()).
+bool DistancesMatch(const Distances &distances, const std::vector<int> &expected) {
+    std::vector<int64_t> histogram;
+    for (size_t v = 0; v < expected.size(); ++v) {
+        int d = expected[v];
+        if (distances.distance[v] != (d < 0 ? Distances::UNREACHABLE : d)) return false;
+        if (d >= 0) {
+            if (histogram.size() <= static_cast<size_t>(d)) histogram.resize(d + 1);
+            ++histogram[d];
+        }
+    }
+    return distances.distance.size() == expected.size() && distances.histogram == histogram;
+}
+
+void TestDistances(const std::string &graph_name, const GraphReader &graph, SearchWorkspace &workspace) {
+    const std::pair<std::string, SearchOptions> search_options[] = {
+        {"top-down", {.bottom_up_alpha = 0}},
+        {"bottom-up", {.bottom_up_alpha = 1e9, .bottom_up_beta = 1e9, .bottom_up_min_fringe = 0}},
+        {"parallel", {.bottom_up_alpha = 0, .threads = 3, .parallel_min_fringe = 0}},
+    };
+    for (index_t source = 1; source < graph.VertexCount(); ++source) {
+        for (Direction direction : {Direction::FORWARD, Direction::BACKWARD}) {
+            std::vector<int> expected = ReferenceDistances(graph, source, direction);
+            std::string what = std::string(direction == Direction::FORWARD ? "forward" : "backward") +
+                    " ComputeDistances()";
+            Check(DistancesMatch(ComputeDistances(graph, source, direction), expected),
+                    graph_name, what, source, 0);
+            for (const auto &[name, options] : search_options) {
+                Check(DistancesMatch(workspace.ComputeDistances(graph, source, direction, options), expected),
+                        graph_name, what + " " + name, source, 0);
+            }
+        }
+    }
+}
+
+// Computes distance matrices between all vertices (plus a duplicate source
+// and target, to check that those are handled) and compares them to the
+// reference distances.
+void TestDistanceMatrix(const std::string &graph_name, const GraphReader &graph) {
+    std::vector<index_t> vertices;
+    for (index_t v = 1; v < graph.VertexCount(); ++v) vertices.push_back(v);
+    vertices.push_back(1);
+    std::vector<std::vector<int>> dist;
+    for (index_t v : vertices) dist.push_back(ReferenceDistances(graph, v));
+
+    for (int width : {64, 128, 256}) {
+        DistanceMatrix matrix = ComputeDistanceMatrix(graph, vertices, vertices, width);
+        bool match = matrix.source_count == vertices.size() && matrix.target_count == vertices.size();
+        for (size_t i = 0; match && i < vertices.size(); ++i) {
+            for (size_t j = 0; match && j < vertices.size(); ++j) {
+                int d = dist[i][vertices[j]];
+                match = matrix(i, j) == (d < 0 ? DistanceMatrix::UNREACHABLE : d);
+            }
+        }
+        Check(match, graph_name, "ComputeDistanceMatrix() with batch_width=" + std::to_string(width), 0, 0);
+    }
+
+    // A single source and target, in a batch that ends early.
+    DistanceMatrix matrix = ComputeDistanceMatrix(graph, std::span(vertices).first(1), std::span(vertices).last(1));
+    int d = dist[0][vertices.back()];
+    Check(matrix.distance == std::vector<uint8_t>{static_cast<uint8_t>(d < 0 ? DistanceMatrix::UNREACHABLE : d)},
+            graph_name, "ComputeDistanceMatrix() with one source and target", vertices.front(), vertices.back());
+}
+
+// Same values as asserted in python_wikipath_test.py.
+void TestStats(const GraphReader &graph) {
+    SearchStats stats;
+    FindShortestPath(graph, 4, 2, &stats);
+    Check(stats.vertices_reached == 4 && stats.vertices_expanded == 2 && stats.edges_expanded == 3,
+            "example-1", "FindShortestPath() stats", 4, 2);
+    Check(stats.levels == std::vector<SearchLevel>{
+                {SearchLevel::Direction::FORWARD, SearchLevel::Mode::TOP_DOWN, 1, 1, 2},
+                {SearchLevel::Direction::BACKWARD, SearchLevel::Mode::TOP_DOWN, 1, 1, 1}},
+            "example-1", "FindShortestPath() levels", 4, 2);
+    Check(stats.time_taken_ns >= stats.search_ns + stats.reconstruct_ns &&
+            stats.propagate_ns == 0 && stats.sort_ns == 0 &&
+            stats.minor_faults >= 0 && stats.major_faults >= 0,
+            "example-1", "FindShortestPath() timings", 4, 2);
+
+    FindShortestPath(graph, 4, 2, &stats, {.bottom_up_alpha = 1e9, .bottom_up_beta = 1e9, .bottom_up_min_fringe = 0});
+    Check(stats.levels == std::vector<SearchLevel>{
+                {SearchLevel::Direction::FORWARD, SearchLevel::Mode::BOTTOM_UP, 1, 5, 10},
+                {SearchLevel::Direction::BACKWARD, SearchLevel::Mode::BOTTOM_UP, 1, 1, 1}},
+            "example-1", "FindShortestPath() bottom-up levels", 4, 2);
+
+    FindShortestPathDag(graph, 4, 2, &stats);
+    Check(stats.time_taken_ns >= stats.search_ns + stats.propagate_ns + stats.sort_ns &&
+            stats.reconstruct_ns == 0,
+            "example-1", "FindShortestPathDag() timings", 4, 2);
+
+    auto result = FindShortestPath(graph, 1, 4, &stats);
+    Check(stats.vertices_reached == 4 && stats.vertices_expanded == 2 && stats.edges_expanded == 2,
+            "example-1", "FindShortestPath() stats when no path exists", 1, 4);
+    Check(result.value.empty() && !result.Aborted() && stats.abort_reason == AbortReason::NONE,
+            "example-1", "FindShortestPath() is not aborted when no path exists", 1, 4);
+}
+
+// Checks that the page faults of a search do not include those of another
+// thread, which keeps faulting in fresh memory while the searches run.
+void TestFaultCounts(const GraphReader &graph, SearchWorkspace &workspace) {
+    constexpr size_t buffer_size = 16 << 20;
+    std::atomic<bool> stop = false;
+    std::atomic<int> passes = 0;
+    std::atomic<int64_t> checksum = 0;
+    std::thread toucher([&]() {
+        while (!stop.load()) {
+            std::vector<char> buffer(buffer_size, 1);
+            checksum += buffer[passes.load() % buffer_size];
+            ++passes;
+        }
+    });
+    int64_t minor_faults = 0;
+    while (passes.load() < 3) {
+        SearchStats stats;
+        workspace.FindShortestPath(graph, 4, 2, &stats);
+        minor_faults += stats.minor_faults;
+    }
+    stop = true;
+    toucher.join();
+    // Each pass faults in buffer_size / 4096 pages.
+    Check(minor_faults < static_cast<int64_t>(buffer_size / 4096),
+            "example-1", "FindShortestPath() counts only its own page faults", 4, 2);
+}
+
+// Runs the tests on a random graph in the uncompressed format, and on a
+// smaller one (since all pairs are tested) in the compressed format.
+void TestRandomGraph(SearchWorkspace &workspace) {
+    for (bool compressed : {false, true}) {
+        std::string filename = TempFilename("searcher_test", ".graph");
+        if (!WriteRandomGraph(filename.c_str(), compressed ? 120 : 300, 2, 42, compressed)) {
+            Check(false, filename, "write random graph", 0, 0);
+            return;
+        }
+        std::unique_ptr<GraphReader> graph = GraphReader::Open(filename.c_str(), {});
+        std::filesystem::remove(filename);
+        if (graph == nullptr) {
+            Check(false, filename, "open random graph", 0, 0);
+            return;
+        }
+        const std::string graph_name = compressed ? "random (compressed)" : "random";
+        Check(graph->Compressed() == compressed, graph_name, "Compressed()", 0, 0);
+        TestAllPairs(graph_name, *graph, workspace);
+        TestDistances(graph_name, *graph, workspace);
+        TestDistanceMatrix(graph_name, *graph);
+        TestNearShortestPaths(graph_name, *graph, workspace, 100);
+        TestFilter(graph_name, *graph, workspace, 42);
+    }
+}
+
+// FindNearShortestPaths() on a chain 1 -> 2 -> ... -> 299, where the search
+// radii exceed the range of the 8-bit distance labels before the searches
+// meet for the longest paths.
+void TestNearShortestPathsOnLongChain(SearchWorkspace &workspace) {
+    const index_t size = 300;
+    std::vector<std::vector<index_t>> outlinks(size), inlinks(size);
+    for (index_t v = 1; v + 1 < size; ++v) {
+        outlinks[v].push_back(v + 1);
+        inlinks[v + 1].push_back(v);
+    }
+    const std::string filename = TempFilename("searcher_test", "-chain.graph");
+    std::unique_ptr<GraphReader> graph = WriteGraphOutput(filename.c_str(), outlinks, inlinks)
+        ? GraphReader::Open(filename.c_str(), {}) : nullptr;
+    std::filesystem::remove(filename);
+    if (graph == nullptr) {
+        Check(false, "chain", "write and open", 0, 0);
+        return;
+    }
+
+    // Too long for the labels: no result, rather than a wrong one.
+    Check(FindShortestPath(*graph, 1, 299, nullptr).value.size() == 299, "chain", "FindShortestPath()", 1, 299);
+    auto too_long = workspace.FindNearShortestPaths(*graph, 1, 299, 0, nullptr);
+    Check(!too_long.value && !too_long.Aborted(), "chain",
+            "FindNearShortestPaths() of a path longer than 253 edges", 1, 299);
+    Check(!FindNearShortestPaths(*graph, 1, 200, 60, nullptr).value, "chain",
+            "FindNearShortestPaths() with a maximum length over 253", 1, 200);
+
+    // The longest paths that fit, and a short one to check that the
+    // workspace was reset after the aborted searches.
+    for (auto [start, finish] : {std::pair<index_t, index_t>{1, 254}, {40, 240}, {1, 3}}) {
+        std::optional<NearShortestPaths> result = workspace.FindNearShortestPaths(*graph, start, finish, 0, nullptr).value;
+        const int d = finish - start;
+        Check(result && result->shortest_length == d && result->max_length == d, "chain",
+                "FindNearShortestPaths() lengths", start, finish);
+        Check(result && result->edges == FindShortestPathDag(*graph, start, finish, nullptr).value, "chain",
+                "FindNearShortestPaths() matches FindShortestPathDag()", start, finish);
+    }
+}
+
+// Checks that searches are aborted when they exceed their limits, and that
+// generous limits do not affect the result.
+void TestLimits(SearchWorkspace &workspace) {
+    std::string filename = TempFilename("searcher_test", "-limits.graph");
+    if (!WriteRandomGraph(filename.c_str(), 20000, 2, 42)) {
+        Check(false, filename, "write random graph", 0, 0);
+        return;
+    }
+    std::unique_ptr<GraphReader> graph = GraphReader::Open(filename.c_str(), {});
+    std::filesystem::remove(filename);
+    if (graph == nullptr) {
+        Check(false, filename, "open random graph", 0, 0);
+        return;
+    }
+
+    // Find a pair of vertices where the search expands many vertices.
+    index_t start = 1, finish = 2;
+    SearchStats unlimited_stats;
+    for (; finish < graph->VertexCount(); ++finish) {
+        FindShortestPath(*graph, start, finish, &unlimited_stats);
+        if (unlimited_stats.vertices_expanded > 500) break;
+    }
+    if (finish == graph->VertexCount()) {
+        Check(false, "limits", "find an expensive search", start, 0);
+        return;
+    }
+    std::vector<index_t> unlimited_path = FindShortestPath(*graph, start, finish, nullptr).value;
+    auto unlimited_dag = FindShortestPathDag(*graph, start, finish, nullptr).value;
+
+    const std::atomic<bool> cancelled = true;
+    const std::atomic<bool> not_cancelled = false;
+    const std::vector<std::pair<std::string, SearchLimits>> limit_configs = {
+        {"max_vertices_expanded", {.max_vertices_expanded = 10}},
+        {"max_edges_expanded", {.max_edges_expanded = 10}},
+        {"deadline", {.deadline = std::chrono::steady_clock::now() - std::chrono::seconds(1)}},
+        {"cancel", {.cancel = &cancelled}},
+    };
+    const std::vector<AbortReason> expected_reasons = {
+        AbortReason::VERTEX_LIMIT, AbortReason::EDGE_LIMIT, AbortReason::DEADLINE, AbortReason::CANCELLED,
+    };
+    const std::vector<std::pair<std::string, SearchOptions>> option_configs = {
+        {"default", {}},
+        {"bottom-up", {.sparse_visited_max_fraction = 0, .bottom_up_alpha = 1e9, .bottom_up_beta = 1e9, .bottom_up_min_fringe = 0}},
+        {"parallel", {.sparse_visited_max_fraction = 0, .threads = 3, .parallel_min_fringe = 1}},
+        {"layered", {.layered = true}},
+    };
+    for (const auto &[options_name, options] : option_configs) {
+        for (size_t i = 0; i < limit_configs.size(); ++i) {
+            const auto &[limits_name, limits] = limit_configs[i];
+            const std::string what = options_name + " " + limits_name;
+            SearchStats stats;
+            auto path = workspace.FindShortestPath(*graph, start, finish, &stats, options, limits);
+            Check(path.value.empty() && path.abort_reason == expected_reasons[i] &&
+                    stats.abort_reason == expected_reasons[i] &&
+                    stats.vertices_expanded > 0 && stats.vertices_expanded < unlimited_stats.vertices_expanded,
+                    "limits", what + " FindShortestPath() aborted", start, finish);
+            auto dag = workspace.FindShortestPathDag(*graph, start, finish, &stats, options, limits);
+            Check(!dag.value && dag.abort_reason == expected_reasons[i] &&
+                    stats.abort_reason == expected_reasons[i] && stats.vertices_expanded > 0,
+                    "limits", what + " FindShortestPathDag() aborted", start, finish);
+
+            // The result tells an aborted search from one that found no path
+            // without a SearchStats object.
+            Check(workspace.FindShortestPath(*graph, start, finish, nullptr, options, limits).Aborted(),
+                    "limits", what + " FindShortestPath() aborted without stats", start, finish);
+            Check(workspace.FindShortestPathDag(*graph, start, finish, nullptr, options, limits).Aborted(),
+                    "limits", what + " FindShortestPathDag() aborted without stats", start, finish);
+        }
+
+        // Generous limits, which must not affect the result. (The workspace must
+        // also have been reset properly after the aborted searches.)
+        const SearchLimits limits = {
+            .max_vertices_expanded = 1000000,
+            .max_edges_expanded = 1000000,
+            .deadline = std::chrono::steady_clock::now() + std::chrono::hours(1),
+            .cancel = &not_cancelled,
+        };
+        SearchStats stats;
+        auto path = workspace.FindShortestPath(*graph, start, finish, &stats, options, limits);
+        Check(path.value.size() == unlimited_path.size() && !path.Aborted() && stats.abort_reason == AbortReason::NONE,
+                "limits", options_name + " FindShortestPath() within limits", start, finish);
+        auto dag = workspace.FindShortestPathDag(*graph, start, finish, &stats, options, limits);
+        Check(dag.value == unlimited_dag && !dag.Aborted() && stats.abort_reason == AbortReason::NONE,
+                "limits", options_name + " FindShortestPathDag() within limits", start, finish);
+    }
+
+    for (size_t i = 0; i < limit_configs.size(); ++i) {
+        SearchStats stats;
+        auto length = workspace.ShortestPathLength(*graph, start, finish, &stats, limit_configs[i].second);
+        Check(!length.value && length.abort_reason == expected_reasons[i] &&
+                stats.abort_reason == expected_reasons[i] && stats.vertices_expanded > 0,
+                "limits", limit_configs[i].first + " ShortestPathLength() aborted", start, finish);
+    }
+    SearchStats stats;
+    auto length = workspace.ShortestPathLength(*graph, start, finish, &stats, {.max_edges_expanded = 1000000});
+    Check(length.value == static_cast<int>(unlimited_path.size()) - 1 && !length.Aborted() &&
+            stats.abort_reason == AbortReason::NONE,
+            "limits", "ShortestPathLength() within limits", start, finish);
+}
+
+// Checks SearchOptions::sort_fringes on a layered graph where the fringe that
+// is expanded last is large (so it is radix sorted) and in random order:
+//
+//   1 -> A (10000 vertices) -> D (random) -> C (10000 vertices) -> 2
+void TestSortedFringes(SearchWorkspace &workspace) {
+    const index_t layer = 10000;
+    const index_t a = 3, d = a + layer, c = d + layer, size = c + layer;
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<index_t> random_d(d, c - 1);
+    std::vector<std::vector<index_t>> outlinks(size), inlinks(size);
+    auto add_edge = [&](index_t v, index_t w) {
+        outlinks[v].push_back(w);
+        inlinks[w].push_back(v);
+    };
+    for (index_t i = 0; i < layer; ++i) {
+        add_edge(1, a + i);
+        add_edge(a + i, random_d(rng));
+        add_edge(d + i, c + (i * 7919) % layer);
+        add_edge(c + i, 2);
+    }
+    for (auto &edges : outlinks) {
+        std::sort(edges.begin(), edges.end());
+        edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+    }
+    for (auto &edges : inlinks) {
+        std::sort(edges.begin(), edges.end());
+        edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+    }
+    std::string filename = TempFilename("searcher_test", "-sorted.graph");
+    if (!WriteGraphOutput(filename.c_str(), outlinks, inlinks)) {
+        Check(false, filename, "write layered graph", 0, 0);
+        return;
+    }
+    std::unique_ptr<GraphReader> graph = GraphReader::Open(filename.c_str(), {});
+    std::filesystem::remove(filename);
+    if (graph == nullptr) {
+        Check(false, filename, "open layered graph", 0, 0);
+        return;
+    }
+    for (double fraction : {0.0, 1.0}) {
+        SearchOptions options = {.sparse_visited_max_fraction = fraction, .bottom_up_alpha = 0, .sort_fringes = true};
+        SearchStats stats;
+        auto path = workspace.FindShortestPath(*graph, 1, 2, &stats, options).value;
+        Check(IsShortestPath(*graph, 1, 2, 4, path), "layered", "FindShortestPath() with sorted fringes", 1, 2);
+        bool large_level = false;
+        for (const SearchLevel &level : stats.levels) large_level |= level.fringe_size >= 4096;
+        Check(large_level, "layered", "FindShortestPath() expands a large fringe", 1, 2);
+    }
+}
+
+}  // namespace
+}  // namespace wikipath
+
+int main() {
+    using namespace wikipath;
+    SearchWorkspace workspace;
+    for (const char *filename : {"testdata/example-1.graph", "testdata/example-2.graph", "testdata/example-3.graph"}) {
+        std::unique_ptr<GraphReader> graph = GraphReader::Open(filename, {});
+        if (graph == nullptr) {
+            std::cout << "Could not open " << filename << "!\n";
+            return EXIT_FAILURE;
+        }
+        TestAllPairs(filename, *graph, workspace);
+        TestDistances(filename, *graph, workspace);
+        TestDistanceMatrix(filename, *graph);
+        TestNearShortestPaths(filename, *graph, workspace, 1000);
+        for (unsigned seed : {1, 2, 3}) TestFilter(filename, *graph, workspace, seed);
+        if (std::string_view(filename) == "testdata/example-1.graph") {
+            TestStats(*graph);
+            TestFaultCounts(*graph, workspace);
+        }
+    }
+    {
+        // Searches use the copy of the graph on the NUMA node of the calling
+        // thread, and pin the threads of parallel searches to that node.
+        const char *filename = "testdata/example-1.graph";
+        std::unique_ptr<GraphReader> graph = GraphReader::Open(filename,
+                {.numa_replicas = true, .numa_nodes = {CurrentNumaNode()}});
+        if (graph == nullptr || graph->NumaReplicaNodes().size() != 1) {
+            std::cout << "Could not open " << filename << " with NUMA replicas!\n";
+            return EXIT_FAILURE;
+        }
+        TestAllPairs(std::string(filename) + " (NUMA replica)", *graph, workspace);
+    }
+    TestRandomGraph(workspace);
+    TestNearShortestPathsOnLongChain(workspace);
+    TestLimits(workspace);
+    TestSortedFringes(workspace);
+
+    if (failures > 0) {
+        std::cout << failures << " tests failed!\n";
+        return EXIT_FAILURE;
+    } else {
+        std::cout << "All " << successes << " tests passed.\n";
+        return EXIT_SUCCESS;
+    }
+}
@@ -0,0 +1,98 @@
+#include "wikipath/stream-vbyte.h"
+
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <stdlib.h>
+
+namespace wikipath {
+namespace {
+
+int successes = 0, failures = 0;
+
+void Check(bool condition, const std::string &what) {
+    if (condition) {
+        ++successes;
+    } else {
+        ++failures;
+        std::cout << "Test failed!\n"
+            << "\tCheck: " << what << "\n";
+    }
+}
+
+// Encodes `indices`, decodes them with `kernel`, and checks that the result
+// and the size of the encoding match.
+void CheckRoundTrip(DecodeKernel kernel, const std::vector<index_t> &indices, const std::string &what) {
+    std::vector<uint8_t> data;
+    EncodeSortedIndices(indices, data);
+    const size_t encoded_size = data.size();
+    data.resize(encoded_size + stream_vbyte_padding, 0xff);
+    std::vector<index_t> decoded(indices.size());
+    size_t decoded_size = DecodeSortedIndices(kernel, data.data(), indices.size(), decoded.data());
+    const std::string prefix = std::string(DecodeKernelName(kernel)) + " " + what + ": ";
+    Check(decoded == indices, prefix + "indices");
+    Check(decoded_size == encoded_size, prefix + "size");
+}
+
+void TestEncoding() {
+    std::vector<uint8_t> data;
+    EncodeSortedIndices({}, data);
+    Check(data.empty(), "empty list");
+
+    // Gaps 1, 0x100, 0x10000 and 0x1000000 take 1 to 4 bytes; the fifth gap
+    // starts a second control byte.
+    std::vector<index_t> indices = {1, 0x101, 0x10101, 0x1010101, 0x1010102};
+    EncodeSortedIndices(indices, data);
+    Check(data == std::vector<uint8_t>{
+                0b11100100, 0b00000000,
+                0x01, 0x00, 0x01, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x01, 0x01},
+            "gap lengths");
+
+    // Encoding appends to the output.
+    EncodeSortedIndices(std::vector<index_t>{7}, data);
+    Check(data.size() == 15 && data[13] == 0 && data[14] == 7, "append");
+}
+
+void TestKernel(DecodeKernel kernel) {
+    if (!DecodeKernelSupported(kernel)) {
+        std::cout << "Skipping unsupported kernel " << DecodeKernelName(kernel) << ".\n";
+        return;
+    }
+    CheckRoundTrip(kernel, {}, "empty list");
+    CheckRoundTrip(kernel, {0, 0, 0, 0, 0}, "zeros");
+    CheckRoundTrip(kernel, {0xfffffffe, 0xffffffff}, "largest indices");
+    CheckRoundTrip(kernel, {0, 0xffffffff, 0xffffffff, 0xffffffff}, "largest gap");
+
+    std::mt19937 rng(42);
+    for (int round = 0; round < 200; ++round) {
+        // Mix gaps of different lengths, and duplicates.
+        const int size = round % 70;
+        const int max_bytes = 1 + round % 4;
+        std::uniform_int_distribution<index_t> value(0, max_bytes == 4 ? 0xffffffff : (1u << (8 * max_bytes)) - 1);
+        std::vector<index_t> indices(size);
+        for (index_t &i : indices) i = value(rng);
+        std::sort(indices.begin(), indices.end());
+        CheckRoundTrip(kernel, indices, "round " + std::to_string(round) + " (size " + std::to_string(size) + ")");
+    }
+}
+
+}  // namespace
+}  // namespace wikipath
+
+int main() {
+    using namespace wikipath;
+    TestEncoding();
+    for (DecodeKernel kernel : {DecodeKernel::SCALAR, DecodeKernel::SSSE3}) TestKernel(kernel);
+    Check(DecodeKernelSupported(BestDecodeKernel()), "BestDecodeKernel() is supported");
+
+    if (failures > 0) {
+        std::cout << failures << " tests failed!\n";
+        return EXIT_FAILURE;
+    } else {
+        std::cout << "All " << successes << " tests passed.\n";
+        return EXIT_SUCCESS;
+    }
+}
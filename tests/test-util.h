@@ -0,0 +1,120 @@
+#ifndef WIKIPATH_TEST_UTIL_H_INCLUDED
+#define WIKIPATH_TEST_UTIL_H_INCLUDED
+
+#include "wikipath/graph-reader.h"
+#include "wikipath/graph-writer.h"
+#include "wikipath/searcher.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace wikipath {
+
+// Helpers shared by the tests that search graphs. Each test is a separate
+// executable, so the counters below are per test.
+
+inline int successes = 0, failures = 0;
+
+inline void Check(bool condition, const std::string &graph_name, const std::string &what) {
+    if (condition) {
+        ++successes;
+    } else {
+        ++failures;
+        std::cout << "Test failed!\n"
+            << "\tGraph: " << graph_name << "\n"
+            << "\tCheck: " << what << "\n";
+    }
+}
+
+inline void Check(bool condition, const std::string &graph_name, const std::string &what,
+        index_t start, index_t finish) {
+    if (condition) {
+        ++successes;
+    } else {
+        ++failures;
+        std::cout << "Test failed!\n"
+            << "\tGraph: " << graph_name << "\n"
+            << "\tCheck: " << what << "\n"
+            << "\tStart: " << start << "\n"
+            << "\tFinish: " << finish << "\n";
+    }
+}
+
+// Returns a filename in the temporary directory that is unique to this run
+// of test `test_name`.
+inline std::string TempFilename(const std::string &test_name, const std::string &suffix) {
+    return (std::filesystem::temp_directory_path() /
+            (test_name + "-" + std::to_string(getpid()) + suffix)).string();
+}
+
+inline bool HasEdge(const GraphReader &graph, index_t v, index_t w) {
+    auto edges = graph.ForwardEdges(v);
+    return std::find(edges.begin(), edges.end(), w) != edges.end();
+}
+
+// Returns whether `path` is a valid path from `start` to `finish` of length
+// `dist`, or empty if `dist` is `unreachable`.
+inline bool IsShortestPath(const GraphReader &graph, index_t start, index_t finish, int dist,
+        const std::vector<index_t> &path, int unreachable = -1) {
+    if (dist == unreachable) return path.empty();
+    if (path.size() != static_cast<size_t>(dist) + 1) return false;
+    if (path.front() != start || path.back() != finish) return false;
+    for (size_t i = 0; i + 1 < path.size(); ++i) {
+        if (!HasEdge(graph, path[i], path[i + 1])) return false;
+    }
+    return true;
+}
+
+// Returns distances from `start` to all vertices (or from all vertices to
+// `start`, if `direction` is BACKWARD), or `unreachable` if unreachable,
+// calculated with a simple breadth-first search.
+inline std::vector<int> ReferenceDistances(const GraphReader &graph, index_t start,
+        Direction direction = Direction::FORWARD, int unreachable = -1) {
+    std::vector<int> dist(graph.VertexCount(), unreachable);
+    std::vector<index_t> queue = {start};
+    dist[start] = 0;
+    for (size_t i = 0; i < queue.size(); ++i) {
+        index_t v = queue[i];
+        for (index_t w : direction == Direction::FORWARD ? graph.ForwardEdges(v) : graph.BackwardEdges(v)) {
+            if (dist[w] == unreachable) {
+                dist[w] = dist[v] + 1;
+                queue.push_back(w);
+            }
+        }
+    }
+    return dist;
+}
+
+// Writes a random graph where vertex 0 has no edges (like in the real graph)
+// and returns whether it succeeded.
+inline bool WriteRandomGraph(const char *filename, index_t size, int edges_per_vertex, unsigned seed,
+        bool compressed = false) {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<index_t> dist(1, size - 1);
+    std::vector<std::vector<index_t>> outlinks(size), inlinks(size);
+    for (index_t v = 1; v < size; ++v) {
+        std::set<index_t> targets;
+        for (int i = 0; i < edges_per_vertex; ++i) {
+            index_t w = dist(rng);
+            if (w != v) targets.insert(w);
+        }
+        for (index_t w : targets) {
+            outlinks[v].push_back(w);
+            inlinks[w].push_back(v);
+        }
+    }
+    return compressed
+        ? WriteCompressedGraphOutput(filename, outlinks, inlinks)
+        : WriteGraphOutput(filename, outlinks, inlinks);
+}
+
+}  // namespace wikipath
+
+#endif  // ndef WIKIPATH_TEST_UTIL_H_INCLUDED
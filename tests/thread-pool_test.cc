@@ -0,0 +1,94 @@
+#include "wikipath/thread-pool.h"
+
+#include "wikipath/numa.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <stdlib.h>
+
+namespace {
+
+int successes = 0, failures = 0;
+
+void Check(bool condition, const std::string &what) {
+    if (condition) {
+        ++successes;
+    } else {
+        ++failures;
+        std::cout << "Test failed!\n"
+            << "\tCheck: " << what << "\n";
+    }
+}
+
+void TestRun(wikipath::ThreadPool &pool) {
+    const std::string name = "Run() with " + std::to_string(pool.ThreadCount()) + " threads";
+    std::vector<int> calls(pool.ThreadCount());
+    for (int i = 0; i < 3; ++i) {
+        pool.Run([&](int thread_index) { ++calls[thread_index]; });
+    }
+    for (int count : calls) Check(count == 3, name + " calls each thread once per run");
+}
+
+void TestParallelFor(wikipath::ThreadPool &pool, size_t begin, size_t end, size_t grain) {
+    const std::string name = "ParallelFor(" + std::to_string(begin) + ", " + std::to_string(end) +
+            ", " + std::to_string(grain) + ") with " + std::to_string(pool.ThreadCount()) + " threads";
+
+    // Uneven costs, so that threads run out of work at different times.
+    std::vector<std::atomic<int>> visits(end);
+    std::atomic<bool> bad_range = false;
+    pool.ParallelFor(begin, end, grain, [&](int thread_index, size_t b, size_t e) {
+        if (thread_index < 0 || thread_index >= pool.ThreadCount() || b >= e || e - b > grain) {
+            bad_range = true;
+        }
+        for (size_t i = b; i < e; ++i) {
+            volatile size_t sum = 0;
+            for (size_t j = 0; j < (i % 7 == 0 ? 10000 : 10); ++j) sum = sum + j;
+            ++visits[i];
+        }
+    });
+    Check(!bad_range, name + " passes valid ranges");
+    bool each_once = true;
+    for (size_t i = 0; i < end; ++i) {
+        if (visits[i] != (i >= begin ? 1 : 0)) each_once = false;
+    }
+    Check(each_once, name + " visits each index exactly once");
+}
+
+void TestPinWorkers(wikipath::ThreadPool &pool) {
+    const std::string name = "PinWorkersToNumaNode() with " + std::to_string(pool.ThreadCount()) + " threads";
+    const int node = wikipath::CurrentNumaNode();
+    Check(pool.PinWorkersToNumaNode(node), name + " succeeds");
+    std::vector<int> nodes(pool.ThreadCount(), -1);
+    pool.Run([&](int thread_index) { nodes[thread_index] = wikipath::CurrentNumaNode(); });
+    Check(std::all_of(nodes.begin() + 1, nodes.end(), [node](int n) { return n == node; }),
+            name + " runs workers on the node");
+}
+
+}  // namespace
+
+int main() {
+    for (int threads : {1, 2, 5}) {
+        wikipath::ThreadPool pool(threads);
+        Check(pool.ThreadCount() == threads, "ThreadCount()");
+        TestRun(pool);
+        TestParallelFor(pool, 0, 0, 1);
+        TestParallelFor(pool, 3, 4, 1);
+        TestParallelFor(pool, 0, 100, 1);
+        TestParallelFor(pool, 10, 10000, 64);
+        TestParallelFor(pool, 0, 100000, 7);
+        TestPinWorkers(pool);
+    }
+
+    if (failures > 0) {
+        std::cout << failures << " tests failed!\n";
+        return EXIT_FAILURE;
+    } else {
+        std::cout << "All " << successes << " tests passed.\n";
+        return EXIT_SUCCESS;
+    }
+}
@@ -0,0 +1,238 @@
+#include "wikipath/graph-reader.h"
+#include "wikipath/graph-writer.h"
+#include "wikipath/metadata-reader.h"
+#include "wikipath/metadata-writer.h"
+#include "wikipath/searcher.h"
+#include "wikipath/vertex-order.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <stdlib.h>
+
+namespace wikipath {
+namespace {
+
+constexpr VertexOrder all_orders[] = {VertexOrder::BFS, VertexOrder::RCM, VertexOrder::DEGREE, VertexOrder::GORDER};
+
+int successes = 0, failures = 0;
+
+void Check(bool condition, const std::string &graph_name, const std::string &what) {
+    if (condition) {
+        ++successes;
+    } else {
+        ++failures;
+        std::cout << "Test failed!\n"
+            << "\tGraph: " << graph_name << "\n"
+            << "\tCheck: " << what << "\n";
+    }
+}
+
+std::string TempFilename(const std::string &suffix) {
+    return (std::filesystem::temp_directory_path() /
+            ("vertex-order_test-" + std::to_string(getpid()) + suffix)).string();
+}
+
+bool IsPermutation(const std::vector<index_t> &new_id) {
+    std::vector<bool> seen(new_id.size(), false);
+    for (index_t i : new_id) {
+        if (i >= new_id.size() || seen[i]) return false;
+        seen[i] = true;
+    }
+    return true;
+}
+
+// Renumbers `graph` in `order`, writes it in both file formats, and checks
+// that the result has the same edges and shortest path lengths as the
+// original, up to renumbering.
+void TestRenumber(const std::string &graph_name, const GraphReader &graph, VertexOrder order) {
+    const std::string what = std::string(VertexOrderName(order)) + ": ";
+    std::vector<index_t> new_id = ComputeVertexOrder(graph, order);
+    Check(new_id.size() == graph.VertexCount(), graph_name, what + "size");
+    Check(IsPermutation(new_id), graph_name, what + "permutation");
+    Check(!new_id.empty() && new_id[0] == 0, graph_name, what + "vertex 0 is not renumbered");
+    if (new_id.size() != graph.VertexCount() || !IsPermutation(new_id)) return;
+
+    const std::string filename = TempFilename(".graph");
+    auto [outlinks, inlinks] = RenumberedAdjacency(graph, new_id);
+    for (bool compressed : {false, true}) {
+        const std::string format = compressed ? "compressed " : "uncompressed ";
+        bool written = compressed
+            ? WriteCompressedGraphOutput(filename.c_str(), graph.VertexCount(), outlinks, inlinks)
+            : WriteGraphOutput(filename.c_str(), graph.VertexCount(), outlinks, inlinks);
+        std::unique_ptr<GraphReader> renumbered = written ? GraphReader::Open(filename.c_str(), {}) : nullptr;
+        std::filesystem::remove(filename);
+        if (renumbered == nullptr) {
+            Check(false, graph_name, what + format + "write and open");
+            continue;
+        }
+        Check(renumbered->EdgeCount() == graph.EdgeCount(), graph_name, what + format + "EdgeCount()");
+
+        bool forward_match = true, backward_match = true;
+        std::vector<index_t> expected, buffer;
+        for (index_t v = 0; v < graph.VertexCount(); ++v) {
+            expected.clear();
+            for (index_t w : graph.ForwardEdges(v, buffer)) expected.push_back(new_id[w]);
+            std::sort(expected.begin(), expected.end());
+            forward_match &= std::ranges::equal(renumbered->ForwardEdges(new_id[v], buffer), expected);
+            expected.clear();
+            for (index_t w : graph.BackwardEdges(v, buffer)) expected.push_back(new_id[w]);
+            std::sort(expected.begin(), expected.end());
+            backward_match &= std::ranges::equal(renumbered->BackwardEdges(new_id[v], buffer), expected);
+        }
+        Check(forward_match, graph_name, what + format + "forward edges");
+        Check(backward_match, graph_name, what + format + "backward edges");
+
+        std::mt19937 rng(42);
+        std::uniform_int_distribution<index_t> vertex(1, graph.VertexCount() - 1);
+        bool lengths_match = true;
+        for (int i = 0; i < 50; ++i) {
+            index_t start = vertex(rng), finish = vertex(rng);
+            lengths_match &= FindShortestPath(graph, start, finish, nullptr).value.size() ==
+                    FindShortestPath(*renumbered, new_id[start], new_id[finish], nullptr).value.size();
+        }
+        Check(lengths_match, graph_name, what + format + "shortest path lengths");
+    }
+}
+
+// Two interleaved cliques (odd and even vertices): the traversal-based orders
+// must give each clique a contiguous range of ids.
+void TestLocality() {
+    const index_t size = 41;
+    std::vector<std::vector<index_t>> outlinks(size), inlinks(size);
+    for (index_t v = 1; v < size; ++v) {
+        for (index_t w = 1; w < size; ++w) {
+            if (v != w && v % 2 == w % 2) {
+                outlinks[v].push_back(w);
+                inlinks[w].push_back(v);
+            }
+        }
+    }
+    const std::string filename = TempFilename(".graph");
+    std::unique_ptr<GraphReader> graph = WriteGraphOutput(filename.c_str(), outlinks, inlinks)
+        ? GraphReader::Open(filename.c_str(), {}) : nullptr;
+    std::filesystem::remove(filename);
+    if (graph == nullptr) {
+        Check(false, "cliques", "write and open");
+        return;
+    }
+    for (VertexOrder order : {VertexOrder::BFS, VertexOrder::RCM, VertexOrder::GORDER}) {
+        std::vector<index_t> new_id = ComputeVertexOrder(*graph, order);
+        bool contiguous = true;
+        for (index_t v = 1; v < size; ++v) {
+            // Vertices 1..20 and 21..40 are the new ranges, in either order.
+            contiguous &= ((new_id[v] - 1) / 20 == (new_id[1] - 1) / 20) == (v % 2 == 1);
+        }
+        Check(contiguous, "cliques", std::string(VertexOrderName(order)) + ": contiguous cliques");
+    }
+}
+
+// Renumbers the metadata of an example graph, and checks that every page and
+// link is found under its new id.
+void TestMetadata(const char *graph_filename, const char *metadata_filename) {
+    std::unique_ptr<GraphReader> graph = GraphReader::Open(graph_filename, {});
+    std::unique_ptr<MetadataReader> metadata = MetadataReader::Open(metadata_filename);
+    if (graph == nullptr || metadata == nullptr) {
+        Check(false, graph_filename, "open");
+        return;
+    }
+    std::vector<index_t> new_id = ComputeVertexOrder(*graph, VertexOrder::GORDER);
+    const std::string filename = TempFilename(".metadata");
+    {
+        std::unique_ptr<MetadataWriter> writer = MetadataWriter::Create(filename.c_str());
+        Check(writer != nullptr && writer->InsertRenumbered(metadata_filename, new_id),
+                graph_filename, "InsertRenumbered()");
+    }
+    std::unique_ptr<MetadataReader> renumbered = MetadataReader::Open(filename.c_str());
+    std::filesystem::remove(filename);
+    if (renumbered == nullptr) {
+        Check(false, graph_filename, "open renumbered metadata");
+        return;
+    }
+    bool pages_match = true, links_match = true;
+    int pages = 0, links = 0;
+    for (index_t v = 0; v < graph->VertexCount(); ++v) {
+        std::optional<MetadataReader::Page> page = metadata->GetPageById(v);
+        std::optional<MetadataReader::Page> renumbered_page = renumbered->GetPageById(new_id[v]);
+        pages += page.has_value();
+        pages_match &= page.has_value() == renumbered_page.has_value() &&
+                (!page || page->title == renumbered_page->title);
+        for (index_t w : graph->ForwardEdges(v)) {
+            std::optional<MetadataReader::Link> link = metadata->GetLink(v, w);
+            std::optional<MetadataReader::Link> renumbered_link = renumbered->GetLink(new_id[v], new_id[w]);
+            links += link.has_value();
+            links_match &= link.has_value() == renumbered_link.has_value() &&
+                    (!link || link->title == renumbered_link->title);
+        }
+    }
+    Check(pages > 0 && pages_match, graph_filename, "renumbered pages");
+    Check(links > 0 && links_match, graph_filename, "renumbered links");
+}
+
+}  // namespace
+}  // namespace wikipath
+
+int main() {
+    using namespace wikipath;
+    for (VertexOrder order : all_orders) {
+        Check(ParseVertexOrder(VertexOrderName(order)) == order, VertexOrderName(order), "ParseVertexOrder()");
+    }
+    Check(!ParseVertexOrder("random"), "random", "ParseVertexOrder()");
+
+    for (const char *filename : {"testdata/example-1.graph", "testdata/example-2.graph", "testdata/example-3.graph"}) {
+        std::unique_ptr<GraphReader> graph = GraphReader::Open(filename, {});
+        if (graph == nullptr) {
+            Check(false, filename, "open");
+            continue;
+        }
+        for (VertexOrder order : all_orders) TestRenumber(filename, *graph, order);
+    }
+
+    // A random graph with skewed degrees, which has ties and vertices without
+    // edges.
+    {
+        const index_t size = 2000;
+        std::mt19937 rng(7);
+        std::uniform_real_distribution<double> real(0.0, 1.0);
+        std::vector<std::vector<index_t>> outlinks(size), inlinks(size);
+        for (index_t v = 1; v < size; ++v) {
+            for (int i = rng() % 8; i > 0; --i) {
+                double x = real(rng);
+                index_t w = 1 + static_cast<index_t>(x * x * x * (size - 1));
+                if (w < size && w != v && std::ranges::find(outlinks[v], w) == outlinks[v].end()) {
+                    outlinks[v].push_back(w);
+                    inlinks[w].push_back(v);
+                }
+            }
+        }
+        const std::string filename = TempFilename("-random.graph");
+        std::unique_ptr<GraphReader> graph = WriteGraphOutput(filename.c_str(), outlinks, inlinks)
+            ? GraphReader::Open(filename.c_str(), {}) : nullptr;
+        std::filesystem::remove(filename);
+        if (graph == nullptr) {
+            Check(false, "random", "write and open");
+        } else {
+            for (VertexOrder order : all_orders) TestRenumber("random", *graph, order);
+        }
+    }
+
+    TestLocality();
+    TestMetadata("testdata/example-1.graph", "testdata/example-1.metadata");
+    TestMetadata("testdata/example-2.graph", "testdata/example-2.metadata");
+
+    if (failures > 0) {
+        std::cout << failures << " tests failed!\n";
+        return EXIT_FAILURE;
+    } else {
+        std::cout << "All " << successes << " tests passed.\n";
+        return EXIT_SUCCESS;
+    }
+}